@@ -0,0 +1,181 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Run the coreidle planning and application path over a synthetic
+// system (see coreidle_sandbox.h), by default 8 sockets x 28 cores x 2
+// threads = 448 CPUs with 100k tasks and one FPGA per socket.
+//
+// usage: bench_coreidle_topology [sockets] [cores-per-socket]
+//                                [threads-per-core] [tasks]
+//                                [threads-per-process] [iterations]
+
+#include <opae/fpga.h>
+
+extern "C" {
+
+#include "coreidle.h"
+
+}
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <vector>
+
+#include "coreidle_sandbox.h"
+
+using hrc = std::chrono::high_resolution_clock;
+
+namespace {
+
+double usec_since(hrc::time_point start)
+{
+  return std::chrono::duration<double, std::micro>(hrc::now() - start).count();
+}
+
+// Every task must see exactly the planned CPUs of each socket.
+bool verify(const coreidle_sandbox::sandbox &sb,
+            const std::vector<struct socket_plan> &plans, size_t tasks)
+{
+  for (pid_t tid = 1; tid <= static_cast<pid_t>(tasks); ++tid) {
+    const cpu_set_t *set = sb.affinity(tid);
+    if (!set)
+      return false;
+    for (const auto &plan : plans) {
+      int cpus = plan.topo.cpu_num / plan.topo.socket_num;
+      for (int cpu = 0; cpu < cpus; ++cpu) {
+        bool online = static_cast<uint64_t>(cpu) < plan.max_available_cpu;
+        if (CPU_ISSET(plan.topo.split_point + cpu, set) != online)
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char *argv[])
+{
+  coreidle_sandbox::config cfg;
+  int tasks = 100000;
+  int iterations = 3;
+
+  cfg.sockets = argc > 1 ? atoi(argv[1]) : 8;
+  cfg.cores_per_socket = argc > 2 ? atoi(argv[2]) : 28;
+  cfg.threads_per_core = argc > 3 ? atoi(argv[3]) : 2;
+  tasks = argc > 4 ? atoi(argv[4]) : tasks;
+  cfg.threads_per_process = argc > 5 ? atoi(argv[5]) : 4;
+  iterations = argc > 6 ? atoi(argv[6]) : iterations;
+
+  if (cfg.sockets < 1 || cfg.cores_per_socket < 1 ||
+      cfg.threads_per_core < 1 || tasks < 3 ||
+      cfg.threads_per_process < 1 || iterations < 1) {
+    std::cerr << "invalid arguments" << std::endl;
+    return 1;
+  }
+
+  // pid 1 and 2 are single threaded
+  cfg.processes = 2 + (tasks - 2 + cfg.threads_per_process - 1) /
+                      cfg.threads_per_process;
+  cfg.xeon_limit = 205;
+  cfg.fpga_limit = 90;
+  cfg.pkg_power_limit = 250;
+
+  try {
+    hrc::time_point start = hrc::now();
+    coreidle_sandbox::sandbox sb(cfg);
+    double build_usec = usec_since(start);
+
+    // The planner is chatty; keep the report readable.
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) {
+      dup2(devnull, STDOUT_FILENO);
+      close(devnull);
+    }
+
+    std::vector<struct socket_plan> plans(cfg.sockets);
+    double plan_usec = 0.0;
+    double apply_usec = 0.0;
+    uint64_t get_calls = 0;
+    uint64_t set_calls = 0;
+    bool ok = true;
+
+    for (int i = 0; i < iterations; ++i) {
+      sb.reset_affinity();
+
+      start = hrc::now();
+      for (int s = 0; s < cfg.sockets; ++s) {
+        struct fpga_power_info info;
+        if (get_fpga_power_info(sb.fpga(s), &info) != FPGA_OK)
+          return 1;
+        socket_plan_init(&plans[s], info.socket_id);
+        if (socket_plan_add_fpga(&plans[s], &info, 50) != FPGA_OK ||
+            plan_socket_core_idle(&plans[s]) != FPGA_OK)
+          return 1;
+      }
+      plan_usec += usec_since(start);
+
+      start = hrc::now();
+      if (apply_core_idle_plans(plans.data(), plans.size()) != FPGA_OK)
+        return 1;
+      apply_usec += usec_since(start);
+      get_calls += sb.getaffinity_calls();
+      set_calls += sb.setaffinity_calls();
+
+      ok = ok && verify(sb, plans, sb.num_tasks());
+    }
+
+    fflush(stdout);
+    if (saved_stdout >= 0) {
+      dup2(saved_stdout, STDOUT_FILENO);
+      close(saved_stdout);
+    }
+
+    printf("system          : %d sockets, %d CPUs, %zu tasks\n",
+            cfg.sockets, sb.num_cpus(), sb.num_tasks());
+    printf("online / socket : %lu of %d\n",
+            plans[0].max_available_cpu,
+            cfg.cores_per_socket * cfg.threads_per_core);
+    printf("sandbox build   : %12.0f usec\n", build_usec);
+    printf("plan all        : %12.1f usec\n", plan_usec / iterations);
+    printf("apply all       : %12.1f usec  (%lu get / %lu set)\n",
+            apply_usec / iterations, get_calls / iterations,
+            set_calls / iterations);
+    printf("verify          : %s\n", ok ? "ok" : "FAILED");
+
+    return ok ? 0 : 1;
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+}
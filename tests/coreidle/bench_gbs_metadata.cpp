@@ -0,0 +1,145 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Compare the cost of reading GBS metadata through the lazy
+// header-only reader against loading the whole bitstream with
+// opae_load_bitstream, on a synthetic GBS of configurable size.
+//
+// usage: bench_coreidle_gbs_metadata [payload-MiB] [iterations]
+
+#include <opae/fpga.h>
+
+extern "C" {
+
+#include <uuid/uuid.h>
+#include <libbitstream/bitstream.h>
+#include "gbs_metadata.h"
+
+}
+
+#include <sys/resource.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using hrc = std::chrono::high_resolution_clock;
+
+namespace {
+
+const std::string metadata =
+  "{\"version\": 1, \"afu-image\": {\"clock-frequency-high\": 312, "
+  "\"clock-frequency-low\": 156, \"power\": 50, "
+  "\"interface-uuid\": \"01234567-89ab-cdef-0123-456789abcdef\", "
+  "\"magic-no\": 488605312, \"accelerator-clusters\": "
+  "[{\"total-contexts\": 1, \"name\": \"nlb\", "
+  "\"accelerator-type-uuid\": \"d8424dc4-a4a3-c413-f89e-433683f9040b\"}]}, "
+  "\"platform-name\": \"\"}";
+
+bool make_gbs(const char *path, size_t payload_mib)
+{
+  fpga_guid guid;
+  uuid_parse(GBS_METADATA_GUID, guid);
+  uint32_t len = metadata.size();
+
+  std::ofstream gbs(path, std::ios::out | std::ios::binary);
+  gbs.write(reinterpret_cast<const char *>(guid), sizeof(guid));
+  gbs.write(reinterpret_cast<const char *>(&len), sizeof(len));
+  gbs.write(metadata.c_str(), metadata.size());
+
+  std::vector<char> chunk(1024 * 1024);
+  for (size_t i = 0; i < chunk.size(); ++i)
+    chunk[i] = static_cast<char>(i * 31);
+  for (size_t i = 0; i < payload_mib; ++i)
+    gbs.write(chunk.data(), chunk.size());
+  return gbs.good();
+}
+
+long max_rss_kib()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  size_t payload_mib = argc > 1 ? strtoul(argv[1], NULL, 0) : 256;
+  int iterations = argc > 2 ? atoi(argv[2]) : 10;
+  char path[] = "bench-XXXXXX.gbs";
+  close(mkstemps(path, 4));
+
+  if (!make_gbs(path, payload_mib)) {
+    std::cerr << "failed to create " << path << std::endl;
+    unlink(path);
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "GBS payload: " << payload_mib << " MiB, "
+            << iterations << " iterations" << std::endl;
+
+  // Header-only path first, so its peak RSS is not
+  // inflated by the full load.
+  auto begin = hrc::now();
+  for (int i = 0; i < iterations; ++i) {
+    struct gbs_metadata md = GBS_METADATA_INITIALIZER;
+    if (read_gbs_metadata(path, &md) != FPGA_OK || md.power != 50) {
+      std::cerr << "read_gbs_metadata failed" << std::endl;
+      unlink(path);
+      return EXIT_FAILURE;
+    }
+  }
+  std::chrono::duration<double, std::micro> lazy = hrc::now() - begin;
+  long lazy_rss = max_rss_kib();
+
+  begin = hrc::now();
+  for (int i = 0; i < iterations; ++i) {
+    opae_bitstream_info info = OPAE_BITSTREAM_INFO_INITIALIZER;
+    if (opae_load_bitstream(path, &info) != FPGA_OK) {
+      std::cerr << "opae_load_bitstream failed" << std::endl;
+      unlink(path);
+      return EXIT_FAILURE;
+    }
+    opae_unload_bitstream(&info);
+  }
+  std::chrono::duration<double, std::micro> full = hrc::now() - begin;
+  long full_rss = max_rss_kib();
+
+  std::cout << "read_gbs_metadata   : " << lazy.count() / iterations
+            << " usec/call, peak RSS " << lazy_rss << " KiB" << std::endl;
+  std::cout << "opae_load_bitstream : " << full.count() / iterations
+            << " usec/call, peak RSS " << full_rss << " KiB" << std::endl;
+
+  unlink(path);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,296 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "coreidle_sandbox.h"
+
+#include <errno.h>
+#include <ftw.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace coreidle_sandbox {
+
+namespace {
+
+const uint64_t msr_core_count = 0x35;
+const uint64_t msr_pkg_rapl_power_limit = 0x610;
+const uint64_t msr_rapl_power_unit = 0x606;
+// 2^3: the power limit MSR counts in 1/8 W
+const uint64_t rapl_power_unit = 3;
+
+void mkdirs(const std::string &path)
+{
+  for (size_t pos = 1; pos != std::string::npos; ) {
+    pos = path.find('/', pos + 1);
+    std::string dir = path.substr(0, pos);
+    if (mkdir(dir.c_str(), 0755) && errno != EEXIST)
+      throw std::runtime_error("mkdir " + dir + ": " + strerror(errno));
+  }
+}
+
+void write_file(const std::string &path, const std::string &value)
+{
+  std::ofstream out(path);
+  if (!out.is_open())
+    throw std::runtime_error("open " + path);
+  out << value << "\n";
+}
+
+int remove_entry(const char *path, const struct stat *, int, struct FTW *)
+{
+  return remove(path);
+}
+
+} // end of anonymous namespace
+
+sandbox *sandbox::active_ = nullptr;
+
+sandbox::sandbox(const config &cfg)
+: cfg_(cfg)
+, getaffinity_calls_(0)
+, setaffinity_calls_(0)
+{
+  if (active_)
+    throw std::logic_error("only one coreidle sandbox may be active");
+
+  if (num_cpus() > CPU_SETSIZE)
+    throw std::invalid_argument("sandbox has more CPUs than CPU_SETSIZE");
+
+  const char *tmp = getenv("TMPDIR");
+  std::string tmpl = std::string(tmp ? tmp : "/tmp") + "/coreidle-XXXXXX";
+  std::vector<char> buf(tmpl.begin(), tmpl.end());
+  buf.push_back('\0');
+  if (!mkdtemp(buf.data()))
+    throw std::runtime_error("mkdtemp: " + std::string(strerror(errno)));
+  root_ = buf.data();
+
+  make_cpus();
+  make_tasks();
+  make_fpgas();
+
+  struct coreidle_ops ops = {
+    read_object,
+    readmsr,
+    online_cpus,
+    getaffinity,
+    setaffinity,
+  };
+  active_ = this;
+  coreidle_set_ops(&ops, root_.c_str());
+}
+
+sandbox::~sandbox()
+{
+  coreidle_set_ops(nullptr, nullptr);
+  active_ = nullptr;
+  nftw(root_.c_str(), remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+}
+
+int sandbox::num_cpus() const
+{
+  return cfg_.sockets * cfg_.cores_per_socket * cfg_.threads_per_core;
+}
+
+// CPUs are numbered socket by socket, as coreidle's split point
+// expects. coreidle learns the CPU count from online_cpus and the
+// topology from the MSRs, so only those are written.
+void sandbox::make_cpus()
+{
+  int cpus_per_socket = cfg_.cores_per_socket * cfg_.threads_per_core;
+
+  for (int cpu = 0; cpu < num_cpus(); ++cpu) {
+    write_msr(cpu, msr_core_count,
+              (uint64_t(cfg_.cores_per_socket) << 16) | cpus_per_socket);
+    write_msr(cpu, msr_pkg_rapl_power_limit,
+              (cfg_.pkg_power_limit << rapl_power_unit) & 0x7fff);
+    write_msr(cpu, msr_rapl_power_unit, rapl_power_unit);
+  }
+}
+
+void sandbox::write_msr(int cpu, uint64_t msr, uint64_t value)
+{
+  char name[32];
+  char hex[32];
+  std::string dir = root_ + "/dev/cpu/" + std::to_string(cpu);
+
+  mkdirs(dir);
+  snprintf(name, sizeof(name), "/msr_0x%lx", msr);
+  snprintf(hex, sizeof(hex), "%lx", value);
+  write_file(dir + name, hex);
+}
+
+void sandbox::make_tasks()
+{
+  std::string proc = root_ + "/proc";
+  cpu_set_t all;
+
+  CPU_ZERO(&all);
+  for (int cpu = 0; cpu < num_cpus(); ++cpu)
+    CPU_SET(cpu, &all);
+
+  mkdirs(proc + "/sys/kernel");
+  write_file(proc + "/sys/kernel/pid_max", std::to_string(cfg_.pid_max));
+
+  pid_t pid = 1;
+  for (int p = 0; p < cfg_.processes; ++p) {
+    // init and kthreadd are single threaded
+    int threads = pid <= 2 ? 1 : cfg_.threads_per_process;
+    std::string task = proc + "/" + std::to_string(pid) + "/task";
+
+    if (pid + threads > static_cast<pid_t>(cfg_.pid_max))
+      throw std::invalid_argument("sandbox tasks exceed pid_max");
+
+    mkdirs(task);
+    for (int t = 0; t < threads; ++t) {
+      if (mkdir((task + "/" + std::to_string(pid + t)).c_str(), 0755))
+        throw std::runtime_error("mkdir " + task + ": " + strerror(errno));
+      affinity_[pid + t] = all;
+    }
+
+    pid += threads;
+  }
+}
+
+void sandbox::make_fpgas()
+{
+  for (int socket = 0; socket < cfg_.sockets; ++socket) {
+    for (int i = 0; i < cfg_.fpgas_per_socket; ++i) {
+      std::string fme = root_ + "/fpga/fme." + std::to_string(fpgas_.size());
+
+      mkdirs(fme + "/power_mgmt");
+      // The FME reports power in 1/8 W
+      write_file(fme + "/power_mgmt/xeon_limit",
+                 std::to_string(cfg_.xeon_limit * 8));
+      write_file(fme + "/power_mgmt/fpga_limit",
+                 std::to_string(cfg_.fpga_limit * 8));
+      write_file(fme + "/socket_id", std::to_string(socket));
+
+      fpgas_.push_back(fake_fpga{ socket, fme });
+    }
+  }
+}
+
+fpga_handle sandbox::fpga(int socket, int index)
+{
+  size_t i = socket * cfg_.fpgas_per_socket + index;
+  if (socket < 0 || socket >= cfg_.sockets ||
+      index < 0 || index >= cfg_.fpgas_per_socket)
+    throw std::out_of_range("no such sandbox FPGA");
+  return &fpgas_[i];
+}
+
+void sandbox::reset_affinity()
+{
+  cpu_set_t all;
+
+  CPU_ZERO(&all);
+  for (int cpu = 0; cpu < num_cpus(); ++cpu)
+    CPU_SET(cpu, &all);
+
+  for (auto &task : affinity_)
+    task.second = all;
+
+  getaffinity_calls_ = 0;
+  setaffinity_calls_ = 0;
+}
+
+const cpu_set_t *sandbox::affinity(pid_t tid) const
+{
+  auto it = affinity_.find(tid);
+  return it == affinity_.end() ? nullptr : &it->second;
+}
+
+fpga_result sandbox::read_object(fpga_handle handle, const char *name,
+                                 uint64_t *value)
+{
+  const fake_fpga *fpga = static_cast<const fake_fpga *>(handle);
+  std::ifstream in(fpga->path + "/" + name);
+
+  if (!(in >> *value))
+    return FPGA_NOT_FOUND;
+
+  return FPGA_OK;
+}
+
+int sandbox::readmsr(int cpu, uint64_t msr, uint64_t *value)
+{
+  char name[32];
+
+  snprintf(name, sizeof(name), "/msr_0x%lx", msr);
+  std::ifstream in(active_->root_ + "/dev/cpu/" + std::to_string(cpu) + name);
+
+  if (!(in >> std::hex >> *value))
+    return -1;
+
+  return 0;
+}
+
+int sandbox::online_cpus(void)
+{
+  return active_->num_cpus();
+}
+
+int sandbox::getaffinity(pid_t pid, size_t size, cpu_set_t *set)
+{
+  auto it = active_->affinity_.find(pid);
+
+  ++active_->getaffinity_calls_;
+  if (it == active_->affinity_.end()) {
+    errno = ESRCH;
+    return -1;
+  }
+
+  memcpy(set, &it->second, size < sizeof(cpu_set_t) ? size : sizeof(cpu_set_t));
+  return 0;
+}
+
+int sandbox::setaffinity(pid_t pid, size_t size, const cpu_set_t *set)
+{
+  auto it = active_->affinity_.find(pid);
+
+  ++active_->setaffinity_calls_;
+  if (it == active_->affinity_.end()) {
+    errno = ESRCH;
+    return -1;
+  }
+
+  if (CPU_COUNT_S(size, set) == 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  memcpy(&it->second, set, size < sizeof(cpu_set_t) ? size : sizeof(cpu_set_t));
+  return 0;
+}
+
+} // end of namespace coreidle_sandbox
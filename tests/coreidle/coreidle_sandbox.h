@@ -0,0 +1,123 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// A synthetic system for exercising coreidle away from the build host.
+//
+// The sandbox builds a root directory holding the /proc/<pid>/task/<tid>
+// trees, per-CPU MSR values and one FME power_mgmt directory per FPGA,
+// then routes coreidle's system interface (coreidle_set_ops) to it.
+// The CPU count comes from its online_cpus. Task affinities live in
+// memory, so sched_{get,set}affinity never touch the host.
+
+#pragma once
+
+#include <opae/fpga.h>
+
+extern "C" {
+
+#include "coreidle.h"
+
+}
+
+#include <sched.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace coreidle_sandbox {
+
+struct config {
+  int sockets = 2;
+  int cores_per_socket = 4;
+  int threads_per_core = 2;
+  int fpgas_per_socket = 1;
+  // pid 1, pid 2 and (processes - 2) more, each with this many threads
+  int processes = 16;
+  int threads_per_process = 1;
+  uint64_t pid_max = 4194304;
+  // watts
+  uint64_t xeon_limit = 9999;
+  uint64_t fpga_limit = 90;
+  uint64_t pkg_power_limit = 250;
+};
+
+class sandbox {
+ public:
+  explicit sandbox(const config &cfg);
+  ~sandbox();
+
+  sandbox(const sandbox &) = delete;
+  sandbox &operator=(const sandbox &) = delete;
+
+  // Directory holding the fake proc, dev and fpga trees
+  const std::string &root() const { return root_; }
+
+  int num_cpus() const;
+  size_t num_tasks() const { return affinity_.size(); }
+
+  // Opaque handle understood by the sandbox's read_object
+  fpga_handle fpga(int socket, int index = 0);
+
+  // Give every task the full CPU set again
+  void reset_affinity();
+
+  // Current affinity of a task, nullptr if there is no such task
+  const cpu_set_t *affinity(pid_t tid) const;
+
+  uint64_t getaffinity_calls() const { return getaffinity_calls_; }
+  uint64_t setaffinity_calls() const { return setaffinity_calls_; }
+
+ private:
+  struct fake_fpga {
+    int socket;
+    std::string path;
+  };
+
+  void make_cpus();
+  void make_tasks();
+  void make_fpgas();
+  void write_msr(int cpu, uint64_t msr, uint64_t value);
+
+  static fpga_result read_object(fpga_handle handle, const char *name,
+                                 uint64_t *value);
+  static int readmsr(int cpu, uint64_t msr, uint64_t *value);
+  static int online_cpus(void);
+  static int getaffinity(pid_t pid, size_t size, cpu_set_t *set);
+  static int setaffinity(pid_t pid, size_t size, const cpu_set_t *set);
+
+  static sandbox *active_;
+
+  config cfg_;
+  std::string root_;
+  std::vector<fake_fpga> fpgas_;
+  std::unordered_map<pid_t, cpu_set_t> affinity_;
+  uint64_t getaffinity_calls_;
+  uint64_t setaffinity_calls_;
+};
+
+} // end of namespace coreidle_sandbox
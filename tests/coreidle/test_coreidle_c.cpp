@@ -31,6 +31,7 @@ extern "C" {
 
 #include <json-c/json.h>
 #include <uuid/uuid.h>
+#include "coreidle.h"
 
 fpga_result sysfs_read_u64(const char *path, uint64_t *u);
 
@@ -40,12 +41,6 @@ fpga_result set_cpu_core_idle(fpga_handle handle, uint64_t gbs_power);
 
 fpga_result get_package_power(int split_point, long double *pkg_power);
 
-fpga_result setaffinity(cpu_set_t *idle_set, int socket,
-                        int pid, int split_point);
-
-fpga_result cpuset_setaffinity(int socket, int split_point,
-                               uint64_t max_cpu_count);
-
 }
 
 #include <config.h>
@@ -200,92 +195,152 @@ TEST_P(coreidle_coreidle_c_p, pkg_pow0) {
 }
 
 /**
- * @test       setaff0
- * @brief      Test: setaffinity
- * @details    When passed a NULL idle_set pointer,<br>
- *             setaffinity returns FPGA_INVALID_PARAM.<br>
+ * @test       power_info0
+ * @brief      Test: get_fpga_power_info
+ * @details    When passed a NULL info pointer,<br>
+ *             get_fpga_power_info returns FPGA_INVALID_PARAM.<br>
  */
-TEST_P(coreidle_coreidle_c_p, setaff0) {
-  EXPECT_EQ(setaffinity(nullptr, 0, 0, 0), FPGA_INVALID_PARAM);
+TEST_P(coreidle_coreidle_c_p, power_info0) {
+  EXPECT_EQ(get_fpga_power_info(device_, nullptr), FPGA_INVALID_PARAM);
 }
 
-
 /**
- * @test       cpu_setaff0
- * @brief      Test: cpuset_setaffinity
- * @details    When passed an invalid socket parameter,<br>
- *             cpuset_setaffinity returns FPGA_NOT_SUPPORTED.<br>
+ * @test       power_info1
+ * @brief      Test: get_fpga_power_info
+ * @details    When passed a valid FME handle,<br>
+ *             get_fpga_power_info reads the power limits in watts<br>
+ *             and the socket id, and the fn returns FPGA_OK.<br>
  */
-TEST_P(coreidle_coreidle_c_p, cpu_setaff0) {
-  EXPECT_EQ(cpuset_setaffinity(2, 0, 0), FPGA_NOT_SUPPORTED);
+TEST_P(coreidle_coreidle_c_p, power_info1) {
+  struct fpga_power_info info;
+  ASSERT_EQ(get_fpga_power_info(device_, &info), FPGA_OK);
+  EXPECT_EQ(info.xeon_pwr_limit, (long double)(get_xeon_limit() / 8));
 }
 
 /**
- * @test       cpu_setaff3
- * @brief      Test: cpuset_setaffinity
- * @details    When called with valid parameters,<br>
- *             cpuset_setaffinity returns FPGA_OK.<br>
+ * @test       plan_add0
+ * @brief      Test: socket_plan_add_fpga
+ * @details    When passed a NULL plan or info pointer,<br>
+ *             socket_plan_add_fpga returns FPGA_INVALID_PARAM.<br>
  */
-TEST_P(coreidle_coreidle_c_p, cpu_setaff3) {
-  EXPECT_EQ(cpuset_setaffinity(0, 0, 0), FPGA_OK);
+TEST_P(coreidle_coreidle_c_p, plan_add0) {
+  struct socket_plan plan;
+  struct fpga_power_info info = { 0, 100, 90 };
+  socket_plan_init(&plan, 0);
+  EXPECT_EQ(socket_plan_add_fpga(nullptr, &info, 0), FPGA_INVALID_PARAM);
+  EXPECT_EQ(socket_plan_add_fpga(&plan, nullptr, 0), FPGA_INVALID_PARAM);
 }
 
-GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(coreidle_coreidle_c_p);
-INSTANTIATE_TEST_SUITE_P(coreidle_coreidle_c, coreidle_coreidle_c_p,
-                         ::testing::ValuesIn(test_platform::platforms({"skx-p"})));
-
-class coreidle_coreidle_c_mock_p : public coreidle_coreidle_c_p {
-  protected:
-    coreidle_coreidle_c_mock_p() {}
-};
+/**
+ * @test       plan_add1
+ * @brief      Test: socket_plan_add_fpga
+ * @details    When the gbs_power parameter is out of range,<br>
+ *             socket_plan_add_fpga leaves the plan unchanged<br>
+ *             and returns FPGA_INVALID_PARAM.<br>
+ */
+TEST_P(coreidle_coreidle_c_p, plan_add1) {
+  struct socket_plan plan;
+  struct fpga_power_info info = { 0, 100, 90 };
+  socket_plan_init(&plan, 0);
+  EXPECT_EQ(socket_plan_add_fpga(&plan, &info, 61), FPGA_INVALID_PARAM);
+  EXPECT_EQ(plan.num_fpgas, 0);
+  EXPECT_EQ(plan.gbs_power, 0);
+}
 
+/**
+ * @test       plan_add2
+ * @brief      Test: socket_plan_add_fpga
+ * @details    When several FPGAs are added to one socket plan,<br>
+ *             the FPGA limits and GBS + BBS power are summed,<br>
+ *             a zero gbs_power means the maximum for that FPGA,<br>
+ *             and the lowest XEON limit is kept.<br>
+ */
+TEST_P(coreidle_coreidle_c_p, plan_add2) {
+  struct socket_plan plan;
+  struct fpga_power_info info0 = { 1, 120, 90 };
+  struct fpga_power_info info1 = { 1, 100, 60 };
+  socket_plan_init(&plan, 1);
+  EXPECT_EQ(socket_plan_add_fpga(&plan, &info0, 25), FPGA_OK);
+  EXPECT_EQ(socket_plan_add_fpga(&plan, &info1, 0), FPGA_OK);
+  EXPECT_EQ(plan.socket_id, 1);
+  EXPECT_EQ(plan.num_fpgas, 2);
+  EXPECT_EQ(plan.xeon_pwr_limit, 100);
+  EXPECT_EQ(plan.fpga_pwr_limit, 150);
+  EXPECT_EQ(plan.gbs_power, 25 + 30 + 60);
+}
 
 /**
- * @test       setaff2
- * @brief      Test: setaffinity
- * @details    When pid <= 2 and sched_setaffinity fails,<br>
- *             setaffinity returns FGPA_NOT_SUPPORTED.<br>
+ * @test       plan0
+ * @brief      Test: plan_socket_core_idle
+ * @details    When the plan has no FPGA,<br>
+ *             plan_socket_core_idle returns FPGA_INVALID_PARAM.<br>
  */
-TEST_P(coreidle_coreidle_c_mock_p, setaff2) {
-  cpu_set_t idle;
-  CPU_ZERO(&idle);
-  system_->hijack_sched_setaffinity(-1, 0, "setaffinity");
-  EXPECT_EQ(setaffinity(&idle, 0, 2, 0), FPGA_NOT_SUPPORTED);
+TEST_P(coreidle_coreidle_c_p, plan0) {
+  struct socket_plan plan;
+  socket_plan_init(&plan, 0);
+  EXPECT_EQ(plan_socket_core_idle(nullptr), FPGA_INVALID_PARAM);
+  EXPECT_EQ(plan_socket_core_idle(&plan), FPGA_INVALID_PARAM);
 }
 
 /**
- * @test       setaff1
- * @brief      Test: setaffinity
- * @details    When pid > 2 and sched_setaffinity fails,<br>
- *             setaffinity returns FGPA_OK.<br>
+ * @test       apply0
+ * @brief      Test: apply_core_idle_plans
+ * @details    When passed a NULL plans pointer,<br>
+ *             apply_core_idle_plans returns FPGA_INVALID_PARAM.<br>
+ *             When no plan is a shared TDP plan,<br>
+ *             no affinity is changed and the fn returns FPGA_OK.<br>
  */
-TEST_P(coreidle_coreidle_c_mock_p, setaff1) {
-  cpu_set_t idle;
-  CPU_ZERO(&idle);
-  system_->hijack_sched_setaffinity(-1, 0, "setaffinity");
-  EXPECT_EQ(setaffinity(&idle, 0, 3, 0), FPGA_OK);
+TEST_P(coreidle_coreidle_c_p, apply0) {
+  struct socket_plan plan;
+  socket_plan_init(&plan, 0);
+  plan.result = FPGA_INVALID_PARAM;
+  EXPECT_EQ(apply_core_idle_plans(nullptr, 0), FPGA_INVALID_PARAM);
+  EXPECT_EQ(apply_core_idle_plans(&plan, 1), FPGA_OK);
 }
 
+GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(coreidle_coreidle_c_p);
+INSTANTIATE_TEST_SUITE_P(coreidle_coreidle_c, coreidle_coreidle_c_p,
+                         ::testing::ValuesIn(test_platform::platforms({"skx-p"})));
+
+class coreidle_coreidle_c_mock_p : public coreidle_coreidle_c_p {
+  protected:
+    coreidle_coreidle_c_mock_p() {}
+
+    // one socket of two CPUs, one of which stays online
+    void shared_tdp_plan(struct socket_plan *plan) {
+      socket_plan_init(plan, 0);
+      plan->result = FPGA_OK;
+      plan->topo.cpu_num = 2;
+      plan->topo.socket_num = 1;
+      plan->topo.split_point = 0;
+      plan->max_available_cpu = 1;
+    }
+};
+
 /**
- * @test       cpu_setaff1
- * @brief      Test: cpuset_setaffinity
+ * @test       apply1
+ * @brief      Test: apply_core_idle_plans
  * @details    When sched_setaffinity fails for pid 1,<br>
- *             cpuset_setaffinity returns FPGA_NOT_SUPPORTED.<br>
+ *             apply_core_idle_plans returns FPGA_NOT_SUPPORTED.<br>
  */
-TEST_P(coreidle_coreidle_c_mock_p, cpu_setaff1) {
-  system_->hijack_sched_setaffinity(-1, 0, "setaffinity");
-  EXPECT_EQ(cpuset_setaffinity(0, 0, 0), FPGA_NOT_SUPPORTED);
+TEST_P(coreidle_coreidle_c_mock_p, apply1) {
+  struct socket_plan plan;
+  shared_tdp_plan(&plan);
+  system_->hijack_sched_setaffinity(-1, 0, "set_plans_affinity");
+  EXPECT_EQ(apply_core_idle_plans(&plan, 1), FPGA_NOT_SUPPORTED);
 }
 
 /**
- * @test       cpu_setaff2
- * @brief      Test: cpuset_setaffinity
+ * @test       apply2
+ * @brief      Test: apply_core_idle_plans
  * @details    When sched_setaffinity fails for pid 2,<br>
- *             cpuset_setaffinity returns FPGA_NOT_SUPPORTED.<br>
+ *             apply_core_idle_plans returns FPGA_NOT_SUPPORTED.<br>
  */
-TEST_P(coreidle_coreidle_c_mock_p, cpu_setaff2) {
-  system_->hijack_sched_setaffinity(-1, 1, "setaffinity");
-  EXPECT_EQ(cpuset_setaffinity(0, 0, 0), FPGA_NOT_SUPPORTED);
+TEST_P(coreidle_coreidle_c_mock_p, apply2) {
+  struct socket_plan plan;
+  shared_tdp_plan(&plan);
+  system_->hijack_sched_setaffinity(-1, 1, "set_plans_affinity");
+  EXPECT_EQ(apply_core_idle_plans(&plan, 1), FPGA_NOT_SUPPORTED);
 }
 
 /**
@@ -0,0 +1,195 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <opae/fpga.h>
+
+extern "C" {
+
+#include "coreidle.h"
+
+}
+
+#include <config.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "coreidle_sandbox.h"
+
+using coreidle_sandbox::config;
+using coreidle_sandbox::sandbox;
+
+class coreidle_sandbox_c : public ::testing::Test {
+ protected:
+  virtual void SetUp() override {
+    // 2 sockets x 4 cores x 2 threads, shared TDP:
+    // xeon + fpga (150 + 90) > package limit (200).
+    cfg_.sockets = 2;
+    cfg_.cores_per_socket = 4;
+    cfg_.threads_per_core = 2;
+    cfg_.processes = 10;
+    cfg_.threads_per_process = 3;
+    cfg_.xeon_limit = 150;
+    cfg_.fpga_limit = 90;
+    cfg_.pkg_power_limit = 200;
+  }
+
+  virtual void TearDown() override {
+    sandbox_.reset();
+  }
+
+  fpga_result plan_socket(int socket, uint64_t gbs_power,
+                          struct socket_plan *plan) {
+    struct fpga_power_info info;
+    fpga_result res = get_fpga_power_info(sandbox_->fpga(socket), &info);
+    if (res != FPGA_OK)
+      return res;
+    socket_plan_init(plan, info.socket_id);
+    res = socket_plan_add_fpga(plan, &info, gbs_power);
+    if (res != FPGA_OK)
+      return res;
+    return plan_socket_core_idle(plan);
+  }
+
+  config cfg_;
+  std::unique_ptr<sandbox> sandbox_;
+};
+
+/**
+ * @test       topology0
+ * @brief      Test: get_socket_topology
+ * @details    On a synthetic 8 socket, 448 CPU system,<br>
+ *             get_socket_topology reads the counts from the MSRs<br>
+ *             and places socket 7 at CPU 392.<br>
+ */
+TEST_F(coreidle_sandbox_c, topology0) {
+  cfg_.sockets = 8;
+  cfg_.cores_per_socket = 28;
+  sandbox_.reset(new sandbox(cfg_));
+
+  struct socket_topology topo;
+  ASSERT_EQ(get_socket_topology(7, &topo), FPGA_OK);
+  EXPECT_EQ(topo.threads_num, 56);
+  EXPECT_EQ(topo.cores_num, 28);
+  EXPECT_EQ(topo.threads_per_core, 2);
+  EXPECT_EQ(topo.cpu_num, 448);
+  EXPECT_EQ(topo.socket_num, 8);
+  EXPECT_EQ(topo.split_point, 392);
+
+  EXPECT_EQ(get_socket_topology(8, &topo), FPGA_NOT_SUPPORTED);
+}
+
+/**
+ * @test       plan0
+ * @brief      Test: plan_socket_core_idle
+ * @details    On a shared TDP socket,<br>
+ *             plan_socket_core_idle keeps 2 * available / core power<br>
+ *             CPUs online: (uint64_t)(2 * 145 / 37.5) = 7.<br>
+ */
+TEST_F(coreidle_sandbox_c, plan0) {
+  sandbox_.reset(new sandbox(cfg_));
+
+  struct socket_plan plan;
+  ASSERT_EQ(plan_socket(1, 25, &plan), FPGA_OK);
+  EXPECT_EQ(plan.result, FPGA_OK);
+  EXPECT_EQ(plan.topo.split_point, 8);
+  EXPECT_EQ(plan.total_power, 200);
+  EXPECT_EQ(plan.max_available_cpu, 7);
+}
+
+/**
+ * @test       apply0
+ * @brief      Test: apply_core_idle_plans
+ * @details    When socket 1 is planned,<br>
+ *             apply_core_idle_plans restricts socket 1 CPUs of every<br>
+ *             task, thread included, to the planned online CPUs and<br>
+ *             leaves socket 0 CPUs untouched.<br>
+ */
+TEST_F(coreidle_sandbox_c, apply0) {
+  sandbox_.reset(new sandbox(cfg_));
+
+  struct socket_plan plan;
+  ASSERT_EQ(plan_socket(1, 25, &plan), FPGA_OK);
+  ASSERT_EQ(apply_core_idle_plans(&plan, 1), FPGA_OK);
+
+  // pid 1, pid 2 and 8 processes of 3 threads
+  ASSERT_EQ(sandbox_->num_tasks(), 26);
+  for (pid_t tid = 1; tid <= 26; ++tid) {
+    const cpu_set_t *set = sandbox_->affinity(tid);
+    ASSERT_NE(set, nullptr);
+    EXPECT_EQ(CPU_COUNT(set), 8 + 7) << "tid " << tid;
+    for (int cpu = 0; cpu < 15; ++cpu)
+      EXPECT_TRUE(CPU_ISSET(cpu, set)) << "tid " << tid << " cpu " << cpu;
+  }
+  EXPECT_EQ(sandbox_->setaffinity_calls(), 26);
+}
+
+/**
+ * @test       apply1
+ * @brief      Test: apply_core_idle_plans
+ * @details    When both sockets are planned together,<br>
+ *             apply_core_idle_plans idles CPUs on socket 0 as well.<br>
+ *             When no plan is a shared TDP plan,<br>
+ *             no affinity is changed.<br>
+ */
+TEST_F(coreidle_sandbox_c, apply1) {
+  sandbox_.reset(new sandbox(cfg_));
+
+  struct socket_plan plans[2];
+  ASSERT_EQ(plan_socket(0, 25, &plans[0]), FPGA_OK);
+  ASSERT_EQ(plan_socket(1, 25, &plans[1]), FPGA_OK);
+  ASSERT_EQ(apply_core_idle_plans(plans, 2), FPGA_OK);
+
+  const cpu_set_t *set = sandbox_->affinity(7);
+  ASSERT_NE(set, nullptr);
+  EXPECT_EQ(CPU_COUNT(set), 14);
+  EXPECT_FALSE(CPU_ISSET(7, set));
+  EXPECT_FALSE(CPU_ISSET(15, set));
+
+  sandbox_->reset_affinity();
+  plans[0].result = FPGA_INVALID_PARAM;
+  plans[1].result = FPGA_INVALID_PARAM;
+  ASSERT_EQ(apply_core_idle_plans(plans, 2), FPGA_OK);
+  EXPECT_EQ(sandbox_->setaffinity_calls(), 0);
+}
+
+/**
+ * @test       tdp_plus0
+ * @brief      Test: plan_socket_core_idle
+ * @details    When xeon + fpga limits fit in the package limit,<br>
+ *             (indicating TDP+ SKU),<br>
+ *             the plan result is FPGA_INVALID_PARAM.<br>
+ */
+TEST_F(coreidle_sandbox_c, tdp_plus0) {
+  cfg_.pkg_power_limit = 250;
+  sandbox_.reset(new sandbox(cfg_));
+
+  struct socket_plan plan;
+  ASSERT_EQ(plan_socket(0, 25, &plan), FPGA_OK);
+  EXPECT_EQ(plan.result, FPGA_INVALID_PARAM);
+}
@@ -0,0 +1,213 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <opae/fpga.h>
+
+extern "C" {
+
+#include <uuid/uuid.h>
+#include "gbs_metadata.h"
+
+}
+
+#include <config.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "gtest/gtest.h"
+
+namespace {
+
+const char *interface_uuid = "01234567-89ab-cdef-0123-456789abcdef";
+
+std::string metadata_v1(int power)
+{
+  return std::string("{\"version\": 1, \"afu-image\": {\"power\": ") +
+         std::to_string(power) +
+         ", \"interface-uuid\": \"" + interface_uuid + "\", "
+         "\"magic-no\": 488605312, \"accelerator-clusters\": "
+         "[{\"total-contexts\": 1, \"name\": \"nlb\", "
+         "\"accelerator-type-uuid\": \"d8424dc4-a4a3-c413-f89e-433683f9040b\"}]}, "
+         "\"platform-name\": \"\"}";
+}
+
+}
+
+class gbs_metadata_c : public ::testing::Test {
+ protected:
+  gbs_metadata_c() {}
+
+  virtual void SetUp() override {
+    strcpy(tmp_gbs_, "tmp-XXXXXX.gbs");
+    close(mkstemps(tmp_gbs_, 4));
+  }
+
+  virtual void TearDown() override {
+    unlink(tmp_gbs_);
+  }
+
+  void write_gbs(const std::string &mdata, size_t payload_size,
+                 uint32_t mdata_len, bool valid_guid = true) {
+    fpga_guid guid;
+    uuid_parse(GBS_METADATA_GUID, guid);
+    if (!valid_guid)
+      guid[0] ^= 0xff;
+
+    std::ofstream gbs(tmp_gbs_, std::ios::out | std::ios::binary);
+    gbs.write(reinterpret_cast<const char *>(guid), sizeof(guid));
+    gbs.write(reinterpret_cast<const char *>(&mdata_len), sizeof(mdata_len));
+    gbs.write(mdata.c_str(), mdata.size());
+    std::vector<char> payload(payload_size, 0x5a);
+    gbs.write(payload.data(), payload.size());
+  }
+
+  void write_gbs(const std::string &mdata, size_t payload_size = 4096) {
+    write_gbs(mdata, payload_size, mdata.size());
+  }
+
+  char tmp_gbs_[20];
+};
+
+/**
+ * @test       read_null
+ * @brief      Test: read_gbs_metadata
+ * @details    When given a NULL filename or metadata pointer,<br>
+ *             read_gbs_metadata returns FPGA_INVALID_PARAM.<br>
+ */
+TEST_F(gbs_metadata_c, read_null) {
+  struct gbs_metadata md = GBS_METADATA_INITIALIZER;
+  EXPECT_EQ(read_gbs_metadata(NULL, &md), FPGA_INVALID_PARAM);
+  EXPECT_EQ(read_gbs_metadata(tmp_gbs_, NULL), FPGA_INVALID_PARAM);
+}
+
+/**
+ * @test       read_missing
+ * @brief      Test: read_gbs_metadata
+ * @details    When the file does not exist,<br>
+ *             read_gbs_metadata returns FPGA_INVALID_PARAM.<br>
+ */
+TEST_F(gbs_metadata_c, read_missing) {
+  struct gbs_metadata md = GBS_METADATA_INITIALIZER;
+  EXPECT_EQ(read_gbs_metadata("doesnt-exist.gbs", &md), FPGA_INVALID_PARAM);
+}
+
+/**
+ * @test       read_short
+ * @brief      Test: read_gbs_metadata
+ * @details    When the file is shorter than a GBS header,<br>
+ *             read_gbs_metadata returns FPGA_INVALID_PARAM.<br>
+ */
+TEST_F(gbs_metadata_c, read_short) {
+  struct gbs_metadata md = GBS_METADATA_INITIALIZER;
+  EXPECT_EQ(read_gbs_metadata(tmp_gbs_, &md), FPGA_INVALID_PARAM);
+}
+
+/**
+ * @test       read_bad_guid
+ * @brief      Test: read_gbs_metadata
+ * @details    When the file does not start with the GBS GUID,<br>
+ *             read_gbs_metadata returns FPGA_INVALID_PARAM.<br>
+ */
+TEST_F(gbs_metadata_c, read_bad_guid) {
+  std::string mdata = metadata_v1(50);
+  write_gbs(mdata, 4096, mdata.size(), false);
+  struct gbs_metadata md = GBS_METADATA_INITIALIZER;
+  EXPECT_EQ(read_gbs_metadata(tmp_gbs_, &md), FPGA_INVALID_PARAM);
+}
+
+/**
+ * @test       read_bad_length
+ * @brief      Test: read_gbs_metadata
+ * @details    When the metadata length runs past the end of file,<br>
+ *             read_gbs_metadata returns FPGA_INVALID_PARAM.<br>
+ */
+TEST_F(gbs_metadata_c, read_bad_length) {
+  std::string mdata = metadata_v1(50);
+  write_gbs(mdata, 0, mdata.size() + 1);
+  struct gbs_metadata md = GBS_METADATA_INITIALIZER;
+  EXPECT_EQ(read_gbs_metadata(tmp_gbs_, &md), FPGA_INVALID_PARAM);
+}
+
+/**
+ * @test       read_v1
+ * @brief      Test: read_gbs_metadata
+ * @details    When given a valid GBS file,<br>
+ *             read_gbs_metadata fills in the version, power<br>
+ *             and PR interface id, and returns FPGA_OK.<br>
+ */
+TEST_F(gbs_metadata_c, read_v1) {
+  write_gbs(metadata_v1(50));
+  struct gbs_metadata md = GBS_METADATA_INITIALIZER;
+  ASSERT_EQ(read_gbs_metadata(tmp_gbs_, &md), FPGA_OK);
+  EXPECT_EQ(md.version, 1);
+  EXPECT_EQ(md.power, 50);
+
+  fpga_guid expected;
+  ASSERT_EQ(uuid_parse(interface_uuid, expected), 0);
+  EXPECT_EQ(uuid_compare(md.pr_interface_id, expected), 0);
+}
+
+/**
+ * @test       parse_malformed
+ * @brief      Test: parse_gbs_metadata
+ * @details    When the metadata is not valid JSON,<br>
+ *             parse_gbs_metadata returns FPGA_EXCEPTION.<br>
+ */
+TEST_F(gbs_metadata_c, parse_malformed) {
+  const char json[] = "{\"version\": 1, \"afu-image\": {";
+  struct gbs_metadata md = GBS_METADATA_INITIALIZER;
+  EXPECT_EQ(parse_gbs_metadata(json, strlen(json), &md), FPGA_EXCEPTION);
+}
+
+/**
+ * @test       parse_no_interface
+ * @brief      Test: parse_gbs_metadata
+ * @details    When the afu-image has no interface-uuid,<br>
+ *             parse_gbs_metadata returns FPGA_EXCEPTION.<br>
+ */
+TEST_F(gbs_metadata_c, parse_no_interface) {
+  const char json[] = "{\"version\": 1, \"afu-image\": {\"power\": 10}}";
+  struct gbs_metadata md = GBS_METADATA_INITIALIZER;
+  EXPECT_EQ(parse_gbs_metadata(json, strlen(json), &md), FPGA_EXCEPTION);
+}
+
+/**
+ * @test       parse_unterminated
+ * @brief      Test: parse_gbs_metadata
+ * @details    The metadata buffer is bounded by its length,<br>
+ *             not by a NUL terminator.<br>
+ */
+TEST_F(gbs_metadata_c, parse_unterminated) {
+  std::string json = metadata_v1(25) + "garbage";
+  struct gbs_metadata md = GBS_METADATA_INITIALIZER;
+  EXPECT_EQ(parse_gbs_metadata(json.c_str(), json.size() - 7, &md), FPGA_OK);
+  EXPECT_EQ(md.power, 25);
+}
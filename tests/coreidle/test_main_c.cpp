@@ -26,13 +26,25 @@
 
 #include <opae/fpga.h>
 #include <linux/limits.h>
-#include <libbitstream/bitstream.h>
+#include "gbs_metadata.h"
 
 extern "C" {
 
 #include <json-c/json.h>
 #include <uuid/uuid.h>
 
+#define MAX_CARD_GBS 8
+
+struct CardGbs
+{
+        int      segment;
+        int      bus;
+        int      device;
+        int      function;
+        char     filename[PATH_MAX];
+        struct gbs_metadata gbs;
+};
+
 struct  CoreIdleCommandLine
 {
         int      segment;
@@ -41,7 +53,10 @@ struct  CoreIdleCommandLine
         int      function;
         int      socket;
         char     filename[PATH_MAX];
-	opae_bitstream_info bitstr;
+        struct gbs_metadata gbs;
+        int      dry_run;
+        int      num_cards;
+        struct CardGbs cards[MAX_CARD_GBS];
 };
 extern struct CoreIdleCommandLine coreidleCmdLine;
 
@@ -55,6 +70,8 @@ int ParseCmds(struct CoreIdleCommandLine *coreidleCmdLine,
 	      int argc,
 	      char *argv[]);
 
+int parse_card_gbs(const char *arg, struct CardGbs *card);
+
 }
 
 #include <sys/types.h>
@@ -296,7 +313,7 @@ TEST_P(coreidle_main_c_p, parse1) {
                    ten, eleven, twelve };
 
   struct CoreIdleCommandLine cmd =
-  { -1, -1, -1, -1, -1, {0,}, OPAE_BITSTREAM_INFO_INITIALIZER };
+  { -1, -1, -1, -1, -1, {0,}, GBS_METADATA_INITIALIZER, 0, 0, { { 0, } } };
   EXPECT_EQ(ParseCmds(&cmd, 13, argv), 0);
 
   EXPECT_EQ(cmd.segment, 0x1234);
@@ -307,6 +324,84 @@ TEST_P(coreidle_main_c_p, parse1) {
   EXPECT_STREQ(cmd.filename, "file.gbs");
 }
 
+/**
+ * @test       parse_card0
+ * @brief      Test: ParseCmds
+ * @details    When given --card-gbs options and --dry-run,<br>
+ *             ParseCmds records each card's PCIe address and GBS,<br>
+ *             sets dry_run and returns 0.<br>
+ */
+TEST_P(coreidle_main_c_p, parse_card0) {
+  const char *argv[] = { "coreidle",
+                         "--card-gbs", "0001:5e:00.0=a.gbs",
+                         "-c", "be:00.1=b.gbs",
+                         "-n" };
+
+  struct CoreIdleCommandLine cmd =
+  { -1, -1, -1, -1, -1, {0,}, GBS_METADATA_INITIALIZER, 0, 0, { { 0, } } };
+  EXPECT_EQ(ParseCmds(&cmd, 6, (char **)argv), 0);
+
+  EXPECT_EQ(cmd.dry_run, 1);
+  ASSERT_EQ(cmd.num_cards, 2);
+  EXPECT_EQ(cmd.cards[0].segment, 1);
+  EXPECT_EQ(cmd.cards[0].bus, 0x5e);
+  EXPECT_EQ(cmd.cards[0].device, 0);
+  EXPECT_EQ(cmd.cards[0].function, 0);
+  EXPECT_STREQ(cmd.cards[0].filename, "a.gbs");
+  EXPECT_EQ(cmd.cards[1].segment, 0);
+  EXPECT_EQ(cmd.cards[1].bus, 0xbe);
+  EXPECT_EQ(cmd.cards[1].function, 1);
+  EXPECT_STREQ(cmd.cards[1].filename, "b.gbs");
+}
+
+/**
+ * @test       parse_card1
+ * @brief      Test: parse_card_gbs
+ * @details    When given a malformed card assignment,<br>
+ *             parse_card_gbs returns -1.<br>
+ */
+TEST_P(coreidle_main_c_p, parse_card1) {
+  struct CardGbs card;
+  EXPECT_EQ(parse_card_gbs("5e:00.0", &card), -1);
+  EXPECT_EQ(parse_card_gbs("5e:00.0=", &card), -1);
+  EXPECT_EQ(parse_card_gbs("5e:00=a.gbs", &card), -1);
+  EXPECT_EQ(parse_card_gbs("5e:20.0=a.gbs", &card), -1);
+  EXPECT_EQ(parse_card_gbs("a.gbs", &card), -1);
+}
+
+/**
+ * @test       parse_gbs_empty
+ * @brief      Test: ParseCmds
+ * @details    When given an empty --gbs,<br>
+ *             ParseCmds returns -1 rather than running as if<br>
+ *             no --gbs were given.<br>
+ */
+TEST_P(coreidle_main_c_p, parse_gbs_empty) {
+  struct CoreIdleCommandLine cmd;
+  memset(&cmd, 0, sizeof(cmd));
+  char zero[20];
+  char one[20];
+  char two[20];
+  strcpy(zero, "coreidle");
+  strcpy(one, "-G");
+  strcpy(two, "");
+  char *argv[] = { zero, one, two };
+  EXPECT_EQ(ParseCmds(&cmd, 3, argv), -1);
+}
+
+/**
+ * @test       main_dry_run
+ * @brief      Test: coreidle_main
+ * @details    When given a valid GBS and --dry-run,<br>
+ *             coreidle_main plans every socket without applying,<br>
+ *             and returns the TDP+ status as main0 does.<br>
+ */
+TEST_P(coreidle_main_c_p, main_dry_run) {
+  const char *argv[] = { "coreidle", "-G", tmp_gbs_, "--dry-run" };
+
+  EXPECT_EQ(coreidle_main(4, (char **)argv), 1);
+}
+
 /**
  * @test       parse_err0
  * @brief      Test: ParseCmds
@@ -0,0 +1,207 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "fpgalocality.h"
+#include "fpgalocality_int.h"
+
+#include <array>
+#include <cstring>
+#include <string>
+
+#include <opae/fpga.h>
+
+#include "gtest/gtest.h"
+#include "mock/test_system.h"
+
+using namespace opae::testing;
+
+class fpgalocality_c_p : public ::testing::TestWithParam<std::string> {
+ protected:
+  fpgalocality_c_p() : tokens_{{nullptr, nullptr}} {}
+
+  virtual void SetUp() override {
+    ASSERT_TRUE(test_platform::exists(GetParam()));
+    platform_ = test_platform::get(GetParam());
+    system_ = test_system::instance();
+    system_->initialize();
+    system_->prepare_syfs(platform_);
+
+    ASSERT_EQ(fpgaInitialize(NULL), FPGA_OK);
+    ASSERT_EQ(fpgaGetProperties(nullptr, &filter_), FPGA_OK);
+    ASSERT_EQ(fpgaPropertiesSetObjectType(filter_, FPGA_DEVICE), FPGA_OK);
+    num_matches_ = 0;
+    ASSERT_EQ(fpgaEnumerate(&filter_, 1, tokens_.data(), tokens_.size(),
+                            &num_matches_), FPGA_OK);
+    EXPECT_GT(num_matches_, 0);
+
+    // Two physical cores with two threads each, CPUs 0-3 local,
+    // CPU 5 local but parked.
+    memset(&loc_, 0, sizeof(loc_));
+    memset(loc_.core, 0xff, sizeof(loc_.core));
+    loc_.core[0] = 0; loc_.core[2] = 0;
+    loc_.core[1] = 1; loc_.core[3] = 1;
+    loc_.core[4] = 4; loc_.core[5] = 5;
+    for (int cpu : { 0, 1, 2, 3, 5 })
+      CPU_SET(cpu, &loc_.local_cpus);
+    CPU_SET(5, &loc_.parked_cpus);
+  }
+
+  virtual void TearDown() override {
+    EXPECT_EQ(fpgaDestroyProperties(&filter_), FPGA_OK);
+    for (auto &t : tokens_) {
+      if (t) {
+        EXPECT_EQ(fpgaDestroyToken(&t), FPGA_OK);
+        t = nullptr;
+      }
+    }
+    fpgaFinalize();
+    system_->finalize();
+  }
+
+  std::array<fpga_token, 2> tokens_;
+  fpga_properties filter_;
+  uint32_t num_matches_;
+  fpga_locality loc_;
+  test_platform platform_;
+  test_system *system_;
+};
+
+/**
+ * @test       get0
+ * @brief      Test: fpgaLocalityGet, fpgaLocalityGetFromHandle
+ * @details    When passed a NULL token, handle or locality,<br>
+ *             the fns return FPGA_INVALID_PARAM.<br>
+ */
+TEST_P(fpgalocality_c_p, get0) {
+  fpga_locality loc;
+  EXPECT_EQ(fpgaLocalityGet(nullptr, &loc), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaLocalityGet(tokens_[0], nullptr), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaLocalityGetFromHandle(nullptr, &loc), FPGA_INVALID_PARAM);
+}
+
+/**
+ * @test       cpulist0
+ * @brief      Test: fpga_locality_parse_cpulist
+ * @details    When given a list of CPUs and CPU ranges,<br>
+ *             fpga_locality_parse_cpulist sets exactly those CPUs.<br>
+ */
+TEST_P(fpgalocality_c_p, cpulist0) {
+  cpu_set_t cpus;
+  ASSERT_EQ(fpga_locality_parse_cpulist("0-2,8,10-11", &cpus), FPGA_OK);
+  EXPECT_EQ(CPU_COUNT(&cpus), 6);
+  EXPECT_TRUE(CPU_ISSET(0, &cpus));
+  EXPECT_TRUE(CPU_ISSET(2, &cpus));
+  EXPECT_FALSE(CPU_ISSET(3, &cpus));
+  EXPECT_TRUE(CPU_ISSET(8, &cpus));
+  EXPECT_TRUE(CPU_ISSET(11, &cpus));
+
+  ASSERT_EQ(fpga_locality_parse_cpulist("", &cpus), FPGA_OK);
+  EXPECT_EQ(CPU_COUNT(&cpus), 0);
+}
+
+/**
+ * @test       cpulist1
+ * @brief      Test: fpga_locality_parse_cpulist
+ * @details    When given a malformed or out of range list,<br>
+ *             fpga_locality_parse_cpulist returns FPGA_EXCEPTION.<br>
+ */
+TEST_P(fpgalocality_c_p, cpulist1) {
+  cpu_set_t cpus;
+  EXPECT_EQ(fpga_locality_parse_cpulist(nullptr, &cpus), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpga_locality_parse_cpulist("3-1", &cpus), FPGA_EXCEPTION);
+  EXPECT_EQ(fpga_locality_parse_cpulist("1,x", &cpus), FPGA_EXCEPTION);
+  EXPECT_EQ(fpga_locality_parse_cpulist("-1", &cpus), FPGA_EXCEPTION);
+  EXPECT_EQ(fpga_locality_parse_cpulist("0-99999", &cpus), FPGA_EXCEPTION);
+}
+
+/**
+ * @test       siblings0
+ * @brief      Test: fpgaLocalityGetSiblings
+ * @details    When given an online CPU,<br>
+ *             fpgaLocalityGetSiblings returns every thread of its core.<br>
+ *             When given an offline CPU, the fn returns FPGA_INVALID_PARAM.<br>
+ */
+TEST_P(fpgalocality_c_p, siblings0) {
+  cpu_set_t siblings;
+  ASSERT_EQ(fpgaLocalityGetSiblings(&loc_, 2, &siblings), FPGA_OK);
+  EXPECT_EQ(CPU_COUNT(&siblings), 2);
+  EXPECT_TRUE(CPU_ISSET(0, &siblings));
+  EXPECT_TRUE(CPU_ISSET(2, &siblings));
+  EXPECT_EQ(fpgaLocalityGetSiblings(&loc_, 6, &siblings), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaLocalityGetSiblings(&loc_, -1, &siblings), FPGA_INVALID_PARAM);
+}
+
+/**
+ * @test       placement0
+ * @brief      Test: fpgaLocalityGetPlacement
+ * @details    fpgaLocalityGetPlacement lists one CPU per physical core,<br>
+ *             then the remaining SMT siblings, and skips parked<br>
+ *             and remote CPUs.<br>
+ */
+TEST_P(fpgalocality_c_p, placement0) {
+  int cpus[FPGA_LOCALITY_MAX_CPUS];
+  size_t num_cpus = 0;
+  size_t num_cores = 0;
+  ASSERT_EQ(fpgaLocalityGetPlacement(&loc_, cpus, &num_cpus, &num_cores),
+            FPGA_OK);
+  ASSERT_EQ(num_cpus, 4);
+  EXPECT_EQ(num_cores, 2);
+  EXPECT_EQ(cpus[0], 0);
+  EXPECT_EQ(cpus[1], 1);
+  EXPECT_EQ(cpus[2], 2);
+  EXPECT_EQ(cpus[3], 3);
+}
+
+/**
+ * @test       placement1
+ * @brief      Test: fpgaLocalityGetPlacement
+ * @details    When every local CPU is parked,<br>
+ *             fpgaLocalityGetPlacement returns FPGA_NOT_FOUND.<br>
+ */
+TEST_P(fpgalocality_c_p, placement1) {
+  int cpus[FPGA_LOCALITY_MAX_CPUS];
+  size_t num_cpus = 0;
+  loc_.parked_cpus = loc_.local_cpus;
+  EXPECT_EQ(fpgaLocalityGetPlacement(&loc_, cpus, &num_cpus, nullptr),
+            FPGA_NOT_FOUND);
+  EXPECT_EQ(num_cpus, 0);
+  EXPECT_EQ(fpgaLocalityPinThread(&loc_, pthread_self(), 0), FPGA_NOT_FOUND);
+}
+
+/**
+ * @test       pin0
+ * @brief      Test: fpgaLocalityPinThreads
+ * @details    When passed a NULL thread array,<br>
+ *             fpgaLocalityPinThreads returns FPGA_INVALID_PARAM.<br>
+ */
+TEST_P(fpgalocality_c_p, pin0) {
+  EXPECT_EQ(fpgaLocalityPinThreads(&loc_, nullptr, 1), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaLocalityPinThreads(nullptr, nullptr, 0), FPGA_INVALID_PARAM);
+}
+
+GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(fpgalocality_c_p);
+INSTANTIATE_TEST_SUITE_P(fpgalocality_c, fpgalocality_c_p,
+                         ::testing::ValuesIn(test_platform::platforms({"skx-p"})));
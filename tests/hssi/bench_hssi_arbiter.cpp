@@ -0,0 +1,247 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Share one modelled HSSI controller between several clients, each with
+// its own hssi_przone, the way hssi_config, a monitoring agent and a
+// dump would share an FME:
+//
+//  - bulk threads write and read back MDIO registers of their own port
+//  - a monitor thread reads a retimer byte over I2C and times each read
+//
+// The run is repeated without an arbiter (the sequences interleave and
+// results go wrong), with the monitor queued like any bulk client, and
+// with the monitor at monitor priority. Last, a forked process holds
+// the flock of a scratch file to show the cross-process exclusion.
+//
+// usage: bench_hssi_arbiter [bulk-threads] [operations]
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "arbiter.h"
+#include "hssi_model.h"
+#include "hssi_msg.h"
+#include "hssi_przone.h"
+#include "i2c.h"
+#include "mdio.h"
+
+using namespace intel::fpga;
+using namespace intel::fpga::hssi;
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+enum class mode { unarbitrated, fifo, prioritized };
+
+struct result {
+  uint64_t wrong;
+  uint64_t failed;
+  double monitor_mean_usec;
+  double monitor_max_usec;
+  double seconds;
+};
+
+model_latency bench_latency() {
+  // 2 usec acks, 20 usec I2C bytes, 5 usec MDIO commands
+  model_latency latency = {2000, 1000, 20000, 20000, 5000};
+  return latency;
+}
+
+hssi_przone::ptr_t client(const hssi_model::ptr_t& model,
+                          const arbiter::ptr_t& arb, arbiter::priority p) {
+  hssi_przone::ptr_t przone(
+      new hssi_przone(model, model->ctrl_offset(), model->stat_offset()));
+  if (arb) przone->set_arbiter(arb, p);
+  return przone;
+}
+
+uint64_t bus_timeouts(i2c& bus) {
+  const poll_stats& stats = bus.get_poller().stats();
+  return stats.timeouts + stats.errors;
+}
+
+double usec(clock_type::duration d) {
+  return std::chrono::duration<double, std::micro>(d).count();
+}
+
+result run(mode m, size_t bulk_threads, size_t ops) {
+  hssi_model::ptr_t model(new hssi_model(bench_latency(), 4));
+  arbiter::ptr_t arb;
+  if (m != mode::unarbitrated) arb = std::make_shared<arbiter>();
+
+  std::atomic<uint64_t> wrong(0);
+  std::atomic<uint64_t> failed(0);
+  std::atomic<size_t> bulk_running(bulk_threads);
+  std::vector<std::thread> threads;
+  auto begin = clock_type::now();
+
+  for (size_t t = 0; t < bulk_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      mdio phy(client(model, arb, arbiter::priority::bulk));
+      for (size_t i = 0; i < ops; ++i) {
+        uint32_t value = 0;
+        uint32_t expected = static_cast<uint32_t>(t << 16 | i);
+        if (!phy.write(1, static_cast<uint8_t>(t), 0x10, expected) ||
+            !phy.read(1, static_cast<uint8_t>(t), 0x10, value)) {
+          ++failed;
+        } else if (value != expected) {
+          ++wrong;
+        }
+      }
+      --bulk_running;
+    });
+  }
+
+  // the monitor runs for as long as the bulk clients do
+  std::vector<double> latencies;
+  i2c bus(client(model, arb,
+                 m == mode::prioritized ? arbiter::priority::monitor
+                                        : arbiter::priority::bulk));
+  // with no channel selected, the retimer answers from its shared page
+  uint8_t expected = 0x5A;
+  model->i2c_poke(controller::i2c_instance_retimer, 0x30,
+                  hssi_model::retimer_channels * 256 + 0x20, expected);
+  while (bulk_running) {
+    uint8_t byte = 0;
+    // i2c::read does not fail on a timed out byte; the poller counts it
+    uint64_t timeouts = bus_timeouts(bus);
+    auto start = clock_type::now();
+    bool ok = bus.read(controller::i2c_instance_retimer, 0x30, 0x20, &byte, 1);
+    latencies.push_back(usec(clock_type::now() - start));
+    if (!ok || bus_timeouts(bus) != timeouts) {
+      ++failed;
+    } else if (byte != expected) {
+      ++wrong;
+    }
+  }
+  for (auto& t : threads) t.join();
+
+  result r;
+  r.seconds = usec(clock_type::now() - begin) / 1e6;
+  r.wrong = wrong;
+  r.failed = failed;
+  r.monitor_mean_usec = 0.0;
+  r.monitor_max_usec = 0.0;
+  for (double l : latencies) {
+    r.monitor_mean_usec += l;
+    r.monitor_max_usec = std::max(r.monitor_max_usec, l);
+  }
+  if (!latencies.empty()) r.monitor_mean_usec /= latencies.size();
+  return r;
+}
+
+void print(const char* name, const result& r) {
+  std::printf("%-22s %7.3f sec, monitor read %8.1f usec mean %9.1f max, "
+              "%llu failed, %llu wrong\n",
+              name, r.seconds, r.monitor_mean_usec, r.monitor_max_usec,
+              static_cast<unsigned long long>(r.failed),
+              static_cast<unsigned long long>(r.wrong));
+}
+
+// The parent waits for the flock a child holds for hold_msec
+bool cross_process(uint32_t hold_msec) {
+  char path[] = "/tmp/bench_hssi_arbiter.XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    std::perror("mkstemp");
+    return false;
+  }
+  close(fd);
+
+  int ready[2];
+  if (pipe(ready) != 0) {
+    std::perror("pipe");
+    unlink(path);
+    return false;
+  }
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    arbiter::ptr_t held = arbiter::for_resource(path);
+    arbiter::lease lease(held);
+    char c = held->cross_process() ? 1 : 0;
+    if (write(ready[1], &c, 1) != 1) _exit(EXIT_FAILURE);
+    std::this_thread::sleep_for(std::chrono::milliseconds(hold_msec));
+    _exit(EXIT_SUCCESS);
+  }
+
+  char c = 0;
+  bool ok = pid > 0 && read(ready[0], &c, 1) == 1 && c;
+  double waited = 0.0;
+  if (ok) {
+    arbiter::ptr_t waiting = arbiter::for_resource(path);
+    ok = !waiting->try_lock();
+    auto start = clock_type::now();
+    arbiter::lease lease(waiting);
+    waited = usec(clock_type::now() - start) / 1000.0;
+    ok = ok && waited > 0.0;
+  }
+  if (pid > 0) waitpid(pid, nullptr, 0);
+  close(ready[0]);
+  close(ready[1]);
+  unlink(path);
+
+  std::printf("cross-process          waited %.1f msec for a %u msec holder "
+              "(%s)\n", waited, hold_msec, ok ? "excluded" : "NOT excluded");
+  return ok;
+}
+
+}  // end of anonymous namespace
+
+int main(int argc, char* argv[]) {
+  size_t bulk_threads = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 3;
+  size_t ops = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : 200;
+
+  // more pollers than cores: yield instead of spinning
+  poll_config poll;
+  poller::parse("yield", poll);
+  poller::set_defaults(poll);
+
+  std::printf("%zu bulk clients x %zu MDIO write/read, 1 I2C monitor\n",
+              bulk_threads, ops);
+  result none = run(mode::unarbitrated, bulk_threads, ops);
+  print("no arbiter", none);
+  result fifo = run(mode::fifo, bulk_threads, ops);
+  print("arbiter, monitor bulk", fifo);
+  result prio = run(mode::prioritized, bulk_threads, ops);
+  print("arbiter, monitor prio", prio);
+  bool excluded = cross_process(20);
+
+  if (fifo.wrong || prio.wrong || !excluded) {
+    std::fprintf(stderr, "an arbitrated client saw another's results\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Look up the HSSI feature at the end of a long feature list with
+// dfh_list::find, which walks the list over MMIO on every call, and with
+// a dfh_index built once. The list mixes DFHv0 features and DFHv1
+// features with parameter blocks and several instances of one id.
+//
+// usage: bench_hssi_dfh [features] [lookups]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+#include "dfh.h"
+#include "dfh_index.h"
+#include "hssi.h"
+
+using namespace intel::fpga;
+
+namespace {
+
+const uint64_t dfh_priv = 0x3;
+const uint32_t feature_size = 0x1000;
+const uint32_t v1_id = 0x20;
+
+// A register space holding a feature list
+class dfh_mmio : public mmio {
+ public:
+  explicit dfh_mmio(size_t features) : reads_(0) {
+    for (size_t i = 0; i < features; ++i) {
+      uint32_t offset = static_cast<uint32_t>(i) * feature_size;
+      bool last = i + 1 == features;
+      uint64_t next = last ? 0 : feature_size;
+      uint64_t header = dfh_priv << 60 | static_cast<uint64_t>(last) << 40 |
+                        next << 16;
+      if (last) {
+        regs_[offset] = header | hssi_dfh_id;
+      } else if (i % 2) {
+        // DFHv1, registers at 0x100, two parameter blocks
+        regs_[offset] = header | 1UL << 52 | v1_id;
+        regs_[offset + 0x18] = 0x100;
+        regs_[offset + 0x20] = 0x80UL << 32 | 1UL << 31 | i;
+        regs_[offset + 0x28] = 2UL << 35 | 0x1;  // id 1, 8 bytes of data
+        regs_[offset + 0x38] = 3UL << 35 | 1UL << 32 | 0x2;
+      } else {
+        regs_[offset] = header | 0x10;
+      }
+    }
+  }
+
+  bool write_mmio32(uint32_t, uint32_t) override { return true; }
+  bool write_mmio64(uint32_t, uint64_t) override { return true; }
+  bool read_mmio32(uint32_t, uint32_t& value) override {
+    value = 0;
+    return true;
+  }
+  bool read_mmio64(uint32_t offset, uint64_t& value) override {
+    ++reads_;
+    auto it = regs_.find(offset);
+    value = it == regs_.end() ? 0 : it->second;
+    return true;
+  }
+  uint8_t* mmio_pointer(uint32_t) override { return nullptr; }
+
+  uint64_t reads() const { return reads_; }
+
+ private:
+  std::map<uint32_t, uint64_t> regs_;
+  uint64_t reads_;
+};
+
+double usec_since(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - begin).count();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  size_t features = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 64;
+  size_t lookups = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : 10000;
+  if (features < 2) features = 2;
+
+  std::shared_ptr<dfh_mmio> io(new dfh_mmio(features));
+  uint32_t expected = static_cast<uint32_t>(features - 1) * feature_size;
+
+  auto begin = std::chrono::steady_clock::now();
+  uint32_t found = 0;
+  for (size_t i = 0; i < lookups; ++i) {
+    dfh_list list(io);
+    auto it = list.find(hssi_dfh_id, hssi_dfh_rev, dfh_priv);
+    found = it != list.end() ? it->offset() : 0;
+  }
+  double list_usec = usec_since(begin);
+  uint64_t list_reads = io->reads();
+  if (found != expected) {
+    std::fprintf(stderr, "dfh_list found 0x%x, not 0x%x\n", found, expected);
+    return EXIT_FAILURE;
+  }
+
+  begin = std::chrono::steady_clock::now();
+  auto index = dfh_index::build(io);
+  double build_usec = usec_since(begin);
+  uint64_t build_reads = io->reads() - list_reads;
+
+  begin = std::chrono::steady_clock::now();
+  const dfh_feature* hssi = nullptr;
+  for (size_t i = 0; i < lookups; ++i) {
+    hssi = index->find(hssi_dfh_id, dfh_priv);
+  }
+  double index_usec = usec_since(begin);
+  if (!hssi || hssi->offset != expected || index->truncated()) {
+    std::fprintf(stderr, "dfh_index did not find the HSSI feature\n");
+    return EXIT_FAILURE;
+  }
+
+  // every DFHv1 instance with its parameters
+  size_t v1 = index->count(v1_id, dfh_priv);
+  for (size_t i = 0; i < v1; ++i) {
+    const dfh_feature* f = index->find(v1_id, dfh_priv, i);
+    const dfh_param* p = index->find_param(*f, 2);
+    if (f->instance != i || f->csr_offset != f->offset + 0x100 ||
+        f->params != 2 || !p || p->size != 16) {
+      std::fprintf(stderr, "DFHv1 feature %zu is wrong\n", i);
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::printf("%zu features (%zu DFHv1), %zu lookups\n", features, v1,
+              lookups);
+  std::printf("  dfh_list::find  %10.3f usec/lookup, %6.1f reads/lookup\n",
+              list_usec / lookups, static_cast<double>(list_reads) / lookups);
+  std::printf("  dfh_index build %10.3f usec, %llu reads\n", build_usec,
+              static_cast<unsigned long long>(build_reads));
+  std::printf("  dfh_index::find %10.3f usec/lookup, 0 reads/lookup\n",
+              index_usec / lookups);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Count the PR zone accesses needed to read the four port MAC addresses
+// from the board EEPROM: one single-byte I2C read per MAC byte (the
+// former loopback::read_mac_address) versus a burst-read image of the
+// MAC window, and a second run served from the image's cache file.
+//
+// usage: bench_hssi_eeprom [burst-bytes]
+
+#include <unistd.h>
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "eeprom_image.h"
+#include "i2c.h"
+#include "przone.h"
+
+using namespace intel::fpga;
+using namespace intel::fpga::hssi;
+
+// I2C controller that never has a transfer in flight and reads back
+// the byte address it was sent
+class counting_przone : public przone_interface {
+ public:
+  counting_przone() : accesses(0), last_(0) {}
+
+  bool read(uint32_t address, uint32_t& value) override {
+    ++accesses;
+    value = address == i2c_reg_stat_rddata ? last_ & 0xFF : 0;
+    return true;
+  }
+
+  bool write(uint32_t address, uint32_t value) override {
+    ++accesses;
+    if (address == i2c_reg_ctrl_wrdata) last_ = value;
+    return true;
+  }
+
+  uint64_t accesses;
+
+ private:
+  uint32_t last_;
+};
+
+static const std::array<uint32_t, 4> offsets = {{0xE0, 0xE8, 0xF0, 0xF8}};
+static const uint32_t eeprom_addr = 0xAE;
+
+int main(int argc, char* argv[]) {
+  const uint32_t base = offsets.front();
+  const size_t window = offsets.back() + 6 - base;
+  size_t burst = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : window;
+
+  std::shared_ptr<counting_przone> pz(new counting_przone());
+  i2c::ptr_t bus(new i2c(pz));
+
+  for (uint32_t off : offsets) {
+    for (uint32_t b = 0; b < 6; ++b) {
+      uint8_t byte;
+      bus->read(1, eeprom_addr, off + b, &byte, 1);
+    }
+  }
+  std::printf("per-byte reads      %8llu przone accesses\n",
+              static_cast<unsigned long long>(pz->accesses));
+
+  char dir[] = "/tmp/bench_hssi_eeprom.XXXXXX";
+  if (!mkdtemp(dir)) {
+    std::perror("mkdtemp");
+    return EXIT_FAILURE;
+  }
+  std::string file =
+      eeprom_image::cache_file(dir, 0, 0x5e, 0, 0, eeprom_addr, base);
+
+  for (const char* run : {"burst image", "cached image"}) {
+    pz->accesses = 0;
+    eeprom_image image(bus, 1, eeprom_addr, base, window, burst);
+    image.set_cache_file(file);
+    for (uint32_t off : offsets) {
+      uint8_t mac[6];
+      if (!image.read(off, mac, sizeof(mac))) {
+        std::fprintf(stderr, "%s: read failed\n", run);
+        return EXIT_FAILURE;
+      }
+    }
+    std::printf("%-19s %8llu przone accesses\n", run,
+                static_cast<unsigned long long>(pz->accesses));
+  }
+
+  ::unlink(file.c_str());
+  ::rmdir(dir);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Write a register table through fme with one write_mmio64 per register
+// and with write_bulk using each bulk store the CPU supports. The
+// "resource" is a scratch file and its _wc view a link to it, so the
+// results are checked through the uncached mapping; the timings show
+// the cost of the write path, not of PCIe.
+//
+// usage: bench_hssi_fme_bulk [registers] [passes]
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "fme.h"
+
+using namespace intel::fpga;
+
+namespace {
+
+const char* store_names[] = {"qword", "avx512", "movdir64b"};
+
+double usec_since(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - begin).count();
+}
+
+bool check(fme& f, const std::vector<csr_write>& table, uint64_t pass) {
+  for (const auto& w : table) {
+    uint64_t value = 0;
+    if (!f.read_mmio64(w.offset, value) || value != (w.value ^ pass)) {
+      std::fprintf(stderr, "0x%x: 0x%llx\n", w.offset,
+                   static_cast<unsigned long long>(value));
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  size_t registers = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 4096;
+  size_t passes = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : 200;
+
+  char path[] = "/tmp/bench_hssi_fme_bulkXXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0 || ftruncate(fd, registers * sizeof(uint64_t)) != 0) {
+    std::perror("scratch resource");
+    return EXIT_FAILURE;
+  }
+  close(fd);
+  std::string wc = std::string(path) + "_wc";
+  if (symlink(path, wc.c_str()) != 0) {
+    std::perror("scratch resource_wc");
+    unlink(path);
+    return EXIT_FAILURE;
+  }
+
+  // one fence after every 512 registers, as a table loader would before
+  // a trigger register
+  std::vector<csr_write> table(registers);
+  for (size_t i = 0; i < registers; ++i) {
+    table[i] = {static_cast<uint32_t>(i * sizeof(uint64_t)),
+                0x5A5A000000000000ULL | i, (i + 1) % 512 == 0};
+  }
+
+  int status = EXIT_SUCCESS;
+  fme::ptr_t f = fme::open(path);
+  if (!f) {
+    std::fprintf(stderr, "cannot open %s\n", path);
+    status = EXIT_FAILURE;
+  } else {
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t p = 0; p < passes; ++p) {
+      for (const auto& w : table) f->write_mmio64(w.offset, w.value ^ p);
+    }
+    std::printf("write_mmio64          %8.2f nsec/register\n",
+                usec_since(begin) * 1000 / (passes * registers));
+
+    bool wc_mapped = f->map_write_combining();
+    fme::bulk_store best = f->best_bulk_store();
+    std::printf("write-combining view: %s, best bulk store: %s\n",
+                wc_mapped ? "mapped" : "none",
+                store_names[static_cast<int>(best)]);
+
+    for (int s = 0; s <= static_cast<int>(best); ++s) {
+      if (!f->set_bulk_store(static_cast<fme::bulk_store>(s))) continue;
+      std::vector<csr_write> pass_table(table);
+      double usec = 0;
+      for (size_t p = 0; p < passes; ++p) {
+        for (size_t i = 0; i < registers; ++i) {
+          pass_table[i].value = table[i].value ^ p;
+        }
+        begin = std::chrono::steady_clock::now();
+        size_t done = f->write_bulk(pass_table);
+        usec += usec_since(begin);
+        if (done != registers || !check(*f, table, p)) {
+          std::fprintf(stderr, "%s: pass %zu failed\n", store_names[s], p);
+          status = EXIT_FAILURE;
+          break;
+        }
+      }
+      std::printf("write_bulk %-10s %8.2f nsec/register\n", store_names[s],
+                  usec * 1000 / (passes * registers));
+    }
+  }
+
+  f.reset();
+  unlink(wc.c_str());
+  unlink(path);
+  return status;
+}
@@ -0,0 +1,133 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Cost and use of the hssi-io latency histograms:
+//
+//  - nanoseconds per latency_scope, against an empty loop
+//  - histograms recorded by threads that exited are still merged
+//  - the table hssi_config stats prints, for a mix of operations on a
+//    modelled controller with typical latency
+//
+// usage: bench_hssi_latency [records] [operations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "hssi_model.h"
+#include "hssi_msg.h"
+#include "hssi_przone.h"
+#include "i2c.h"
+#include "latency.h"
+#include "mdio.h"
+#include "nios.h"
+#include "xcvr.h"
+
+using namespace intel::fpga;
+using namespace intel::fpga::hssi;
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+double nsec_per(clock_type::time_point begin, size_t n) {
+  return std::chrono::duration<double, std::nano>(clock_type::now() - begin)
+             .count() / n;
+}
+
+}  // end of anonymous namespace
+
+int main(int argc, char* argv[]) {
+  size_t records = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 10000000;
+  size_t ops = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : 200;
+  bool ok = true;
+
+  // the clock is calibrated once, on the first read
+  latency_histogram::to_usec(0);
+
+  volatile uint64_t sink = 0;
+  auto begin = clock_type::now();
+  for (size_t i = 0; i < records; ++i) {
+    sink = sink + trace_tsc();
+  }
+  double empty = nsec_per(begin, records);
+  begin = clock_type::now();
+  for (size_t i = 0; i < records; ++i) {
+    latency_scope timer(latency_op::przone_read);
+  }
+  double scoped = nsec_per(begin, records);
+  std::printf("latency_scope          %6.1f nsec (%.1f nsec over a time "
+              "stamp read)\n", scoped, scoped - empty);
+
+  latency_recorder::reset();
+  const size_t threads = 4;
+  const size_t per_thread = 100000;
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([]() {
+      for (size_t i = 0; i < per_thread; ++i) {
+        latency_recorder::record(latency_op::nios, i);
+      }
+    });
+  }
+  for (auto& t : workers) t.join();
+  latency_histogram merged = latency_recorder::snapshot(latency_op::nios);
+  std::printf("merged                 %llu of %zu records from exited "
+              "threads\n", static_cast<unsigned long long>(merged.count()),
+              threads * per_thread);
+  ok &= merged.count() == threads * per_thread;
+
+  latency_recorder::reset();
+  hssi_model::ptr_t model(new hssi_model(hssi_model::typical_latency(), 4));
+  hssi_przone::ptr_t przone(new hssi_przone(model, model->ctrl_offset(),
+                                            model->stat_offset()));
+  xcvr rcfg(przone);
+  nios soft(przone);
+  i2c bus(przone);
+  mdio phy(przone);
+  for (size_t i = 0; i < ops; ++i) {
+    uint32_t value = 0;
+    uint8_t byte = 0;
+    rcfg.write(i % 4, 0x10, static_cast<uint32_t>(i));
+    rcfg.read(i % 4, 0x10, value);
+    soft.write(controller::nios_cmd::firmware_version, {}, value);
+    bus.read(controller::i2c_instance_retimer, 0x30, 0x20, &byte, 1);
+    phy.write(1, 0, 0x10, static_cast<uint32_t>(i));
+    phy.read(1, 0, 0x10, value);
+  }
+  std::printf("\n%zu rounds of xcvr, nios, i2c and mdio on a typical "
+              "model:\n", ops);
+  latency_recorder::print(std::cout);
+
+  if (!ok) {
+    std::fprintf(stderr, "records were lost merging the threads\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
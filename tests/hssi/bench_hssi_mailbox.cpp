@@ -0,0 +1,124 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Cost per HSSI handshake (one controller word, ack, clear, nack) of the
+// mailbox over the virtual mmio adapter and over a statically dispatched
+// policy. Both drive the same zero-latency controller model, in which
+// the ack bit follows HSSI_CTRL, so the difference is the dispatch.
+//
+// usage: bench_hssi_mailbox [words]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "mailbox.h"
+#include "mmio.h"
+
+using namespace intel::fpga;
+using namespace intel::fpga::hssi;
+
+static const uint32_t ctrl = 0x88;
+static const uint32_t stat = 0x90;
+
+struct controller_model {
+  uint64_t ctrl_word = 0;
+
+  void write(uint32_t offset, uint64_t value) {
+    if (offset == ctrl) ctrl_word = value;
+  }
+  uint64_t read(uint32_t offset) const {
+    return offset == stat && ctrl_word ? 1UL << 32 : 0;
+  }
+};
+
+class model_mmio : public mmio {
+ public:
+  explicit model_mmio(controller_model* m) : m_(m) {}
+  bool write_mmio32(uint32_t, uint32_t) override { return true; }
+  bool write_mmio64(uint32_t offset, uint64_t value) override {
+    m_->write(offset, value);
+    return true;
+  }
+  bool read_mmio32(uint32_t, uint32_t& value) override {
+    value = 0;
+    return true;
+  }
+  bool read_mmio64(uint32_t offset, uint64_t& value) override {
+    value = m_->read(offset);
+    return true;
+  }
+  uint8_t* mmio_pointer(uint32_t) override { return nullptr; }
+
+ private:
+  controller_model* m_;
+};
+
+class model_policy {
+ public:
+  explicit model_policy(controller_model* m) : m_(m) {}
+  bool read64(uint32_t offset, uint64_t& value) const {
+    value = m_->read(offset);
+    return true;
+  }
+  bool write64(uint32_t offset, uint64_t value) const {
+    m_->write(offset, value);
+    return true;
+  }
+
+ private:
+  controller_model* m_;
+};
+
+template <typename Policy>
+static double nsec_per_word(Policy io, size_t words) {
+  poller poll;
+  mailbox<Policy> box(io, ctrl, stat, poll);
+  transaction tx;
+  for (size_t i = 0; i < words; ++i) tx.add(i + 1);
+
+  auto begin = std::chrono::steady_clock::now();
+  if (!box.execute(tx, nullptr, 1000)) {
+    std::fprintf(stderr, "handshake failed\n");
+    std::exit(EXIT_FAILURE);
+  }
+  auto nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - begin).count();
+  return static_cast<double>(nsec) / words;
+}
+
+int main(int argc, char* argv[]) {
+  size_t words = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 1000000;
+  controller_model model;
+  std::unique_ptr<mmio> io(new model_mmio(&model));
+
+  std::printf("virtual adapter %8.1f nsec/handshake\n",
+              nsec_per_word(virtual_mmio(io.get()), words));
+  std::printf("static policy   %8.1f nsec/handshake\n",
+              nsec_per_word(model_policy(&model), words));
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Time a clause-45 register dump through mdio with completion polling
+// only and with a settle time equal to the former fixed 1 ms sleep.
+// The MDIO controller model completes each command after a fixed
+// number of status polls.
+//
+// usage: bench_hssi_mdio [registers] [busy-polls]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "mdio.h"
+#include "przone.h"
+
+using namespace intel::fpga::hssi;
+
+class mdio_przone : public przone_interface {
+ public:
+  explicit mdio_przone(uint32_t busy_polls)
+      : busy_polls_(busy_polls), busy_(0), ctrl_(0) {}
+
+  bool read(uint32_t address, uint32_t& value) override {
+    if (address == mdio_ctrl_reg) {
+      if (busy_ && --busy_ == 0) ctrl_ &= ~(mdio_write | mdio_read);
+      value = ctrl_;
+    } else {
+      value = address == mdio_rd_data_reg ? 0x1234 : 0;
+    }
+    return true;
+  }
+
+  bool write(uint32_t address, uint32_t value) override {
+    if (address == mdio_ctrl_reg) {
+      ctrl_ = value;
+      busy_ = busy_polls_;
+    }
+    return true;
+  }
+
+ private:
+  uint32_t busy_polls_;
+  uint32_t busy_;
+  uint32_t ctrl_;
+};
+
+int main(int argc, char* argv[]) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 64;
+  uint32_t busy = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : 4;
+
+  std::vector<mdio_register> regs(count);
+  for (size_t i = 0; i < count; ++i) {
+    regs[i] = {1, 0, static_cast<uint16_t>(i), 0};
+  }
+
+  for (uint32_t settle : {0u, 1000u}) {
+    mdio bus(przone_interface::ptr_t(new mdio_przone(busy)));
+    bus.set_settle_usec(1, settle);
+    auto begin = std::chrono::steady_clock::now();
+    size_t done = bus.read(regs);
+    auto usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - begin).count();
+    if (done != count) {
+      std::fprintf(stderr, "settle %u: read %zu of %zu\n", settle, done, count);
+      return EXIT_FAILURE;
+    }
+    std::printf("settle %4u usec: %zu registers in %8lld usec (%.1f usec/reg)\n",
+                settle, count, static_cast<long long>(usec),
+                static_cast<double>(usec) / count);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,196 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Drive the hssi-io library against the HSSI controller model: every
+// thread owns a model and runs rounds of transceiver writes and reads
+// over all lanes, soft commands, retimer register accesses, an EEPROM
+// MAC address load and an MDIO dump, checking each result against the
+// model's state.
+//
+// usage: bench_hssi_model [threads] [rounds] [none|typical]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "eeprom_image.h"
+#include "hssi_model.h"
+#include "hssi_msg.h"
+#include "hssi_przone.h"
+#include "i2c.h"
+#include "mdio.h"
+#include "nios.h"
+#include "xcvr.h"
+
+using namespace intel::fpga;
+using namespace intel::fpga::hssi;
+
+namespace {
+
+const uint32_t lanes = 16;
+const uint32_t xcvr_regs = 8;
+const uint32_t retimer = 0x30;
+const size_t mdio_regs = 16;
+
+struct result {
+  uint64_t ops;
+  uint64_t failures;
+  hssi_model::stats stats;
+};
+
+bool run_round(hssi_model& model, xcvr& rcfg, nios& cmd, i2c& bus,
+               mdio& phy, uint32_t round) {
+  bool ok = true;
+
+  for (uint32_t lane = 0; lane < lanes; ++lane) {
+    for (uint32_t reg = 0; reg < xcvr_regs; ++reg) {
+      uint32_t value = round << 16 | lane << 8 | reg;
+      uint32_t back = 0;
+      ok &= rcfg.write(lane, reg, value) && rcfg.read(lane, reg, back) &&
+            back == value;
+    }
+  }
+
+  uint32_t mode = round & 0x3;
+  uint32_t value = 0;
+  ok &= cmd.write(controller::nios_cmd::change_hssi_mode, {mode}) &&
+        cmd.write(controller::nios_cmd::get_hssi_mode, {}, value) &&
+        value == mode && model.hssi_mode() == mode;
+  ok &= cmd.write(controller::nios_cmd::tx_eq_write, {round % lanes, 1, round}) &&
+        cmd.write(controller::nios_cmd::tx_eq_read, {round % lanes, 1}, value) &&
+        value == round;
+
+  uint8_t select = 4 + round % hssi_model::retimer_channels;
+  uint8_t word[4] = {static_cast<uint8_t>(round), 0, 0, 0};
+  uint8_t back[4] = {};
+  ok &= bus.write(controller::i2c_instance_retimer, retimer, 0xFF, &select, 1) &&
+        bus.write(controller::i2c_instance_retimer, retimer, 0x10, word, 4) &&
+        bus.read(controller::i2c_instance_retimer, retimer, 0x10, back, 4) &&
+        back[0] == word[0];
+  uint8_t reg = 0;
+  ok &= model.retimer_register(retimer, select - 4, 0x10, reg) && reg == word[0];
+
+  std::vector<mdio_register> regs(mdio_regs);
+  for (size_t i = 0; i < mdio_regs; ++i) {
+    regs[i] = {1, 0, static_cast<uint16_t>(i), round + static_cast<uint32_t>(i)};
+  }
+  ok &= phy.write(regs) == mdio_regs;
+  for (auto& r : regs) r.value = 0;
+  ok &= phy.read(regs) == mdio_regs;
+  for (size_t i = 0; i < mdio_regs; ++i) {
+    ok &= regs[i].value == round + i;
+  }
+  return ok;
+}
+
+void worker(const model_latency& latency, uint32_t rounds, result& out) {
+  hssi_model::ptr_t model(new hssi_model(latency, lanes));
+  hssi_przone::ptr_t przone(
+      new hssi_przone(model, model->ctrl_offset(), model->stat_offset()));
+  auto pz = std::dynamic_pointer_cast<przone_interface>(przone);
+  xcvr rcfg(przone);
+  nios cmd(przone);
+  i2c::ptr_t bus(new i2c(pz));
+  mdio phy(pz);
+
+  out = result();
+  for (uint32_t round = 0; round < rounds; ++round) {
+    if (!run_round(*model, rcfg, cmd, *bus, phy, round)) ++out.failures;
+
+    // a fresh image each round, so the MAC window crosses the bus
+    eeprom_image eeprom(bus, controller::i2c_instance_retimer,
+                        hssi_model::eeprom_device, 0xE0, 30, 30);
+    uint8_t mac[6];
+    if (!eeprom.read(0xF8, mac, sizeof(mac)) || mac[0] != 0x02 || mac[5] != 3) {
+      ++out.failures;
+    }
+  }
+  out.stats = model->get_stats();
+  out.ops = out.stats.commands;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  uint32_t threads = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 4;
+  uint32_t rounds = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : 50;
+  std::string name = argc > 3 ? argv[3] : "none";
+
+  model_latency latency;
+  if (!hssi_model::parse_latency(name, latency)) {
+    std::fprintf(stderr, "latency must be none or typical\n");
+    return EXIT_FAILURE;
+  }
+  // spinning threads beyond the core count would starve each other
+  poll_config poll;
+  poller::parse(threads > std::thread::hardware_concurrency() ? "yield" : "spin",
+                poll);
+  poller::set_defaults(poll);
+
+  std::vector<result> results(threads);
+  std::vector<std::thread> pool;
+  auto begin = std::chrono::steady_clock::now();
+  for (uint32_t t = 0; t < threads; ++t) {
+    pool.emplace_back(worker, latency, rounds, std::ref(results[t]));
+  }
+  for (auto& t : pool) t.join();
+  double sec = std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - begin).count();
+
+  hssi_model::stats total = hssi_model::stats();
+  uint64_t failures = 0;
+  for (const auto& r : results) {
+    failures += r.failures;
+    total.commands += r.stats.commands;
+    total.xcvr_reads += r.stats.xcvr_reads;
+    total.xcvr_writes += r.stats.xcvr_writes;
+    total.nios_cmds += r.stats.nios_cmds;
+    total.i2c_bytes += r.stats.i2c_bytes;
+    total.mdio_cmds += r.stats.mdio_cmds;
+    total.errors += r.stats.errors;
+  }
+
+  std::printf("%u threads x %u rounds, %s latency: %.3f sec\n", threads,
+              rounds, name.c_str(), sec);
+  std::printf("  %llu controller commands (%.0f/sec, %.2f usec each)\n",
+              static_cast<unsigned long long>(total.commands),
+              total.commands / sec, sec * 1e6 / total.commands);
+  std::printf("  %llu xcvr writes, %llu xcvr reads, %llu soft commands, "
+              "%llu I2C bytes, %llu MDIO commands\n",
+              static_cast<unsigned long long>(total.xcvr_writes),
+              static_cast<unsigned long long>(total.xcvr_reads),
+              static_cast<unsigned long long>(total.nios_cmds),
+              static_cast<unsigned long long>(total.i2c_bytes),
+              static_cast<unsigned long long>(total.mdio_cmds));
+  std::printf("  %llu failed rounds, %llu protocol errors\n",
+              static_cast<unsigned long long>(failures),
+              static_cast<unsigned long long>(total.errors));
+  return failures || total.errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Heap allocations of the NIOS soft command path, counted by replacing
+// the global operator new:
+//
+//  - a bulk load of TX equalization settings (tx_eq_write over all
+//    lanes) and get_hssi_mode reads through nios::write, which must
+//    not allocate once warm
+//  - the same commands built the way they used to be, with a vector
+//    of arguments and a transaction per command, for comparison (this
+//    one skips the tracing, timing and shadow upkeep of nios::write)
+//
+// usage: bench_hssi_nios [rounds]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "hssi_model.h"
+#include "hssi_msg.h"
+#include "hssi_przone.h"
+#include "nios.h"
+#include "transaction.h"
+
+namespace {
+
+std::atomic<uint64_t> allocations(0);
+
+}  // end of anonymous namespace
+
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void* p = std::malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+// out of line, so the compiler does not pair the free() with the new
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+using namespace intel::fpga;
+using namespace intel::fpga::hssi;
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+const uint32_t lanes = 16;
+
+struct outcome {
+  uint64_t commands;
+  uint64_t allocations;
+  uint64_t failures;
+  double usec;
+};
+
+// one round: an equalization setting per lane, then the mode
+template <typename Command>
+outcome bulk_load(size_t rounds, Command command) {
+  outcome o = {0, 0, 0, 0.0};
+  uint64_t before = allocations.load(std::memory_order_relaxed);
+  auto begin = clock_type::now();
+  for (size_t r = 0; r < rounds; ++r) {
+    for (uint32_t lane = 0; lane < lanes; ++lane) {
+      if (!command(controller::nios_cmd::tx_eq_write, lane,
+                   static_cast<uint32_t>(r))) {
+        ++o.failures;
+      }
+      ++o.commands;
+    }
+    if (!command(controller::nios_cmd::get_hssi_mode, 0, 0)) ++o.failures;
+    ++o.commands;
+  }
+  o.usec = std::chrono::duration<double, std::micro>(clock_type::now() -
+                                                     begin).count();
+  o.allocations = allocations.load(std::memory_order_relaxed) - before;
+  return o;
+}
+
+void print(const char* name, const outcome& o) {
+  std::printf("%-22s %8llu commands %8.2f allocations/command %7.2f "
+              "usec/command\n", name,
+              static_cast<unsigned long long>(o.commands),
+              static_cast<double>(o.allocations) / o.commands,
+              o.usec / o.commands);
+}
+
+}  // end of anonymous namespace
+
+int main(int argc, char* argv[]) {
+  size_t rounds = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 2000;
+
+  hssi_model::ptr_t model(new hssi_model(hssi_model::no_latency(), lanes));
+  hssi_przone::ptr_t przone(new hssi_przone(model, model->ctrl_offset(),
+                                            model->stat_offset()));
+  nios cmd(przone);
+
+  auto span = [&cmd](uint32_t func, uint32_t lane, uint32_t value) {
+    uint32_t mode = 0;
+    return func == controller::nios_cmd::tx_eq_write
+               ? cmd.write(func, {lane, 1, value})
+               : cmd.write(func, {}, mode);
+  };
+
+  // the per-thread state of the recorders and the transaction is made
+  // by the first command
+  bulk_load(1, span);
+  outcome spans = bulk_load(rounds, span);
+
+  outcome vectors = bulk_load(rounds, [&przone](uint32_t func, uint32_t lane,
+                                                uint32_t value) {
+    std::vector<uint32_t> args;
+    if (func == controller::nios_cmd::tx_eq_write) args = {lane, 1, value};
+    uint32_t junk = 0;
+    transaction tx;
+    tx.reserve(args.size() + 2);
+    tx.soft_cmd(func, args.data(), args.size(), &junk);
+    return przone->execute(tx, nullptr, nios::soft_cmd_timeout_usec);
+  });
+
+  print("nios::write", spans);
+  print("vector + transaction", vectors);
+
+  if (spans.failures || vectors.failures) {
+    std::fprintf(stderr, "%llu commands failed\n",
+                 static_cast<unsigned long long>(spans.failures +
+                                                 vectors.failures));
+  }
+  if (spans.allocations) {
+    std::fprintf(stderr, "nios::write allocated %llu times\n",
+                 static_cast<unsigned long long>(spans.allocations));
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
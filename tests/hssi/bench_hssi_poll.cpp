@@ -0,0 +1,99 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Time the HSSI mailbox handshake (przone write/read) under each
+// completion polling policy, against the fake mailbox of latency_mmio.h.
+//
+// usage: bench_hssi_poll [latency-usec] [iterations]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "hssi_przone.h"
+#include "poll.h"
+#include "latency_mmio.h"
+
+using namespace intel::fpga;
+using namespace intel::fpga::hssi;
+
+typedef std::chrono::steady_clock clock_type;
+
+static double percentile(std::vector<double>& v, double p) {
+  size_t i = static_cast<size_t>(p * (v.size() - 1));
+  std::nth_element(v.begin(), v.begin() + i, v.end());
+  return v[i];
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t latency_usec = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 2;
+  size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : 2000;
+  const uint32_t ctrl = 0x88, stat = 0x90;
+
+  std::printf("handshake latency %u usec, %zu przone writes per policy\n",
+              latency_usec, iterations);
+  std::printf("%-8s %10s %10s %10s %12s %10s\n", "policy", "mean(us)",
+              "p50(us)", "p99(us)", "polls/wait", "cpu(%)");
+
+  for (const char* name : {"legacy", "sleep", "yield", "spin"}) {
+    poll_config config;
+    poller::parse(name, config);
+
+    mmio::ptr_t m(new latency_mmio(ctrl, stat, latency_usec));
+    hssi_przone przone(m, ctrl, stat);
+    przone.get_poller().set_config(config);
+
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    std::clock_t cpu_begin = std::clock();
+    auto wall_begin = clock_type::now();
+    for (size_t i = 0; i < iterations; ++i) {
+      auto begin = clock_type::now();
+      if (!przone.write(0x100, static_cast<uint32_t>(i))) {
+        std::fprintf(stderr, "%s: handshake timed out\n", name);
+        return EXIT_FAILURE;
+      }
+      std::chrono::duration<double, std::micro> d = clock_type::now() - begin;
+      samples.push_back(d.count());
+    }
+    std::chrono::duration<double> wall = clock_type::now() - wall_begin;
+    double cpu = static_cast<double>(std::clock() - cpu_begin) / CLOCKS_PER_SEC;
+
+    double mean = 0.0;
+    for (double s : samples) mean += s;
+    mean /= samples.size();
+
+    const poll_stats& stats = przone.get_poller().stats();
+    std::printf("%-8s %10.2f %10.2f %10.2f %12.1f %10.1f\n", name, mean,
+                percentile(samples, 0.50), percentile(samples, 0.99),
+                static_cast<double>(stats.polls) / stats.waits,
+                100.0 * cpu / wall.count());
+  }
+  return EXIT_SUCCESS;
+}
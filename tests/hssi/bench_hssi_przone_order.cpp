@@ -0,0 +1,71 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Time the read-ordering overhead of one e10 gen_report (ten PR zone
+// reads) with the former 1 usec sleep and with the busy-wait on the
+// steady clock. The fence ordering costs one MMIO read of
+// afu_ctrl per PR zone read and needs an accelerator to measure.
+//
+// usage: bench_hssi_przone_order [reports] [delay-nsec]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "accelerator_przone.h"
+
+using intel::fpga::hssi::accelerator_przone;
+typedef std::chrono::steady_clock clock_type;
+
+static const int reads_per_report = 10;
+
+template <typename Delay>
+static double usec_per_report(int reports, Delay delay) {
+  auto begin = clock_type::now();
+  for (int r = 0; r < reports; ++r) {
+    for (int i = 0; i < reads_per_report; ++i) delay();
+  }
+  auto nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  clock_type::now() - begin).count();
+  return nsec / 1000.0 / reports;
+}
+
+int main(int argc, char* argv[]) {
+  int reports = argc > 1 ? std::atoi(argv[1]) : 1000;
+  uint32_t delay_nsec = argc > 2 ? std::strtoul(argv[2], nullptr, 0)
+                                 : accelerator_przone::default_delay_nsec;
+
+  std::printf("sleep             %8.1f usec/report\n",
+              usec_per_report(reports, [=]() {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(delay_nsec));
+              }));
+  std::printf("spin              %8.1f usec/report\n",
+              usec_per_report(reports, [=]() {
+                accelerator_przone::spin_delay(delay_nsec);
+              }));
+  return EXIT_SUCCESS;
+}
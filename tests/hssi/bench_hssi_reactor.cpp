@@ -0,0 +1,233 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Run the same work on several modelled HSSI controllers three ways:
+// one thread doing the cards one after the other with the blocking
+// calls, one blocking thread per card, and a single reactor thread
+// driving every card's mailbox through async_hssi.
+//
+// usage: bench_hssi_reactor [cards] [operations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "hssi_model.h"
+#include "hssi_msg.h"
+#include "hssi_przone.h"
+#include "i2c.h"
+#include "mdio.h"
+#include "reactor.h"
+#include "xcvr.h"
+
+using namespace intel::fpga;
+using namespace intel::fpga::hssi;
+
+namespace {
+
+const uint32_t lanes = 4;
+
+struct card {
+  hssi_model::ptr_t model;
+  hssi_przone::ptr_t przone;
+};
+
+model_latency bench_latency() {
+  // a quick board: 2 usec acks, 20 usec I2C bytes, 5 usec MDIO commands
+  model_latency latency = {2000, 1000, 20000, 20000, 5000};
+  return latency;
+}
+
+std::vector<card> make_cards(size_t count) {
+  std::vector<card> cards(count);
+  for (auto& c : cards) {
+    c.model.reset(new hssi_model(bench_latency(), lanes));
+    c.przone.reset(new hssi_przone(c.model, c.model->ctrl_offset(),
+                                   c.model->stat_offset()));
+  }
+  return cards;
+}
+
+// Per operation: a transceiver write and read back, a retimer byte and
+// an MDIO register written and read back. Timeouts are counted, not
+// fatal: a loaded machine can stall a poller past the I2C timeout.
+struct tally {
+  uint64_t failed;
+  uint64_t wrong;
+};
+
+tally blocking_work(card& c, size_t ops) {
+  xcvr rcfg(c.przone);
+  i2c bus(c.przone);
+  mdio phy(c.przone);
+  tally t = {0, 0};
+  for (size_t i = 0; i < ops; ++i) {
+    uint32_t value = 0;
+    uint8_t byte = 0;
+    if (!rcfg.write(i % lanes, 0x10, static_cast<uint32_t>(i)) ||
+        !rcfg.read(i % lanes, 0x10, value)) {
+      ++t.failed;
+    } else if (value != i) {
+      ++t.wrong;
+    }
+    if (!bus.read(controller::i2c_instance_retimer, 0x30, 0x20, &byte, 1)) {
+      ++t.failed;
+    }
+    if (!phy.write(1, 0, static_cast<uint16_t>(i), static_cast<uint32_t>(i)) ||
+        !phy.read(1, 0, static_cast<uint16_t>(i), value)) {
+      ++t.failed;
+    } else if (value != i) {
+      ++t.wrong;
+    }
+  }
+  return t;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       begin).count();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 8;
+  size_t ops = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : 50;
+
+  poll_config spin;
+  poller::parse("spin", spin);
+  poller::set_defaults(spin);
+  {
+    auto cards = make_cards(count);
+    tally total = {0, 0};
+    auto begin = std::chrono::steady_clock::now();
+    for (auto& c : cards) {
+      tally t = blocking_work(c, ops);
+      total.failed += t.failed;
+      total.wrong += t.wrong;
+    }
+    std::printf("1 blocking thread      %8.3f sec (%llu timed out, %llu "
+                "wrong)\n", seconds_since(begin),
+                static_cast<unsigned long long>(total.failed),
+                static_cast<unsigned long long>(total.wrong));
+  }
+
+  {
+    auto cards = make_cards(count);
+    std::vector<tally> results(count);
+    std::vector<std::thread> threads;
+    // spinning threads beyond the core count would starve each other
+    poll_config poll;
+    poller::parse(count > std::thread::hardware_concurrency() ? "yield" : "spin",
+                  poll);
+    poller::set_defaults(poll);
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+      threads.emplace_back([&cards, &results, ops, i]() {
+        results[i] = blocking_work(cards[i], ops);
+      });
+    }
+    for (auto& t : threads) t.join();
+    double sec = seconds_since(begin);
+    tally total = {0, 0};
+    for (const tally& t : results) {
+      total.failed += t.failed;
+      total.wrong += t.wrong;
+    }
+    std::printf("%zu blocking threads    %8.3f sec (%llu timed out, %llu "
+                "wrong)\n", count, sec,
+                static_cast<unsigned long long>(total.failed),
+                static_cast<unsigned long long>(total.wrong));
+  }
+
+  uint64_t wrong = 0;
+  {
+    auto cards = make_cards(count);
+    reactor::ptr_t r(new reactor());
+    std::vector<async_hssi> links;
+    for (auto& c : cards) links.emplace_back(r, c.przone);
+
+    // per card: results of the reads, kept until the futures are ready
+    std::vector<std::vector<uint32_t>> xcvr_values(count,
+                                                   std::vector<uint32_t>(ops));
+    std::vector<std::vector<uint32_t>> mdio_values(count,
+                                                   std::vector<uint32_t>(ops));
+    std::vector<std::vector<uint8_t>> bytes(count, std::vector<uint8_t>(ops));
+    struct pending {
+      std::future<bool> write, read, byte, mdio_write, mdio_read;
+    };
+    std::vector<pending> futures(count * ops);
+
+    auto begin = std::chrono::steady_clock::now();
+    r->start();
+    for (size_t i = 0; i < ops; ++i) {
+      for (size_t c = 0; c < count; ++c) {
+        async_hssi& l = links[c];
+        pending& p = futures[c * ops + i];
+        p.write = l.xcvr_write(i % lanes, 0x10, static_cast<uint32_t>(i));
+        p.read = l.xcvr_read(i % lanes, 0x10, xcvr_values[c][i]);
+        p.byte = l.i2c_read(controller::i2c_instance_retimer, 0x30, 0x20,
+                            &bytes[c][i], 1);
+        p.mdio_write = l.mdio_write(1, 0, static_cast<uint16_t>(i),
+                                    static_cast<uint32_t>(i));
+        p.mdio_read = l.mdio_read(1, 0, static_cast<uint16_t>(i),
+                                  mdio_values[c][i]);
+      }
+    }
+    for (size_t c = 0; c < count; ++c) {
+      for (size_t i = 0; i < ops; ++i) {
+        pending& p = futures[c * ops + i];
+        // wait for every future: the reads land in the vectors above
+        bool written = p.write.get();
+        bool read = p.read.get();
+        if (written && read && xcvr_values[c][i] != i) ++wrong;
+        p.byte.get();
+        written = p.mdio_write.get();
+        read = p.mdio_read.get();
+        if (written && read && mdio_values[c][i] != i) ++wrong;
+      }
+    }
+    double sec = seconds_since(begin);
+    r->stop();
+
+    auto stats = r->get_stats();
+    std::printf("1 reactor thread       %8.3f sec (%llu operations, %llu "
+                "timed out, %.1f polls/operation)\n",
+                sec, static_cast<unsigned long long>(stats.completed),
+                static_cast<unsigned long long>(stats.failed),
+                static_cast<double>(stats.polls) / stats.submitted);
+  }
+
+  if (wrong) {
+    std::fprintf(stderr, "%llu completed reads returned a wrong value\n",
+                 static_cast<unsigned long long>(wrong));
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
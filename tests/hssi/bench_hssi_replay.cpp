@@ -0,0 +1,167 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Record a 16-lane transceiver profile load, one xcvr::write per
+// register, against the fake mailbox of latency_mmio.h, then replay the
+// trace:
+//   - per-register writes, as recorded
+//   - the profile as one transaction, which must put the same words on
+//     the bus
+//   - the profile again through a primed shadow cache, which skips the
+//     writes and so must be reported as not matching the trace
+// with and without the recorded timing.
+//
+// usage: bench_hssi_replay [latency-usec] [registers-per-lane]
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "hssi_przone.h"
+#include "latency_mmio.h"
+#include "mmio_replay.h"
+#include "mmio_trace.h"
+#include "shadow_cache.h"
+#include "transaction.h"
+#include "xcvr.h"
+
+using namespace intel::fpga;
+using namespace intel::fpga::hssi;
+
+typedef std::chrono::steady_clock clock_type;
+
+static const uint32_t ctrl = 0x88, stat = 0x90, lanes = 16;
+static uint32_t regs_per_lane = 8;
+
+typedef bool (*load_fn)(hssi_przone::ptr_t);
+
+static bool per_register(hssi_przone::ptr_t przone) {
+  xcvr xc(przone);
+  for (uint32_t lane = 0; lane < lanes; ++lane) {
+    for (uint32_t r = 0; r < regs_per_lane; ++r) {
+      if (!xc.write(lane, 0x200 + r, lane << 8 | r)) return false;
+    }
+  }
+  return true;
+}
+
+static bool batched(hssi_przone::ptr_t przone) {
+  transaction tx;
+  for (uint32_t lane = 0; lane < lanes; ++lane) {
+    for (uint32_t r = 0; r < regs_per_lane; ++r) {
+      tx.xcvr_write(lane, 0x200 + r, lane << 8 | r);
+    }
+  }
+  return przone->execute(tx);
+}
+
+static bool cached(hssi_przone::ptr_t przone) {
+  shadow_cache::ptr_t cache(new shadow_cache());
+  for (uint32_t lane = 0; lane < lanes; ++lane) {
+    for (uint32_t r = 0; r < regs_per_lane; ++r) {
+      cache->update(shadow_cache::target::xcvr,
+                    shadow_cache::xcvr_key(lane, 0x200 + r), lane << 8 | r);
+    }
+  }
+  xcvr xc(przone, cache);
+  for (uint32_t lane = 0; lane < lanes; ++lane) {
+    for (uint32_t r = 0; r < regs_per_lane; ++r) {
+      if (!xc.write(lane, 0x200 + r, lane << 8 | r)) return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t latency_usec = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 2;
+  regs_per_lane = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : 8;
+
+  std::string prefix = "/tmp/bench_hssi_replay." + std::to_string(::getpid());
+  std::string file = prefix + ".0.trace";
+  double recorded_ms = 0.0;
+  // a descheduled host can time out a handshake; record again then
+  bool recorded = false;
+  for (int attempt = 0; attempt < 3 && !recorded; ++attempt) {
+    mmio::ptr_t hw(new latency_mmio(ctrl, stat, latency_usec));
+    mmio::ptr_t traced(new mmio_trace(hw, prefix));
+    auto begin = clock_type::now();
+    recorded = per_register(hssi_przone::ptr_t(new hssi_przone(traced, ctrl, stat)));
+    recorded_ms = std::chrono::duration<double, std::milli>(
+                      clock_type::now() - begin).count();
+  }
+  if (!recorded) {
+    std::fprintf(stderr, "recording failed\n");
+    ::unlink(file.c_str());
+    return EXIT_FAILURE;
+  }
+  std::printf("recorded %u registers in %.3f ms\n", lanes * regs_per_lane,
+              recorded_ms);
+  std::printf("%-14s %-9s %10s %8s %10s %9s %9s\n", "replay", "timing",
+              "time(ms)", "matches", "mismatches", "repeated", "skipped");
+
+  struct {
+    const char* name;
+    load_fn load;
+    bool same_bus;
+  } const loads[] = {{"per-register", per_register, true},
+                     {"transaction", batched, true},
+                     {"cached", cached, false}};
+  int rc = EXIT_SUCCESS;
+  for (const auto& load : loads) {
+    for (auto timing : {mmio_replay::timing::none, mmio_replay::timing::recorded}) {
+      std::string error;
+      mmio_replay::ptr_t replay = mmio_replay::open(file, timing, error);
+      if (!replay) {
+        std::fprintf(stderr, "%s: %s\n", file.c_str(), error.c_str());
+        return EXIT_FAILURE;
+      }
+      auto begin = clock_type::now();
+      bool loaded = load.load(hssi_przone::ptr_t(new hssi_przone(replay, ctrl, stat)));
+      double ms = std::chrono::duration<double, std::milli>(
+                      clock_type::now() - begin).count();
+      bool match = replay->finished() && replay->get_stats().mismatches == 0;
+      auto stats = replay->get_stats();
+      std::printf("%-14s %-9s %10.3f %8s %10llu %9llu %9llu%s\n", load.name,
+                  timing == mmio_replay::timing::none ? "none" : "recorded",
+                  ms, match ? "yes" : "no",
+                  static_cast<unsigned long long>(stats.mismatches),
+                  static_cast<unsigned long long>(stats.repeated_polls),
+                  static_cast<unsigned long long>(stats.skipped_polls),
+                  loaded ? "" : " (timed out)");
+      // a timeout on a busy host stops the load early without a mismatch
+      if ((loaded || stats.mismatches) && match != load.same_bus) {
+        rc = EXIT_FAILURE;
+      }
+    }
+  }
+
+  ::unlink(file.c_str());
+  return rc;
+}
@@ -0,0 +1,140 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Time lost to a wedged controller, with fixed and learned timeouts:
+//
+//  - the timeout learned from a healthy, modelled controller with
+//    typical latency
+//  - the time to read a batch of transceiver registers once the
+//    controller stops answering, with the fixed timeout, the learned
+//    one, and the learned one with the circuit breaker
+//
+// usage: bench_hssi_timeouts [warmup] [registers]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "hssi_model.h"
+#include "hssi_przone.h"
+#include "latency.h"
+#include "xcvr.h"
+
+using namespace intel::fpga;
+using namespace intel::fpga::hssi;
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+struct outcome {
+  size_t healthy_timeouts;
+  uint32_t timeout_usec;  ///< of an ack wait, before the controller wedged
+  double p999_usec;       ///< of the healthy ack waits
+  double msec;
+  size_t failed;
+  bool tripped;
+};
+
+// learn on a healthy controller, then wedge it and read a batch,
+// stopping early as a batch of hssi_config does once the breaker trips
+outcome wedged_batch(bool adaptive, uint32_t breaker, size_t warmup,
+                     size_t registers) {
+  timeout_policy policy;
+  adaptive_timeout::parse(adaptive ? "adaptive" : "static", policy);
+  adaptive_timeout::set_policy(policy);
+  latency_recorder::reset();
+
+  hssi_model::ptr_t model(new hssi_model(hssi_model::typical_latency(), 4));
+  hssi_przone::ptr_t przone(new hssi_przone(model, model->ctrl_offset(),
+                                            model->stat_offset()));
+  przone->set_breaker_limit(breaker);
+  xcvr rcfg(przone);
+  uint32_t value = 0;
+  for (size_t i = 0; i < warmup; ++i) {
+    rcfg.read(i % 4, 0x10, value);
+  }
+  outcome o = {0, 0, 0.0, 0.0, 0, false};
+  o.healthy_timeouts = przone->get_poller().stats().timeouts;
+  o.timeout_usec = adaptive_timeout::get(latency_op::ack_wait,
+                                         hssi_przone::default_timeout_usec);
+  o.p999_usec =
+      latency_recorder::snapshot(latency_op::ack_wait).percentile_usec(99.9);
+
+  model_latency wedged = hssi_model::typical_latency();
+  wedged.ack_nsec = 4000000000u;
+  model->set_latency(wedged);
+
+  auto begin = clock_type::now();
+  for (size_t i = 0; i < registers && !przone->tripped(); ++i) {
+    if (!rcfg.read(i % 4, 0x10, value)) ++o.failed;
+  }
+  o.msec = std::chrono::duration<double, std::milli>(clock_type::now() -
+                                                     begin).count();
+  o.tripped = przone->tripped();
+  return o;
+}
+
+}  // end of anonymous namespace
+
+int main(int argc, char* argv[]) {
+  size_t warmup = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 2000;
+  size_t registers = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : 200;
+  bool ok = true;
+
+  outcome fixed = wedged_batch(false, 0, warmup, registers);
+  outcome learned = wedged_batch(true, 0, warmup, registers);
+  outcome breaker = wedged_batch(true, hssi_przone::default_breaker_limit,
+                                 warmup, registers);
+
+  std::printf("ack wait p99.9 %.1f usec over %zu healthy reads\n",
+              learned.p999_usec, warmup);
+  std::printf("fixed timeout          %4u usec, %zu healthy reads timed "
+              "out\n", fixed.timeout_usec, fixed.healthy_timeouts);
+  std::printf("learned timeout        %4u usec, %zu healthy reads timed "
+              "out\n", learned.timeout_usec, learned.healthy_timeouts);
+
+  std::printf("\n%zu registers of a wedged controller:\n", registers);
+  std::printf("  fixed                %8.1f msec, %zu failed\n", fixed.msec,
+              fixed.failed);
+  std::printf("  learned              %8.1f msec, %zu failed\n",
+              learned.msec, learned.failed);
+  std::printf("  learned + breaker    %8.1f msec, %zu failed, then %s\n",
+              breaker.msec, breaker.failed,
+              breaker.tripped ? "aborted" : "not aborted");
+
+  if (!breaker.tripped ||
+      breaker.failed != hssi_przone::default_breaker_limit) {
+    std::fprintf(stderr, "the breaker did not trip after %u timeouts\n",
+                 hssi_przone::default_breaker_limit);
+    ok = false;
+  }
+  if (fixed.tripped || learned.tripped) {
+    std::fprintf(stderr, "a disabled breaker tripped\n");
+    ok = false;
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,128 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Time loading a 16-lane transceiver equalization profile, one
+// xcvr::write per register versus one transaction for the whole profile,
+// against the fake mailbox of latency_mmio.h. The last column reapplies
+// the profile through a shadow cache that already holds it.
+//
+// usage: bench_hssi_transaction [latency-usec] [registers-per-lane]
+//                               [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "hssi_przone.h"
+#include "latency_mmio.h"
+#include "poll.h"
+#include "shadow_cache.h"
+#include "transaction.h"
+#include "xcvr.h"
+
+using namespace intel::fpga::hssi;
+
+typedef std::chrono::steady_clock clock_type;
+
+int main(int argc, char* argv[]) {
+  uint32_t latency_usec = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 2;
+  uint32_t regs_per_lane = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : 8;
+  size_t iterations = argc > 3 ? std::strtoul(argv[3], nullptr, 0) : 10;
+  const uint32_t lanes = 16;
+  const uint32_t ctrl = 0x88, stat = 0x90;
+
+  std::shared_ptr<latency_mmio> m(new latency_mmio(ctrl, stat, latency_usec));
+  hssi_przone::ptr_t przone(new hssi_przone(m, ctrl, stat));
+  xcvr xc(przone);
+  shadow_cache::ptr_t cache(new shadow_cache());
+  xcvr cached(przone, cache);
+
+  std::printf("%u lanes x %u registers, handshake latency %u usec\n", lanes,
+              regs_per_lane, latency_usec);
+
+  for (const char* policy : {"legacy", "sleep", "spin"}) {
+    poll_config config;
+    poller::parse(policy, config);
+    przone->get_poller().set_config(config);
+
+    std::chrono::duration<double, std::milli> per_register(0), batched(0),
+        reapply(0);
+    for (size_t it = 0; it < iterations; ++it) {
+      auto begin = clock_type::now();
+      for (uint32_t lane = 0; lane < lanes; ++lane) {
+        for (uint32_t r = 0; r < regs_per_lane; ++r) {
+          if (!xc.write(lane, 0x200 + r, lane << 8 | r)) {
+            std::fprintf(stderr, "xcvr write timed out\n");
+            return EXIT_FAILURE;
+          }
+        }
+      }
+      per_register += clock_type::now() - begin;
+
+      begin = clock_type::now();
+      transaction tx;
+      tx.reserve(lanes * regs_per_lane * transaction::xcvr_write_steps);
+      for (uint32_t lane = 0; lane < lanes; ++lane) {
+        for (uint32_t r = 0; r < regs_per_lane; ++r) {
+          tx.xcvr_write(lane, 0x200 + r, lane << 8 | r);
+        }
+      }
+      if (!przone->execute(tx)) {
+        std::fprintf(stderr, "transaction timed out\n");
+        return EXIT_FAILURE;
+      }
+      batched += clock_type::now() - begin;
+
+      begin = clock_type::now();
+      for (uint32_t lane = 0; lane < lanes; ++lane) {
+        for (uint32_t r = 0; r < regs_per_lane; ++r) {
+          if (!cached.write(lane, 0x200 + r, lane << 8 | r)) {
+            std::fprintf(stderr, "cached xcvr write timed out\n");
+            return EXIT_FAILURE;
+          }
+        }
+      }
+      reapply += clock_type::now() - begin;
+    }
+
+    std::printf("%-8s per-register %9.3f ms   transaction %9.3f ms   "
+                "reapply %9.3f ms\n",
+                policy, per_register.count() / iterations,
+                batched.count() / iterations, reapply.count() / iterations);
+  }
+
+  // only the first cached pass reaches the mailbox
+  uint64_t expected = (3ULL * 2 * iterations + 1) * lanes * regs_per_lane *
+                      transaction::xcvr_write_steps;
+  if (m->words() != expected) {
+    std::fprintf(stderr, "mailbox saw %llu commands, expected %llu\n",
+                 static_cast<unsigned long long>(m->words()),
+                 static_cast<unsigned long long>(expected));
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
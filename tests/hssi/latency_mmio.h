@@ -0,0 +1,95 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// A fake HSSI mailbox for the hssi-io benchmarks. The ack bit in
+// HSSI_STAT rises a fixed latency after a command is written to
+// HSSI_CTRL and falls the same latency after HSSI_CTRL is cleared.
+// mmio_pointer returns nullptr, so every access is a virtual call that
+// advances the model.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "mmio.h"
+
+class latency_mmio : public intel::fpga::mmio {
+ public:
+  typedef std::chrono::steady_clock clock;
+
+  latency_mmio(uint32_t ctrl, uint32_t stat, uint32_t latency_usec)
+      : ctrl_(ctrl),
+        stat_(stat),
+        latency_(std::chrono::microseconds(latency_usec)),
+        ack_(false),
+        target_(false),
+        change_(clock::now()),
+        words_(0) {}
+
+  bool write_mmio32(uint32_t, uint32_t) override { return true; }
+
+  bool write_mmio64(uint32_t offset, uint64_t value) override {
+    if (offset == ctrl_) {
+      settle();
+      if (value) ++words_;
+      target_ = value != 0;
+      change_ = clock::now() + latency_;
+    }
+    return true;
+  }
+
+  bool read_mmio32(uint32_t, uint32_t& value) override {
+    value = 0;
+    return true;
+  }
+
+  bool read_mmio64(uint32_t offset, uint64_t& value) override {
+    value = 0;
+    if (offset == stat_) {
+      settle();
+      if (ack_) value |= 1UL << 32;
+    }
+    return true;
+  }
+
+  uint8_t* mmio_pointer(uint32_t) override { return nullptr; }
+
+  /// Commands written to HSSI_CTRL
+  uint64_t words() const { return words_; }
+
+ private:
+  void settle() {
+    if (ack_ != target_ && clock::now() >= change_) ack_ = target_;
+  }
+
+  uint32_t ctrl_;
+  uint32_t stat_;
+  clock::duration latency_;
+  bool ack_;
+  bool target_;
+  clock::time_point change_;
+  uint64_t words_;
+};
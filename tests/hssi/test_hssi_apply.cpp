@@ -0,0 +1,159 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "config_app.h"
+
+#include <unistd.h>
+
+#include <sstream>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "option_parser.h"
+
+using namespace intel::fpga::hssi;
+using namespace intel::utils;
+
+namespace {
+
+// hssi_config against the software model of the controller
+class hssi_apply_f : public ::testing::Test {
+ protected:
+  hssi_apply_f() : app_(out_, err_) {}
+
+  void SetUp() override {
+    const char* argv[] = {"hssi_config", "--model", "none"};
+    // the parser runs getopt, whose state lasts from one test to the next
+    optind = 0;
+    option_parser parser;
+    ASSERT_TRUE(parser.parse_args(3, const_cast<char**>(argv),
+                                  app_.get_options()));
+    ASSERT_TRUE(app_.setup());
+  }
+
+  std::vector<eq_register> profile() const {
+    return {
+        eq_register(eq_register_type::hssi_mode, -1, -1, 0, 2),
+        eq_register(eq_register_type::fpga_tx, 0, 0, 0x110, 0x1f),
+        eq_register(eq_register_type::fpga_rx, 1, 0, 0x167, 0x05),
+        eq_register(eq_register_type::przone, 0, 0, 0x20, 0xa5),
+    };
+  }
+
+  std::ostringstream out_;
+  std::ostringstream err_;
+  config_app app_;
+};
+
+}  // namespace
+
+/**
+ * @test       dry_run0
+ * @brief      Test: config_app::apply
+ * @details    A dry run counts the mode change and every register,<br>
+ *             and writes none of them.<br>
+ */
+TEST_F(hssi_apply_f, dry_run0) {
+  std::vector<eq_register> regs = profile();
+  std::ostringstream plan;
+  EXPECT_EQ(app_.apply(regs.data(), regs.size(), true, plan), regs.size());
+  EXPECT_NE(plan.str().find("MODE: "), std::string::npos);
+
+  std::ostringstream again;
+  EXPECT_EQ(app_.apply(regs.data(), regs.size(), true, again), regs.size());
+}
+
+/**
+ * @test       apply0
+ * @brief      Test: config_app::apply
+ * @details    Apply changes the mode and writes what differs,<br>
+ *             after which nothing differs.<br>
+ */
+TEST_F(hssi_apply_f, apply0) {
+  std::vector<eq_register> regs = profile();
+  std::ostringstream plan;
+  ASSERT_EQ(app_.apply(regs.data(), regs.size(), false, plan), regs.size());
+  EXPECT_EQ(err_.str(), "");
+
+  std::ostringstream again;
+  EXPECT_EQ(app_.apply(regs.data(), regs.size(), false, again), 0u);
+  EXPECT_NE(again.str().find("(unchanged)"), std::string::npos);
+  EXPECT_NE(again.str().find("0 of 3 registers differ"), std::string::npos);
+}
+
+/**
+ * @test       apply1
+ * @brief      Test: config_app::apply
+ * @details    Only the registers that differ are rewritten.<br>
+ */
+TEST_F(hssi_apply_f, apply1) {
+  std::vector<eq_register> regs = profile();
+  std::ostringstream plan;
+  ASSERT_NE(app_.apply(regs.data(), regs.size(), false, plan),
+            config_app::apply_error);
+
+  regs[2].value = 0x06;
+  std::ostringstream again;
+  EXPECT_EQ(app_.apply(regs.data(), regs.size(), false, again), 1u);
+  EXPECT_NE(again.str().find("1 of 3 registers differ"), std::string::npos);
+}
+
+/**
+ * @test       load0
+ * @brief      Test: config_app::load
+ * @details    Load counts the registers written,<br>
+ *             including those already holding their value.<br>
+ */
+TEST_F(hssi_apply_f, load0) {
+  std::vector<eq_register> regs = profile();
+  EXPECT_EQ(app_.load(regs.data(), regs.size()), regs.size());
+  EXPECT_EQ(app_.load(regs.data(), regs.size()), regs.size());
+}
+
+/**
+ * @test       load1
+ * @brief      Test: config_app::load
+ * @details    A register written twice in one batch gets both writes,<br>
+ *             even when the second restores the value it held before.<br>
+ */
+TEST_F(hssi_apply_f, load1) {
+  std::vector<eq_register> before = {
+      eq_register(eq_register_type::fpga_tx, 0, 0, 0x110, 0),
+  };
+  ASSERT_EQ(app_.load(before.data(), before.size()), before.size());
+
+  std::vector<eq_register> toggle = {
+      eq_register(eq_register_type::fpga_tx, 0, 0, 0x110, 1),
+      eq_register(eq_register_type::fpga_tx, 0, 0, 0x110, 0),
+  };
+  EXPECT_EQ(app_.load(toggle.data(), toggle.size()), toggle.size());
+
+  auto model = std::dynamic_pointer_cast<hssi_model>(app_.get_mmio());
+  ASSERT_TRUE(model);
+  uint32_t value = 0xff;
+  ASSERT_TRUE(model->xcvr_register(0, 0x110, value));
+  EXPECT_EQ(value, 0u);
+  EXPECT_EQ(model->get_stats().xcvr_writes, 3u);
+}
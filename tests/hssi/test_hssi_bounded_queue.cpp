@@ -0,0 +1,122 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "bounded_queue.h"
+
+#include <thread>
+
+#include "gtest/gtest.h"
+
+using namespace intel::fpga::hssi;
+
+/**
+ * @test       fifo0
+ * @brief      Test: bounded_queue::push, bounded_queue::pop
+ * @details    Items come out in the order they went in.<br>
+ */
+TEST(hssi_bounded_queue, fifo0) {
+  bounded_queue<int> queue(4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.push(i));
+  }
+  for (int i = 0; i < 4; ++i) {
+    int item = -1;
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ(item, i);
+  }
+}
+
+/**
+ * @test       close0
+ * @brief      Test: bounded_queue::close
+ * @details    A closed queue refuses pushes,<br>
+ *             and pop drains what is left before failing.<br>
+ */
+TEST(hssi_bounded_queue, close0) {
+  bounded_queue<int> queue(4);
+  queue.push(1);
+  queue.push(2);
+  queue.close();
+  EXPECT_FALSE(queue.push(3));
+
+  int item = 0;
+  ASSERT_TRUE(queue.pop(item));
+  EXPECT_EQ(item, 1);
+  ASSERT_TRUE(queue.pop(item));
+  EXPECT_EQ(item, 2);
+  EXPECT_FALSE(queue.pop(item));
+  EXPECT_EQ(item, 2);
+}
+
+/**
+ * @test       close1
+ * @brief      Test: bounded_queue::close
+ * @details    Closing wakes a consumer waiting on an empty queue<br>
+ *             and a producer waiting on a full one.<br>
+ */
+TEST(hssi_bounded_queue, close1) {
+  bounded_queue<int> empty(1);
+  bool popped = true;
+  std::thread consumer([&empty, &popped]() {
+    int item;
+    popped = empty.pop(item);
+  });
+  empty.close();
+  consumer.join();
+  EXPECT_FALSE(popped);
+
+  bounded_queue<int> full(1);
+  ASSERT_TRUE(full.push(1));
+  bool pushed = true;
+  std::thread producer([&full, &pushed]() { pushed = full.push(2); });
+  full.close();
+  producer.join();
+  EXPECT_FALSE(pushed);
+}
+
+/**
+ * @test       bound0
+ * @brief      Test: bounded_queue::push
+ * @details    A producer never gets more than capacity items<br>
+ *             ahead of the consumer, and nothing is lost.<br>
+ */
+TEST(hssi_bounded_queue, bound0) {
+  const int count = 1000;
+  bounded_queue<int> queue(2);
+  std::thread producer([&queue]() {
+    for (int i = 0; i < count; ++i) {
+      queue.push(i);
+    }
+    queue.close();
+  });
+
+  int expected = 0;
+  int item = 0;
+  while (queue.pop(item)) {
+    EXPECT_EQ(item, expected++);
+  }
+  producer.join();
+  EXPECT_EQ(expected, count);
+}
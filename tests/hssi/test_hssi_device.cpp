@@ -0,0 +1,96 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "hssi_device.h"
+
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "hssi_model.h"
+
+using namespace intel::fpga;
+using namespace intel::fpga::hssi;
+
+/**
+ * @test       open0
+ * @brief      Test: hssi_device::open
+ * @details    The controller behind an MMIO space is found<br>
+ *             through its HSSI DFH.<br>
+ */
+TEST(hssi_device, open0) {
+  std::shared_ptr<hssi_model> model(new hssi_model());
+  hssi_device::ptr_t dev = hssi_device::open(model, "model");
+  ASSERT_TRUE(dev);
+  EXPECT_EQ(dev->name(), "model");
+  EXPECT_TRUE(dev->has_hssi_dfh());
+  EXPECT_EQ(dev->get_ctrl(), model->ctrl_offset());
+  EXPECT_EQ(dev->get_stat(), model->stat_offset());
+  EXPECT_TRUE(dev->get_dfh_index());
+}
+
+/**
+ * @test       open1
+ * @brief      Test: hssi_device::open
+ * @details    Nothing is opened without an MMIO space<br>
+ *             or a resource file.<br>
+ */
+TEST(hssi_device, open1) {
+  EXPECT_FALSE(hssi_device::open(mmio::ptr_t(), "none"));
+  EXPECT_FALSE(hssi_device::open("/nonexistent/resource0", "none"));
+}
+
+/**
+ * @test       run0
+ * @brief      Test: run_on_devices
+ * @details    Results come back in device order,<br>
+ *             and a job that throws fails its device only.<br>
+ */
+TEST(hssi_device, run0) {
+  std::vector<hssi_device::ptr_t> devices;
+  for (int i = 0; i < 4; ++i) {
+    devices.push_back(hssi_device::open(
+        mmio::ptr_t(new hssi_model()), "model" + std::to_string(i)));
+  }
+
+  auto results = run_on_devices(
+      devices, [](const hssi_device::ptr_t& device, std::ostream& out,
+                  std::ostream&) -> bool {
+        if (device->name() == "model2") {
+          throw std::runtime_error("wedged");
+        }
+        out << device->name();
+        return true;
+      });
+
+  ASSERT_EQ(results.size(), devices.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(results[i].device, devices[i]);
+    EXPECT_EQ(results[i].ok, i != 2);
+  }
+  EXPECT_EQ(results[0].output, "model0");
+  EXPECT_EQ(results[2].output, "");
+  EXPECT_NE(results[2].errors.find("wedged"), std::string::npos);
+}
@@ -0,0 +1,179 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "eq_csv.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+using namespace intel::fpga::hssi;
+
+namespace {
+
+bool parse(const char* line, eq_register& reg) {
+  return eq_csv_reader::parse_line(line, line + std::strlen(line), reg);
+}
+
+}  // namespace
+
+/**
+ * @test       parse0
+ * @brief      Test: eq_csv_reader::parse_line
+ * @details    Types by name or number, numbers decimal, hex or octal,<br>
+ *             and blanks around the fields.<br>
+ */
+TEST(hssi_eq_csv, parse0) {
+  eq_register reg;
+  ASSERT_TRUE(parse("FPGA_TX,3,-1,0x109,0x1f", reg));
+  EXPECT_EQ(reg.type, eq_register_type::fpga_tx);
+  EXPECT_EQ(reg.channel_lane, 3);
+  EXPECT_EQ(reg.device, -1);
+  EXPECT_EQ(reg.address, 0x109u);
+  EXPECT_EQ(reg.value, 0x1fu);
+
+  ASSERT_TRUE(parse(" RTMR_RX , 2 , 0x30 , 010 , 7 \r", reg));
+  EXPECT_EQ(reg.type, eq_register_type::retimer_rx);
+  EXPECT_EQ(reg.device, 0x30);
+  EXPECT_EQ(reg.address, 8u);
+  EXPECT_EQ(reg.value, 7u);
+
+  ASSERT_TRUE(parse("5,-1,-1,0,2,ignored,fields", reg));
+  EXPECT_EQ(reg.type, eq_register_type::hssi_mode);
+  EXPECT_EQ(reg.value, 2u);
+
+  ASSERT_TRUE(parse("MDIO,1,0,0x20", reg));
+  EXPECT_EQ(reg.type, eq_register_type::mdio);
+  EXPECT_EQ(reg.value, 0u);
+}
+
+/**
+ * @test       parse1
+ * @brief      Test: eq_csv_reader::parse_line
+ * @details    Unknown types, bad or missing fields and headings<br>
+ *             are refused, leaving the register as it was.<br>
+ */
+TEST(hssi_eq_csv, parse1) {
+  eq_register reg(eq_register_type::przone, 1, 2, 3, 4);
+  EXPECT_FALSE(parse("TYPE,LANE,DEVICE,ADDRESS,VALUE", reg));
+  EXPECT_FALSE(parse("FPGA_XX,0,0,0x100,1", reg));
+  EXPECT_FALSE(parse("fpga_tx,0,0,0x100,1", reg));
+  EXPECT_FALSE(parse("FPGA_TX,0,0", reg));
+  EXPECT_FALSE(parse("FPGA_TX,0,0,0x10g,1", reg));
+  EXPECT_FALSE(parse("FPGA_TX,0,0,,1", reg));
+  EXPECT_FALSE(parse("FPGA_TX,0,0,-1,1", reg));
+  EXPECT_FALSE(parse("FPGA_TX,0,0,0x100,0x100000000", reg));
+  EXPECT_FALSE(parse("FPGA_TX,0x80000000,0,0x100,1", reg));
+  EXPECT_FALSE(parse("256,0,0,0x100,1", reg));
+  EXPECT_EQ(reg.type, eq_register_type::przone);
+  EXPECT_EQ(reg.address, 3u);
+}
+
+/**
+ * @test       parse2
+ * @brief      Test: eq_csv_reader::parse_line
+ * @details    Addresses and values are 32 bits wide,<br>
+ *             not limited to 16.<br>
+ */
+TEST(hssi_eq_csv, parse2) {
+  eq_register reg;
+  ASSERT_TRUE(parse("PRZONE,0,0,0x10000,0xffffffff", reg));
+  EXPECT_EQ(reg.address, 0x10000u);
+  EXPECT_EQ(reg.value, 0xffffffffu);
+  ASSERT_TRUE(parse("FPGA_RX,0,0,0xffffffff,1", reg));
+  EXPECT_EQ(reg.address, 0xffffffffu);
+}
+
+/**
+ * @test       names0
+ * @brief      Test: str_register_type_map, register_type_str_map
+ * @details    Every type name maps back to itself.<br>
+ */
+TEST(hssi_eq_csv, names0) {
+  EXPECT_EQ(str_register_type_map.size(), register_type_str_map.size());
+  for (const auto& name : str_register_type_map) {
+    auto it = register_type_str_map.find(name.second);
+    ASSERT_NE(it, register_type_str_map.end());
+    EXPECT_EQ(it->second, name.first);
+  }
+}
+
+/**
+ * @test       next0
+ * @brief      Test: eq_csv_reader::next
+ * @details    Blank lines and comments are passed over,<br>
+ *             lines that do not parse are counted as skipped.<br>
+ */
+TEST(hssi_eq_csv, next0) {
+  std::string path = "/tmp/test_hssi_eq_csv." + std::to_string(::getpid());
+  {
+    std::ofstream f(path);
+    f << "TYPE,LANE,DEVICE,ADDRESS,VALUE\n"
+         "\n"
+         "  # FPGA_TX,9,9,9,9\n"
+         "FPGA_TX,0,-1,0x109,1\r\n"
+         "\t\n"
+         "MODE,-1,-1,0,2";
+  }
+  std::string error;
+  eq_csv_reader::ptr_t reader = eq_csv_reader::open(path, error);
+  std::remove(path.c_str());
+  ASSERT_TRUE(reader) << error;
+
+  eq_register reg;
+  ASSERT_TRUE(reader->next(reg));
+  EXPECT_EQ(reg.type, eq_register_type::fpga_tx);
+  EXPECT_EQ(reader->line(), 4u);
+  ASSERT_TRUE(reader->next(reg));
+  EXPECT_EQ(reg.type, eq_register_type::hssi_mode);
+  EXPECT_EQ(reader->line(), 6u);
+  EXPECT_FALSE(reader->next(reg));
+  EXPECT_EQ(reader->skipped(), 1u);
+}
+
+/**
+ * @test       open0
+ * @brief      Test: eq_csv_reader::open
+ * @details    A missing file is refused,<br>
+ *             an empty one holds no registers.<br>
+ */
+TEST(hssi_eq_csv, open0) {
+  std::string path = "/tmp/test_hssi_eq_csv." + std::to_string(::getpid());
+  std::string error;
+  EXPECT_FALSE(eq_csv_reader::open(path, error));
+  EXPECT_EQ(error, "cannot open");
+
+  std::ofstream(path).close();
+  eq_csv_reader::ptr_t reader = eq_csv_reader::open(path, error);
+  std::remove(path.c_str());
+  ASSERT_TRUE(reader) << error;
+  eq_register reg;
+  EXPECT_FALSE(reader->next(reg));
+}
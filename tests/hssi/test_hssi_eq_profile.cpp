@@ -0,0 +1,183 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "eq_profile.h"
+
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace intel::fpga::hssi;
+
+namespace {
+
+eq_register xcvr(int32_t lane, uint32_t address, uint32_t value) {
+  return eq_register(eq_register_type::fpga_tx, lane, 0, address, value);
+}
+
+eq_register retimer(int32_t device, int32_t channel, uint32_t address) {
+  return eq_register(eq_register_type::retimer_tx, channel, device, address,
+                     0);
+}
+
+eq_register mode(uint32_t value) {
+  return eq_register(eq_register_type::hssi_mode, -1, -1, 0, value);
+}
+
+class hssi_eq_profile_f : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path_ = "/tmp/test_hssi_eq_profile." + std::to_string(::getpid()) +
+            ".eqp";
+  }
+
+  void TearDown() override { std::remove(path_.c_str()); }
+
+  std::string path_;
+};
+
+}  // namespace
+
+/**
+ * @test       arrange0
+ * @brief      Test: eq_profile::arrange
+ * @details    Transceivers are grouped by lane ahead of retimers,<br>
+ *             and registers of one lane keep their CSV order.<br>
+ */
+TEST(hssi_eq_profile, arrange0) {
+  std::vector<eq_register> regs = {
+      retimer(0x32, 1, 0x10), xcvr(1, 0x300, 1), xcvr(0, 0x200, 2),
+      xcvr(1, 0x100, 3),      retimer(0x30, 2, 0x20), xcvr(0, 0x100, 4),
+  };
+  eq_profile::arrange(regs);
+
+  ASSERT_EQ(regs.size(), 6u);
+  EXPECT_EQ(regs[0].channel_lane, 0);
+  EXPECT_EQ(regs[0].address, 0x200u);
+  EXPECT_EQ(regs[1].address, 0x100u);
+  EXPECT_EQ(regs[2].channel_lane, 1);
+  EXPECT_EQ(regs[2].address, 0x300u);
+  EXPECT_EQ(regs[3].address, 0x100u);
+  EXPECT_EQ(regs[4].device, 0x30);
+  EXPECT_EQ(regs[5].device, 0x32);
+}
+
+/**
+ * @test       arrange1
+ * @brief      Test: eq_profile::arrange
+ * @details    No register moves across a mode change.<br>
+ */
+TEST(hssi_eq_profile, arrange1) {
+  std::vector<eq_register> regs = {
+      xcvr(3, 0x100, 1), mode(2), xcvr(1, 0x100, 2), xcvr(0, 0x100, 3),
+  };
+  eq_profile::arrange(regs);
+
+  EXPECT_EQ(regs[0].channel_lane, 3);
+  EXPECT_EQ(regs[1].type, eq_register_type::hssi_mode);
+  EXPECT_EQ(regs[2].channel_lane, 0);
+  EXPECT_EQ(regs[3].channel_lane, 1);
+}
+
+/**
+ * @test       write0
+ * @brief      Test: eq_profile::write, eq_profile::open
+ * @details    A compiled profile maps back to the arranged registers.<br>
+ */
+TEST_F(hssi_eq_profile_f, write0) {
+  std::vector<eq_register> regs = {
+      mode(1), xcvr(2, 0x110, 0x1f), xcvr(0, 0x167, 5), retimer(0x30, 0, 0x2f),
+  };
+  std::string error;
+  ASSERT_TRUE(eq_profile::write(path_, regs, error)) << error;
+  EXPECT_TRUE(eq_profile::is_profile(path_));
+
+  eq_profile::ptr_t profile = eq_profile::open(path_, error);
+  ASSERT_TRUE(profile) << error;
+  eq_profile::arrange(regs);
+  ASSERT_EQ(profile->size(), regs.size());
+  for (size_t i = 0; i < regs.size(); ++i) {
+    const eq_register& r = profile->data()[i];
+    EXPECT_EQ(r.type, regs[i].type);
+    EXPECT_EQ(r.channel_lane, regs[i].channel_lane);
+    EXPECT_EQ(r.device, regs[i].device);
+    EXPECT_EQ(r.address, regs[i].address);
+    EXPECT_EQ(r.value, regs[i].value);
+  }
+}
+
+/**
+ * @test       crc0
+ * @brief      Test: eq_profile::open
+ * @details    A profile whose records changed after compile<br>
+ *             fails its checksum.<br>
+ */
+TEST_F(hssi_eq_profile_f, crc0) {
+  std::vector<eq_register> regs = {xcvr(0, 0x100, 1), xcvr(1, 0x100, 2)};
+  std::string error;
+  ASSERT_TRUE(eq_profile::write(path_, regs, error)) << error;
+
+  {
+    std::fstream f(path_, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(sizeof(eq_profile_header) + offsetof(eq_register, value));
+    f.put('\x7f');
+  }
+  EXPECT_FALSE(eq_profile::open(path_, error));
+  EXPECT_EQ(error, "profile checksum mismatch");
+}
+
+/**
+ * @test       open0
+ * @brief      Test: eq_profile::open
+ * @details    A missing, foreign or truncated file is refused.<br>
+ */
+TEST_F(hssi_eq_profile_f, open0) {
+  std::string error;
+  EXPECT_FALSE(eq_profile::open(path_, error));
+  EXPECT_EQ(error, "cannot open");
+
+  {
+    std::ofstream f(path_);
+    f << "TYPE,LANE,DEVICE,ADDRESS,VALUE\n"
+         "FPGA_TX,0,0,0x100,0x1,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,,\n";
+  }
+  EXPECT_FALSE(eq_profile::is_profile(path_));
+  EXPECT_FALSE(eq_profile::open(path_, error));
+  EXPECT_EQ(error, "not a compiled equalization profile");
+
+  std::vector<eq_register> regs = {xcvr(0, 0x100, 1), xcvr(1, 0x100, 2)};
+  ASSERT_TRUE(eq_profile::write(path_, regs, error)) << error;
+  ASSERT_EQ(::truncate(path_.c_str(),
+                       sizeof(eq_profile_header) + sizeof(eq_register) + 4),
+            0);
+  EXPECT_FALSE(eq_profile::open(path_, error));
+  EXPECT_EQ(error, "truncated profile");
+}
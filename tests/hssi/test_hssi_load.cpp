@@ -0,0 +1,120 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "config_app.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "option_parser.h"
+
+using namespace intel::fpga::hssi;
+using namespace intel::utils;
+
+namespace {
+
+class hssi_load_f : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    base_ = "/tmp/test_hssi_load." + std::to_string(::getpid());
+    csv_ = base_ + ".csv";
+    std::ofstream f(csv_);
+    f << "# lane,device,address,value\n"
+         "MODE,-1,-1,0,1\n";
+    // enough registers for several chunks of load_stream
+    for (uint32_t i = 0; i < 3 * config_app::load_chunk; ++i) {
+      f << "FPGA_TX," << i % 16 << ",-1," << 0x100 + i / 16 << "," << i % 32
+        << "\n";
+    }
+    f << "RTMR_RX,0,0x30,0x12,0x5\n"
+         "PRZONE,0,0,0x20,0xa5\n";
+  }
+
+  void TearDown() override {
+    std::remove(csv_.c_str());
+    std::remove((base_ + ".0.trace").c_str());
+    std::remove((base_ + ".1.trace").c_str());
+  }
+
+  // hssi_config with args, then command
+  uint32_t run(std::vector<std::string> args,
+               const std::vector<std::string>& command) {
+    std::ostringstream out;
+    config_app app(out, err_);
+    args.insert(args.begin(), "hssi_config");
+    std::vector<char*> argv;
+    for (auto& a : args) argv.push_back(&a[0]);
+    // the parser runs getopt, whose state lasts from one test to the next
+    optind = 0;
+    option_parser parser;
+    if (!parser.parse_args(static_cast<int>(argv.size()), argv.data(),
+                           app.get_options()) ||
+        !app.setup()) {
+      return EXIT_FAILURE;
+    }
+    return app.run(command);
+  }
+
+  std::string base_;
+  std::string csv_;
+  std::ostringstream err_;
+};
+
+}  // namespace
+
+/**
+ * @test       replay0
+ * @brief      Test: config_app::load_stream
+ * @details    A load recorded against the model is one trace file,<br>
+ *             which replays the same load without a mismatch.<br>
+ */
+TEST_F(hssi_load_f, replay0) {
+  ASSERT_EQ(run({"--model", "none", "--trace", base_}, {"load", csv_}),
+            static_cast<uint32_t>(EXIT_SUCCESS))
+      << err_.str();
+  EXPECT_FALSE(std::ifstream(base_ + ".1.trace"));
+
+  err_.str("");
+  EXPECT_EQ(run({"--replay", base_ + ".0.trace"}, {"load", csv_}),
+            static_cast<uint32_t>(EXIT_SUCCESS))
+      << err_.str();
+  EXPECT_NE(err_.str().find(" 0 mismatches"), std::string::npos);
+}
+
+/**
+ * @test       load0
+ * @brief      Test: config_app::load_stream
+ * @details    A missing file fails the load.<br>
+ */
+TEST_F(hssi_load_f, load0) {
+  EXPECT_EQ(run({"--model", "none"}, {"load", base_ + ".missing"}),
+            static_cast<uint32_t>(EXIT_FAILURE));
+}
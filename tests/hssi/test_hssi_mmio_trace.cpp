@@ -0,0 +1,241 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "mmio_trace.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace intel::fpga;
+using namespace intel::fpga::hssi;
+
+namespace {
+
+// Registers kept in memory; accesses to fail_offset fail
+class memory_mmio : public mmio {
+ public:
+  memory_mmio() : fail_offset(~0u) {}
+
+  bool write_mmio32(uint32_t offset, uint32_t value) override {
+    regs[offset] = value;
+    return offset != fail_offset;
+  }
+  bool write_mmio64(uint32_t offset, uint64_t value) override {
+    regs[offset] = value;
+    return offset != fail_offset;
+  }
+  bool read_mmio32(uint32_t offset, uint32_t& value) override {
+    value = static_cast<uint32_t>(regs[offset]);
+    return offset != fail_offset;
+  }
+  bool read_mmio64(uint32_t offset, uint64_t& value) override {
+    value = regs[offset];
+    return offset != fail_offset;
+  }
+  uint8_t* mmio_pointer(uint32_t) override { return nullptr; }
+
+  std::map<uint32_t, uint64_t> regs;
+  uint32_t fail_offset;
+};
+
+class hssi_mmio_trace_f : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    prefix_ = "/tmp/test_hssi_mmio_trace." + std::to_string(::getpid());
+    target_.reset(new memory_mmio());
+  }
+
+  void TearDown() override {
+    for (const auto& f : files_) {
+      std::remove(f.c_str());
+    }
+  }
+
+  // records of the trace files, after the trace is gone and its
+  // rings were unmapped
+  std::vector<trace_file> finish(mmio_trace::ptr_t& trace) {
+    files_ = trace->files();
+    trace.reset();
+    std::vector<trace_file> loaded(files_.size());
+    for (size_t i = 0; i < files_.size(); ++i) {
+      std::string error;
+      EXPECT_TRUE(loaded[i].load(files_[i], error)) << files_[i] << ": "
+                                                   << error;
+    }
+    return loaded;
+  }
+
+  std::string prefix_;
+  std::shared_ptr<memory_mmio> target_;
+  std::vector<std::string> files_;
+};
+
+}  // namespace
+
+/**
+ * @test       record0
+ * @brief      Test: mmio_trace, trace_file::load
+ * @details    Every access is loaded back in order, with its kind,<br>
+ *             offset, value, tag and outcome.<br>
+ */
+TEST_F(hssi_mmio_trace_f, record0) {
+  mmio_trace::ptr_t trace(new mmio_trace(target_, prefix_));
+  target_->fail_offset = 0x30;
+  {
+    trace_scope scope(trace_tag::xcvr_write);
+    EXPECT_TRUE(trace->write_mmio64(0x10, 0x1122334455667788ULL));
+    EXPECT_TRUE(trace->write_mmio32(0x20, 0xabcd));
+  }
+  uint64_t value64 = 0;
+  uint32_t value32 = 0;
+  EXPECT_TRUE(trace->read_mmio64(0x10, value64));
+  EXPECT_FALSE(trace->read_mmio32(0x30, value32));
+
+  std::vector<trace_file> files = finish(trace);
+  ASSERT_EQ(files.size(), 1u);
+  const trace_file& f = files[0];
+  EXPECT_EQ(f.header.head, 4u);
+  EXPECT_EQ(f.header.thread, static_cast<uint32_t>(::syscall(SYS_gettid)));
+  ASSERT_EQ(f.records.size(), 4u);
+
+  const trace_record* r = f.records.data();
+  EXPECT_EQ(r[0].access, static_cast<uint8_t>(trace_access::write64));
+  EXPECT_EQ(r[0].offset, 0x10u);
+  EXPECT_EQ(r[0].value, 0x1122334455667788ULL);
+  EXPECT_EQ(r[0].tag, static_cast<uint8_t>(trace_tag::xcvr_write));
+  EXPECT_EQ(r[1].access, static_cast<uint8_t>(trace_access::write32));
+  EXPECT_EQ(r[1].value, 0xabcdu);
+  EXPECT_EQ(r[1].op, r[0].op);
+  EXPECT_EQ(r[2].access, static_cast<uint8_t>(trace_access::read64));
+  EXPECT_EQ(r[2].value, 0x1122334455667788ULL);
+  EXPECT_EQ(r[2].tag, static_cast<uint8_t>(trace_tag::none));
+  EXPECT_EQ(r[3].access, static_cast<uint8_t>(trace_access::read32));
+  EXPECT_EQ(r[3].flags & trace_failed, trace_failed);
+  EXPECT_EQ(r[0].flags & trace_failed, 0);
+  for (size_t i = 1; i < f.records.size(); ++i) {
+    EXPECT_GE(r[i].tsc, r[i - 1].tsc);
+  }
+}
+
+/**
+ * @test       live0
+ * @brief      Test: trace_file::load
+ * @details    The records are in the file while the trace<br>
+ *             is still open, as after a crash.<br>
+ */
+TEST_F(hssi_mmio_trace_f, live0) {
+  mmio_trace::ptr_t trace(new mmio_trace(target_, prefix_));
+  for (uint32_t i = 0; i < 3; ++i) {
+    trace->write_mmio32(0x40, i);
+  }
+  std::vector<std::string> paths = trace->files();
+  ASSERT_EQ(paths.size(), 1u);
+  trace_file f;
+  std::string error;
+  ASSERT_TRUE(f.load(paths[0], error)) << error;
+  EXPECT_EQ(f.records.size(), 3u);
+  finish(trace);
+}
+
+/**
+ * @test       wrap0
+ * @brief      Test: trace_file::load
+ * @details    Once the ring wrapped, the newest capacity records<br>
+ *             are loaded, oldest first.<br>
+ */
+TEST_F(hssi_mmio_trace_f, wrap0) {
+  const size_t capacity = 4;
+  mmio_trace::ptr_t trace(new mmio_trace(target_, prefix_, capacity));
+  for (uint32_t i = 0; i < 10; ++i) {
+    trace->write_mmio32(0x40, i);
+  }
+
+  std::vector<trace_file> files = finish(trace);
+  ASSERT_EQ(files.size(), 1u);
+  EXPECT_EQ(files[0].header.capacity, capacity);
+  EXPECT_EQ(files[0].header.head, 10u);
+  ASSERT_EQ(files[0].records.size(), capacity);
+  for (size_t i = 0; i < capacity; ++i) {
+    EXPECT_EQ(files[0].records[i].value, 6 + i);
+  }
+}
+
+/**
+ * @test       threads0
+ * @brief      Test: mmio_trace::files
+ * @details    Each thread records into a ring file of its own,<br>
+ *             holding that thread's accesses only.<br>
+ */
+TEST_F(hssi_mmio_trace_f, threads0) {
+  mmio_trace::ptr_t trace(new mmio_trace(target_, prefix_));
+  trace->write_mmio32(0x50, 0);
+  std::thread other([&trace]() {
+    for (uint32_t i = 1; i <= 2; ++i) {
+      trace->write_mmio32(0x60, i);
+    }
+  });
+  other.join();
+
+  std::vector<trace_file> files = finish(trace);
+  ASSERT_EQ(files.size(), 2u);
+  EXPECT_EQ(files[0].path, prefix_ + ".0.trace");
+  EXPECT_EQ(files[1].path, prefix_ + ".1.trace");
+  EXPECT_NE(files[0].header.thread, files[1].header.thread);
+  ASSERT_EQ(files[0].records.size(), 1u);
+  EXPECT_EQ(files[0].records[0].offset, 0x50u);
+  ASSERT_EQ(files[1].records.size(), 2u);
+  EXPECT_EQ(files[1].records[0].offset, 0x60u);
+  EXPECT_EQ(files[1].records[1].value, 2u);
+}
+
+/**
+ * @test       load0
+ * @brief      Test: trace_file::load
+ * @details    A missing file or one that is not a trace<br>
+ *             is refused with a reason.<br>
+ */
+TEST_F(hssi_mmio_trace_f, load0) {
+  trace_file f;
+  std::string error;
+  EXPECT_FALSE(f.load(prefix_ + ".missing", error));
+  EXPECT_FALSE(error.empty());
+
+  files_.push_back(prefix_ + ".bogus");
+  FILE* bogus = std::fopen(files_.back().c_str(), "w");
+  ASSERT_NE(bogus, nullptr);
+  std::fputs("not a trace, but long enough to hold a whole header ....", bogus);
+  std::fclose(bogus);
+  error.clear();
+  EXPECT_FALSE(f.load(files_.back(), error));
+  EXPECT_EQ(error, "not an HSSI MMIO trace");
+}
@@ -0,0 +1,143 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "poll.h"
+
+#include <cstdint>
+
+#include "gtest/gtest.h"
+
+using namespace intel::fpga::hssi;
+
+/**
+ * @test       parse0
+ * @brief      Test: poller::parse
+ * @details    Each policy name selects its policy,<br>
+ *             and an unknown name is refused.<br>
+ */
+TEST(hssi_poll, parse0) {
+  poll_config config;
+  ASSERT_TRUE(poller::parse("spin", config));
+  EXPECT_EQ(config.policy, poll_policy::spin);
+  ASSERT_TRUE(poller::parse("yield", config));
+  EXPECT_EQ(config.policy, poll_policy::spin_yield);
+  ASSERT_TRUE(poller::parse("sleep", config));
+  EXPECT_EQ(config.policy, poll_policy::spin_sleep);
+  ASSERT_TRUE(poller::parse("legacy", config));
+  EXPECT_EQ(config.policy, poll_policy::sleep);
+  EXPECT_EQ(config.spin_usec, 0u);
+  EXPECT_FALSE(poller::parse("busy", config));
+}
+
+/**
+ * @test       defaults0
+ * @brief      Test: poller::set_defaults
+ * @details    A poller created after set_defaults<br>
+ *             uses the new configuration.<br>
+ */
+TEST(hssi_poll, defaults0) {
+  poll_config saved = poller::get_defaults();
+  poll_config config = {poll_policy::spin_yield, 7, 3, 9};
+  poller::set_defaults(config);
+  poller p;
+  EXPECT_EQ(p.config().policy, poll_policy::spin_yield);
+  EXPECT_EQ(p.config().spin_usec, 7u);
+  EXPECT_EQ(p.config().sleep_usec, 3u);
+  EXPECT_EQ(p.config().max_sleep_usec, 9u);
+  poller::set_defaults(saved);
+}
+
+/**
+ * @test       ready0
+ * @brief      Test: poller::wait
+ * @details    A condition that already holds<br>
+ *             is polled once.<br>
+ */
+TEST(hssi_poll, ready0) {
+  poller p;
+  EXPECT_TRUE(p.wait([]() { return poll_status::ready; }, 1000));
+  EXPECT_EQ(p.stats().waits, 1u);
+  EXPECT_EQ(p.stats().polls, 1u);
+  EXPECT_EQ(p.stats().timeouts, 0u);
+}
+
+/**
+ * @test       pending0
+ * @brief      Test: poller::wait
+ * @details    Under every policy, a condition that becomes ready<br>
+ *             is polled until it does, and its duration is reported.<br>
+ */
+TEST(hssi_poll, pending0) {
+  for (const char* name : {"spin", "yield", "sleep", "legacy"}) {
+    poll_config config;
+    ASSERT_TRUE(poller::parse(name, config));
+    poller p(config);
+    int pending = 3;
+    uint32_t duration = UINT32_MAX;
+    EXPECT_TRUE(p.wait(
+        [&pending]() {
+          return pending-- > 0 ? poll_status::pending : poll_status::ready;
+        },
+        1000000, &duration)) << name;
+    EXPECT_EQ(p.stats().last_polls, 4u) << name;
+    EXPECT_EQ(p.stats().max_polls, 4u) << name;
+    EXPECT_NE(duration, UINT32_MAX) << name;
+  }
+}
+
+/**
+ * @test       timeout0
+ * @brief      Test: poller::wait
+ * @details    A condition that never holds<br>
+ *             fails once the deadline passes and counts a timeout.<br>
+ */
+TEST(hssi_poll, timeout0) {
+  poller p;
+  EXPECT_FALSE(p.wait([]() { return poll_status::pending; }, 200));
+  EXPECT_EQ(p.stats().waits, 1u);
+  EXPECT_EQ(p.stats().timeouts, 1u);
+  EXPECT_GT(p.stats().polls, 1u);
+
+  p.reset_stats();
+  EXPECT_EQ(p.stats().waits, 0u);
+  EXPECT_EQ(p.stats().timeouts, 0u);
+}
+
+/**
+ * @test       error0
+ * @brief      Test: poller::wait
+ * @details    A condition reporting an error<br>
+ *             fails at once and counts an error, not a timeout.<br>
+ */
+TEST(hssi_poll, error0) {
+  poller p;
+  EXPECT_FALSE(p.wait([]() { return poll_status::error; }, 1000000));
+  uint32_t duration = 0;
+  EXPECT_FALSE(p.wait([]() { return poll_status::error; }, 1000000,
+                      &duration));
+  EXPECT_EQ(p.stats().errors, 2u);
+  EXPECT_EQ(p.stats().timeouts, 0u);
+}
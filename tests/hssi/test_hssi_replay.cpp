@@ -0,0 +1,94 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "mmio_replay.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace intel::fpga::hssi;
+
+namespace {
+
+trace_record record(trace_access access, uint32_t offset, uint64_t value,
+                    uint8_t flags = 0) {
+  trace_record rec = {};
+  rec.access = static_cast<uint8_t>(access);
+  rec.offset = offset;
+  rec.value = value;
+  rec.flags = flags;
+  return rec;
+}
+
+}  // end of anonymous namespace
+
+/**
+ * @test       poll0
+ * @brief      Test: mmio_replay::read
+ * @details    Ack polls beyond the recorded ones<br>
+ *             read the last recorded value again,<br>
+ *             and are not mismatches.<br>
+ */
+TEST(hssi_replay, poll0) {
+  std::vector<trace_record> records = {
+      record(trace_access::write64, 0x10, 1),
+      record(trace_access::read64, 0x18, 2, trace_ack_poll)};
+  mmio_replay replay(records, 0);
+  uint64_t value = 0;
+  EXPECT_TRUE(replay.write_mmio64(0x10, 1));
+  EXPECT_TRUE(replay.read_mmio64(0x18, value));
+  EXPECT_EQ(value, 2u);
+  value = 0;
+  EXPECT_TRUE(replay.read_mmio64(0x18, value));
+  EXPECT_EQ(value, 2u);
+  EXPECT_TRUE(replay.finished());
+  EXPECT_EQ(replay.get_stats().repeated_polls, 1u);
+  EXPECT_EQ(replay.get_stats().mismatches, 0u);
+}
+
+/**
+ * @test       read0
+ * @brief      Test: mmio_replay::read
+ * @details    A read beyond the trace of a register<br>
+ *             not last read as an ack poll<br>
+ *             fails and is counted as a mismatch.<br>
+ */
+TEST(hssi_replay, read0) {
+  std::vector<trace_record> records = {
+      record(trace_access::read64, 0x18, 2, trace_ack_poll),
+      record(trace_access::read64, 0x20, 3)};
+  mmio_replay replay(records, 0);
+  uint64_t value = 0;
+  EXPECT_TRUE(replay.read_mmio64(0x18, value));
+  EXPECT_TRUE(replay.read_mmio64(0x20, value));
+  EXPECT_EQ(value, 3u);
+  EXPECT_FALSE(replay.read_mmio64(0x20, value));
+  EXPECT_EQ(replay.get_stats().repeated_polls, 0u);
+  EXPECT_EQ(replay.get_stats().mismatches, 1u);
+  ASSERT_EQ(replay.mismatches().size(), 1u);
+}
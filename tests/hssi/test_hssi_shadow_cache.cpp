@@ -0,0 +1,214 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "shadow_cache.h"
+
+#include <cstdint>
+
+#include "gtest/gtest.h"
+#include "mdio.h"
+
+using namespace intel::fpga::hssi;
+
+namespace {
+
+const shadow_cache::target xcvr = shadow_cache::target::xcvr;
+const shadow_cache::target mdio_target = shadow_cache::target::mdio;
+
+// An MDIO bus whose commands complete at once and whose data register
+// counts the reads, like a PHY counter
+class counting_przone : public przone_interface {
+ public:
+  counting_przone() : reads(0), writes(0) {}
+
+  bool read(uint32_t address, uint32_t& value) override {
+    if (address == mdio_rd_data_reg) {
+      value = ++reads;
+    } else {
+      value = 0;
+    }
+    return true;
+  }
+
+  bool write(uint32_t address, uint32_t) override {
+    if (address == mdio_ctrl_reg) ++writes;
+    return true;
+  }
+
+  uint32_t reads;
+  uint32_t writes;
+};
+
+}  // namespace
+
+/**
+ * @test       lookup0
+ * @brief      Test: shadow_cache::lookup
+ * @details    A register is unknown until updated,<br>
+ *             and each target keeps its own entries.<br>
+ */
+TEST(hssi_shadow_cache, lookup0) {
+  shadow_cache cache;
+  uint32_t value = 0;
+  EXPECT_FALSE(cache.lookup(xcvr, 1, value));
+  cache.update(xcvr, 1, 0x55);
+  ASSERT_TRUE(cache.lookup(xcvr, 1, value));
+  EXPECT_EQ(value, 0x55u);
+  EXPECT_FALSE(cache.lookup(shadow_cache::target::retimer, 1, value));
+}
+
+/**
+ * @test       invalidate0
+ * @brief      Test: shadow_cache::invalidate
+ * @details    Invalidating a target retires its entries only,<br>
+ *             and erase forgets a single register.<br>
+ */
+TEST(hssi_shadow_cache, invalidate0) {
+  shadow_cache cache;
+  uint32_t value = 0;
+  cache.update(xcvr, 1, 1);
+  cache.update(xcvr, 2, 2);
+  cache.update(mdio_target, 1, 3);
+  cache.erase(xcvr, 2);
+  EXPECT_TRUE(cache.lookup(xcvr, 1, value));
+  EXPECT_FALSE(cache.lookup(xcvr, 2, value));
+
+  uint32_t epoch = cache.epoch(xcvr);
+  cache.invalidate(xcvr);
+  EXPECT_EQ(cache.epoch(xcvr), epoch + 1);
+  EXPECT_FALSE(cache.lookup(xcvr, 1, value));
+  EXPECT_TRUE(cache.lookup(mdio_target, 1, value));
+
+  cache.update(xcvr, 1, 4);
+  ASSERT_TRUE(cache.lookup(xcvr, 1, value));
+  EXPECT_EQ(value, 4u);
+}
+
+/**
+ * @test       read0
+ * @brief      Test: shadow_cache::read
+ * @details    Only a miss reads the hardware,<br>
+ *             and a failed read records nothing.<br>
+ */
+TEST(hssi_shadow_cache, read0) {
+  shadow_cache cache;
+  uint32_t hw_reads = 0;
+  auto read_hw = [&hw_reads](uint32_t& v) {
+    v = 0x12;
+    ++hw_reads;
+    return true;
+  };
+  uint32_t value = 0;
+  EXPECT_FALSE(cache.read(xcvr, 7, value, [](uint32_t&) { return false; }));
+  ASSERT_TRUE(cache.read(xcvr, 7, value, read_hw));
+  ASSERT_TRUE(cache.read(xcvr, 7, value, read_hw));
+  EXPECT_EQ(value, 0x12u);
+  EXPECT_EQ(hw_reads, 1u);
+  EXPECT_EQ(cache.get_stats().read_hits, 1u);
+  EXPECT_EQ(cache.get_stats().read_misses, 2u);
+}
+
+/**
+ * @test       write0
+ * @brief      Test: shadow_cache::write
+ * @details    A write of the value already held is skipped,<br>
+ *             and a failed write forgets the register.<br>
+ */
+TEST(hssi_shadow_cache, write0) {
+  shadow_cache cache;
+  uint32_t hw_writes = 0;
+  auto write_hw = [&hw_writes]() {
+    ++hw_writes;
+    return true;
+  };
+  EXPECT_TRUE(cache.write(xcvr, 3, 0x10, write_hw));
+  EXPECT_TRUE(cache.write(xcvr, 3, 0x10, write_hw));
+  EXPECT_EQ(hw_writes, 1u);
+  EXPECT_EQ(cache.get_stats().writes_skipped, 1u);
+
+  uint32_t value = 0;
+  EXPECT_FALSE(cache.write(xcvr, 3, 0x20, []() { return false; }));
+  EXPECT_FALSE(cache.lookup(xcvr, 3, value));
+}
+
+/**
+ * @test       disabled0
+ * @brief      Test: shadow_cache::set_enabled
+ * @details    A disabled cache records nothing,<br>
+ *             so every access reaches the hardware.<br>
+ */
+TEST(hssi_shadow_cache, disabled0) {
+  shadow_cache cache;
+  cache.update(xcvr, 1, 1);
+  cache.set_enabled(false);
+  uint32_t value = 0;
+  EXPECT_FALSE(cache.lookup(xcvr, 1, value));
+  uint32_t hw_writes = 0;
+  auto write_hw = [&hw_writes]() {
+    ++hw_writes;
+    return true;
+  };
+  cache.write(xcvr, 1, 1, write_hw);
+  cache.write(xcvr, 1, 1, write_hw);
+  EXPECT_EQ(hw_writes, 2u);
+
+  cache.set_enabled(true);
+  EXPECT_FALSE(cache.lookup(xcvr, 1, value));
+}
+
+/**
+ * @test       mdio0
+ * @brief      Test: mdio::read, mdio::write
+ * @details    MDIO reads and writes always reach the device,<br>
+ *             even a write of the value last read or written.<br>
+ */
+TEST(hssi_shadow_cache, mdio0) {
+  std::shared_ptr<counting_przone> przone(new counting_przone());
+  shadow_cache::ptr_t cache(new shadow_cache());
+  mdio bus(przone, cache);
+
+  uint32_t value = 0;
+  ASSERT_TRUE(bus.read(1, 0, 0x20, value));
+  EXPECT_EQ(value, 1u);
+  ASSERT_TRUE(bus.read(1, 0, 0x20, value));
+  EXPECT_EQ(value, 2u);
+  EXPECT_EQ(cache->get_stats().read_hits, 0u);
+
+  uint32_t commands = przone->writes;
+  EXPECT_TRUE(bus.write(1, 0, 0x20, 2));
+  EXPECT_GT(przone->writes, commands);
+
+  // a self-clearing reset bit, written twice
+  commands = przone->writes;
+  EXPECT_TRUE(bus.write(1, 0, 0x00, 0x8000));
+  uint32_t once = przone->writes - commands;
+  EXPECT_TRUE(bus.write(1, 0, 0x00, 0x8000));
+  EXPECT_EQ(przone->writes - commands, 2 * once);
+  EXPECT_EQ(cache->get_stats().writes_skipped, 0u);
+
+  ASSERT_TRUE(cache->lookup(mdio_target, shadow_cache::mdio_key(1, 0, 0x00),
+                            value));
+  EXPECT_EQ(value, 0x8000u);
+}
@@ -39,9 +39,13 @@
 #include <unistd.h>
 #include <sched.h>
 #include <fcntl.h>
+#include <dirent.h>
+#include <linux/limits.h>
 
 #include <opae/fpga.h>
 
+#include "coreidle.h"
+
 // FIXME
 #define FPGA_BBS_MIN_POWER               30  // watts
 
@@ -52,6 +56,7 @@
 
 #define RDMSR_CMD_PATH                    "rdmsr -c0 -p %d 0x%lx"
 #define SYFS_PID_MAX_PATH                 "/proc/sys/kernel/pid_max"
+#define PROC_PATH                         "/proc"
 
 #define MSR_MAX_BUF_SIZE                  1024
 #define XEON_PWR_LIMIT                    "power_mgmt/xeon_limit"
@@ -60,7 +65,49 @@
 
 
 fpga_result get_package_power(int split_point, long double *pkg_power);
-fpga_result cpuset_setaffinity(int socket, int split_point, uint64_t max_cpu_count);
+int readmsr(int split_point, uint64_t msr, uint64_t *value);
+static fpga_result read_handle_object(fpga_handle handle,
+				      const char *name,
+				      uint64_t *value);
+
+static int online_cpus(void)
+{
+	return sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+static const struct coreidle_ops default_ops = {
+	.read_object  = read_handle_object,
+	.readmsr      = readmsr,
+	.num_cpus     = online_cpus,
+	.getaffinity  = sched_getaffinity,
+	.setaffinity  = sched_setaffinity,
+};
+
+// the system interface in use: default_ops or a copy of the replacement
+static struct coreidle_ops replaced_ops;
+static const struct coreidle_ops *ops = &default_ops;
+
+// prefix of the /proc paths
+static char root_path[PATH_MAX];
+
+void coreidle_set_ops(const struct coreidle_ops *new_ops, const char *root)
+{
+	size_t len;
+
+	if (new_ops) {
+		replaced_ops = *new_ops;
+		ops = &replaced_ops;
+	} else {
+		ops = &default_ops;
+	}
+
+	root_path[0] = '\0';
+	if (root) {
+		len = strnlen(root, sizeof(root_path) - 1);
+		memcpy(root_path, root, len);
+		root_path[len] = '\0';
+	}
+}
 
 
 fpga_result sysfs_read_u64(const char *path, uint64_t *u)
@@ -143,203 +190,289 @@ int readmsr(int split_point, uint64_t msr, uint64_t *value)
 	return 0;
 }
 
-// idle cpu cores
-fpga_result set_cpu_core_idle(fpga_handle handle,
-				uint64_t gbs_power)
+// read a 64-bit sysfs object below the FME
+static fpga_result read_handle_object(fpga_handle handle,
+				      const char *name,
+				      uint64_t *value)
 {
-	int socket_num                       = -1;
-	int cpu_num                          = -1;
-	int threads_num                      = -1;
-	int cores_num                        = -1;
-	uint64_t  msrvalue                   = 0;
-	int split_point                      = 0;
-	int threads_per_core                 = -1;
-	long double total_power              = 0;
-	long double available_cpu_pwr        = 0;
-	uint64_t max_available_cpu           = 0;
-	fpga_result result                   = FPGA_OK;
-	uint64_t socketid                    = 0;
-	uint64_t value                       = 0;
-	long double xeon_pwr_limit           = 0;
-	long double fpga_pwr_limit           = 0;
-	long double core_power               = 0;
-
 	fpga_object fpga_object;
+	fpga_result result = FPGA_OK;
 
-	// XEON PWR LIMIT
-	result = fpgaHandleGetObject(handle, XEON_PWR_LIMIT, &fpga_object, 0);
+	result = fpgaHandleGetObject(handle, name, &fpga_object, 0);
 	if (result != FPGA_OK) {
-		fprintf(stderr, "Failed to get Handle Object \n");
+		OPAE_ERR("Failed to get Handle Object \n");
 		return result;
 	}
 
-	result = fpgaObjectRead64(fpga_object, &value, 0);
+	result = fpgaObjectRead64(fpga_object, value, 0);
 	if (result != FPGA_OK) {
-		fprintf(stderr, "Failed to Read Object \n");
+		OPAE_ERR("Failed to Read Object \n");
 		fpgaDestroyObject(&fpga_object);
 		return result;
 	}
 
-	xeon_pwr_limit = value / 8;
-
 	result = fpgaDestroyObject(&fpga_object);
 	if (result != FPGA_OK) {
 		OPAE_ERR("Failed to Destroy Object \n");
 		return result;
 	}
 
-	// FPGA PWR LIMIT
-	result = fpgaHandleGetObject(handle, FPGA_PWR_LIMIT, &fpga_object, 0);
-	if (result != FPGA_OK) {
-		OPAE_ERR("Failed to get Handle Object \n");
-		return result;
+	return result;
+}
+
+// read FPGA power limits and socket id
+fpga_result get_fpga_power_info(fpga_handle handle,
+				struct fpga_power_info *info)
+{
+	uint64_t value                       = 0;
+	fpga_result result                   = FPGA_OK;
+
+	if (info == NULL) {
+		OPAE_ERR("Invalid input parm. \n");
+		return FPGA_INVALID_PARAM;
 	}
 
-	result = fpgaObjectRead64(fpga_object, &value, 0);
-	if (result != FPGA_OK) {
-		OPAE_ERR("Failed to Read Object \n");
-		fpgaDestroyObject(&fpga_object);
+	// XEON PWR LIMIT
+	result = ops->read_object(handle, XEON_PWR_LIMIT, &value);
+	if (result != FPGA_OK)
 		return result;
-	}
 
-	fpga_pwr_limit = value / 8;
+	info->xeon_pwr_limit = value / 8;
 
-	result = fpgaDestroyObject(&fpga_object);
-	if (result != FPGA_OK) {
-		OPAE_ERR("Failed to Destroy Object \n");
+	// FPGA PWR LIMIT
+	result = ops->read_object(handle, FPGA_PWR_LIMIT, &value);
+	if (result != FPGA_OK)
 		return result;
-	}
 
+	info->fpga_pwr_limit = value / 8;
 
 	// Socket id
-	result = fpgaHandleGetObject(handle, FPGA_SYSFS_SOCKET_ID, &fpga_object, 0);
-	if (result != FPGA_OK) {
-		OPAE_ERR("Failed to get Handle Object \n");
+	result = ops->read_object(handle, FPGA_SYSFS_SOCKET_ID,
+				    &info->socket_id);
+	if (result != FPGA_OK)
 		return result;
-	}
 
-	result = fpgaObjectRead64(fpga_object, &socketid, 0);
-	if (result != FPGA_OK) {
-		OPAE_ERR("Failed to Read Object \n");
-		fpgaDestroyObject(&fpga_object);
-		return result;
-	}
+	printf("Socket id        : %ld \n", info->socket_id);
+	printf("XEON Power limit : %Lf watts \n", info->xeon_pwr_limit);
+	printf("FPGA pwr limit   : %Lf watts \n", info->fpga_pwr_limit);
 
-	result = fpgaDestroyObject(&fpga_object);
-	if (result != FPGA_OK) {
-		OPAE_ERR("Failed to Destroy Object \n");
-		return result;
-	}
+	return result;
+}
 
-	printf("Socket id        : %ld \n", socketid);
-	printf("XEON Power limit : %Lf watts \n", xeon_pwr_limit);
-	printf("FPGA pwr limit   : %Lf watts \n", fpga_pwr_limit);
+// read socket CPU topology
+fpga_result get_socket_topology(uint64_t socket_id,
+				struct socket_topology *topo)
+{
+	uint64_t  msrvalue                   = 0;
 
-	if (readmsr(socketid, MSR_CORE_COUNT, &msrvalue) != 0) {
+	if (topo == NULL) {
+		OPAE_ERR("Invalid input parm. \n");
+		return FPGA_INVALID_PARAM;
+	}
+
+	if (ops->readmsr(socket_id, MSR_CORE_COUNT, &msrvalue) != 0) {
 		OPAE_ERR("Failed to read MSR");
-		result = FPGA_EXCEPTION;
-		return result;
+		return FPGA_EXCEPTION;
 	}
 
 	OPAE_DBG("msrvalue : %lx", msrvalue);
 
 	// Threads count in a socket
-	threads_num = msrvalue & 0xff;
+	topo->threads_num = msrvalue & 0xff;
 
 	// Cores count in a socket
-	cores_num = ((msrvalue >> 16) & 0xff);
+	topo->cores_num = ((msrvalue >> 16) & 0xff);
 
 	// Threads per core
-	if (cores_num > 0) {
-		threads_per_core = threads_num / cores_num;
+	if (topo->cores_num > 0) {
+		topo->threads_per_core = topo->threads_num / topo->cores_num;
 	} else {
 		OPAE_ERR("Invalid core count");
-		result = FPGA_NOT_SUPPORTED;
-		return result;
+		return FPGA_NOT_SUPPORTED;
 	}
 
 	// CPU count
-	cpu_num = sysconf(_SC_NPROCESSORS_ONLN);
+	topo->cpu_num = ops->num_cpus();
 
 	// Socket count
-	if (cores_num > 0  && threads_per_core > 0) {
-		socket_num = cpu_num / threads_per_core / cores_num;
-	} else {
+	if (topo->threads_per_core > 0) {
+		topo->socket_num = topo->cpu_num / topo->threads_per_core /
+				   topo->cores_num;
+	}
+
+	if (topo->threads_per_core <= 0 || topo->socket_num <= 0) {
 		OPAE_ERR("Invalid socket count");
-		result = FPGA_NOT_SUPPORTED;
-		return result;
+		return FPGA_NOT_SUPPORTED;
 	}
 
-	// Split point
-	if (socketid == 0) {
-		split_point = 0;
-	} else {
-		split_point = cpu_num / socket_num;
+	if (socket_id >= (uint64_t)topo->socket_num) {
+		OPAE_ERR("Invalid socket id\n");
+		return FPGA_NOT_SUPPORTED;
 	}
 
-	printf("Threads_num        : %d \n", threads_num);
-	printf("CoreCount          : %d \n", cores_num);
-	printf("Socket_num         : %d \n", socket_num);
-	printf("Threads per core   : %d \n", threads_per_core);
-	printf("CPU_num            : %d \n", cpu_num);
-	printf("Split_point        : %d \n", split_point);
+	// Split point
+	topo->split_point = socket_id * (topo->cpu_num / topo->socket_num);
 
-	// Get Package power
-	result = get_package_power(split_point, &total_power);
-	if (result != FPGA_OK) {
-		OPAE_ERR("Failed to read Package power");
-		return result;
-	}
+	printf("Threads_num        : %d \n", topo->threads_num);
+	printf("CoreCount          : %d \n", topo->cores_num);
+	printf("Socket_num         : %d \n", topo->socket_num);
+	printf("Threads per core   : %d \n", topo->threads_per_core);
+	printf("CPU_num            : %d \n", topo->cpu_num);
+	printf("Split_point        : %d \n", topo->split_point);
 
-	// per core power
-	core_power = xeon_pwr_limit / cores_num;
+	return FPGA_OK;
+}
 
-	printf("Total Power : %Lf \n", total_power);
-	printf("Core Power  : %Lf \n", core_power);
+void socket_plan_init(struct socket_plan *plan, uint64_t socket_id)
+{
+	memset(plan, 0, sizeof(*plan));
+	plan->socket_id = socket_id;
+	plan->result = FPGA_OK;
+}
+
+// account for one more FPGA, running gbs_power watts, on the socket
+fpga_result socket_plan_add_fpga(struct socket_plan *plan,
+				 const struct fpga_power_info *info,
+				 uint64_t gbs_power)
+{
+	if (plan == NULL || info == NULL) {
+		OPAE_ERR("Invalid input parm. \n");
+		return FPGA_INVALID_PARAM;
+	}
 
 	// Set to maximum gbs power if power setting is zero in metadata.
 	if (gbs_power == 0) {
-		gbs_power = fpga_pwr_limit - FPGA_BBS_MIN_POWER;
+		gbs_power = info->fpga_pwr_limit - FPGA_BBS_MIN_POWER;
 	}
 
-	if ((gbs_power + FPGA_BBS_MIN_POWER) > fpga_pwr_limit) {
+	if ((gbs_power + FPGA_BBS_MIN_POWER) > info->fpga_pwr_limit) {
 		OPAE_ERR("Invalid Input FPGA GBS Power");
-		result = FPGA_INVALID_PARAM;
+		return FPGA_INVALID_PARAM;
+	}
+
+	// Every FME on a socket reports that socket's XEON limit;
+	// should they ever disagree, budget against the lowest.
+	if (plan->num_fpgas == 0 ||
+	    info->xeon_pwr_limit < plan->xeon_pwr_limit) {
+		plan->xeon_pwr_limit = info->xeon_pwr_limit;
+	}
+
+	plan->fpga_pwr_limit += info->fpga_pwr_limit;
+	plan->gbs_power += gbs_power + FPGA_BBS_MIN_POWER;
+	++plan->num_fpgas;
+
+	return FPGA_OK;
+}
+
+// compute the number of CPUs that stay online on the socket
+fpga_result plan_socket_core_idle(struct socket_plan *plan)
+{
+	fpga_result result                   = FPGA_OK;
+	uint64_t socket_cpus                 = 0;
+
+	if (plan == NULL || plan->num_fpgas == 0) {
+		OPAE_ERR("Invalid input parm. \n");
+		return FPGA_INVALID_PARAM;
+	}
+
+	result = get_socket_topology(plan->socket_id, &plan->topo);
+	if (result != FPGA_OK) {
+		plan->result = result;
 		return result;
 	}
 
-	//Shared TDP SKU
-	if (xeon_pwr_limit + fpga_pwr_limit > total_power) {
+	// Get Package power
+	result = get_package_power(plan->topo.split_point, &plan->total_power);
+	if (result != FPGA_OK) {
+		OPAE_ERR("Failed to read Package power");
+		plan->result = result;
+		return result;
+	}
 
-		printf("Shared TDP SKU power shared between XEON and FPGA \n");
+	// per core power
+	plan->core_power = plan->xeon_pwr_limit / plan->topo.cores_num;
 
-		// Available power to CPU
-		available_cpu_pwr = (int)total_power -
-			(gbs_power + FPGA_BBS_MIN_POWER);
+	//Shared TDP SKU
+	if (plan->xeon_pwr_limit + plan->fpga_pwr_limit > plan->total_power) {
 
-		printf("Available CPU power: %Lf \n", available_cpu_pwr);
+		// Available power to CPU
+		plan->available_cpu_pwr = (int)plan->total_power -
+			plan->gbs_power;
+		if (plan->available_cpu_pwr < 0) {
+			plan->available_cpu_pwr = 0;
+		}
 
 		// Max number of CPU available
-		max_available_cpu = 2 * ((int) available_cpu_pwr / core_power);
+		plan->max_available_cpu = 2 * ((int) plan->available_cpu_pwr /
+			plan->core_power);
 
-		printf("Online CPU count: %ld \n", max_available_cpu);
-
-		result = cpuset_setaffinity(socketid, split_point,
-				max_available_cpu);
-		if (result != FPGA_OK) {
-			OPAE_ERR("Failed to idle cores");
-			return result;
+		socket_cpus = plan->topo.cpu_num / plan->topo.socket_num;
+		if (plan->max_available_cpu > socket_cpus) {
+			plan->max_available_cpu = socket_cpus;
 		}
 
-	} else if (xeon_pwr_limit + fpga_pwr_limit <= total_power) {
+		plan->result = FPGA_OK;
+	} else {
 		// TDP+ SKU
-		printf("TDP+ SKU XEON and FPGA each can run maximum allowed TDP \n");
-		result = FPGA_INVALID_PARAM;
-		return result;
+		plan->result = FPGA_INVALID_PARAM;
+	}
+
+	return FPGA_OK;
+}
 
+void print_socket_plan(const struct socket_plan *plan)
+{
+	printf("Socket %ld: %d FPGA(s)\n", plan->socket_id, plan->num_fpgas);
+	printf("  XEON Power limit    : %Lf watts \n", plan->xeon_pwr_limit);
+	printf("  FPGA pwr limit      : %Lf watts \n", plan->fpga_pwr_limit);
+	printf("  GBS + BBS power     : %Lf watts \n", plan->gbs_power);
+	printf("  Total Power         : %Lf \n", plan->total_power);
+	printf("  Core Power          : %Lf \n", plan->core_power);
+
+	if (plan->result == FPGA_OK) {
+		printf("  Shared TDP SKU power shared between XEON and FPGA \n");
+		printf("  Available CPU power : %Lf \n", plan->available_cpu_pwr);
+		printf("  Online CPU count    : %ld of %d starting at CPU %d\n",
+		       plan->max_available_cpu,
+		       plan->topo.cpu_num / plan->topo.socket_num,
+		       plan->topo.split_point);
+	} else if (plan->result == FPGA_INVALID_PARAM) {
+		printf("  TDP+ SKU XEON and FPGA each can run maximum allowed TDP \n");
 	} else {
-		OPAE_ERR("Invalid Socket Power");
-		result = FPGA_NOT_SUPPORTED;
+		printf("  Planning failed: %s\n", fpgaErrStr(plan->result));
+	}
+}
+
+// idle cpu cores
+fpga_result set_cpu_core_idle(fpga_handle handle,
+				uint64_t gbs_power)
+{
+	struct fpga_power_info info;
+	struct socket_plan plan;
+	fpga_result result                   = FPGA_OK;
+
+	result = get_fpga_power_info(handle, &info);
+	if (result != FPGA_OK)
+		return result;
+
+	socket_plan_init(&plan, info.socket_id);
+
+	result = socket_plan_add_fpga(&plan, &info, gbs_power);
+	if (result != FPGA_OK)
+		return result;
+
+	result = plan_socket_core_idle(&plan);
+	if (result != FPGA_OK)
+		return result;
+
+	print_socket_plan(&plan);
+
+	if (plan.result != FPGA_OK)
+		return plan.result;
+
+	result = apply_core_idle_plans(&plan, 1);
+	if (result != FPGA_OK) {
+		OPAE_ERR("Failed to idle cores");
 		return result;
 	}
 
@@ -362,7 +495,7 @@ fpga_result get_package_power(int split_point,
 	}
 
 	// Read PKG Power limit MSR
-	if (readmsr(split_point, MSR_PKG_RAPL_POWER_LIMIT, &msrvalue) != 0) {
+	if (ops->readmsr(split_point, MSR_PKG_RAPL_POWER_LIMIT, &msrvalue) != 0) {
 		OPAE_ERR("Failed to read MSR.\n");
 		result = FPGA_NOT_SUPPORTED;
 		return result ;
@@ -372,7 +505,7 @@ fpga_result get_package_power(int split_point,
 	OPAE_DBG("Power Limit converted: %lx\n", pkg_pwr_limit);
 
 	// Read power units
-	if (readmsr(split_point, MSR_RAPL_POWER_UNIT, &msrvalue) != 0) {
+	if (ops->readmsr(split_point, MSR_RAPL_POWER_UNIT, &msrvalue) != 0) {
 		OPAE_ERR("Failed to read MSR.\n");
 		result = FPGA_NOT_SUPPORTED;
 		return result ;
@@ -390,141 +523,189 @@ fpga_result get_package_power(int split_point,
 	return result;
 }
 
-// sets cpu affinity
-fpga_result setaffinity(cpu_set_t *idle_set,
-			int socket,
-			int pid,
-			int split_point)
+// read pid_max below the root path
+static fpga_result read_pid_max(uint64_t *max_pid_index)
+{
+	char path[PATH_MAX] = { 0 };
+
+	if (snprintf(path, sizeof(path), "%s" SYFS_PID_MAX_PATH,
+		     root_path) >= (int)sizeof(path))
+		return FPGA_EXCEPTION;
+
+	return sysfs_read_u64(path, max_pid_index);
+}
+
+// replace the planned sockets' CPUs in the affinity of pid
+static fpga_result set_plans_affinity(cpu_set_t *clear_set,
+				      cpu_set_t *idle_set,
+				      int pid)
 {
 	cpu_set_t current_set;
+	cpu_set_t keep_set;
 	cpu_set_t full_mask_set;
-	int i              = 0;
-	fpga_result result = FPGA_OK;
 
 	CPU_ZERO(&current_set);
+	CPU_ZERO(&keep_set);
 	CPU_ZERO(&full_mask_set);
 
-	if (idle_set == NULL) {
-		OPAE_ERR("Invalid input parm. \n");
-		result = FPGA_INVALID_PARAM;
-		goto setafy_exit;
-	}
-
-	if (sched_getaffinity(pid, sizeof(current_set), &current_set) != 0) {
+	if (ops->getaffinity(pid, sizeof(current_set), &current_set) != 0) {
 
 		// PID may not exists in system
-		if (pid > 2) {
-			goto setafy_exit;
-		}
+		if (pid > 2)
+			return FPGA_OK;
 
 		OPAE_ERR("sched_getaffinity failure for pid: %d\n", pid);
-		result = FPGA_NOT_SUPPORTED;
-		goto setafy_exit;
+		return FPGA_NOT_SUPPORTED;
 	}
 
-	for (i = 0; i < split_point; i++) {
-		if (socket == 0) {
-			CPU_CLR(i, &current_set);
-		} else {
-			CPU_CLR(i + split_point, &current_set);
-		}
+	// keep = current & ~clear
+	CPU_XOR(&keep_set, &current_set, clear_set);
+	CPU_AND(&keep_set, &keep_set, &current_set);
+	CPU_OR(&full_mask_set, &keep_set, idle_set);
+
+	if (ops->setaffinity(pid, sizeof(full_mask_set), &full_mask_set) != 0) {
+
+		if (pid > 2)
+			return FPGA_OK;
+
+		OPAE_ERR("sched_setaffinity failure for pid: %d\n", pid);
+		return FPGA_NOT_SUPPORTED;
 	}
 
-	CPU_OR(&full_mask_set, &current_set, idle_set);
+	return FPGA_OK;
+}
 
-	if (sched_setaffinity(pid, sizeof(full_mask_set), &full_mask_set) != 0) {
+static int parse_pid(const char *name)
+{
+	char *endptr = NULL;
+	long pid     = 0;
 
-		if (pid > 2) {
-			goto setafy_exit;
+	pid = strtol(name, &endptr, 10);
+	if (endptr == name || *endptr != '\0' || pid <= 0)
+		return -1;
+
+	return pid;
+}
+
+// apply the plans to every thread of every process found below /proc
+static fpga_result for_each_task(cpu_set_t *clear_set,
+				 cpu_set_t *idle_set)
+{
+	char path[PATH_MAX]            = { 0 };
+	DIR *proc                      = NULL;
+	DIR *task                      = NULL;
+	struct dirent *pent            = NULL;
+	struct dirent *tent            = NULL;
+	int pid                        = 0;
+	int tid                        = 0;
+
+	if (snprintf(path, sizeof(path), "%s" PROC_PATH,
+		     root_path) >= (int)sizeof(path))
+		return FPGA_EXCEPTION;
+
+	proc = opendir(path);
+	if (proc == NULL) {
+		OPAE_MSG("opendir(%s) failed", path);
+		return FPGA_NOT_FOUND;
+	}
+
+	while ((pent = readdir(proc)) != NULL) {
+		pid = parse_pid(pent->d_name);
+		if (pid < 0)
+			continue;
+
+		if (snprintf(path, sizeof(path), "%s" PROC_PATH "/%d/task",
+			     root_path, pid) >= (int)sizeof(path))
+			continue;
+
+		task = opendir(path);
+		if (task == NULL) {
+			// Process exited, or no task list
+			if (pid > 2)
+				set_plans_affinity(clear_set, idle_set, pid);
+			continue;
 		}
 
-		OPAE_ERR("sched_setaffinity failure for pid: %d\n", pid);
-		result = FPGA_NOT_SUPPORTED;
-		goto setafy_exit;
+		while ((tent = readdir(task)) != NULL) {
+			tid = parse_pid(tent->d_name);
+			if (tid > 2)
+				set_plans_affinity(clear_set, idle_set, tid);
+		}
+
+		closedir(task);
 	}
 
-setafy_exit:
-	return result;
+	closedir(proc);
+
+	return FPGA_OK;
 }
-// set threads's CPU affinity
-fpga_result cpuset_setaffinity(int socket,
-				int split_point,
-				uint64_t max_cpu_count)
+
+// apply every shared TDP socket plan in a single pass over all pids
+fpga_result apply_core_idle_plans(const struct socket_plan *plans,
+				  int num_plans)
 {
+	cpu_set_t clear_set;
 	cpu_set_t idle_set;
-	uint64_t i                     = 0;
+	int i                          = 0;
+	int cpu                        = 0;
+	int socket_cpus                = 0;
 	uint64_t pid                   = 0;
 	uint64_t max_pid_index         = 0;
 	fpga_result result             = FPGA_OK;
 
+	if (plans == NULL) {
+		OPAE_ERR("Invalid input parm. \n");
+		return FPGA_INVALID_PARAM;
+	}
 
-	// Set affinity for pid 1 and pid 2, first.
-	// All children of pids created after these call inherent affinity.
-	// Pids that already exist will get affinity from max_pid loop.
-	//
-	// Clear all bits in cpu affinity mask per chosen socket.
-	// Next step after this one will be to set full mask for both
-	// sockets by idle mask calculated above with
-	// the remainder of the mask from this step.
-
-
-	// set Idle CPU set
+	CPU_ZERO(&clear_set);
 	CPU_ZERO(&idle_set);
 
-	if (socket == 0) {
-		for (i = 0; i < max_cpu_count; i++) {
-		CPU_SET(i, &idle_set);
-		}
-	} else if (socket == 1) {
-		for (i = 0; i < max_cpu_count; i++) {
-			CPU_SET(i + split_point, &idle_set);
+	for (i = 0; i < num_plans; i++) {
+		if (plans[i].result != FPGA_OK)
+			continue;
+
+		socket_cpus = plans[i].topo.cpu_num / plans[i].topo.socket_num;
+		for (cpu = 0; cpu < socket_cpus; cpu++) {
+			CPU_SET(plans[i].topo.split_point + cpu, &clear_set);
+			if ((uint64_t)cpu < plans[i].max_available_cpu)
+				CPU_SET(plans[i].topo.split_point + cpu,
+					&idle_set);
 		}
-	} else {
-		OPAE_ERR("Invalid socket id\n");
-		result = FPGA_NOT_SUPPORTED;
-		return result ;
 	}
 
-	i = CPU_COUNT_S(sizeof(cpu_set_t), &idle_set);
-	OPAE_DBG("CPU_COUNT_S : %d\n", i);
+	if (CPU_COUNT(&clear_set) == 0) {
+		OPAE_MSG("No shared TDP socket to idle");
+		return FPGA_OK;
+	}
+
+	OPAE_DBG("CPU_COUNT_S : %d\n", CPU_COUNT(&idle_set));
 
-	// Get affinity of pid 1
-	// Change CPU set
-	// Set affinity of pid 1
-	result = setaffinity(&idle_set, socket, 1, split_point);
-	if (result != FPGA_OK) {
-		OPAE_ERR(" sched_setaffinity failure for pid: 1\n");
+	// Set affinity for pid 1 and pid 2, first.
+	// All children of pids created after these call inherent affinity.
+	result = set_plans_affinity(&clear_set, &idle_set, 1);
+	if (result != FPGA_OK)
 		return result;
-	}
 
-	// Get affinity of pid 2
-	// Change CPU set
-	// Set affinity of pid 2
-	result = setaffinity(&idle_set, socket, 2, split_point);
-	if (result != FPGA_OK) {
-		OPAE_ERR(" sched_setaffinity failure for pid: 1\n");
+	result = set_plans_affinity(&clear_set, &idle_set, 2);
+	if (result != FPGA_OK)
 		return result;
-	}
+
+	// Walk the tasks that exist rather than every possible pid;
+	// pid_max is 4M on large systems.
+	if (for_each_task(&clear_set, &idle_set) == FPGA_OK)
+		return FPGA_OK;
 
 	// Find max pid number
-	result = sysfs_read_u64(SYFS_PID_MAX_PATH, &max_pid_index);
+	result = read_pid_max(&max_pid_index);
 	if (result != FPGA_OK) {
 		OPAE_ERR("Failed to read max pid count.\n");
 		return result;
 	}
 
-	OPAE_DBG("max_pid_index: %d\n", max_pid_index);
-
-	// Get affinity from pid 3 to Max pid count
-	// Change CPU set
-	// Set affinity of pid 3 to Max pid count
-
-	//  Set affinity for all possible pids to mask in cpuset.
 	// App cannot set cpu set for process like kworker,ksoftirqd,watchdog etc
-	OPAE_DBG("Set affinity for all possible pids to mask in cpuset ");
-
 	for (pid = 3; pid < max_pid_index; pid++) {
-		setaffinity(&idle_set, socket, pid, split_point);
+		set_plans_affinity(&clear_set, &idle_set, pid);
 	}
 
 	return result;
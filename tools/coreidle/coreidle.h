@@ -0,0 +1,114 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __COREIDLE_H__
+#define __COREIDLE_H__
+
+#include <stdint.h>
+#include <sched.h>
+#include <sys/types.h>
+#include <opae/fpga.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Power limits published by one FPGA's FME.
+struct fpga_power_info {
+	uint64_t    socket_id;
+	long double xeon_pwr_limit;
+	long double fpga_pwr_limit;
+};
+
+// CPU topology of one socket, as seen from the MSRs.
+struct socket_topology {
+	int threads_num;
+	int cores_num;
+	int threads_per_core;
+	int cpu_num;
+	int socket_num;
+	int split_point;      // first CPU of the socket
+};
+
+// Core idle budget for one socket and all of the FPGAs on it.
+struct socket_plan {
+	uint64_t    socket_id;
+	int         num_fpgas;
+	long double xeon_pwr_limit;
+	long double fpga_pwr_limit;    // sum over all FPGAs
+	long double gbs_power;         // sum of GBS + BBS power
+	long double total_power;       // package power limit
+	long double core_power;
+	long double available_cpu_pwr;
+	uint64_t    max_available_cpu;
+	struct socket_topology topo;
+	// FPGA_OK: shared TDP, cores will be idled.
+	// FPGA_INVALID_PARAM: TDP+ SKU, nothing to do.
+	fpga_result result;
+};
+
+// System interface of coreidle. The defaults read FME sysfs objects,
+// run rdmsr and call sched_{get,set}affinity; test sandboxes replace
+// them to model other systems.
+struct coreidle_ops {
+	fpga_result (*read_object)(fpga_handle handle, const char *name,
+				   uint64_t *value);
+	int (*readmsr)(int cpu, uint64_t msr, uint64_t *value);
+	int (*num_cpus)(void);
+	int (*getaffinity)(pid_t pid, size_t size, cpu_set_t *set);
+	int (*setaffinity)(pid_t pid, size_t size, const cpu_set_t *set);
+};
+
+// Replace the system interface, NULL restores the defaults.
+// root is prepended to the /proc paths, NULL or "" for none.
+void coreidle_set_ops(const struct coreidle_ops *ops, const char *root);
+
+fpga_result get_fpga_power_info(fpga_handle handle,
+				struct fpga_power_info *info);
+
+fpga_result get_socket_topology(uint64_t socket_id,
+				struct socket_topology *topo);
+
+void socket_plan_init(struct socket_plan *plan, uint64_t socket_id);
+
+fpga_result socket_plan_add_fpga(struct socket_plan *plan,
+				 const struct fpga_power_info *info,
+				 uint64_t gbs_power);
+
+fpga_result plan_socket_core_idle(struct socket_plan *plan);
+
+void print_socket_plan(const struct socket_plan *plan);
+
+fpga_result apply_core_idle_plans(const struct socket_plan *plans,
+				  int num_plans);
+
+fpga_result set_cpu_core_idle(fpga_handle handle, uint64_t gbs_power);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __COREIDLE_H__
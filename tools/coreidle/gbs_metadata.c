@@ -0,0 +1,196 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <uuid/uuid.h>
+#include <json-c/json.h>
+
+#include <opae/fpga.h>
+#include <libbitstream/bitstream.h>
+
+#include "gbs_metadata.h"
+
+#define GBS_JSON_VERSION          "version"
+#define GBS_JSON_AFU_IMAGE        "afu-image"
+#define GBS_JSON_POWER            "power"
+#define GBS_JSON_INTERFACE_UUID   "interface-uuid"
+
+// read exactly len bytes at offset
+static int pread_full(int fd, void *buf, size_t len, off_t offset)
+{
+	size_t done = 0;
+	ssize_t res;
+
+	while (done < len) {
+		res = pread(fd, (uint8_t *)buf + done, len - done,
+			    offset + done);
+		if (res <= 0)
+			return -1;
+		done += res;
+	}
+
+	return 0;
+}
+
+fpga_result parse_gbs_metadata(const char *json, size_t len,
+			       struct gbs_metadata *md)
+{
+	json_tokener *tok        = NULL;
+	json_object *root        = NULL;
+	json_object *afu_image   = NULL;
+	json_object *value       = NULL;
+	fpga_result result       = FPGA_EXCEPTION;
+
+	if (!json || !md) {
+		OPAE_ERR("Invalid input parm");
+		return FPGA_INVALID_PARAM;
+	}
+
+	tok = json_tokener_new();
+	if (!tok) {
+		OPAE_ERR("Failed to allocate json tokener");
+		return FPGA_NO_MEMORY;
+	}
+
+	root = json_tokener_parse_ex(tok, json, (int)len);
+	if (!root || json_tokener_get_error(tok) != json_tokener_success) {
+		OPAE_ERR("Failed to parse GBS metadata");
+		goto out_free;
+	}
+
+	if (json_object_object_get_ex(root, GBS_JSON_VERSION, &value))
+		md->version = json_object_get_int(value);
+
+	if (!json_object_object_get_ex(root, GBS_JSON_AFU_IMAGE, &afu_image)) {
+		OPAE_ERR("GBS metadata has no %s", GBS_JSON_AFU_IMAGE);
+		goto out_put;
+	}
+
+	// A missing power entry is treated as zero,
+	// which coreidle takes to mean "use the maximum".
+	md->power = 0;
+	if (json_object_object_get_ex(afu_image, GBS_JSON_POWER, &value))
+		md->power = json_object_get_int(value);
+
+	if (!json_object_object_get_ex(afu_image,
+				       GBS_JSON_INTERFACE_UUID, &value) ||
+	    uuid_parse(json_object_get_string(value), md->pr_interface_id)) {
+		OPAE_ERR("GBS metadata has no valid %s",
+			 GBS_JSON_INTERFACE_UUID);
+		goto out_put;
+	}
+
+	result = FPGA_OK;
+
+out_put:
+	json_object_put(root);
+out_free:
+	json_tokener_free(tok);
+	return result;
+}
+
+fpga_result read_gbs_metadata(const char *filename, struct gbs_metadata *md)
+{
+	uint8_t header[GBS_METADATA_HEADER_LEN] = { 0 };
+	fpga_guid gbs_guid                      = { 0 };
+	struct stat st;
+	uint32_t mdata_len                      = 0;
+	char *mdata                             = NULL;
+	fpga_result result                      = FPGA_INVALID_PARAM;
+	int fd                                  = -1;
+
+	if (!filename || !md) {
+		OPAE_ERR("Invalid input parm");
+		return FPGA_INVALID_PARAM;
+	}
+
+	if (!opae_bitstream_path_is_valid(filename,
+					  OPAE_BITSTREAM_PATH_NO_PARENT |
+					  OPAE_BITSTREAM_PATH_NO_SYMLINK)) {
+		OPAE_ERR("Invalid bitstream path: %s", filename);
+		return FPGA_INVALID_PARAM;
+	}
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		OPAE_ERR("open(%s) failed", filename);
+		return FPGA_INVALID_PARAM;
+	}
+
+	if (fstat(fd, &st) || !S_ISREG(st.st_mode) ||
+	    (size_t)st.st_size < GBS_METADATA_HEADER_LEN) {
+		OPAE_ERR("%s is not a GBS file", filename);
+		goto out_close;
+	}
+
+	if (pread_full(fd, header, sizeof(header), 0)) {
+		OPAE_ERR("Failed to read GBS header");
+		goto out_close;
+	}
+
+	if (uuid_parse(GBS_METADATA_GUID, gbs_guid) ||
+	    uuid_compare(header, gbs_guid)) {
+		OPAE_ERR("%s has no valid GBS header", filename);
+		goto out_close;
+	}
+
+	memcpy(&mdata_len, header + GBS_METADATA_GUID_LEN, sizeof(mdata_len));
+	if (!mdata_len || mdata_len > GBS_METADATA_MAX_LEN ||
+	    mdata_len > (uint64_t)st.st_size - GBS_METADATA_HEADER_LEN) {
+		OPAE_ERR("Invalid GBS metadata length: %u", mdata_len);
+		goto out_close;
+	}
+
+	mdata = malloc(mdata_len);
+	if (!mdata) {
+		OPAE_ERR("Failed to allocate metadata buffer");
+		result = FPGA_NO_MEMORY;
+		goto out_close;
+	}
+
+	if (pread_full(fd, mdata, mdata_len, GBS_METADATA_HEADER_LEN)) {
+		OPAE_ERR("Failed to read GBS metadata");
+		result = FPGA_EXCEPTION;
+		goto out_free;
+	}
+
+	result = parse_gbs_metadata(mdata, mdata_len, md);
+
+out_free:
+	free(mdata);
+out_close:
+	close(fd);
+	return result;
+}
@@ -0,0 +1,81 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __COREIDLE_GBS_METADATA_H__
+#define __COREIDLE_GBS_METADATA_H__
+
+#include <opae/fpga.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// GBS file layout: 16-byte GUID, 32-bit metadata length,
+// JSON metadata, then the bitstream payload.
+#define GBS_METADATA_GUID         "58656F6E-4650-4741-B747-425376303031"
+#define GBS_METADATA_GUID_LEN     16
+#define GBS_METADATA_HEADER_LEN   (GBS_METADATA_GUID_LEN + sizeof(uint32_t))
+
+// Upper bound on the JSON metadata section. Real GBS metadata
+// is a few hundred bytes; anything larger is a corrupt header.
+#define GBS_METADATA_MAX_LEN      (1024 * 1024)
+
+// The subset of GBS metadata consumed by coreidle.
+struct gbs_metadata {
+	int       version;
+	int       power;
+	fpga_guid pr_interface_id;
+};
+
+#define GBS_METADATA_INITIALIZER { 0, 0, { 0, } }
+
+/**
+ * Read the GBS metadata for a bitstream file.
+ *
+ * Only the GBS header and the JSON metadata section are read from
+ * disk. The bitstream payload that follows is never touched, so
+ * the cost is independent of the size of the GBS file.
+ *
+ * @param[in]  filename Path to the GBS file.
+ * @param[out] md       Parsed metadata.
+ * @returns FPGA_OK on success, FPGA_INVALID_PARAM if the path is
+ * rejected or the file does not hold a valid GBS header, and
+ * FPGA_EXCEPTION if the metadata could not be read or parsed.
+ */
+fpga_result read_gbs_metadata(const char *filename, struct gbs_metadata *md);
+
+/**
+ * Parse an in-memory GBS metadata JSON section of len bytes.
+ * The buffer need not be NUL-terminated.
+ */
+fpga_result parse_gbs_metadata(const char *json, size_t len,
+			       struct gbs_metadata *md);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __COREIDLE_GBS_METADATA_H__
@@ -27,6 +27,10 @@
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif // HAVE_CONFIG_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include <errno.h>
 #include <malloc.h>
 #include <stdlib.h>
@@ -41,10 +45,11 @@
 #include <linux/limits.h>
 
 #include <opae/fpga.h>
-#include <libbitstream/bitstream.h>
-#include <libbitstream/metadatav1.h>
 
-#define GETOPT_STRING ":hB:D:F:S:Gv"
+#include "gbs_metadata.h"
+#include "coreidle.h"
+
+#define GETOPT_STRING ":hB:D:F:S:Gcnv"
 
 struct option longopts[] = {
 	{ "help",      no_argument,       NULL, 'h' },
@@ -54,10 +59,24 @@ struct option longopts[] = {
 	{ "function",  required_argument, NULL, 'F' },
 	{ "socket-id", required_argument, NULL, 'S' },
 	{ "gbs",       required_argument, NULL, 'G' },
+	{ "card-gbs",  required_argument, NULL, 'c' },
+	{ "dry-run",   no_argument,       NULL, 'n' },
 	{ "version",   no_argument,       NULL, 'v' },
 	{ NULL, 0, NULL, 0 }
 };
 
+#define MAX_CARD_GBS 8
+
+// GBS assigned to one card by PCIe address
+struct CardGbs {
+	int      segment;
+	int      bus;
+	int      device;
+	int      function;
+	char     filename[PATH_MAX];
+	struct gbs_metadata gbs;
+};
+
 // coreidle Command line struct
 struct CoreIdleCommandLine {
 	int      segment;
@@ -66,11 +85,14 @@ struct CoreIdleCommandLine {
 	int      function;
 	int      socket;
 	char     filename[PATH_MAX];
-	opae_bitstream_info bitstr;
+	struct gbs_metadata gbs;
+	int      dry_run;
+	int      num_cards;
+	struct CardGbs cards[MAX_CARD_GBS];
 };
 
 struct CoreIdleCommandLine coreidleCmdLine = {
-	-1, -1, -1, -1, -1, { 0, }, OPAE_BITSTREAM_INFO_INITIALIZER
+	-1, -1, -1, -1, -1, { 0, }, GBS_METADATA_INITIALIZER, 0, 0, { { 0, } }
 };
 
 // core idle Command line input help
@@ -89,8 +111,15 @@ void CoreidleAppShowHelp(void)
 			" OR  -S=<SOCKET NUMBER>\n");
 	printf("<GBS Bitstream>       --gbs=<GBS FILE>            "
 			" OR  -G=<GBS FILE>\n");
+	printf("<Card GBS Bitstream>  --card-gbs=<[ssss:]bb:dd.f>=<GBS FILE> "
+			" OR  -c=<[ssss:]bb:dd.f>=<GBS FILE>\n");
+	printf("-n,--dry-run  Print the core idle plan and exit\n");
 	printf("-v,--version  Print version and exit\n");
 	printf("\n");
+	printf("All FPGAs matching the filter options are budgeted together,\n");
+	printf("grouped by socket. A card uses its --card-gbs bitstream,\n");
+	printf("else the --gbs bitstream, else its maximum GBS power.\n");
+	printf("\n");
 
 }
 
@@ -113,18 +142,127 @@ void print_err(const char *s, fpga_result res)
 
 int ParseCmds(struct CoreIdleCommandLine *coreidleCmdLine, int argc, char *argv[]);
 fpga_result get_fpga_interface_id(fpga_token token, fpga_guid *interface_id);
-extern fpga_result set_cpu_core_idle(fpga_handle handle, uint64_t gbs_power);
+int parse_card_gbs(const char *arg, struct CardGbs *card);
+
+// find the GBS metadata that applies to the FPGA behind token,
+// flagging the --card-gbs entry it matched in matched
+static const struct gbs_metadata *
+find_card_gbs(struct CoreIdleCommandLine *cmd, fpga_token token,
+	      int *matched)
+{
+	fpga_properties props = NULL;
+	uint16_t segment      = 0;
+	uint8_t bus           = 0;
+	uint8_t device        = 0;
+	uint8_t function      = 0;
+	int i                 = 0;
+
+	if (cmd->num_cards > 0 &&
+	    fpgaGetProperties(token, &props) == FPGA_OK) {
+		if (fpgaPropertiesGetSegment(props, &segment) == FPGA_OK &&
+		    fpgaPropertiesGetBus(props, &bus) == FPGA_OK &&
+		    fpgaPropertiesGetDevice(props, &device) == FPGA_OK &&
+		    fpgaPropertiesGetFunction(props, &function) == FPGA_OK) {
+			for (i = 0; i < cmd->num_cards; i++) {
+				if (cmd->cards[i].segment == segment &&
+				    cmd->cards[i].bus == bus &&
+				    cmd->cards[i].device == device &&
+				    cmd->cards[i].function == function) {
+					matched[i] = 1;
+					fpgaDestroyProperties(&props);
+					return &cmd->cards[i].gbs;
+				}
+			}
+		}
+		fpgaDestroyProperties(&props);
+	}
+
+	if (cmd->filename[0] != '\0')
+		return &cmd->gbs;
+
+	return NULL;
+}
+
+// add one FPGA to the plan of its socket
+static fpga_result add_fpga_to_plans(fpga_token token,
+				     const struct gbs_metadata *gbs,
+				     struct socket_plan *plans,
+				     int *num_plans)
+{
+	fpga_handle handle                 = NULL;
+	fpga_guid expt_interface_id        = { 0, };
+	struct fpga_power_info info;
+	fpga_result result                 = FPGA_OK;
+	fpga_result res                    = FPGA_OK;
+	int power                          = 0;
+	int i                              = 0;
+
+	if (gbs) {
+		// Read FPGA PR Interface GUID
+		res = get_fpga_interface_id(token, &expt_interface_id);
+		ON_ERR_GOTO(res, out_exit, "PR interface GUID get");
+
+		if (uuid_compare(gbs->pr_interface_id,
+				 expt_interface_id) < 0) {
+			res = FPGA_EXCEPTION;
+		}
+		ON_ERR_GOTO(res, out_exit, "PR Interface GUID doesn't match");
+
+		if (gbs->version == 1) {
+			power = gbs->power;
+		}
+	} else {
+		printf(" No GBS for this FPGA, assuming maximum GBS power \n");
+	}
+
+	printf(" GBS Power :%d watts \n", power);
+
+	if (power < 0) {
+		res = FPGA_INVALID_PARAM;
+		ON_ERR_GOTO(res, out_exit, "Invalid Input FPGA GBS Power");
+	}
+
+	// Open FME device
+	res = fpgaOpen(token, &handle, 0);
+	ON_ERR_GOTO(res, out_exit, "opening FME");
+
+	res = get_fpga_power_info(handle, &info);
+	ON_ERR_GOTO(res, out_close, "reading FPGA power limits");
+
+	for (i = 0; i < *num_plans; i++) {
+		if (plans[i].socket_id == info.socket_id)
+			break;
+	}
+
+	if (i == *num_plans) {
+		socket_plan_init(&plans[i], info.socket_id);
+		++*num_plans;
+	}
+
+	res = socket_plan_add_fpga(&plans[i], &info, power);
+
+out_close:
+	/* Close file handle */
+	result = fpgaClose(handle);
+	ON_ERR_GOTO(result, out_exit, "closing FME");
+
+out_exit:
+	return res != FPGA_OK ? res : result;
+}
 
 int main(int argc, char *argv[])
 {
 	fpga_properties filter             = NULL;
-	uint32_t num_matches               = 1;
+	uint32_t num_matches               = 0;
+	uint32_t i                         = 0;
 	fpga_result result                 = FPGA_OK;
-	fpga_token fme_token               = NULL;
-	fpga_handle fme_handle             = NULL;
+	fpga_token *fme_tokens             = NULL;
 	fpga_result res                    = FPGA_OK;
-	fpga_guid expt_interface_id        = { 0, };
-	int power                          = 0;
+	struct socket_plan *plans          = NULL;
+	int num_plans                      = 0;
+	int num_apply                      = 0;
+	int p                              = 0;
+	int card_matched[MAX_CARD_GBS]     = { 0, };
 
 	// Parse command line
 	if (argc < 2) {
@@ -142,14 +280,37 @@ int main(int argc, char *argv[])
 	printf(" Function              : %d \n", coreidleCmdLine.function);
 	printf(" Socket                : %d \n", coreidleCmdLine.socket);
 	printf(" Filename              : %s \n", coreidleCmdLine.filename);
+	for (p = 0; p < coreidleCmdLine.num_cards; p++) {
+		printf(" Card %04x:%02x:%02x.%x    : %s \n",
+		       coreidleCmdLine.cards[p].segment,
+		       coreidleCmdLine.cards[p].bus,
+		       coreidleCmdLine.cards[p].device,
+		       coreidleCmdLine.cards[p].function,
+		       coreidleCmdLine.cards[p].filename);
+	}
+	printf(" Dry run               : %d \n", coreidleCmdLine.dry_run);
 
 	printf(" ------- Command line Input END   ----\n\n");
 
-	result = opae_load_bitstream(coreidleCmdLine.filename,
-				     &coreidleCmdLine.bitstr);
-	if (result != FPGA_OK) {
-		res = result;
-		ON_ERR_GOTO(res, out_exit, "Invalid Input bitstream");
+	// Only the GBS header and metadata are needed; the
+	// bitstream payload itself is never read. Without --gbs, the
+	// cards with no --card-gbs are budgeted at maximum GBS power.
+	if (coreidleCmdLine.filename[0] != '\0') {
+		result = read_gbs_metadata(coreidleCmdLine.filename,
+					   &coreidleCmdLine.gbs);
+		if (result != FPGA_OK) {
+			res = result;
+			ON_ERR_GOTO(res, out_exit, "Invalid Input bitstream");
+		}
+	}
+
+	for (p = 0; p < coreidleCmdLine.num_cards; p++) {
+		result = read_gbs_metadata(coreidleCmdLine.cards[p].filename,
+					   &coreidleCmdLine.cards[p].gbs);
+		if (result != FPGA_OK) {
+			res = result;
+			ON_ERR_GOTO(res, out_exit, "Invalid Input bitstream");
+		}
 	}
 
 	// Enum FPGA device
@@ -184,7 +345,7 @@ int main(int argc, char *argv[])
 		ON_ERR_GOTO(result, out_destroy_prop, "setting socket");
 	}
 
-	result = fpgaEnumerate(&filter, 1, &fme_token, 1, &num_matches);
+	result = fpgaEnumerate(&filter, 1, NULL, 0, &num_matches);
 	ON_ERR_GOTO(result, out_destroy_prop, "enumerating FPGAs");
 
 	if (num_matches < 1) {
@@ -192,45 +353,80 @@ int main(int argc, char *argv[])
 		res = FPGA_NOT_FOUND;
 		goto out_destroy_prop;
 	}
-	fprintf(stderr, "FME Resource found.\n");
+	fprintf(stderr, "%u FME Resource(s) found.\n", num_matches);
 
-	// Open FME device
-	result = fpgaOpen(fme_token, &fme_handle, 0);
-	ON_ERR_GOTO(result, out_destroy_tok, "opening FME");
+	fme_tokens = calloc(num_matches, sizeof(fpga_token));
+	plans = calloc(num_matches, sizeof(struct socket_plan));
+	if (!fme_tokens || !plans) {
+		res = FPGA_NO_MEMORY;
+		ON_ERR_GOTO(res, out_free, "allocating plans");
+	}
 
-	// Read FPGA PR Interface GUID
-	res = get_fpga_interface_id(fme_token, &expt_interface_id);
-	ON_ERR_GOTO(res, out_close, "PR interface GUID get");
+	result = fpgaEnumerate(&filter, 1, fme_tokens, num_matches,
+			       &num_matches);
+	ON_ERR_GOTO(result, out_free, "enumerating FPGAs");
+
+	// Group every FPGA by socket, before anything is changed.
+	for (i = 0; i < num_matches; i++) {
+		res = add_fpga_to_plans(fme_tokens[i],
+					find_card_gbs(&coreidleCmdLine,
+						      fme_tokens[i],
+						      card_matched),
+					plans, &num_plans);
+		if (res != FPGA_OK)
+			goto out_destroy_tok;
+	}
 
-	if (uuid_compare(coreidleCmdLine.bitstr.pr_interface_id,
-			 expt_interface_id) < 0) {
-		res = FPGA_EXCEPTION;
+	for (p = 0; p < coreidleCmdLine.num_cards; p++) {
+		if (!card_matched[p]) {
+			fprintf(stderr, "Warning: --card-gbs %04x:%02x:%02x.%x "
+				"matches no FPGA; %s is not used\n",
+				coreidleCmdLine.cards[p].segment,
+				coreidleCmdLine.cards[p].bus,
+				coreidleCmdLine.cards[p].device,
+				coreidleCmdLine.cards[p].function,
+				coreidleCmdLine.cards[p].filename);
+		}
 	}
-	ON_ERR_GOTO(res, out_close, "PR Interface GUID doesn't match");
 
-	if (coreidleCmdLine.bitstr.metadata_version == 1) {
-		opae_bitstream_metadata_v1 *mdata = (opae_bitstream_metadata_v1 *)
-			coreidleCmdLine.bitstr.parsed_metadata;
-		power = mdata->afu_image.power;
+	printf(" ------- Core idle plan START ----\n\n");
+
+	for (p = 0; p < num_plans; p++) {
+		res = plan_socket_core_idle(&plans[p]);
+		print_socket_plan(&plans[p]);
+		if (res != FPGA_OK)
+			break;
+		if (plans[p].result == FPGA_OK)
+			++num_apply;
 	}
 
-	printf(" GBS Power :%d watts \n", power);
+	printf(" ------- Core idle plan END   ----\n\n");
 
-	// Idle CPU cores
-	if (power >= 0) {
-		 res = set_cpu_core_idle(fme_handle, power);
+	ON_ERR_GOTO(res, out_destroy_tok, "planning core idle");
+
+	if (num_apply == 0) {
+		// TDP+ SKU on every socket
+		res = plans[0].result;
+		goto out_destroy_tok;
 	}
 
-out_close:
-	/* Close file handle */
-	result = fpgaClose(fme_handle);
-	ON_ERR_GOTO(result, out_destroy_tok, "closing FME");
+	// Idle CPU cores
+	if (!coreidleCmdLine.dry_run) {
+		res = apply_core_idle_plans(plans, num_plans);
+		ON_ERR_GOTO(res, out_destroy_tok, "idling cores");
+	}
 
-	/* Destroy token */
+	/* Destroy tokens */
 out_destroy_tok:
-	result = fpgaDestroyToken(&fme_token);
-	ON_ERR_GOTO(result, out_destroy_prop, "destroying token");
+	for (i = 0; i < num_matches; i++) {
+		result = fpgaDestroyToken(&fme_tokens[i]);
+		if (result != FPGA_OK)
+			print_err("destroying token", result);
+	}
 
+out_free:
+	free(plans);
+	free(fme_tokens);
 
 	/* Destroy properties object */
 out_destroy_prop:
@@ -238,10 +434,48 @@ out_destroy_prop:
 	ON_ERR_GOTO(result, out_exit, "destroying properties object");
 
 out_exit:
-	opae_unload_bitstream(&coreidleCmdLine.bitstr);
 	return res != FPGA_OK ? res : result;
 }
 
+// parse <[ssss:]bb:dd.f>=<GBS FILE>
+int parse_card_gbs(const char *arg, struct CardGbs *card)
+{
+	unsigned int segment  = 0;
+	unsigned int bus      = 0;
+	unsigned int device   = 0;
+	unsigned int function = 0;
+	int n                 = 0;
+	size_t len;
+
+	if (sscanf(arg, "%x:%x:%x.%x%n",
+		   &segment, &bus, &device, &function, &n) != 4 ||
+	    arg[n] != '=') {
+		segment = 0;
+		n = 0;
+		if (sscanf(arg, "%x:%x.%x%n",
+			   &bus, &device, &function, &n) != 3 ||
+		    arg[n] != '=')
+			return -1;
+	}
+
+	if (segment > 0xffff || bus > 0xff || device > 0x1f || function > 0x7)
+		return -1;
+
+	arg += n + 1;
+	len = strnlen(arg, PATH_MAX - 1);
+	if (len == 0)
+		return -1;
+
+	card->segment = segment;
+	card->bus = bus;
+	card->device = device;
+	card->function = function;
+	memcpy(card->filename, arg, len);
+	card->filename[len] = '\0';
+
+	return 0;
+}
+
 #define MAX_CMD_OPT 256
 // parse Input command line
 int ParseCmds(struct CoreIdleCommandLine *coreidleCmdLine,
@@ -320,10 +554,35 @@ int ParseCmds(struct CoreIdleCommandLine *coreidleCmdLine,
 			if (!tmp_optarg)
 				return -1;
 			len = strnlen(tmp_optarg, MAX_CMD_OPT - 1);
+			// an empty name would silently mean no --gbs
+			if (len == 0) {
+				printf("Invalid --gbs option.\n");
+				return -1;
+			}
 			memcpy(coreidleCmdLine->filename, tmp_optarg, len);
 			coreidleCmdLine->filename[len] = '\0';
 			break;
 
+		case 'c':
+			// Bitstream GBS for one card
+			if (!tmp_optarg)
+				return -1;
+			if (coreidleCmdLine->num_cards >= MAX_CARD_GBS) {
+				printf("Too many --card-gbs options.\n");
+				return -1;
+			}
+			if (parse_card_gbs(tmp_optarg,
+				&coreidleCmdLine->cards[coreidleCmdLine->num_cards])) {
+				printf("Invalid --card-gbs option.\n");
+				return -1;
+			}
+			++coreidleCmdLine->num_cards;
+			break;
+
+		case 'n':
+			coreidleCmdLine->dry_run = 1;
+			break;
+
 		case 'v':
 			printf("coreidle %s %s%s\n",
 			       OPAE_VERSION,
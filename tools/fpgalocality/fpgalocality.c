@@ -0,0 +1,446 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "fpgalocality.h"
+#include "fpgalocality_int.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <opae/fpga.h>
+#include <opae/log.h>
+#include <opae/properties.h>
+
+#define LOCALITY_PATH_MAX	256
+#define LOCALITY_LIST_MAX	4096
+
+#define PCI_DEVICE_SYSFS	"/sys/bus/pci/devices/%04x:%02x:%02x.%1x"
+#define CPU_SYSFS		"/sys/devices/system/cpu"
+
+/* read the first line of a sysfs file */
+static fpga_result read_sysfs_line(const char *path, char *buf, size_t len)
+{
+	FILE *file = NULL;
+
+	file = fopen(path, "r");
+	if (!file) {
+		OPAE_DBG("fopen(%s) failed", path);
+		return FPGA_NOT_FOUND;
+	}
+
+	if (!fgets(buf, len, file)) {
+		OPAE_DBG("Failed to read %s", path);
+		fclose(file);
+		return FPGA_NOT_FOUND;
+	}
+
+	fclose(file);
+	buf[strcspn(buf, "\n")] = '\0';
+	return FPGA_OK;
+}
+
+/* parse a cpulist such as "0-27,56-83" */
+fpga_result fpga_locality_parse_cpulist(const char *list, cpu_set_t *cpus)
+{
+	char *endptr	= NULL;
+	long first	= 0;
+	long last	= 0;
+
+	if (!list || !cpus)
+		return FPGA_INVALID_PARAM;
+
+	CPU_ZERO(cpus);
+
+	while (*list) {
+		errno = 0;
+		first = strtol(list, &endptr, 10);
+		if (errno || endptr == list || first < 0)
+			return FPGA_EXCEPTION;
+		last = first;
+		list = endptr;
+
+		if (*list == '-') {
+			++list;
+			last = strtol(list, &endptr, 10);
+			if (errno || endptr == list || last < first)
+				return FPGA_EXCEPTION;
+			list = endptr;
+		}
+
+		if (last >= FPGA_LOCALITY_MAX_CPUS)
+			return FPGA_EXCEPTION;
+
+		for (; first <= last; first++)
+			CPU_SET(first, cpus);
+
+		if (*list == ',')
+			++list;
+		else if (*list)
+			return FPGA_EXCEPTION;
+	}
+
+	return FPGA_OK;
+}
+
+static fpga_result read_cpulist(const char *path, cpu_set_t *cpus)
+{
+	char buf[LOCALITY_LIST_MAX] = { 0 };
+	fpga_result res = FPGA_OK;
+
+	res = read_sysfs_line(path, buf, sizeof(buf));
+	if (res != FPGA_OK)
+		return res;
+
+	return fpga_locality_parse_cpulist(buf, cpus);
+}
+
+static fpga_result read_cpu_topology(int cpu, const char *attr,
+				     char *buf, size_t len)
+{
+	char path[LOCALITY_PATH_MAX] = { 0 };
+
+	if (snprintf(path, sizeof(path), CPU_SYSFS "/cpu%d/topology/%s",
+		     cpu, attr) < 0) {
+		OPAE_ERR("snprintf buffer overflow");
+		return FPGA_EXCEPTION;
+	}
+
+	return read_sysfs_line(path, buf, len);
+}
+
+/* CPUs whose physical package is socket_id */
+static fpga_result get_socket_cpus(const cpu_set_t *online,
+				   uint8_t socket_id,
+				   cpu_set_t *cpus)
+{
+	char buf[32] = { 0 };
+	int cpu = 0;
+
+	CPU_ZERO(cpus);
+
+	for (cpu = 0; cpu < FPGA_LOCALITY_MAX_CPUS; cpu++) {
+		if (!CPU_ISSET(cpu, online))
+			continue;
+		if (read_cpu_topology(cpu, "physical_package_id",
+				      buf, sizeof(buf)) != FPGA_OK)
+			continue;
+		if (strtol(buf, NULL, 10) == socket_id)
+			CPU_SET(cpu, cpus);
+	}
+
+	return CPU_COUNT(cpus) ? FPGA_OK : FPGA_NOT_FOUND;
+}
+
+static fpga_result locality_from_properties(fpga_properties props,
+					    fpga_locality *loc)
+{
+	char path[LOCALITY_PATH_MAX]	= { 0 };
+	char buf[32]			= { 0 };
+	fpga_result res			= FPGA_OK;
+	uint16_t segment		= 0;
+	uint8_t bus			= 0;
+	uint8_t device			= 0;
+	uint8_t function		= 0;
+	cpu_set_t online;
+	cpu_set_t siblings;
+	cpu_set_t init_cpus;
+	int cpu				= 0;
+	int sibling			= 0;
+
+	memset(loc, 0, sizeof(*loc));
+	loc->numa_node = -1;
+	memset(loc->core, 0xff, sizeof(loc->core));
+
+	res = fpgaPropertiesGetSegment(props, &segment);
+	if (res == FPGA_OK)
+		res = fpgaPropertiesGetBus(props, &bus);
+	if (res == FPGA_OK)
+		res = fpgaPropertiesGetDevice(props, &device);
+	if (res == FPGA_OK)
+		res = fpgaPropertiesGetFunction(props, &function);
+	if (res == FPGA_OK)
+		res = fpgaPropertiesGetSocketID(props, &loc->socket_id);
+	if (res != FPGA_OK) {
+		OPAE_ERR("Failed to get sbdf");
+		return res;
+	}
+
+	res = read_cpulist(CPU_SYSFS "/online", &online);
+	if (res != FPGA_OK) {
+		OPAE_ERR("Failed to read online CPUs");
+		return FPGA_NOT_FOUND;
+	}
+
+	if (snprintf(path, sizeof(path), PCI_DEVICE_SYSFS "/numa_node",
+		     segment, bus, device, function) < 0) {
+		OPAE_ERR("snprintf buffer overflow");
+		return FPGA_EXCEPTION;
+	}
+
+	if (read_sysfs_line(path, buf, sizeof(buf)) == FPGA_OK)
+		loc->numa_node = strtol(buf, NULL, 10);
+
+	// Without NUMA affinity, local_cpulist spans every CPU;
+	// the FME's socket is then the best locality we know of.
+	res = FPGA_NOT_FOUND;
+	if (loc->numa_node >= 0) {
+		if (snprintf(path, sizeof(path),
+			     PCI_DEVICE_SYSFS "/local_cpulist",
+			     segment, bus, device, function) < 0) {
+			OPAE_ERR("snprintf buffer overflow");
+			return FPGA_EXCEPTION;
+		}
+		res = read_cpulist(path, &loc->local_cpus);
+	}
+
+	if (res != FPGA_OK)
+		res = get_socket_cpus(&online, loc->socket_id,
+				      &loc->local_cpus);
+	if (res != FPGA_OK) {
+		OPAE_ERR("Failed to find FPGA local CPUs");
+		return FPGA_NOT_FOUND;
+	}
+
+	CPU_AND(&loc->local_cpus, &loc->local_cpus, &online);
+
+	// SMT sibling map
+	for (cpu = 0; cpu < FPGA_LOCALITY_MAX_CPUS; cpu++) {
+		char list[LOCALITY_LIST_MAX] = { 0 };
+
+		if (!CPU_ISSET(cpu, &online) || loc->core[cpu] >= 0)
+			continue;
+
+		loc->core[cpu] = cpu;
+		if (read_cpu_topology(cpu, "thread_siblings_list",
+				      list, sizeof(list)) != FPGA_OK ||
+		    fpga_locality_parse_cpulist(list, &siblings) != FPGA_OK)
+			continue;
+
+		for (sibling = cpu + 1;
+		     sibling < FPGA_LOCALITY_MAX_CPUS; sibling++) {
+			if (CPU_ISSET(sibling, &siblings) &&
+			    CPU_ISSET(sibling, &online))
+				loc->core[sibling] = cpu;
+		}
+	}
+
+	// coreidle parks CPUs by removing them from the affinity
+	// of every task, starting with pid 1.
+	CPU_ZERO(&init_cpus);
+	if (sched_getaffinity(1, sizeof(init_cpus), &init_cpus) == 0) {
+		CPU_XOR(&loc->parked_cpus, &loc->local_cpus, &init_cpus);
+		CPU_AND(&loc->parked_cpus, &loc->parked_cpus,
+			&loc->local_cpus);
+	}
+
+	return FPGA_OK;
+}
+
+fpga_result fpgaLocalityGet(fpga_token token, fpga_locality *loc)
+{
+	fpga_properties props	= NULL;
+	fpga_result res		= FPGA_OK;
+	fpga_result resval	= FPGA_OK;
+
+	if (!token || !loc) {
+		OPAE_ERR("Invalid input parameters");
+		return FPGA_INVALID_PARAM;
+	}
+
+	res = fpgaGetProperties(token, &props);
+	if (res != FPGA_OK) {
+		OPAE_ERR("Failed to get properties");
+		return res;
+	}
+
+	resval = locality_from_properties(props, loc);
+
+	res = fpgaDestroyProperties(&props);
+	if (res != FPGA_OK)
+		OPAE_ERR("Failed to destroy properties");
+
+	return resval != FPGA_OK ? resval : res;
+}
+
+fpga_result fpgaLocalityGetFromHandle(fpga_handle handle, fpga_locality *loc)
+{
+	fpga_properties props	= NULL;
+	fpga_result res		= FPGA_OK;
+	fpga_result resval	= FPGA_OK;
+
+	if (!handle || !loc) {
+		OPAE_ERR("Invalid input parameters");
+		return FPGA_INVALID_PARAM;
+	}
+
+	res = fpgaGetPropertiesFromHandle(handle, &props);
+	if (res != FPGA_OK) {
+		OPAE_ERR("Failed to get properties");
+		return res;
+	}
+
+	resval = locality_from_properties(props, loc);
+
+	res = fpgaDestroyProperties(&props);
+	if (res != FPGA_OK)
+		OPAE_ERR("Failed to destroy properties");
+
+	return resval != FPGA_OK ? resval : res;
+}
+
+fpga_result fpgaLocalityGetSiblings(const fpga_locality *loc, int cpu,
+				    cpu_set_t *siblings)
+{
+	int i = 0;
+
+	if (!loc || !siblings || cpu < 0 || cpu >= FPGA_LOCALITY_MAX_CPUS ||
+	    loc->core[cpu] < 0) {
+		OPAE_ERR("Invalid input parameters");
+		return FPGA_INVALID_PARAM;
+	}
+
+	CPU_ZERO(siblings);
+	for (i = loc->core[cpu]; i < FPGA_LOCALITY_MAX_CPUS; i++) {
+		if (loc->core[i] == loc->core[cpu])
+			CPU_SET(i, siblings);
+	}
+
+	return FPGA_OK;
+}
+
+fpga_result fpgaLocalityGetPlacement(const fpga_locality *loc,
+				     int *cpus,
+				     size_t *num_cpus,
+				     size_t *num_cores)
+{
+	cpu_set_t usable;
+	cpu_set_t placed;
+	cpu_set_t primary;
+	size_t count	= 0;
+	size_t cores	= 0;
+	int cpu		= 0;
+	int core	= 0;
+
+	if (!loc || !cpus || !num_cpus) {
+		OPAE_ERR("Invalid input parameters");
+		return FPGA_INVALID_PARAM;
+	}
+
+	// usable = local & ~parked
+	CPU_XOR(&usable, &loc->local_cpus, &loc->parked_cpus);
+	CPU_AND(&usable, &usable, &loc->local_cpus);
+	CPU_ZERO(&placed);
+	CPU_ZERO(&primary);
+
+	// One thread per physical core first ...
+	for (cpu = 0; cpu < FPGA_LOCALITY_MAX_CPUS; cpu++) {
+		if (!CPU_ISSET(cpu, &usable))
+			continue;
+		core = loc->core[cpu] >= 0 ? loc->core[cpu] : cpu;
+		if (CPU_ISSET(core, &placed))
+			continue;
+		CPU_SET(core, &placed);
+		CPU_SET(cpu, &primary);
+		cpus[count++] = cpu;
+	}
+	cores = count;
+
+	// ... then the remaining SMT siblings.
+	for (cpu = 0; cpu < FPGA_LOCALITY_MAX_CPUS; cpu++) {
+		if (CPU_ISSET(cpu, &usable) && !CPU_ISSET(cpu, &primary))
+			cpus[count++] = cpu;
+	}
+
+	*num_cpus = count;
+	if (num_cores)
+		*num_cores = cores;
+
+	return count ? FPGA_OK : FPGA_NOT_FOUND;
+}
+
+static fpga_result pin_thread(pthread_t thread, int cpu)
+{
+	cpu_set_t cpus;
+	int err = 0;
+
+	CPU_ZERO(&cpus);
+	CPU_SET(cpu, &cpus);
+
+	err = pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+	if (err) {
+		OPAE_ERR("Failed to pin thread to CPU %d: %s",
+			 cpu, strerror(err));
+		return FPGA_EXCEPTION;
+	}
+
+	return FPGA_OK;
+}
+
+fpga_result fpgaLocalityPinThread(const fpga_locality *loc,
+				  pthread_t thread,
+				  size_t index)
+{
+	int cpus[FPGA_LOCALITY_MAX_CPUS];
+	size_t num_cpus		= 0;
+	size_t num_cores	= 0;
+	fpga_result res		= FPGA_OK;
+
+	res = fpgaLocalityGetPlacement(loc, cpus, &num_cpus, &num_cores);
+	if (res != FPGA_OK)
+		return res;
+
+	return pin_thread(thread, cpus[index % num_cores]);
+}
+
+fpga_result fpgaLocalityPinThreads(const fpga_locality *loc,
+				   const pthread_t *threads,
+				   size_t num_threads)
+{
+	int cpus[FPGA_LOCALITY_MAX_CPUS];
+	size_t num_cpus		= 0;
+	size_t i		= 0;
+	fpga_result res		= FPGA_OK;
+
+	if (!threads) {
+		OPAE_ERR("Invalid input parameters");
+		return FPGA_INVALID_PARAM;
+	}
+
+	res = fpgaLocalityGetPlacement(loc, cpus, &num_cpus, NULL);
+	if (res != FPGA_OK)
+		return res;
+
+	for (i = 0; i < num_threads; i++) {
+		res = pin_thread(threads[i], cpus[i % num_cpus]);
+		if (res != FPGA_OK)
+			return res;
+	}
+
+	return FPGA_OK;
+}
@@ -0,0 +1,170 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __FPGA_LOCALITY_H__
+#define __FPGA_LOCALITY_H__
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <opae/types.h>
+#include <opae/types_enum.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define FPGA_LOCALITY_MAX_CPUS	CPU_SETSIZE
+
+typedef struct {
+	int numa_node;
+	uint8_t socket_id;
+	cpu_set_t local_cpus;
+	cpu_set_t parked_cpus;
+	int16_t core[FPGA_LOCALITY_MAX_CPUS];
+} fpga_locality;
+
+/**
+ * Get the CPU locality of an FPGA.
+ *
+ * Read the NUMA node and local CPU list of the FPGA's PCIe function,
+ * falling back to the CPUs of the FPGA's socket when the platform
+ * reports no NUMA affinity. Each online CPU is mapped to the first
+ * CPU of its SMT sibling list, so that core[cpu] identifies the
+ * physical core (-1 for offline CPUs). Local CPUs missing from the
+ * affinity of pid 1 have been parked by coreidle and are recorded in
+ * parked_cpus.
+ *
+ * @param[in] token Fpga_token object for device (FPGA_DEVICE type)
+ * @param[out] loc Returns the fpga_locality struct
+ *
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if any of the supplied
+ * parameters is invalid. FPGA_NOT_FOUND if the FPGA's local CPUs could not
+ * be determined.
+ */
+fpga_result fpgaLocalityGet(fpga_token token, fpga_locality *loc);
+
+/**
+ * Get the CPU locality of an open FPGA.
+ *
+ * Same as fpgaLocalityGet, for callers that only hold a handle.
+ *
+ * @param[in] handle Handle to an open FPGA_DEVICE or FPGA_ACCELERATOR
+ * @param[out] loc Returns the fpga_locality struct
+ *
+ * @returns See fpgaLocalityGet.
+ */
+fpga_result fpgaLocalityGetFromHandle(fpga_handle handle, fpga_locality *loc);
+
+/**
+ * Get the SMT siblings of a CPU.
+ *
+ * @param[in] loc Locality returned by fpgaLocalityGet
+ * @param[in] cpu CPU number
+ * @param[out] siblings Returns every online CPU on the same physical core
+ *
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if any of the supplied
+ * parameters is invalid or cpu is offline.
+ */
+fpga_result fpgaLocalityGetSiblings(const fpga_locality *loc, int cpu,
+				    cpu_set_t *siblings);
+
+/**
+ * List the CPUs threads should be placed on.
+ *
+ * Return the FPGA-local, online CPUs that coreidle has not parked,
+ * ordered for placement: the first thread of every physical core,
+ * followed by the remaining SMT siblings. Pinning N threads to the
+ * first N entries therefore uses distinct physical cores whenever
+ * enough of them are available.
+ *
+ * @param[in] loc Locality returned by fpgaLocalityGet
+ * @param[out] cpus Array of at least FPGA_LOCALITY_MAX_CPUS entries
+ * @param[out] num_cpus Returns the number of entries written to cpus
+ * @param[out] num_cores Returns the number of physical cores,
+ *             the leading entries of cpus. May be NULL.
+ *
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if any of the supplied
+ * parameters is invalid. FPGA_NOT_FOUND if no usable CPU is left.
+ */
+fpga_result fpgaLocalityGetPlacement(const fpga_locality *loc,
+				     int *cpus,
+				     size_t *num_cpus,
+				     size_t *num_cores);
+
+/**
+ * Pin a thread to an FPGA-local physical core.
+ *
+ * Pin thread to the index-th entry (modulo the number of physical
+ * cores) of the placement computed by fpgaLocalityGetPlacement.
+ * Use pthread_self() to pin the calling thread.
+ *
+ * @param[in] loc Locality returned by fpgaLocalityGet
+ * @param[in] thread Thread to pin
+ * @param[in] index Placement index of the thread
+ *
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if any of the supplied
+ * parameters is invalid. FPGA_NOT_FOUND if no usable CPU is left.
+ * FPGA_EXCEPTION if the affinity could not be set.
+ */
+fpga_result fpgaLocalityPinThread(const fpga_locality *loc,
+				  pthread_t thread,
+				  size_t index);
+
+/**
+ * Pin a pool of threads to FPGA-local cores.
+ *
+ * Thread i is pinned to entry i of the placement computed by
+ * fpgaLocalityGetPlacement, so threads fill distinct physical cores
+ * before sharing SMT siblings, wrapping around when the pool is
+ * larger than the number of usable CPUs.
+ *
+ * @param[in] loc Locality returned by fpgaLocalityGet
+ * @param[in] threads Threads to pin
+ * @param[in] num_threads Number of entries in threads
+ *
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if any of the supplied
+ * parameters is invalid. FPGA_NOT_FOUND if no usable CPU is left.
+ * FPGA_EXCEPTION if an affinity could not be set.
+ */
+fpga_result fpgaLocalityPinThreads(const fpga_locality *loc,
+				   const pthread_t *threads,
+				   size_t num_threads);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FPGA_LOCALITY_H__ */
@@ -25,6 +25,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "accelerator_przone.h"
+#include "poll.h"
 #include <thread>
 #include <chrono>
 
@@ -36,24 +37,76 @@ namespace hssi
 {
 
 using namespace intel::fpga;
-using std::chrono::microseconds;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
 
-enum
+accelerator_przone::accelerator_przone(opae::fpga::types::handle::ptr_t h)
+: handle_(h)
+, order_(ordering::spin)
+, delay_nsec_(default_delay_nsec)
 {
-    mmio_delay_usec = 1
-};
 
+}
 
-accelerator_przone::accelerator_przone(opae::fpga::types::handle::ptr_t h)
-: handle_(h)
+void accelerator_przone::set_ordering(ordering order, uint32_t delay_nsec)
+{
+    order_ = order;
+    delay_nsec_ = delay_nsec;
+}
+
+bool accelerator_przone::parse(const std::string & name, ordering & order)
 {
+    if (name == "sleep")
+    {
+        order = ordering::sleep;
+    }
+    else if (name == "spin")
+    {
+        order = ordering::spin;
+    }
+    else if (name == "fence")
+    {
+        order = ordering::fence;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
 
+void accelerator_przone::spin_delay(uint32_t nsec)
+{
+    // a deadline rather than a count of pauses: the cost of a pause
+    // changes with the CPU model and frequency
+    auto end = steady_clock::now() + nanoseconds(nsec);
+    while (steady_clock::now() < end)
+    {
+        poller::pause();
+    }
+}
+
+void accelerator_przone::order_read()
+{
+    // account for timing differences in AFU logic and ETH logic
+    switch (order_)
+    {
+        case ordering::sleep:
+            std::this_thread::sleep_for(nanoseconds(delay_nsec_));
+            break;
+        case ordering::spin:
+            spin_delay(delay_nsec_);
+            break;
+        case ordering::fence:
+            // a read completes only after the writes posted before it
+            handle_->read_csr32(static_cast<uint32_t>(mmio_reg::afu_ctrl));
+            break;
+    }
 }
 
 bool accelerator_przone::read(uint32_t address, uint32_t & value)
 {
-    // add delay to account for timing differences in AFU logic and ETH logic
-    std::this_thread::sleep_for(microseconds(mmio_delay_usec));
+    order_read();
     uint32_t msg = static_cast<uint32_t>(przone_cmd::read) | address;
     handle_->write_csr32(static_cast<uint32_t>(mmio_reg::afu_ctrl), msg);
     value = handle_->read_csr32(static_cast<uint32_t>(mmio_reg::afu_rd_data));
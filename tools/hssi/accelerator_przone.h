@@ -25,6 +25,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 #include "przone.h"
+#include <string>
 #include <opae/cxx/core/handle.h>
 
 namespace intel
@@ -52,14 +53,39 @@ public:
         afu_rd_data = 0x0030
     };
 
+    /// @brief How a read is kept from overtaking the AFU and ETH logic
+    ///        still busy with the previous command
+    enum class ordering
+    {
+        sleep,  ///< sleep delay_nsec before each read (the historical behavior)
+        spin,   ///< busy-wait delay_nsec on the steady clock
+        fence   ///< read back afu_ctrl, flushing the previous command
+    };
+
+    static const uint32_t default_delay_nsec = 1000;
+
     accelerator_przone(opae::fpga::types::handle::ptr_t acceleratorptr);
     virtual ~accelerator_przone(){}
 
     virtual bool read(uint32_t address, uint32_t & value);
     virtual bool write(uint32_t address, uint32_t value);
 
+    void set_ordering(ordering order, uint32_t delay_nsec = default_delay_nsec);
+    ordering get_ordering() const { return order_; }
+    uint32_t get_delay_nsec() const { return delay_nsec_; }
+
+    /// @brief Parse an ordering name (sleep, spin, fence)
+    static bool parse(const std::string & name, ordering & order);
+
+    /// @brief Busy-wait until nsec nanoseconds have passed
+    static void spin_delay(uint32_t nsec);
+
 private:
     opae::fpga::types::handle::ptr_t handle_;
+    ordering order_;
+    uint32_t delay_nsec_;
+
+    void order_read();
 
 };
 
@@ -0,0 +1,201 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "arbiter.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <map>
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+const size_t arbiter::priorities;
+
+arbiter::arbiter() : arbiter(std::string()) {}
+
+arbiter::arbiter(const std::string& path)
+    : path_(path), fd_(-1), held_(false), depth_(0), stats_() {
+  for (size_t i = 0; i < priorities; ++i) {
+    next_[i] = 0;
+    serving_[i] = 0;
+  }
+  if (!path_.empty()) {
+    fd_ = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  }
+}
+
+arbiter::~arbiter() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+arbiter::ptr_t arbiter::for_resource(const std::string& path) {
+  static std::mutex registry_mutex;
+  static std::map<std::string, std::weak_ptr<arbiter>> registry;
+
+  std::lock_guard<std::mutex> guard(registry_mutex);
+  ptr_t a = registry[path].lock();
+  if (!a) {
+    a.reset(new arbiter(path));
+    registry[path] = a;
+  }
+  return a;
+}
+
+bool arbiter::parse(const std::string& name, priority& p) {
+  if (name == "bulk") {
+    p = priority::bulk;
+  } else if (name == "normal") {
+    p = priority::normal;
+  } else if (name == "monitor") {
+    p = priority::monitor;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void arbiter::lock(priority p) {
+  std::unique_lock<std::mutex> guard(mutex_);
+  if (held_ && owner_ == std::this_thread::get_id()) {
+    ++depth_;
+    return;
+  }
+
+  const size_t i = static_cast<size_t>(p);
+  const uint64_t ticket = next_[i]++;
+  if (held_ || serving_[i] != ticket || ahead(i)) {
+    auto begin = std::chrono::steady_clock::now();
+    do {
+      turn_.wait(guard);
+    } while (held_ || serving_[i] != ticket || ahead(i));
+    uint64_t nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - begin).count();
+    ++stats_.contended;
+    stats_.wait_nsec += nsec;
+    if (nsec > stats_.max_wait_nsec) stats_.max_wait_nsec = nsec;
+  }
+
+  ++serving_[i];
+  ++stats_.acquisitions;
+  held_ = true;
+  owner_ = std::this_thread::get_id();
+  depth_ = 1;
+  guard.unlock();
+
+  // other processes; the waiters of this one queue up meanwhile
+  flock_exclusive(true);
+}
+
+bool arbiter::try_lock(priority p) {
+  std::unique_lock<std::mutex> guard(mutex_);
+  if (held_ && owner_ == std::this_thread::get_id()) {
+    ++depth_;
+    return true;
+  }
+
+  const size_t i = static_cast<size_t>(p);
+  if (held_ || next_[i] != serving_[i] || ahead(i)) {
+    return false;
+  }
+  ++next_[i];
+  ++serving_[i];
+  held_ = true;
+  owner_ = std::this_thread::get_id();
+  depth_ = 1;
+  guard.unlock();
+
+  if (flock_exclusive(false)) {
+    guard.lock();
+    ++stats_.acquisitions;
+    return true;
+  }
+
+  guard.lock();
+  held_ = false;
+  owner_ = std::thread::id();
+  depth_ = 0;
+  turn_.notify_all();
+  return false;
+}
+
+void arbiter::unlock() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (!held_ || owner_ != std::this_thread::get_id() || --depth_ > 0) {
+    return;
+  }
+  flock_release();
+  held_ = false;
+  owner_ = std::thread::id();
+  turn_.notify_all();
+}
+
+bool arbiter::owned() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return held_ && owner_ == std::this_thread::get_id();
+}
+
+arbiter::stats arbiter::get_stats() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return stats_;
+}
+
+bool arbiter::ahead(size_t p) const {
+  for (size_t q = p + 1; q < priorities; ++q) {
+    if (next_[q] != serving_[q]) return true;
+  }
+  return false;
+}
+
+bool arbiter::flock_exclusive(bool wait) {
+  if (fd_ < 0) {
+    return true;
+  }
+  int op = wait ? LOCK_EX : LOCK_EX | LOCK_NB;
+  while (::flock(fd_, op) != 0) {
+    if (errno != EINTR) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void arbiter::flock_release() {
+  if (fd_ >= 0) {
+    ::flock(fd_, LOCK_UN);
+  }
+}
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
@@ -0,0 +1,151 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+/// @brief Serializes the clients of one HSSI controller mailbox.
+///
+/// Within a process, waiters are granted the mailbox by priority, and
+/// in arrival order within a priority. The thread holding the arbiter
+/// may lock it again, so a sequence (an I2C read) can hold it across
+/// the transactions it is made of. An arbiter opened on a lock file
+/// also takes flock() on it while held, which serializes processes;
+/// the kernel drops that lock if the holder dies. Between processes the
+/// order is the kernel's, not the priority.
+class arbiter {
+ public:
+  typedef std::shared_ptr<arbiter> ptr_t;
+
+  enum class priority : uint8_t {
+    bulk,     ///< long dumps and configuration
+    normal,
+    monitor   ///< latency-sensitive link monitoring
+  };
+  static const size_t priorities = 3;
+
+  struct stats {
+    uint64_t acquisitions;  ///< outermost locks
+    uint64_t contended;     ///< of those, the ones that had to wait
+    uint64_t wait_nsec;
+    uint64_t max_wait_nsec;
+  };
+
+  /// @brief Holds an arbiter for its lifetime; a null arbiter is never
+  ///        locked
+  class lease {
+   public:
+    lease() {}
+    explicit lease(const ptr_t& a, priority p = priority::normal) : a_(a) {
+      if (a_) a_->lock(p);
+    }
+    lease(lease&& other) : a_(std::move(other.a_)) { other.a_.reset(); }
+    lease& operator=(lease&& other) {
+      if (this != &other) {
+        release();
+        a_ = std::move(other.a_);
+        other.a_.reset();
+      }
+      return *this;
+    }
+    ~lease() { release(); }
+
+    void release() {
+      if (a_) a_->unlock();
+      a_.reset();
+    }
+
+   private:
+    lease(const lease&) = delete;
+    lease& operator=(const lease&) = delete;
+
+    ptr_t a_;
+  };
+
+  /// @brief An arbiter for the threads of this process only
+  arbiter();
+  ~arbiter();
+
+  /// @brief The arbiter of a resource file, shared by every caller in
+  ///        this process and flock()ed against other processes. Falls
+  ///        back to in-process only if the file cannot be opened. A
+  ///        forked child shares the parent's flock and must not use it.
+  static ptr_t for_resource(const std::string& path);
+
+  static bool parse(const std::string& name, priority& p);
+
+  /// @brief Wait for the mailbox
+  void lock(priority p = priority::normal);
+  /// @brief Take the mailbox only if nobody holds or waits for it at p
+  ///        or above; never blocks
+  bool try_lock(priority p = priority::normal);
+  void unlock();
+
+  /// @brief true if the calling thread holds the arbiter
+  bool owned();
+
+  /// @brief true if other processes are locked out as well
+  bool cross_process() const { return fd_ >= 0; }
+  const std::string& path() const { return path_; }
+
+  stats get_stats();
+
+ private:
+  explicit arbiter(const std::string& path);
+
+  bool ahead(size_t p) const;
+  bool flock_exclusive(bool wait);
+  void flock_release();
+
+  std::string path_;
+  int fd_;
+
+  std::mutex mutex_;
+  std::condition_variable turn_;
+  // per priority: the next ticket handed out and the ticket served next
+  uint64_t next_[priorities];
+  uint64_t serving_[priorities];
+  bool held_;
+  std::thread::id owner_;
+  size_t depth_;
+  stats stats_;
+};
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
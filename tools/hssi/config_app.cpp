@@ -32,8 +32,12 @@
 #include "utils.h"
 #include "fme.h"
 #include "mmio_stream.h"
+#include "eq_profile.h"
+#include "eq_csv.h"
+#include "bounded_queue.h"
 #include <chrono>
 #include <thread>
+#include <unordered_map>
 
 using namespace intel::utils;
 
@@ -53,27 +57,6 @@ enum
 const std::string sysfs_path_template = "/sys/class/fpga/intel-fpga-dev.{0}/device/resource0";
 
 
-static std::map<std::string, eq_register_type> str_register_type_map{
-    {"FPGA_RX", eq_register_type::fpga_rx     },
-    {"FPGA_TX", eq_register_type::fpga_tx     },
-    {"RTMR_RX", eq_register_type::retimer_rx  },
-    {"RTMR_TX", eq_register_type::retimer_tx  },
-    {"MODE",    eq_register_type::hssi_mode   },
-    {"MDIO",    eq_register_type::mdio        },
-    {"PRZONE",  eq_register_type::przone      }
-};
-
-static std::map<eq_register_type, std::string> register_type_str_map{
-    { eq_register_type::fpga_rx,     "FPGA_RX" },
-    { eq_register_type::fpga_tx,     "FPGA_TX" },
-    { eq_register_type::retimer_rx,  "RTMR_RX" },
-    { eq_register_type::retimer_tx,  "RTMR_TX" },
-    { eq_register_type::hssi_mode,   "MODE"    },
-    { eq_register_type::mdio,        "MDIO"    },
-    { eq_register_type::przone,      "PRZONE"  }
-};
-
-
 const uint32_t default_dump_size = 38;
 eq_register default_dump[default_dump_size] =
 {
@@ -127,14 +110,31 @@ const uint32_t max_rtmr_channel       = 4;
 static std::vector<uint32_t> valid_rtmr_device_addrs =  { 0x30, 0x32, 0x34, 0x36 };
 static std::vector<uint32_t> valid_rtmr_device_writes = { 0x31, 0x33, 0x35, 0x37 };
 
+const size_t config_app::load_chunk;
+const size_t config_app::load_queue;
+const size_t config_app::apply_error;
+
 config_app::config_app()
+: config_app(std::cout, std::cerr)
+{
+}
+
+config_app::config_app(std::ostream & out, std::ostream & err)
 : c_header_(false)
+, dry_run_(false)
 , hssi_cmd_count_(0)
 , ctrl_(static_cast<uint32_t>(fme_csr::hssi_ctrl))
 , stat_(static_cast<uint32_t>(fme_csr::hssi_stat))
 , byte_addr_size_(1)
 , header_stream_()
 , input_file_("")
+, no_cache_(false)
+, mdio_settle_usec_(0)
+, out_(out)
+, err_(err)
+, priority_(arbiter::priority::normal)
+, breaker_limit_(hssi_przone::default_breaker_limit)
+, worker_(false)
 {
     options_.add_option<std::string>("resource",   'r', option::with_argument, "Path to syfs resource file");
     options_.add_option<uint8_t>("socket-id",      'S', option::with_argument, "Socket id encoded in BBS", 0);
@@ -143,6 +143,18 @@ config_app::config_app()
     options_.add_option<uint8_t>("function",       'F', option::with_argument, "Function number of PCIe device");
     options_.add_option<bool>("c-header",          'C', option::no_argument,   "Generate a C header file to integrate into BIOS", false);
     options_.add_option<uint32_t>("byte-address-size", option::with_argument,  "Byte address width (in bytes) of I2C devices", byte_addr_size_);
+    options_.add_option<bool>("all",               'a', option::no_argument,   "Run the command on every FPGA, one worker per device", false);
+    options_.add_option<bool>("dry-run",           'n', option::no_argument,   "Print the plan of apply without writing", false);
+    options_.add_option<bool>("no-cache",          option::no_argument,    "Always access registers, bypassing the per-run shadow register cache", false);
+    options_.add_option<std::string>("poll",            option::with_argument,  "Completion polling policy (spin, yield, sleep, legacy)", "sleep");
+    options_.add_option<std::string>("trace",           option::with_argument,  "Record every MMIO access into <trace>.<thread>.trace files (see hssi_trace)");
+    options_.add_option<std::string>("replay",          option::with_argument,  "Run against a trace file recorded with --trace instead of the FPGA, checking every write");
+    options_.add_option<bool>("replay-timing",     option::no_argument,    "Reproduce the recorded timing when replaying", false);
+    options_.add_option<std::string>("model",           option::with_argument,  "Run against a software model of the HSSI controller instead of the FPGA, with none or typical latency");
+    options_.add_option<uint32_t>("mdio-settle",   option::with_argument,  "Minimum time (usec) to wait after each MDIO command before polling for completion", 0);
+    options_.add_option<std::string>("priority",        option::with_argument,  "Priority among the clients of the controller (bulk, normal, monitor)", "normal");
+    options_.add_option<std::string>("timeouts",        option::with_argument,  "Controller wait timeouts (adaptive: learned from the observed latency, static: fixed)", "adaptive");
+    options_.add_option<uint32_t>("breaker",       option::with_argument,  "Abort a batch after this many controller transactions in a row timed out (0 never aborts)", breaker_limit_);
     options_.add_option<bool>("help",              'h', option::no_argument,   "Show help message", false);
     options_.add_option<bool>("version",           'v', option::no_argument,   "Show version", false);
 
@@ -152,6 +164,10 @@ config_app::config_app()
                               std::bind(&config_app::do_load, this, _1),
                               0,
                               "[inputfile.csv] [--c-header]");
+    console_.register_handler("apply",
+                              std::bind(&config_app::do_apply, this, _1),
+                              1,
+                              "inputfile.csv [--dry-run]");
     console_.register_handler("dump",
                               std::bind(&config_app::do_dump, this, _1),
                               0,
@@ -183,11 +199,11 @@ config_app::config_app()
     console_.register_handler("mread",
                               std::bind(&config_app::do_mdio_read, this, _1),
                               3,
-                              "device-addr port_address register-address");
+                              "device-addr port_address register-address [count]");
     console_.register_handler("mwrite",
                               std::bind(&config_app::do_mdio_write, this, _1),
                               4,
-                              "device-addr port_address byte-address value");
+                              "device-addr port_address byte-address value [value...]");
     console_.register_handler("pread",
                               std::bind(&config_app::do_pr_read, this, _1),
                               1,
@@ -196,6 +212,14 @@ config_app::config_app()
                               std::bind(&config_app::do_pr_write, this, _1),
                               2,
                               "address value");
+    console_.register_handler("stats",
+                              std::bind(&config_app::do_stats, this, _1),
+                              0,
+                              "[command [args...]]");
+    console_.register_handler("compile",
+                              std::bind(&config_app::do_compile, this, _1),
+                              2,
+                              "inputfile.csv outputfile.eqp");
 }
 
 
@@ -212,6 +236,7 @@ bool config_app::setup()
     }
 
     options_.get_value<bool>("c-header", c_header_);
+    options_.get_value<bool>("dry-run", dry_run_);
     std::string sysfs_path = "";
     int8_t socket_id = -1;
     if (options_["resource"] && options_["resource"]->is_set())
@@ -227,12 +252,78 @@ bool config_app::setup()
     }
     options_.get_value<uint32_t>("byte-address-size", byte_addr_size_);
 
+    std::string poll_name = "sleep";
+    options_.get_value<std::string>("poll", poll_name);
+    poll_config poll_cfg;
+    if (!poller::parse(poll_name, poll_cfg))
+    {
+        std::cerr << "Invalid polling policy: " << poll_name << std::endl;
+        return false;
+    }
+    poller::set_defaults(poll_cfg);
+
+    std::string priority_name = "normal";
+    options_.get_value<std::string>("priority", priority_name);
+    if (!arbiter::parse(priority_name, priority_))
+    {
+        std::cerr << "Invalid priority: " << priority_name << std::endl;
+        return false;
+    }
+
+    std::string timeouts_name = "adaptive";
+    options_.get_value<std::string>("timeouts", timeouts_name);
+    timeout_policy timeouts;
+    if (!adaptive_timeout::parse(timeouts_name, timeouts))
+    {
+        std::cerr << "Invalid timeouts: " << timeouts_name << std::endl;
+        return false;
+    }
+    adaptive_timeout::set_policy(timeouts);
+    options_.get_value<uint32_t>("breaker", breaker_limit_);
+
     if (options_["socket-id"] && options_["socket-id"]->is_set())
     {
         options_.get_value<int8_t>("socket-id", socket_id);
     }
 
-    if (!path_exists(sysfs_path) && !c_header_)
+    options_.get_value<bool>("no-cache", no_cache_);
+    options_.get_value<uint32_t>("mdio-settle", mdio_settle_usec_);
+    if (options_["trace"] && options_["trace"]->is_set())
+    {
+        options_.get_value<std::string>("trace", trace_prefix_);
+    }
+    std::string replay_file;
+    if (options_["replay"] && options_["replay"]->is_set())
+    {
+        options_.get_value<std::string>("replay", replay_file);
+    }
+    std::string model_latency_name;
+    if (options_["model"] && options_["model"]->is_set())
+    {
+        options_.get_value<std::string>("model", model_latency_name);
+    }
+    bool model = !model_latency_name.empty();
+
+    bool all = false;
+    options_.get_value<bool>("all", all);
+    if (all)
+    {
+        if (c_header_ || !replay_file.empty() || model)
+        {
+            std::cerr << "--all cannot generate a C header, replay a trace or run the model" << std::endl;
+            return false;
+        }
+
+        devices_ = hssi_device::enumerate();
+        if (devices_.empty())
+        {
+            std::cerr << "No FPGA devices found" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    if (!path_exists(sysfs_path) && !c_header_ && replay_file.empty() && !model)
     {
         std::cerr << "Resource path does not exist: " << sysfs_path << std::endl;
         return false;
@@ -242,9 +333,35 @@ bool config_app::setup()
     {
         mmio_.reset(new mmio_stream(header_stream_));
     }
+    else if (!replay_file.empty())
+    {
+        bool timing = false;
+        options_.get_value<bool>("replay-timing", timing);
+        std::string error;
+        replay_ = mmio_replay::open(replay_file,
+                                    timing ? mmio_replay::timing::recorded : mmio_replay::timing::none,
+                                    error);
+        if (!replay_)
+        {
+            std::cerr << replay_file << ": " << error << std::endl;
+            return false;
+        }
+        mmio_ = replay_;
+    }
+    else if (model)
+    {
+        model_latency latency;
+        if (!hssi_model::parse_latency(model_latency_name, latency))
+        {
+            std::cerr << "Invalid model latency: " << model_latency_name << std::endl;
+            return false;
+        }
+        mmio_.reset(new hssi_model(latency));
+    }
     else
     {
         mmio_ = fme::open(sysfs_path, socket_id);
+        lock_path_ = sysfs_path;
     }
 
     if (!mmio_)
@@ -253,26 +370,88 @@ bool config_app::setup()
         return false;
     }
 
-    dfh_list list(mmio_);
-    auto it = list.find(hssi_dfh_id, hssi_dfh_rev, dfh::priv);
-    if (it != list.end())
+    // trace from the feature list walk on, so a replay finds the controller
+    if (!trace_prefix_.empty())
     {
-        ctrl_ = it->offset() + 0x08;
-        stat_ = it->offset() + 0x10;
+        mmio_.reset(new mmio_trace(mmio_, trace_prefix_));
     }
-    przone_.reset(new hssi_przone(mmio_, ctrl_, stat_));
-    i2c_.reset(new i2c(std::dynamic_pointer_cast<przone_interface>(przone_), byte_addr_size_));
-    mdio_.reset(new mdio(std::dynamic_pointer_cast<przone_interface>(przone_)));
+
+    hssi_device::ptr_t device = hssi_device::open(mmio_, device_name_);
+    ctrl_ = device->get_ctrl();
+    stat_ = device->get_stat();
+    open_controller();
     return true;
 
 }
 
+bool config_app::setup(const config_app & parent, const hssi_device::ptr_t & device)
+{
+    c_header_       = false;
+    dry_run_        = parent.dry_run_;
+    no_cache_       = parent.no_cache_;
+    mdio_settle_usec_ = parent.mdio_settle_usec_;
+    // each device gets its own trace files
+    if (!parent.trace_prefix_.empty())
+    {
+        trace_prefix_ = parent.trace_prefix_ + "." + device->name();
+    }
+    byte_addr_size_ = parent.byte_addr_size_;
+    input_file_     = parent.input_file_;
+    priority_       = parent.priority_;
+    breaker_limit_  = parent.breaker_limit_;
+
+    worker_ = true;
+    device_name_ = device->name();
+    lock_path_ = device->resource();
+    mmio_ = device->get_mmio();
+    ctrl_ = device->get_ctrl();
+    stat_ = device->get_stat();
+    if (!trace_prefix_.empty())
+    {
+        mmio_.reset(new mmio_trace(mmio_, trace_prefix_));
+    }
+    open_controller();
+    return true;
+}
+
+void config_app::open_controller()
+{
+    // the C header must record every write
+    cache_.reset(new shadow_cache());
+    cache_->set_enabled(!no_cache_ && !c_header_);
+
+    przone_.reset(new hssi_przone(mmio_, ctrl_, stat_));
+    // hold the resource against other processes too (a model or trace
+    // replay has no other clients)
+    arbiter::ptr_t arb = lock_path_.empty() ? std::make_shared<arbiter>()
+                                            : arbiter::for_resource(lock_path_);
+    if (!lock_path_.empty() && !arb->cross_process())
+    {
+        err_ << "WARNING: Could not open " << lock_path_
+             << " for locking; other processes are not kept out" << std::endl;
+    }
+    przone_->set_arbiter(arb, priority_);
+    przone_->set_breaker_limit(breaker_limit_);
+    i2c_.reset(new i2c(std::dynamic_pointer_cast<przone_interface>(przone_), byte_addr_size_));
+    mdio_.reset(new mdio(std::dynamic_pointer_cast<przone_interface>(przone_), cache_));
+    nios_.reset(new nios(przone_, cache_));
+    for (size_t dev = 0; dev < mdio::max_devices; ++dev)
+    {
+        mdio_->set_settle_usec(dev, mdio_settle_usec_);
+    }
+}
+
 uint32_t config_app::run(const std::vector<std::string> & args)
 {
     if (args.size() < 1)
     {
         return EXIT_FAILURE;
     }
+    if (!devices_.empty())
+    {
+        return run_all(args);
+    }
+
     std::string help = "";
 
     if (!console_.do_cmd(args, help))
@@ -280,7 +459,82 @@ uint32_t config_app::run(const std::vector<std::string> & args)
         console_.writeline(help);
         return EXIT_FAILURE;
     }
-    return EXIT_SUCCESS;
+    return replay_ && !check_replay() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+bool config_app::check_replay()
+{
+    bool finished = replay_->finished();
+    auto stats = replay_->get_stats();
+    for (const auto & m : replay_->mismatches())
+    {
+        err_ << "replay: " << m << std::endl;
+    }
+    if (!finished)
+    {
+        err_ << "replay: stopped at record " << replay_->position()
+             << " of " << replay_->size() << std::endl;
+    }
+    err_ << "replay: " << stats.reads << " reads, " << stats.writes << " writes, "
+         << stats.mismatches << " mismatches, "
+         << stats.repeated_polls << " repeated and "
+         << stats.skipped_polls << " skipped polls" << std::endl;
+    return finished && stats.mismatches == 0;
+}
+
+uint32_t config_app::run_all(const std::vector<std::string> & args)
+{
+    // the latency histograms are shared by the workers: stats clears
+    // them once before and prints them once after the devices ran
+    bool stats = args[0] == "stats";
+    if (stats)
+    {
+        latency_recorder::reset();
+    }
+
+    auto results = run_on_devices(devices_,
+        [this, &args](const hssi_device::ptr_t & device, std::ostream & out, std::ostream & err) -> bool
+        {
+            config_app worker(out, err);
+            worker.setup(*this, device);
+            std::string help = "";
+            if (!worker.console_.do_cmd(args, help))
+            {
+                err << help << std::endl;
+                return false;
+            }
+            return true;
+        });
+
+    // print each device's output in one piece, in device order
+    size_t failed = 0;
+    for (const auto & r : results)
+    {
+        std::cout << "# " << r.device->name()
+                  << " socket " << r.device->socket_id()
+                  << (r.ok ? "" : " FAILED") << std::endl;
+        std::cout << r.output;
+
+        std::istringstream errors(r.errors);
+        std::string line;
+        while (std::getline(errors, line))
+        {
+            std::cerr << r.device->name() << ": " << line << std::endl;
+        }
+
+        if (!r.ok)
+        {
+            ++failed;
+        }
+    }
+
+    std::cout << "# " << results.size() - failed << " of " << results.size()
+              << " devices succeeded" << std::endl;
+    if (stats)
+    {
+        latency_recorder::print(std::cerr);
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 void config_app::show_help()
@@ -294,51 +548,108 @@ bool config_app::do_load(const cmd_handler::cmd_vector_t & cmds)
 {
     if (cmds.size() > 0)
     {
-        if (path_exists(cmds[0]))
+        if (path_exists(cmds[0]) && eq_profile::is_profile(cmds[0]))
         {
-            std::ifstream filestream(cmds[0]);
-            load(filestream);
-            return true;
+            // compiled by the compile command: mapped and written as is
+            std::string error;
+            eq_profile::ptr_t profile = eq_profile::open(cmds[0], error);
+            if (!profile)
+            {
+                err_ << cmds[0] << ": " << error << std::endl;
+                return false;
+            }
+            przone_->reset_breaker();
+            load(profile->data(), profile->size());
+            print_c_header();
+            return !przone_->tripped();
+        }
+        else if (path_exists(cmds[0]))
+        {
+            przone_->reset_breaker();
+            return load_stream(cmds[0]) && !przone_->tripped();
         }
         else
         {
-            std::cerr << "Path(" << cmds[1] << ") does not exist" << std::endl;
+            err_ << "Path(" << cmds[0] << ") does not exist" << std::endl;
             return false;
         }
     }
     else
     {
+        przone_->reset_breaker();
         load(std::cin);
     }
     return false;
 
 }
 
+bool config_app::do_apply(const cmd_handler::cmd_vector_t & cmds)
+{
+    if (c_header_)
+    {
+        err_ << "apply reads back registers and cannot generate a C header" << std::endl;
+        return false;
+    }
+
+    if (!path_exists(cmds[0]))
+    {
+        err_ << "Path(" << cmds[0] << ") does not exist" << std::endl;
+        return false;
+    }
+
+    std::vector<std::vector<std::string>> data;
+    std::ifstream filestream(cmds[0]);
+    csv_parse(filestream, data);
+
+    std::vector<eq_register> registers;
+    parse_registers(data, registers);
+    if (registers.empty())
+    {
+        err_ << "No register data parsed. Nothing to do" << std::endl;
+        return false;
+    }
+
+    przone_->reset_breaker();
+    return apply(registers.data(), registers.size(), dry_run_, out_) != apply_error;
+}
+
 bool config_app::do_dump(const cmd_handler::cmd_vector_t & cmds)
 {
-    eq_register * registers = default_dump;
-    size_t register_count = default_dump_size;
+    // dump fills in values, so work on a copy (workers run concurrently)
+    std::vector<eq_register> registers(default_dump, default_dump + default_dump_size);
     if (input_file_ != "" && path_exists(input_file_))
     {
         std::vector<std::vector<std::string>> data;
         std::ifstream inp(input_file_);
         csv_parse(inp, data);
-        std::vector<eq_register> parsed;
-        parse_registers(data, parsed);
-        registers = parsed.data();
-        register_count = parsed.size();
+        registers.clear();
+        parse_registers(data, registers);
     }
 
     if (cmds.size() > 1)
     {
-        std::ofstream out(cmds[1]);
-        dump(registers, register_count, out);
-        return true;
+        std::string path = cmds[1];
+        if (!device_name_.empty())
+        {
+            // one file per device: out.csv -> out.intel-fpga-dev.0.csv
+            auto dot = path.rfind('.');
+            auto slash = path.rfind('/');
+            if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+            {
+                dot = path.size();
+            }
+            path.insert(dot, "." + device_name_);
+        }
+        std::ofstream out(path);
+        przone_->reset_breaker();
+        dump(registers.data(), registers.size(), out);
+        return !przone_->tripped();
     }
     else
     {
-        dump(registers, register_count, std::cout);
-        return true;
+        przone_->reset_breaker();
+        dump(registers.data(), registers.size(), out_);
+        return !przone_->tripped();
     }
     return false;
 }
@@ -352,7 +663,7 @@ bool config_app::do_read(const cmd_handler::cmd_vector_t & cmds)
     {
         if (lane > (int32_t)max_xcvr_lane || address > max_xcvr_addr)
         {
-            std::cerr << "invalid xcvr read parameter" << std::endl;
+            err_ << "invalid xcvr read parameter" << std::endl;
             return false;
         }
 
@@ -362,7 +673,7 @@ bool config_app::do_read(const cmd_handler::cmd_vector_t & cmds)
             {
                 if ( xcvr_read(i, address, value))
                 {
-                    std::cout << print_hex<uint32_t>(i*hssi_xcvr_lane_offset + address) << ": " <<  print_hex<uint32_t>(value) << std::endl;
+                    out_ << print_hex<uint32_t>(i*hssi_xcvr_lane_offset + address) << ": " <<  print_hex<uint32_t>(value) << std::endl;
                 }
             }
             return true;
@@ -371,7 +682,7 @@ bool config_app::do_read(const cmd_handler::cmd_vector_t & cmds)
         {
             if ( xcvr_read(lane, address, value))
             {
-                std::cout << print_hex<uint32_t>(value) << std::endl;
+                out_ << print_hex<uint32_t>(value) << std::endl;
                 return true;
             }
         }
@@ -391,15 +702,20 @@ bool config_app::do_write(const cmd_handler::cmd_vector_t & cmds)
 
         if (lane > max_xcvr_lane || address > max_xcvr_addr)
         {
-            std::cerr << "invalid xcvr write parameter" << std::endl;
+            err_ << "invalid xcvr write parameter" << std::endl;
             return false;
         }
 
-        if (xcvr_write(lane, address, value_write) &&
-            xcvr_read(lane, address, value_read))
+        if (xcvr_write(lane, address, value_write))
         {
-            std::cout << print_hex<uint32_t>(value_read) << std::endl;
-            return true;
+            // read back from the transceiver, not the shadow
+            cache_->erase(shadow_cache::target::xcvr,
+                          shadow_cache::xcvr_key(lane, address));
+            if (xcvr_read(lane, address, value_read))
+            {
+                out_ << print_hex<uint32_t>(value_read) << std::endl;
+                return true;
+            }
         }
     }
     return false;
@@ -415,18 +731,18 @@ bool config_app::do_retimer_read(const cmd_handler::cmd_vector_t & cmds)
     {
         if (reg.channel_lane > static_cast<int32_t>(max_rtmr_channel))
         {
-            std::cerr << "Invalid retimer channel" << std::endl;
+            err_ << "Invalid retimer channel" << std::endl;
             return false;
         }
 
         if (reg.address > max_rtmr_addr)
         {
-            std::cerr << "Invalid retimer address" << std::endl;
+            err_ << "Invalid retimer address" << std::endl;
         }
 
         if (retimer_read(reg.device, reg.channel_lane, reg.address, reg.value))
         {
-            std::cout << print_hex<uint8_t>(reg.value) << std::endl;
+            out_ << print_hex<uint8_t>(reg.value) << std::endl;
             return true;
         }
     }
@@ -446,7 +762,7 @@ bool config_app::do_i2c_read(const cmd_handler::cmd_vector_t & cmds)
     {
         if (instance > 1 || device_addr > max_i2c_device_addr || byte_addr > max_i2c_byte_addr )
         {
-            std::cerr << "invalid i2c parameters" << std::endl;
+            err_ << "invalid i2c parameters" << std::endl;
             return false;
         }
 
@@ -455,9 +771,9 @@ bool config_app::do_i2c_read(const cmd_handler::cmd_vector_t & cmds)
         {
             for (const auto & byte : bytes)
             {
-                std::cout << print_hex<uint8_t>(byte) << " ";
+                out_ << print_hex<uint8_t>(byte) << " ";
             }
-            std::cout << std::endl;
+            out_ << std::endl;
             return true;
         }
     }
@@ -473,28 +789,30 @@ bool config_app::do_i2c_write(const cmd_handler::cmd_vector_t & cmds)
     {
         if (instance > 1 || device_addr > max_i2c_device_addr || byte_addr > max_i2c_byte_addr )
         {
-            std::cerr << "invalid i2c parameters" << std::endl;
+            err_ << "invalid i2c parameters" << std::endl;
             return false;
         }
 
         std::vector<uint8_t> bytes(cmds.size()-3);
         int i = 0;
         std::for_each(cmds.begin()+3, cmds.end(),
-                [&bytes, &i](const std::string &s)
+                [this, &bytes, &i](const std::string &s)
                 {
                     if (!parse_int(s, bytes[i++]))
                     {
-                        std::cerr  << "Could not parse input: " << s << std::endl;
+                        err_  << "Could not parse input: " << s << std::endl;
                     }
                 });
 
+        // raw writes may change retimer registers or channel selection
+        cache_->invalidate(shadow_cache::target::retimer);
         if (i2c_->write(instance, device_addr, byte_addr, bytes.data(), bytes.size()))
         {
             for (const auto & byte : bytes)
             {
-                std::cout << print_hex<uint8_t>(byte) << " ";
+                out_ << print_hex<uint8_t>(byte) << " ";
             }
-            std::cout << std::endl;
+            out_ << std::endl;
             return true;
         }
     }
@@ -511,14 +829,19 @@ bool config_app::do_retimer_write(const cmd_handler::cmd_vector_t & cmds)
     {
         if (reg.address > max_rtmr_addr)
         {
-            std::cerr << "Invalid retimer address" << std::endl;
+            err_ << "Invalid retimer address" << std::endl;
         }
 
-        if (retimer_write(reg.device, reg.channel_lane, reg.address, reg.value) &&
-            retimer_read(reg.device, reg.channel_lane, reg.address, reg.value))
+        if (retimer_write(reg.device, reg.channel_lane, reg.address, reg.value))
         {
-            std::cout << print_hex<uint32_t>(reg.value) << std::endl;
-            return true;
+            // read back from the retimer, not the shadow
+            cache_->erase(shadow_cache::target::retimer,
+                          shadow_cache::retimer_key(reg.device, reg.channel_lane, reg.address));
+            if (retimer_read(reg.device, reg.channel_lane, reg.address, reg.value))
+            {
+                out_ << print_hex<uint32_t>(reg.value) << std::endl;
+                return true;
+            }
         }
     }
     return false;
@@ -529,17 +852,29 @@ bool config_app::do_mdio_write(const cmd_handler::cmd_vector_t & cmds)
 {
     uint8_t device_addr = 0, port_addr = 0;
     uint16_t reg_addr = 0;
-    uint32_t value = 0;
     if (parse_int(cmds[0], device_addr) &&
         parse_int(cmds[1], port_addr) &&
-        parse_int(cmds[2], reg_addr) &&
-        parse_int(cmds[3], value))
+        parse_int(cmds[2], reg_addr))
     {
-        if (mdio_->write(device_addr, port_addr, reg_addr, value))
+        // extra values go to the registers that follow
+        std::vector<mdio_register> registers;
+        for (size_t i = 3; i < cmds.size(); ++i)
         {
-            std::cout << print_hex<uint32_t>(value) << std::endl;
-            return true;
+            uint32_t value = 0;
+            if (!parse_int(cmds[i], value))
+            {
+                return false;
+            }
+            registers.push_back({ device_addr, port_addr,
+                                  static_cast<uint16_t>(reg_addr + i - 3), value });
         }
+
+        size_t written = mdio_->write(registers);
+        for (size_t i = 0; i < written; ++i)
+        {
+            out_ << print_hex<uint32_t>(registers[i].value) << std::endl;
+        }
+        return written == registers.size();
     }
 
     return false;
@@ -549,17 +884,30 @@ bool config_app::do_mdio_read(const cmd_handler::cmd_vector_t & cmds)
 {
     uint8_t device_addr = 0, port_addr = 0;
     uint16_t reg_addr = 0;
+    uint32_t count = 1;
 
     if (parse_int(cmds[0], device_addr) &&
         parse_int(cmds[1], port_addr) &&
-        parse_int(cmds[2], reg_addr) )
+        parse_int(cmds[2], reg_addr) &&
+        (cmds.size() < 4 || parse_int(cmds[3], count)) &&
+        count > 0 && count <= 0x10000u - reg_addr)
     {
-        uint32_t value;
-        if (mdio_->read(device_addr, port_addr, reg_addr, value))
+        std::vector<mdio_register> registers(count);
+        for (uint32_t i = 0; i < count; ++i)
         {
-            std::cout << print_hex<uint32_t>(value) << std::endl;
-            return true;
+            registers[i] = { device_addr, port_addr, static_cast<uint16_t>(reg_addr + i), 0 };
+        }
+
+        size_t read = mdio_->read(registers);
+        for (size_t i = 0; i < read; ++i)
+        {
+            if (count > 1)
+            {
+                out_ << print_hex<uint16_t>(registers[i].reg_addr) << ": ";
+            }
+            out_ << print_hex<uint32_t>(registers[i].value) << std::endl;
         }
+        return read == registers.size();
     }
 
     return false;
@@ -573,7 +921,7 @@ bool config_app::do_pr_read(const cmd_handler::cmd_vector_t & cmds)
         uint32_t value;
         if (przone_->read(reg_addr, value))
         {
-            std::cout << print_hex<uint32_t>(reg_addr) << ":" << print_hex<uint32_t>(value) << std::endl;
+            out_ << print_hex<uint32_t>(reg_addr) << ":" << print_hex<uint32_t>(value) << std::endl;
             return true;
         }
     }
@@ -581,6 +929,135 @@ bool config_app::do_pr_read(const cmd_handler::cmd_vector_t & cmds)
     return false;
 }
 
+bool config_app::do_stats(const cmd_handler::cmd_vector_t & cmds)
+{
+    // run the command, then show where its time went (on stderr, so the
+    // output of dump stays a CSV file)
+    bool ok = true;
+    if (!cmds.empty())
+    {
+        if (cmds[0] == "stats")
+        {
+            return false;
+        }
+        if (!worker_)
+        {
+            latency_recorder::reset();
+        }
+        std::string help = "";
+        ok = console_.do_cmd(cmds, help);
+        if (!ok && !help.empty())
+        {
+            err_ << help << std::endl;
+        }
+    }
+    // the workers of --all leave the shared histograms to run_all
+    if (!worker_)
+    {
+        latency_recorder::print(err_);
+    }
+    return ok;
+}
+
+bool config_app::do_compile(const cmd_handler::cmd_vector_t & cmds)
+{
+    if (!path_exists(cmds[0]))
+    {
+        err_ << "Path(" << cmds[0] << ") does not exist" << std::endl;
+        return false;
+    }
+
+    std::vector<std::vector<std::string>> data;
+    std::ifstream filestream(cmds[0]);
+    csv_parse(filestream, data);
+
+    std::vector<eq_register> registers;
+    parse_registers(data, registers);
+    if (registers.empty())
+    {
+        err_ << "No register data parsed. Nothing to do" << std::endl;
+        return false;
+    }
+
+    // refuse the whole profile if any line is wrong, naming every one
+    size_t errors = 0;
+    for (size_t i = 0; i < registers.size(); ++i)
+    {
+        std::string problem;
+        if (!check_register(registers[i], problem))
+        {
+            err_ << cmds[0] << ":" << i + 1 << ": " << problem << std::endl;
+            ++errors;
+        }
+    }
+    if (errors)
+    {
+        err_ << errors << " invalid lines, nothing written" << std::endl;
+        return false;
+    }
+
+    std::string error;
+    if (!eq_profile::write(cmds[1], registers, error))
+    {
+        err_ << cmds[1] << ": " << error << std::endl;
+        return false;
+    }
+    out_ << "Compiled " << registers.size() << " registers into " << cmds[1] << std::endl;
+    return true;
+}
+
+bool config_app::check_register(const eq_register & reg, std::string & problem)
+{
+    switch(reg.type)
+    {
+        case eq_register_type::fpga_rx:
+        case eq_register_type::fpga_tx:
+            if (reg.channel_lane < 0 || reg.channel_lane >= static_cast<int32_t>(max_xcvr_lane))
+            {
+                problem = "invalid transceiver lane";
+            }
+            else if (reg.address > max_xcvr_addr)
+            {
+                problem = "invalid transceiver address";
+            }
+            break;
+        case eq_register_type::retimer_rx:
+        case eq_register_type::retimer_tx:
+            if (std::find(valid_rtmr_device_addrs.begin(), valid_rtmr_device_addrs.end(),
+                          static_cast<uint32_t>(reg.device)) == valid_rtmr_device_addrs.end())
+            {
+                problem = "invalid retimer device";
+            }
+            else if (reg.channel_lane < 0 || reg.channel_lane >= static_cast<int32_t>(max_rtmr_channel))
+            {
+                problem = "invalid retimer channel";
+            }
+            else if (reg.address > max_rtmr_addr)
+            {
+                problem = "invalid retimer address";
+            }
+            break;
+        case eq_register_type::mdio:
+            if (reg.channel_lane < 0 || reg.channel_lane >= static_cast<int32_t>(mdio::max_devices) ||
+                reg.device < 0 || reg.device >= static_cast<int32_t>(mdio::max_devices))
+            {
+                problem = "invalid MDIO device or port";
+            }
+            else if (reg.address > 0xFFFF)
+            {
+                problem = "invalid MDIO register";
+            }
+            break;
+        case eq_register_type::hssi_mode:
+        case eq_register_type::przone:
+            break;
+        default:
+            problem = "unknown register type or malformed line";
+            break;
+    }
+    return problem.empty();
+}
+
 bool config_app::do_pr_write(const cmd_handler::cmd_vector_t & cmds)
 {
     uint32_t reg_addr = 0;
@@ -590,7 +1067,7 @@ bool config_app::do_pr_write(const cmd_handler::cmd_vector_t & cmds)
     {
         if (przone_->write(reg_addr, value))
         {
-            std::cout << print_hex<uint32_t>(reg_addr) << ":" << print_hex<uint32_t>(value) << std::endl;
+            out_ << print_hex<uint32_t>(reg_addr) << ":" << print_hex<uint32_t>(value) << std::endl;
             return true;
         }
     }
@@ -610,21 +1087,107 @@ void config_app::load(std::istream & stream)
     load(registers.data(), registers.size());
     if (registers.size() == 0)
     {
-        std::cerr << "No register data parsed. Nothing to do" << std::endl;
+        err_ << "No register data parsed. Nothing to do" << std::endl;
         return;
     }
 
+    print_c_header();
+}
+
+bool config_app::load_stream(const std::string & path)
+{
+    std::string error;
+    eq_csv_reader::ptr_t reader = eq_csv_reader::open(path, error);
+    if (!reader)
+    {
+        err_ << path << ": " << error << std::endl;
+        return false;
+    }
+
+    bounded_queue<std::vector<eq_register>> queue(load_queue);
+    size_t parsed = 0;
+
+    // the registers are written on this thread, so that a trace of the
+    // load is a single ordered stream; the parser stops when the queue
+    // is closed under it
+    std::thread parser([&reader, &queue, &parsed]()
+    {
+        std::vector<eq_register> chunk;
+        chunk.reserve(load_chunk);
+        eq_register reg;
+        while (reader->next(reg))
+        {
+            ++parsed;
+            chunk.push_back(reg);
+            if (chunk.size() == load_chunk)
+            {
+                if (!queue.push(std::move(chunk)))
+                {
+                    return;
+                }
+                chunk.clear();
+                chunk.reserve(load_chunk);
+            }
+        }
+        if (!chunk.empty())
+        {
+            queue.push(std::move(chunk));
+        }
+        queue.close();
+    });
+
+    bool tripped = false;
+    try
+    {
+        std::vector<eq_register> chunk;
+        while (queue.pop(chunk))
+        {
+            load(chunk.data(), chunk.size());
+            if (przone_->tripped())
+            {
+                // drop the chunks parsed ahead
+                tripped = true;
+                break;
+            }
+        }
+    }
+    catch (...)
+    {
+        queue.close();
+        parser.join();
+        throw;
+    }
+    queue.close();
+    parser.join();
+
+    if (tripped)
+    {
+        return false;
+    }
+
+    if (parsed == 0)
+    {
+        err_ << "No register data parsed. Nothing to do" << std::endl;
+        return true;
+    }
+
+    print_c_header();
+    return true;
+}
+
+void config_app::print_c_header()
+{
     if (c_header_)
     {
         std::string cmds = header_stream_.str();
 
-        std::cout << "#ifndef __hssi_cmd_table_h\n";
-        std::cout << "#define __hssi_cmd_table_h\n";
-        std::cout << "#include <stdint.h>\n";
-        std::cout << "uint64_t eq_registers[] = {\n";
-        std::cout << cmds;
-        std::cout << "\t-1UL\n};\n";
-        std::cout << "#endif\n";
+        out_ << "#ifndef __hssi_cmd_table_h\n";
+        out_ << "#define __hssi_cmd_table_h\n";
+        out_ << "#include <stdint.h>\n";
+        out_ << "uint64_t eq_registers[] = {\n";
+        out_ << cmds;
+        out_ << "\t-1UL\n};\n";
+        out_ << "#endif\n";
     }
 }
 
@@ -679,24 +1242,121 @@ size_t config_app::parse_registers(const std::vector<std::vector<std::string>> &
     return count;
 }
 
-size_t config_app::load(eq_register registers[], size_t size)
+size_t config_app::load(const eq_register registers[], size_t size)
 {
     size_t loaded = 0;
+    // runs of transceiver registers are written as one transaction,
+    // leaving out those the shadow says already hold their value
+    transaction xcvr_batch;
+    transaction xcvr_rest;
+    std::vector<const eq_register *> xcvr_pending;
+    // the last value of each register queued in the batch, which the
+    // shadow does not know of until the batch ran
+    std::unordered_map<uint64_t, uint32_t> xcvr_queued;
+    xcvr_batch.reserve(size * transaction::xcvr_write_steps);
+    auto flush_xcvr = [this, &loaded, &xcvr_batch, &xcvr_rest, &xcvr_pending, &xcvr_queued]()
+    {
+        // a register that fails is reported and the run goes on after
+        // it, as if every register were written on its own
+        const transaction * tx = &xcvr_batch;
+        size_t done = 0;
+        while (done < xcvr_pending.size())
+        {
+            size_t completed = 0;
+            bool ok = przone_->execute(*tx, &completed);
+            size_t written = ok ? xcvr_pending.size() - done
+                                : completed / transaction::xcvr_write_steps;
+            for (size_t i = done; i < done + written; ++i)
+            {
+                const eq_register & reg = *xcvr_pending[i];
+                cache_->update(shadow_cache::target::xcvr,
+                               shadow_cache::xcvr_key(reg.channel_lane, reg.address),
+                               reg.value);
+            }
+            done += written;
+            loaded += written;
+            if (ok || przone_->tripped())
+            {
+                break;
+            }
+
+            const eq_register & failed = *xcvr_pending[done];
+            err_ << "Error writing transceiver lane " << failed.channel_lane
+                 << " register " << print_hex<uint32_t>(failed.address) << std::endl;
+            cache_->erase(shadow_cache::target::xcvr,
+                          shadow_cache::xcvr_key(failed.channel_lane, failed.address));
+            ++done;
+
+            xcvr_rest.clear();
+            for (const transaction::step * s = xcvr_batch.begin() + done * transaction::xcvr_write_steps;
+                 s != xcvr_batch.end(); ++s)
+            {
+                xcvr_rest.add(s->ctrl, s->result);
+            }
+            tx = &xcvr_rest;
+        }
+        xcvr_batch.clear();
+        xcvr_pending.clear();
+        xcvr_queued.clear();
+    };
+
     for (size_t i = 0; i < size; ++i)
     {
         const eq_register & reg = registers[i];
+        if (reg.type != eq_register_type::fpga_rx &&
+            reg.type != eq_register_type::fpga_tx)
+        {
+            flush_xcvr();
+        }
+        if (breaker_tripped("load"))
+        {
+            xcvr_batch.clear();
+            xcvr_pending.clear();
+            xcvr_queued.clear();
+            break;
+        }
+
         switch(reg.type)
         {
             case eq_register_type::fpga_rx:
             case eq_register_type::fpga_tx:
-                xcvr_write(reg.channel_lane, reg.address, reg.value);
+                if (c_header_)
+                {
+                    loaded += xcvr_write(reg.channel_lane, reg.address, reg.value) ? 1 : 0;
+                }
+                else
+                {
+                    uint64_t key = shadow_cache::xcvr_key(reg.channel_lane, reg.address);
+                    uint32_t current = 0;
+                    bool known = false;
+                    auto queued = xcvr_queued.find(key);
+                    if (queued != xcvr_queued.end())
+                    {
+                        current = queued->second;
+                        known = true;
+                    }
+                    else
+                    {
+                        known = cache_->lookup(shadow_cache::target::xcvr, key, current);
+                    }
+                    if (!known || current != reg.value)
+                    {
+                        xcvr_batch.xcvr_write(reg.channel_lane, reg.address, reg.value);
+                        xcvr_pending.push_back(&reg);
+                        xcvr_queued[key] = reg.value;
+                    }
+                    else
+                    {
+                        ++loaded;
+                    }
+                }
                 break;
 
             case eq_register_type::retimer_rx:
             case eq_register_type::retimer_tx:
                 if (!c_header_)
                 {
-                    retimer_write(reg.device, reg.channel_lane, reg.address, reg.value);
+                    loaded += retimer_write(reg.device, reg.channel_lane, reg.address, reg.value) ? 1 : 0;
                 }
                 break;
             case eq_register_type::hssi_mode:
@@ -705,14 +1365,17 @@ size_t config_app::load(eq_register registers[], size_t size)
                     header_stream_ << "// GOTO MODE:  "
                                    << print_hex<uint32_t>(reg.value) << std::endl;
                 }
-                hssi_soft_cmd(nios_cmd::change_hssi_mode, std::vector<uint32_t>{ reg.value  });
-                hssi_soft_cmd(nios_cmd::hssi_init, std::vector<uint32_t>{ reg.value  });
+                if (hssi_soft_cmd(nios_cmd::change_hssi_mode, { reg.value }) &&
+                    hssi_soft_cmd(nios_cmd::hssi_init, { reg.value }))
+                {
+                    ++loaded;
+                }
                 break;
             case eq_register_type::mdio:
                 if (!c_header_)
                 {
-                    mdio_->write(reg.channel_lane, reg.device, reg.address, reg.value);
-                    std::cerr << "// MDIO Write Device: " << print_hex<uint8_t>(reg.channel_lane) << " "
+                    loaded += mdio_->write(reg.channel_lane, reg.device, reg.address, reg.value) ? 1 : 0;
+                    err_ << "// MDIO Write Device: " << print_hex<uint8_t>(reg.channel_lane) << " "
                      << "port:" << " " << print_hex<uint8_t>(reg.device) << " "
                      << "reg:" << " " << print_hex<uint16_t>(reg.address) << " "
                      << print_hex<uint32_t>(reg.value) << std::endl;
@@ -721,80 +1384,198 @@ size_t config_app::load(eq_register registers[], size_t size)
             case eq_register_type::przone:
                 if (!c_header_)
                 {
-                    przone_->write(reg.address, reg.value);
+                    loaded += przone_->write(reg.address, reg.value) ? 1 : 0;
                 }
                 break;
             default: break;
         }
     }
+    flush_xcvr();
     return loaded;
 }
 
-bool config_app::hssi_soft_cmd(uint32_t nios_func, std::vector<uint32_t> args)
+bool config_app::hssi_soft_cmd(uint32_t nios_func, const nios_args & args)
 {
+    if (!c_header_)
+    {
+        return nios_->write(nios_func, args);
+    }
     uint32_t junk;
     return hssi_soft_cmd(nios_func, args, junk);
 }
 
-bool config_app::hssi_soft_cmd(uint32_t nios_func, std::vector<uint32_t> args, uint32_t & value_out)
+bool config_app::hssi_soft_cmd(uint32_t nios_func, const nios_args & args, uint32_t & value_out)
 {
-    if (args.size() > 4)
+    if (!c_header_)
+    {
+        return nios_->write(nios_func, args, value_out);
+    }
+
+    // the C header records the words of the command; nothing is read back
+    if (!args.valid())
     {
         return false;
     }
+    transaction tx;
+    tx.soft_cmd(nios_func, args.data(), args.size(), &value_out);
+    return execute(tx);
+}
 
-    hssi_ctrl msg;
-    for (size_t i = 0; i < args.size(); ++i)
+bool config_app::read_register(const eq_register & reg, uint32_t & value)
+{
+    switch(reg.type)
     {
-        msg.clear();
-        msg.set_command(hssi_cmd::sw_write);
-        msg.set_address(i+2);
-        msg.set_data(args[i]);
-        mmio_->write_mmio64(ctrl_, msg.data());
-        if (!hssi_ack())
-        {
+        case eq_register_type::fpga_rx:
+        case eq_register_type::fpga_tx:
+            return xcvr_read(reg.channel_lane, reg.address, value);
+        case eq_register_type::retimer_rx:
+        case eq_register_type::retimer_tx:
+            return retimer_read(reg.device, reg.channel_lane, reg.address, value);
+        case eq_register_type::mdio:
+            return mdio_->read(reg.channel_lane, reg.device, reg.address, value);
+        case eq_register_type::przone:
+            return przone_->read(reg.address, value);
+        default:
             return false;
-        }
     }
+}
 
-    msg.set_command(hssi_cmd::sw_write);
-    msg.set_address(1);
-    msg.set_data(nios_func);
-    mmio_->write_mmio64(ctrl_, msg.data());
-    if (!hssi_ack())
+static void print_register(std::ostream & stream, const eq_register & reg)
+{
+    auto it = register_type_str_map.find(reg.type);
+    stream << (it == register_type_str_map.end() ? "UNKNOWN" : it->second)
+           << "," << reg.channel_lane
+           << "," << print_hex<uint16_t>(reg.device)
+           << "," << print_hex<uint32_t>(reg.address);
+}
+
+size_t config_app::apply(eq_register registers[], size_t size, bool dry_run, std::ostream & plan)
+{
+    // expand lane/channel wildcards the way dump does
+    std::vector<eq_register> targets;
+    eq_register mode;
+    for (size_t i = 0; i < size; ++i)
     {
-        return false;
+        const eq_register & reg = registers[i];
+        switch(reg.type)
+        {
+            case eq_register_type::fpga_rx:
+            case eq_register_type::fpga_tx:
+                if (reg.channel_lane == -1)
+                {
+                    for (int32_t lane = 0; lane < static_cast<int32_t>(max_xcvr_lane); ++lane)
+                    {
+                        targets.push_back(reg);
+                        targets.back().channel_lane = lane;
+                    }
+                }
+                else
+                {
+                    targets.push_back(reg);
+                }
+                break;
+            case eq_register_type::retimer_rx:
+            case eq_register_type::retimer_tx:
+                if (reg.channel_lane == -1 || reg.device == -1)
+                {
+                    for (uint32_t dev : valid_rtmr_device_addrs)
+                    {
+                        for (int32_t ch = 0; ch < static_cast<int32_t>(max_rtmr_channel); ++ch)
+                        {
+                            targets.push_back(reg);
+                            targets.back().device = dev;
+                            targets.back().channel_lane = ch;
+                        }
+                    }
+                }
+                else
+                {
+                    targets.push_back(reg);
+                }
+                break;
+            case eq_register_type::hssi_mode:
+                // load applies modes in order, so the last one sticks
+                mode = reg;
+                break;
+            case eq_register_type::mdio:
+            case eq_register_type::przone:
+                targets.push_back(reg);
+                break;
+            default:
+                break;
+        }
     }
 
-    switch(nios_func)
+    // 1. the mode goes first: changing it reinitializes the registers,
+    //    so reading them back before would compare against stale values
+    bool mode_change = false;
+    if (mode.type == eq_register_type::hssi_mode)
     {
-        case nios_cmd::tx_eq_read:
-        case nios_cmd::hssi_init:
-        case nios_cmd::hssi_init_done:
-        case nios_cmd::fatal_err:
-        case nios_cmd::get_hssi_enable:
-        case nios_cmd::get_hssi_mode:
-            msg.set_command(hssi_cmd::sw_read);
-            msg.set_address(6);
-            msg.set_data(nios_func);
-            mmio_->write_mmio64(ctrl_, msg.data());
-            if (!hssi_ack())
-            {
-                return false;
-            }
-            uint64_t value64;
+        uint32_t current_mode = 0;
+        if (!hssi_soft_cmd(nios_cmd::get_hssi_mode, {}, current_mode))
+        {
+            err_ << "Error executing soft cmd: get_hssi_mode" << std::endl;
+            return apply_error;
+        }
 
-            if (!mmio_->read_mmio64(stat_, value64))
+        mode_change = current_mode != mode.value;
+        if (mode_change)
+        {
+            plan << "MODE: " << print_hex<uint32_t>(current_mode)
+                 << " -> " << print_hex<uint32_t>(mode.value) << std::endl;
+            if (!dry_run && load(&mode, 1) != 1)
             {
-                return false;
+                err_ << "Error changing HSSI mode to "
+                     << print_hex<uint32_t>(mode.value) << std::endl;
+                return apply_error;
             }
-            value_out = static_cast<uint32_t>(value64);
-            break;
-        default:
-            break;
+        }
+        else
+        {
+            plan << "MODE: " << print_hex<uint32_t>(current_mode) << " (unchanged)" << std::endl;
+        }
     }
 
-    return true;
+    // 2. read back what the CSV names and keep what differs
+    std::vector<eq_register> changes;
+    for (const auto & reg : targets)
+    {
+        if (breaker_tripped("apply"))
+        {
+            return apply_error;
+        }
+        uint32_t current = 0;
+        bool known = !(dry_run && mode_change) && read_register(reg, current);
+        // retimer registers are a byte wide; dump shows the low byte
+        uint32_t mask = reg.type == eq_register_type::retimer_rx ||
+                        reg.type == eq_register_type::retimer_tx ? 0xFF : 0xFFFFFFFF;
+        if (known && (current & mask) == (reg.value & mask))
+        {
+            continue;
+        }
+
+        print_register(plan, reg);
+        if (known)
+        {
+            plan << ": " << print_hex<uint32_t>(current & mask);
+        }
+        else
+        {
+            plan << ": " << (dry_run && mode_change ? "(reset by mode change)" : "(unreadable)");
+        }
+        plan << " -> " << print_hex<uint32_t>(reg.value & mask) << std::endl;
+        changes.push_back(reg);
+    }
+    plan << changes.size() << " of " << targets.size() << " registers differ" << std::endl;
+
+    // 3. write only the differences, in CSV order
+    if (!dry_run && !changes.empty() &&
+        load(changes.data(), changes.size()) != changes.size())
+    {
+        err_ << "Error writing the registers that differ" << std::endl;
+        return apply_error;
+    }
+    return changes.size() + (mode_change ? 1 : 0);
 }
 
 size_t config_app::dump(eq_register registers[], size_t size, std::ostream & stream)
@@ -805,12 +1586,12 @@ size_t config_app::dump(eq_register registers[], size_t size, std::ostream & str
     uint32_t hssi_mode = 0;
     if (!hssi_soft_cmd(nios_cmd::get_hssi_mode, {}, hssi_mode))
     {
-        std::cerr << "Error executing soft cmd: get_hssi_mode" << std::endl;
+        err_ << "Error executing soft cmd: get_hssi_mode" << std::endl;
         return false;
     }
 
     // now add registers to dump vector
-    for (size_t i = 0; i < size; ++i)
+    for (size_t i = 0; i < size && !breaker_tripped("dump"); ++i)
     {
         eq_register & reg = registers[i];
         switch(reg.type)
@@ -823,13 +1604,13 @@ size_t config_app::dump(eq_register registers[], size_t size, std::ostream & str
                     {
                         eq_register cpy = reg;
                         cpy.channel_lane = i;
-                        if (xcvr_read(cpy.channel_lane, cpy.address, cpy.value))
+                        if (read_register(cpy, cpy.value))
                         {
                             dumped.push_back(cpy);
                         }
                     }
                 }
-                else if (xcvr_read(reg.channel_lane, reg.address, reg.value))
+                else if (read_register(reg, reg.value))
                 {
                     dumped.push_back(reg);
                 }
@@ -846,7 +1627,7 @@ size_t config_app::dump(eq_register registers[], size_t size, std::ostream & str
                             eq_register cpy = reg;
                             cpy.device = i;
                             cpy.channel_lane = j;
-                            if(retimer_read(cpy.device, cpy.channel_lane, cpy.address, cpy.value))
+                            if (read_register(cpy, cpy.value))
                             {
                                 cpy.value &= 0xFF;
                                 dumped.push_back(cpy);
@@ -856,7 +1637,7 @@ size_t config_app::dump(eq_register registers[], size_t size, std::ostream & str
                 }
                 else
                 {
-                    if (retimer_read(reg.device, reg.channel_lane, reg.address, reg.value))
+                    if (read_register(reg, reg.value))
                     {
                         dumped.push_back(reg);
                     }
@@ -877,7 +1658,7 @@ size_t config_app::dump(eq_register registers[], size_t size, std::ostream & str
                 if (!c_header_)
                 {
                     eq_register cpy = reg;
-                    if (mdio_->read(cpy.channel_lane, cpy.device, cpy.address, cpy.value))
+                    if (read_register(cpy, cpy.value))
                     {
                        dumped.push_back(cpy);
                     }
@@ -887,7 +1668,7 @@ size_t config_app::dump(eq_register registers[], size_t size, std::ostream & str
                 if (!c_header_)
                 {
                     eq_register cpy = reg;
-                    if (przone_->read(cpy.address, cpy.value))
+                    if (read_register(cpy, cpy.value))
                     {
                        dumped.push_back(cpy);
                     }
@@ -902,13 +1683,14 @@ size_t config_app::dump(eq_register registers[], size_t size, std::ostream & str
     // for all registers in dump vector, write them out to the stream
     for (const auto & reg : dumped)
     {
-        if (register_type_str_map.find(reg.type) == register_type_str_map.end())
+        auto it = register_type_str_map.find(reg.type);
+        if (it == register_type_str_map.end())
         {
-            std::cerr << "UNKNOWN TYPE!";
+            err_ << "UNKNOWN TYPE!";
         }
         else
         {
-            stream << register_type_str_map[reg.type];
+            stream << it->second;
         }
 
         stream << "," << reg.channel_lane
@@ -922,198 +1704,86 @@ size_t config_app::dump(eq_register registers[], size_t size, std::ostream & str
 
 bool config_app::xcvr_pll_status_read(uint32_t info_sel, uint32_t &value)
 {
-    hssi_ctrl msg;
-
-    // 3. Read data from local bus to aux bus
-    // Write recfg_cmd_rddata to aux_bus::local_cmd
-    // recfg_cmd_rddata (from recfg_cmd_addr), output goes into local_dout
-    msg.clear();
-    msg.set_address(aux_bus::local_cmd);
-    if (info_sel == 0)
-        msg.set_bus_command(bus_cmd::local_read, local_bus::pll_rst_control);
-    else
-        msg.set_bus_command(bus_cmd::local_read, local_bus::pll_locked_status);
-    msg.set_command(hssi_cmd::aux_write);
-    mmio_->write_mmio64(ctrl_, msg.data());
-
-    if (!hssi_ack())
-    {
-        return false;
-    }
-
-    // 4. Read data from aux bus to hssi_stat
-    // Read local_dout
-    msg.clear();
-    msg.set_address(aux_bus::local_dout);
-    msg.set_command(hssi_cmd::aux_read);
-    mmio_->write_mmio64(ctrl_, msg.data());
-
-    if (!hssi_ack())
-    {
-        return false;
-    }
-
-    uint64_t hssi_value;
-    if (!mmio_->read_mmio64(stat_, hssi_value))
-    {
-        return false;
-    }
-
-    value = static_cast<uint32_t>(hssi_value & 0x00000000FFFFFFFF);
-    return true;
+    trace_scope trace(trace_tag::pll_read);
+    transaction tx;
+    tx.pll_read(info_sel, &value);
+    return execute(tx);
 }
 
 
 bool config_app::xcvr_read(uint32_t lane, uint32_t reg_addr, uint32_t &value)
 {
-    uint32_t reconfig_addr = reg_addr + hssi_xcvr_lane_offset*lane;
-    // HSSI_CTRL cmd(63-48), addr(47-32), data(31-0)
-
-    // 1. Provide ID information of local register to AUX bus handshake registers
-    // Write read_cmd, channel, reconfig_addr to aux_bus::local_din
-    // read_cmd, channel, reconfig_addr -> local_din
-    hssi_ctrl msg;
-
-    msg.clear();
-    msg.set_address(aux_bus::local_din);
-    msg.set_bus_command(bus_cmd::rcfg_read, reconfig_addr);
-    msg.set_command(hssi_cmd::aux_write);
-    mmio_->write_mmio64(ctrl_, msg.data());
-
-    if (!hssi_ack())
-    {
-        return false;
-    }
-
-
-    // 2. Send request to AUX bus handshake, write ID information from step 1 into local bus
-    // Write write_cmd, recfg_cmd_addr to aux_bus::local_cmd
-    // write_cmd from local_din (read_cmd, channel, reconf_addr) -> recfg_cmd_addr
-    msg.clear();
-    msg.set_address(aux_bus::local_cmd);
-    msg.set_bus_command(bus_cmd::local_write, local_bus::recfg_cmd_addr);
-    msg.set_command(hssi_cmd::aux_write);
-    mmio_->write_mmio64(ctrl_, msg.data());
-
-    if (!hssi_ack())
-    {
-        return false;
-    }
-
-
-    // 3. Read data from local bus to aux bus
-    // Write recfg_cmd_rddata to aux_bus::local_cmd
-    // recfg_cmd_rddata (from recfg_cmd_addr), output goes into local_dout
-    msg.clear();
-    msg.set_address(aux_bus::local_cmd);
-    msg.set_bus_command(bus_cmd::local_read, local_bus::recfg_cmd_rddata);
-    msg.set_command(hssi_cmd::aux_write);
-    mmio_->write_mmio64(ctrl_, msg.data());
-
-    if (!hssi_ack())
-    {
-        return false;
-    }
-
-
-    // 4. Read data from aux bus to hssi_stat
-    // Read local_dout
-    msg.clear();
-    msg.set_address(aux_bus::local_dout);
-    msg.set_command(hssi_cmd::aux_read);
-    mmio_->write_mmio64(ctrl_, msg.data());
-
-    if (!hssi_ack())
-    {
-        return false;
-    }
-
-
-    uint64_t hssi_value;
-    if (!mmio_->read_mmio64(stat_, hssi_value))
-    {
-        return false;
-    }
-
-    value = static_cast<uint32_t>(hssi_value & 0x00000000FFFFFFFF);
-    return true;
+    trace_scope trace(trace_tag::xcvr_read);
+    return cache_->read(shadow_cache::target::xcvr,
+                        shadow_cache::xcvr_key(lane, reg_addr), value,
+                        [&](uint32_t & v)
+                        {
+                            transaction tx;
+                            tx.xcvr_read(lane, reg_addr, &v);
+                            return execute(tx);
+                        });
 }
 
 
 bool config_app::xcvr_write(uint32_t lane, uint32_t reg_addr, uint32_t value)
 {
+    trace_scope trace(trace_tag::xcvr_write);
     if (c_header_)
     {
         header_stream_ << "\t// XCVR: Lane " << +lane
                      << ", Address " << print_hex<uint32_t>(reg_addr) << " "
                      << ", Value " << print_hex<uint32_t>(value) << std::endl;
     }
-    // 1. Provide the data to be written into reconf register to the AUX bus
-    // Write value to local_din
-    uint32_t reconfig_addr = reg_addr + hssi_xcvr_lane_offset*lane;
-    hssi_ctrl msg;
-
-    msg.clear();
-    msg.set_address(aux_bus::local_din);
-    msg.set_data(static_cast<uint32_t>(value));
-    msg.set_command(hssi_cmd::aux_write);
-    mmio_->write_mmio64(ctrl_, msg.data());
+    return cache_->write(shadow_cache::target::xcvr,
+                         shadow_cache::xcvr_key(lane, reg_addr), value,
+                         [&]()
+                         {
+                             transaction tx;
+                             tx.xcvr_write(lane, reg_addr, value);
+                             return execute(tx);
+                         });
+}
 
-    if (!hssi_ack())
+bool config_app::breaker_tripped(const char * batch)
+{
+    if (!przone_->tripped())
     {
         return false;
     }
+    err_ << "Aborting " << batch << ": " << przone_->get_breaker_limit()
+         << " controller transactions in a row timed out" << std::endl;
+    return true;
+}
 
-
-    // 2. Send request to AUX bus handshake registers, to write data into RCFG bus
-    // Write from local_din to local_dout
-    msg.clear();
-    msg.set_address(aux_bus::local_cmd);
-    msg.set_bus_command(bus_cmd::local_write, aux_bus::local_dout);
-    msg.set_command(hssi_cmd::aux_write);
-    mmio_->write_mmio64(ctrl_, msg.data());
-
-    if (!hssi_ack())
+bool config_app::execute(const transaction & tx)
+{
+    if (!c_header_)
     {
-        return false;
+        return przone_->execute(tx);
     }
 
-
-    // 3. Provide ID of reconf register to AUX bus handshake register
-    // Write local_dout to channel+reconfig_addr
-    msg.clear();
-    msg.set_address(aux_bus::local_din);
-    msg.set_bus_command(bus_cmd::local_write, reconfig_addr);
-    msg.set_command(hssi_cmd::aux_write);
-    mmio_->write_mmio64(ctrl_, msg.data());
-
-    if (!hssi_ack())
+    // the C header records the controller words, one per line; nothing
+    // is read back, so reads return 0
+    for (const transaction::step & s : tx)
     {
-        return false;
-    }
-
-
-    // 4. Send the request to the AUX bus handshake registers, write ID information from step 3
-    msg.clear();
-    msg.set_address(aux_bus::local_cmd);
-    msg.set_bus_command(bus_cmd::local_write, aux_bus::local_din);
-    msg.set_command(hssi_cmd::aux_write);
-    mmio_->write_mmio64(ctrl_, msg.data());
-
-    if (!hssi_ack())
-    {
-        return false;
+        mmio_->write_mmio64(ctrl_, s.ctrl);
+        header_stream_ << ",\n";
+        ++hssi_cmd_count_;
+        if (s.result)
+        {
+            *s.result = 0;
+        }
     }
-
     return true;
 }
 
 bool config_app::retimer_write(uint32_t device_addr, uint8_t channel, uint32_t address, uint32_t value)
 {
+    trace_scope trace(trace_tag::retimer_write);
     if (std::find(valid_rtmr_device_addrs.begin(), valid_rtmr_device_addrs.end(),
                   device_addr) == valid_rtmr_device_addrs.end())
     {
-        std::cerr << "Invalid retimer address: " << print_hex<uint32_t>(device_addr) << std::endl;
+        err_ << "Invalid retimer address: " << print_hex<uint32_t>(device_addr) << std::endl;
         return false;
     }
 
@@ -1123,90 +1793,47 @@ bool config_app::retimer_write(uint32_t device_addr, uint8_t channel, uint32_t a
                      << +channel << " " << print_hex<uint32_t>(address) << " "
                      << print_hex<uint32_t>(value) << std::endl;
     }
-    uint8_t channel_byte = channel+4;
-    uint8_t channel_select_byte[1]= {channel_byte};
-    i2c_->write(i2c_instance_retimer, device_addr, 0xFF, channel_select_byte, 1UL);
-    uint8_t * ptr = reinterpret_cast<uint8_t*>(&value);
-    i2c_->write(i2c_instance_retimer, device_addr, address, ptr, sizeof(uint32_t));
-    return true;
+    return cache_->write(shadow_cache::target::retimer,
+                         shadow_cache::retimer_key(device_addr, channel, address), value,
+                         [&]()
+                         {
+                             retimer_select_channel(device_addr, channel);
+                             uint8_t * ptr = reinterpret_cast<uint8_t*>(&value);
+                             return i2c_->write(i2c_instance_retimer, device_addr, address, ptr, sizeof(uint32_t));
+                         });
 }
 
 bool config_app::retimer_read(uint32_t device_addr, uint8_t channel, uint32_t address, uint32_t & value)
 {
+    trace_scope trace(trace_tag::retimer_read);
     if (std::find(valid_rtmr_device_addrs.begin(), valid_rtmr_device_addrs.end(),
                   device_addr) == valid_rtmr_device_addrs.end())
     {
-        std::cerr << "Invalid retimer address: " << print_hex<uint32_t>(device_addr) << std::endl;
+        err_ << "Invalid retimer address: " << print_hex<uint32_t>(device_addr) << std::endl;
         return false;
     }
 
-    uint8_t channel_byte = channel+4;
-    uint8_t channel_select_byte[1]= {channel_byte};
-    i2c_->write(i2c_instance_retimer, device_addr, 0xFF, channel_select_byte, 1UL);
-    uint8_t * ptr = reinterpret_cast<uint8_t*>(&value);
-    i2c_->read(i2c_instance_retimer, device_addr, address, ptr, sizeof(uint32_t));
-    return true;
-}
-
-bool config_app::wait_for_ack(config_app::ack_t response, uint32_t timeout_usec, uint32_t * duration)
-{
-    using hrc = std::chrono::high_resolution_clock;
-    using std::chrono::microseconds;
-    auto begin  = hrc::now();
-    static const uint32_t ack_bit = 32;
-
-    uint64_t value = response == ack_t::ack ? 0 : 0xFFFF;
-    // write a little lambda to check the value basked on response type we are
-    // waiting on
-    auto check_ack = [response](uint64_t v) -> bool
-    {
-        return response == ack_t::ack ?  (v & (1UL << ack_bit)) : (~v & (1UL << ack_bit));
-    };
-
-    bool timedout = false;
-    while (!timedout)
-    {
-        auto delta = hrc::now() - begin;
-
-        if (mmio_->read_mmio64(stat_, value) && check_ack(value))
-        {
-            if (duration)
-            {
-                *duration = std::chrono::duration_cast<microseconds>(delta).count();
-            }
-
-            return true;
-        }
-
-        std::this_thread::sleep_for(microseconds(10));
-        timedout = delta > microseconds(timeout_usec);
-    }
-    return false;
-
-
-
+    return cache_->read(shadow_cache::target::retimer,
+                        shadow_cache::retimer_key(device_addr, channel, address), value,
+                        [&](uint32_t & v)
+                        {
+                            retimer_select_channel(device_addr, channel);
+                            uint8_t * ptr = reinterpret_cast<uint8_t*>(&v);
+                            return i2c_->read(i2c_instance_retimer, device_addr, address, ptr, sizeof(uint32_t));
+                        });
 }
 
-bool config_app::hssi_ack()
+bool config_app::retimer_select_channel(uint32_t device_addr, uint8_t channel)
 {
-    if (c_header_)
-    {
-        header_stream_ << ",\n";
-        ++hssi_cmd_count_;
-        return true;
-    }
-
-    if (!wait_for_ack(ack_t::ack))
-    {
-        return false;
-    }
-    mmio_->write_mmio64(ctrl_, 0UL);
-    if (!wait_for_ack(ack_t::nack))
-    {
-        return false;
-    }
-    return true;
-
+    // the channel select register is shadowed as register 0xFF of the device
+    uint32_t channel_byte = channel+4;
+    return cache_->write(shadow_cache::target::retimer,
+                         shadow_cache::retimer_key(device_addr, 0, 0xFF), channel_byte,
+                         [&]()
+                         {
+                             uint8_t channel_select_byte[1]= {static_cast<uint8_t>(channel_byte)};
+                             return i2c_->write(i2c_instance_retimer, device_addr, 0xFF, channel_select_byte, 1UL);
+                         });
 }
 
 } // end of namespace hssi
@@ -26,12 +26,24 @@
 #pragma once
 #include <sstream>
 #include "przone.h"
+#include "eq_register.h"
+#include "arbiter.h"
+#include "hssi_przone.h"
+#include "transaction.h"
+#include "shadow_cache.h"
+#include "hssi_device.h"
 #include "i2c.h"
 #include "mdio.h"
+#include "nios.h"
 #include "option_map.h"
 #include "cmd_handler.h"
 #include "log.h"
 #include "mmio.h"
+#include "mmio_trace.h"
+#include "mmio_replay.h"
+#include "hssi_model.h"
+#include "poll.h"
+#include "latency.h"
 
 namespace intel
 {
@@ -40,47 +52,14 @@ namespace fpga
 namespace hssi
 {
 
-enum class eq_register_type : uint8_t
-{
-    unknown = 0,
-    fpga_tx,
-    fpga_rx,
-    retimer_tx,
-    retimer_rx,
-    hssi_mode,
-    mdio,
-    przone
-};
-
-struct eq_register
-{
-    eq_register_type type;
-    int32_t channel_lane;
-    int32_t device;
-    uint32_t address;
-    uint32_t value;
-    eq_register()
-    : type(eq_register_type::unknown)
-    , channel_lane(-1)
-    , device(-1)
-    , address(0)
-    , value(0)
-    {}
-
-    eq_register(eq_register_type in_type, int32_t cl, int32_t dev, uint32_t addr, uint32_t in_value=0 )
-    : type(in_type)
-    , channel_lane(cl)
-    , device(dev)
-    , address(addr)
-    , value(in_value)
-    {}
-};
-
 class config_app
 {
 public:
     config_app();
 
+    /// @brief Create an app printing command output to out and errors to err
+    config_app(std::ostream & out, std::ostream & err);
+
     virtual ~config_app();
 
     virtual intel::utils::option_map & get_options()
@@ -89,16 +68,59 @@ public:
     }
 
     bool setup();
+
+    /// @brief The MMIO space of the controller: the FPGA, a trace replay
+    ///        or the model
+    mmio::ptr_t get_mmio() const
+    {
+        return mmio_;
+    }
+
+    /// @brief Set up a worker for one device of a multi-device run,
+    ///        with the settings of parent
+    bool setup(const config_app & parent, const hssi_device::ptr_t & device);
     void show_help();
 
     uint32_t run(const std::vector<std::string> & args);
     size_t parse_registers(const std::vector<std::vector<std::string>> & data,
                            std::vector<eq_register> & registers);
     void load(std::istream & stream);
-    size_t load(eq_register registers[], size_t size);
+
+    /// @brief Write registers in order, going on past the ones that fail
+    ///
+    /// @return Number of registers written (or found holding their value)
+    size_t load(const eq_register registers[], size_t size);
+
+    /// @brief Load a CSV file, writing registers while the rest of the
+    ///        file is still being parsed
+    ///
+    /// The file is mapped and parsed on a helper thread, which queues
+    /// every load_chunk registers at most load_queue chunks ahead of the
+    /// writes. The writes stay on the calling thread.
+    ///
+    /// @return false if the file could not be read or the controller's
+    ///         circuit breaker tripped
+    bool load_stream(const std::string & path);
+    static const size_t load_chunk = 256;
+    static const size_t load_queue = 16;
     size_t dump(eq_register registers[], size_t size, std::ostream & stream);
-    bool hssi_soft_cmd(uint32_t nios_func, std::vector<uint32_t> args);
-    bool hssi_soft_cmd(uint32_t nios_func, std::vector<uint32_t> args, uint32_t & value_out);
+
+    /// @brief Write the registers whose read-back value differs
+    ///        The HSSI mode is changed (and the HSSI reinitialized) only if
+    ///        it differs from the current one.
+    ///
+    /// @param[in] registers The target register values, in load order
+    /// @param[in] size Number of target registers
+    /// @param[in] dry_run Print the plan without writing anything
+    /// @param[in] plan Stream the plan is printed to
+    ///
+    /// @return Number of registers (and mode) that differ or apply_error
+    size_t apply(eq_register registers[], size_t size, bool dry_run, std::ostream & plan);
+    static const size_t apply_error = static_cast<size_t>(-1);
+
+    bool read_register(const eq_register & reg, uint32_t & value);
+    bool hssi_soft_cmd(uint32_t nios_func, const nios_args & args = nios_args());
+    bool hssi_soft_cmd(uint32_t nios_func, const nios_args & args, uint32_t & value_out);
     bool xcvr_pll_status_read(uint32_t info_sel, uint32_t &value);
     bool xcvr_read(uint32_t lane, uint32_t reg_addr, uint32_t &value);
     bool xcvr_write(uint32_t lane, uint32_t reg_addr, uint32_t value);
@@ -109,6 +131,7 @@ public:
 
 private:
     bool                      c_header_;
+    bool                      dry_run_;
     uint32_t                  hssi_cmd_count_;
     uint32_t                  ctrl_;
     uint32_t                  stat_;
@@ -117,37 +140,45 @@ private:
     std::string               input_file_;
     intel::utils::logger      log_;
     mmio::ptr_t               mmio_;
-    przone_interface::ptr_t   przone_;
+    hssi_przone::ptr_t        przone_;
     i2c::ptr_t                i2c_;
     mdio::ptr_t               mdio_;
+    nios::ptr_t               nios_;
+    shadow_cache::ptr_t       cache_;
     intel::utils::option_map  options_;
     intel::utils::cmd_handler console_;
-
-    enum class ack_t : uint64_t
-    {
-        nack = 0,
-        ack
-    };
-
-    /// @brief Wait for an ack or nack message from the HSSI controller
-    /// @note ack means the ack bit was asserted
-    ///       nack means the ack bit was de-asserted
-    /// @param[in] response The type of response to poll for (ack or nack)
-    /// @param[in] timeout_usec The number of microseconds at which this times out
-    /// @param[out] duration Optional output variable that indicates the how long it took
-    ///             to receive the message
-    ///
-    /// @return true if it receives the message beforeeq_register_type the timeout period, false otherwise
-    bool wait_for_ack(ack_t response, uint32_t timeout_usec=1000, uint32_t * duration = 0);
-
-    /// @brief Perform the HSSI acknowledge routine
-    ///        This will wait for an ack message, then write 0 to the HSSI_CTRL register.
-    ///        Finally, this will wait for a nack messaeq_register_typege
-    ///
-    /// @return true if the routine completed successfully, false if any of the waits timed out
-    bool hssi_ack();
+    bool                      no_cache_;
+    uint32_t                  mdio_settle_usec_;
+    std::string               trace_prefix_;
+    mmio_replay::ptr_t        replay_;
+    std::ostream &            out_;
+    std::ostream &            err_;
+    std::string               device_name_;
+    std::string               lock_path_;
+    arbiter::priority         priority_;
+    uint32_t                  breaker_limit_;
+    std::vector<hssi_device::ptr_t> devices_;
+    bool                      worker_;
+
+    void open_controller();
+
+    /// @brief true (after saying so) if the controller's circuit breaker
+    ///        tripped and the rest of batch is to be skipped
+    bool breaker_tripped(const char * batch);
+
+    /// @brief Report the mismatches of a replay
+    /// @return true if the whole trace was replayed without mismatch
+    bool check_replay();
+    uint32_t run_all(const std::vector<std::string> & args);
+
+    /// @brief Run a transaction on the HSSI controller, or record its
+    ///        controller words when generating a C header
+    bool execute(const transaction & tx);
+
+    bool retimer_select_channel(uint32_t device_addr, uint8_t channel);
 
     bool do_load         (const intel::utils::cmd_handler::cmd_vector_t & cmd);
+    bool do_apply        (const intel::utils::cmd_handler::cmd_vector_t & cmd);
     bool do_dump         (const intel::utils::cmd_handler::cmd_vector_t & cmd);
     bool do_read         (const intel::utils::cmd_handler::cmd_vector_t & cmd);
     bool do_write        (const intel::utils::cmd_handler::cmd_vector_t & cmd);
@@ -159,6 +190,15 @@ private:
     bool do_pr_write     (const intel::utils::cmd_handler::cmd_vector_t & cmd);
     bool do_mdio_read    (const intel::utils::cmd_handler::cmd_vector_t & cmd);
     bool do_mdio_write   (const intel::utils::cmd_handler::cmd_vector_t & cmd);
+    bool do_stats        (const intel::utils::cmd_handler::cmd_vector_t & cmd);
+    bool do_compile      (const intel::utils::cmd_handler::cmd_vector_t & cmd);
+
+    /// @brief true if reg names a register load can write; otherwise
+    ///        problem says why not
+    bool check_register(const eq_register & reg, std::string & problem);
+
+    /// @brief Print the controller words recorded by a load as a C header
+    void print_c_header();
 };
 
 } // end of namespace hssi
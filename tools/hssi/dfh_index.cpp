@@ -0,0 +1,204 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "dfh_index.h"
+
+#include <exception>
+
+namespace intel {
+namespace fpga {
+
+namespace {
+
+// DFH (version 0 and 1)
+const unsigned dfh_next_shift = 16;
+const uint64_t dfh_next_mask = 0xFFFFFF;
+const unsigned dfh_end_bit = 40;
+const unsigned dfh_version_shift = 52;
+const unsigned dfh_type_shift = 60;
+const uint64_t dfh_type_afu = 0x1;
+
+// DFHv1 registers, relative to the header
+const uint32_t dfh_guid_l = 0x08;
+const uint32_t dfh_guid_h = 0x10;
+const uint32_t dfh_csr_addr = 0x18;
+const uint32_t dfh_csr_size_group = 0x20;
+const uint32_t dfh_param_hdr = 0x28;
+
+const uint64_t csr_addr_rel = 0x1;       // the address is absolute
+const uint64_t csr_has_params = 1UL << 31;
+const unsigned param_next_shift = 35;    // in 8 byte units
+const uint64_t param_eop = 1UL << 32;
+
+}  // end of anonymous namespace
+
+const size_t dfh_index::max_features;
+
+dfh_index::ptr_t dfh_index::build(const reader& read, uint32_t start) {
+  ptr_t index(new dfh_index());
+  index->scan(read, start);
+  index->finish();
+  return index;
+}
+
+dfh_index::ptr_t dfh_index::build(mmio::ptr_t io, uint32_t start) {
+  return build([io](uint32_t offset, uint64_t& value) {
+    return io->read_mmio64(offset, value);
+  }, start);
+}
+
+dfh_index::ptr_t dfh_index::build(opae::fpga::types::handle::ptr_t handle,
+                                  uint32_t start) {
+  return build([handle](uint32_t offset, uint64_t& value) {
+    try {
+      value = handle->read_csr64(offset);
+    } catch (const std::exception&) {
+      return false;
+    }
+    return true;
+  }, start);
+}
+
+const dfh_param* dfh_index::find_param(const dfh_feature& feature,
+                                       uint16_t id) const {
+  for (uint32_t i = 0; i < feature.params; ++i) {
+    const dfh_param& p = params_[feature.first_param + i];
+    if (p.id == id) {
+      return &p;
+    }
+  }
+  return nullptr;
+}
+
+void dfh_index::scan(const reader& read, uint32_t start) {
+  uint32_t offset = start;
+  while (true) {
+    if (features_.size() == max_features) {
+      truncated_ = true;
+      return;
+    }
+
+    uint64_t header = 0;
+    if (!read(offset, header)) {
+      truncated_ = true;
+      return;
+    }
+
+    dfh_feature f = dfh_feature();
+    f.offset = offset;
+    f.header = header;
+    f.id = header & 0xFFF;
+    f.rev = (header >> 12) & 0xF;
+    f.type = (header >> dfh_type_shift) & 0xF;
+    f.version = (header >> dfh_version_shift) & 0xFF;
+    f.csr_offset = offset;
+    f.first_param = static_cast<uint32_t>(params_.size());
+
+    uint32_t next = (header >> dfh_next_shift) & dfh_next_mask;
+    f.csr_size = next;
+    if (f.version == 1) {
+      read_v1(read, f);
+    } else if (f.type == dfh_type_afu) {
+      read(offset + dfh_guid_l, f.guid_l);
+      read(offset + dfh_guid_h, f.guid_h);
+    }
+    features_.push_back(f);
+
+    if (!next || (header >> dfh_end_bit) & 0x1) {
+      return;
+    }
+    offset += next;
+  }
+}
+
+void dfh_index::read_v1(const reader& read, dfh_feature& f) {
+  uint64_t addr = 0;
+  uint64_t size_group = 0;
+  read(f.offset + dfh_guid_l, f.guid_l);
+  read(f.offset + dfh_guid_h, f.guid_h);
+  read(f.offset + dfh_csr_addr, addr);
+  read(f.offset + dfh_csr_size_group, size_group);
+
+  f.csr_offset = addr & csr_addr_rel ? addr & ~csr_addr_rel
+                                     : f.offset + (addr & ~csr_addr_rel);
+  f.csr_size = size_group >> 32;
+  f.group = (size_group >> 16) & 0x7FFF;
+  f.instance_id = size_group & 0xFFFF;
+  if (!(size_group & csr_has_params)) {
+    return;
+  }
+
+  // parameter blocks follow each other until end of parameters
+  uint32_t hdr_offset = f.offset + dfh_param_hdr;
+  while (true) {
+    uint64_t hdr = 0;
+    if (!read(hdr_offset, hdr)) {
+      truncated_ = true;
+      return;
+    }
+    uint32_t next = static_cast<uint32_t>(hdr >> param_next_shift) * 8;
+    if (!next) {
+      // a malformed block would loop forever
+      truncated_ = true;
+      return;
+    }
+
+    dfh_param p;
+    p.id = hdr & 0xFFFF;
+    p.version = (hdr >> 16) & 0xFFFF;
+    p.offset = hdr_offset + 8;
+    p.size = next - 8;
+    params_.push_back(p);
+    ++f.params;
+
+    if (hdr & param_eop) {
+      return;
+    }
+    hdr_offset += next;
+  }
+}
+
+void dfh_index::finish() {
+  // count the instances of each key, then lay their indices out together
+  for (auto& f : features_) {
+    auto& range = map_[key(f.id, f.type)];
+    f.instance = range.second++;
+  }
+  uint32_t begin = 0;
+  for (auto& entry : map_) {
+    entry.second.first = begin;
+    begin += entry.second.second;
+    entry.second.second = 0;
+  }
+  order_.resize(features_.size());
+  for (uint32_t i = 0; i < features_.size(); ++i) {
+    auto& range = map_[key(features_[i].id, features_[i].type)];
+    order_[range.first + range.second++] = i;
+  }
+}
+
+}  // end of namespace fpga
+}  // end of namespace intel
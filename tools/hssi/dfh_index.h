@@ -0,0 +1,139 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <opae/cxx/core/handle.h>
+
+#include "mmio.h"
+
+namespace intel {
+namespace fpga {
+
+/// @brief A parameter block of a DFHv1 feature
+struct dfh_param {
+  uint16_t id;
+  uint16_t version;
+  uint32_t offset;  ///< of the parameter data
+  uint32_t size;    ///< of the parameter data, in bytes
+};
+
+/// @brief One feature of a device feature list
+struct dfh_feature {
+  uint32_t offset;       ///< of the feature header
+  uint64_t header;
+  uint16_t id;
+  uint8_t rev;
+  uint8_t type;
+  uint8_t version;       ///< DFH version, 0 or 1
+  uint8_t reserved[3];
+  uint64_t guid_l;       ///< DFHv1 and AFU headers, otherwise 0
+  uint64_t guid_h;
+  uint64_t csr_offset;   ///< start of the feature registers
+  uint64_t csr_size;     ///< DFHv1 only, otherwise the distance to next
+  uint16_t instance_id;  ///< DFHv1 only
+  uint16_t group;        ///< DFHv1 only
+  uint32_t instance;     ///< count of earlier features with this id and type
+  uint32_t first_param;  ///< index into dfh_index::params()
+  uint32_t params;
+};
+
+/// @brief Device feature list indexed in a single walk.
+///
+/// The features are kept in discovery order in a flat array, with a map
+/// from id and type to every instance of that feature, so a lookup is a
+/// hash probe with no MMIO and no allocation. The index holds no
+/// reference to the register space and can be shared by every component
+/// of a device.
+class dfh_index {
+ public:
+  typedef std::shared_ptr<dfh_index> ptr_t;
+  typedef std::function<bool(uint32_t offset, uint64_t& value)> reader;
+
+  /// @brief A list longer than this is taken as a loop
+  static const size_t max_features = 4096;
+
+  /// @brief Walk the list starting at start through read
+  static ptr_t build(const reader& read, uint32_t start = 0);
+  /// @brief Walk the list of an FME (or other) register space
+  static ptr_t build(mmio::ptr_t io, uint32_t start = 0);
+  /// @brief Walk the list of an AFU through its OPAE handle
+  static ptr_t build(opae::fpga::types::handle::ptr_t handle,
+                     uint32_t start = 0);
+
+  /// @brief The instance-th feature with id and type, or nullptr
+  const dfh_feature* find(uint32_t id, uint32_t type,
+                          size_t instance = 0) const {
+    auto it = map_.find(key(id, type));
+    if (it == map_.end() || instance >= it->second.second) {
+      return nullptr;
+    }
+    return &features_[order_[it->second.first + instance]];
+  }
+
+  /// @brief Instances of the feature with id and type
+  size_t count(uint32_t id, uint32_t type) const {
+    auto it = map_.find(key(id, type));
+    return it == map_.end() ? 0 : it->second.second;
+  }
+
+  /// @brief Parameter id of feature, or nullptr
+  const dfh_param* find_param(const dfh_feature& feature, uint16_t id) const;
+
+  const std::vector<dfh_feature>& features() const { return features_; }
+  const std::vector<dfh_param>& params() const { return params_; }
+
+  /// @brief The walk stopped at a failed read or a looping list
+  bool truncated() const { return truncated_; }
+
+ private:
+  dfh_index() : truncated_(false) {}
+
+  static uint32_t key(uint32_t id, uint32_t type) {
+    return (type & 0xF) << 12 | (id & 0xFFF);
+  }
+
+  void scan(const reader& read, uint32_t start);
+  void read_v1(const reader& read, dfh_feature& feature);
+  void finish();
+
+  std::vector<dfh_feature> features_;
+  std::vector<dfh_param> params_;
+  std::vector<uint32_t> order_;  ///< feature indices grouped by key
+  std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> map_;
+  bool truncated_;
+};
+
+}  // end of namespace fpga
+}  // end of namespace intel
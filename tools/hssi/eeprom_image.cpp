@@ -0,0 +1,154 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "eeprom_image.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+eeprom_image::eeprom_image(i2c::ptr_t bus, uint32_t instance,
+                           uint32_t device_addr, uint32_t base, size_t size,
+                           size_t burst)
+    : bus_(bus),
+      instance_(instance),
+      device_addr_(device_addr),
+      base_(base),
+      burst_(burst ? burst : size),
+      loaded_(false),
+      image_(size) {}
+
+bool eeprom_image::read(uint32_t offset, uint8_t bytes[], size_t count) {
+  if (offset < base_ || offset - base_ > image_.size() ||
+      count > image_.size() - (offset - base_)) {
+    return false;
+  }
+  if (!load()) {
+    return false;
+  }
+  std::memcpy(bytes, image_.data() + (offset - base_), count);
+  return true;
+}
+
+bool eeprom_image::load() {
+  if (loaded_) {
+    return true;
+  }
+  if (read_file()) {
+    loaded_ = true;
+    return true;
+  }
+  return reload();
+}
+
+bool eeprom_image::reload() {
+  loaded_ = false;
+  if (!read_bus()) {
+    return false;
+  }
+  loaded_ = true;
+  write_file();
+  return true;
+}
+
+void eeprom_image::invalidate() {
+  loaded_ = false;
+  if (!cache_file_.empty()) {
+    ::unlink(cache_file_.c_str());
+  }
+}
+
+bool eeprom_image::read_bus() {
+  for (size_t offset = 0; offset < image_.size(); offset += burst_) {
+    size_t count = std::min(burst_, image_.size() - offset);
+    if (!bus_->read(instance_, device_addr_,
+                    base_ + static_cast<uint32_t>(offset),
+                    image_.data() + offset, count)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool eeprom_image::read_file() {
+  if (cache_file_.empty()) {
+    return false;
+  }
+  std::ifstream in(cache_file_, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  std::vector<uint8_t> data(image_.size());
+  in.read(reinterpret_cast<char*>(data.data()), data.size());
+  // a short or long file is a different (or damaged) image
+  if (in.gcount() != static_cast<std::streamsize>(data.size()) ||
+      in.peek() != std::char_traits<char>::eof()) {
+    return false;
+  }
+  image_.swap(data);
+  return true;
+}
+
+bool eeprom_image::write_file() const {
+  if (cache_file_.empty()) {
+    return false;
+  }
+  // write a temporary and rename it so readers never see a partial image
+  std::string tmp = cache_file_ + "." + std::to_string(::getpid()) + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      return false;
+    }
+    out.write(reinterpret_cast<const char*>(image_.data()), image_.size());
+    if (!out) {
+      ::unlink(tmp.c_str());
+      return false;
+    }
+  }
+  return std::rename(tmp.c_str(), cache_file_.c_str()) == 0;
+}
+
+std::string eeprom_image::cache_file(const std::string& dir,
+                                     uint16_t segment, uint8_t bus,
+                                     uint8_t device, uint8_t function,
+                                     uint32_t device_addr, uint32_t base) {
+  char name[64];
+  std::snprintf(name, sizeof(name), "eeprom-%04x:%02x:%02x.%x-%02x-%02x.bin",
+                segment, bus, device, function, device_addr, base);
+  return dir + "/" + name;
+}
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
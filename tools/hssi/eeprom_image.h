@@ -0,0 +1,100 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "i2c.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+/// @brief In-memory image of an I2C EEPROM.
+///
+/// The first access reads the imaged window [base, base + size) with
+/// sequential multi-byte reads (one START/address phase per burst instead
+/// of per byte) and later accesses are served from memory. With a cache file the image
+/// is also kept on disk, so a later process can skip the I2C bus.
+class eeprom_image {
+ public:
+  typedef std::shared_ptr<eeprom_image> ptr_t;
+
+  static const size_t default_size = 256;
+  static const size_t default_burst = 64;
+
+  eeprom_image(i2c::ptr_t bus, uint32_t instance, uint32_t device_addr,
+               uint32_t base = 0, size_t size = default_size,
+               size_t burst = default_burst);
+
+  /// @brief Copy count bytes at EEPROM offset out of the image, loading
+  ///        it first if needed
+  bool read(uint32_t offset, uint8_t bytes[], size_t count);
+
+  /// @brief Load the image from the cache file or, failing that, the bus
+  bool load();
+
+  /// @brief Read the image from the bus, refreshing the cache file
+  bool reload();
+
+  /// @brief Drop the image from memory and remove the cache file
+  void invalidate();
+
+  bool loaded() const { return loaded_; }
+  const std::vector<uint8_t>& image() const { return image_; }
+
+  /// @brief Keep the image in path (empty for memory only)
+  void set_cache_file(const std::string& path) { cache_file_ = path; }
+  const std::string& cache_file() const { return cache_file_; }
+
+  /// @brief Cache file name for a board, e.g.
+  ///        <dir>/eeprom-0000:5e:00.0-ae-e0.bin
+  static std::string cache_file(const std::string& dir, uint16_t segment,
+                                uint8_t bus, uint8_t device, uint8_t function,
+                                uint32_t device_addr, uint32_t base = 0);
+
+ private:
+  bool read_bus();
+  bool read_file();
+  bool write_file() const;
+
+  i2c::ptr_t bus_;
+  uint32_t instance_;
+  uint32_t device_addr_;
+  uint32_t base_;
+  size_t burst_;
+  bool loaded_;
+  std::vector<uint8_t> image_;
+  std::string cache_file_;
+};
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
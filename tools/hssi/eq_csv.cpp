@@ -0,0 +1,232 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "eq_csv.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <limits>
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+const std::map<std::string, eq_register_type> str_register_type_map{
+    {"FPGA_RX", eq_register_type::fpga_rx},
+    {"FPGA_TX", eq_register_type::fpga_tx},
+    {"RTMR_RX", eq_register_type::retimer_rx},
+    {"RTMR_TX", eq_register_type::retimer_tx},
+    {"MODE", eq_register_type::hssi_mode},
+    {"MDIO", eq_register_type::mdio},
+    {"PRZONE", eq_register_type::przone}};
+
+const std::map<eq_register_type, std::string> register_type_str_map{
+    {eq_register_type::fpga_rx, "FPGA_RX"},
+    {eq_register_type::fpga_tx, "FPGA_TX"},
+    {eq_register_type::retimer_rx, "RTMR_RX"},
+    {eq_register_type::retimer_tx, "RTMR_TX"},
+    {eq_register_type::hssi_mode, "MODE"},
+    {eq_register_type::mdio, "MDIO"},
+    {eq_register_type::przone, "PRZONE"}};
+
+namespace {
+
+inline bool blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+void trim(const char*& begin, const char*& end) {
+  while (begin < end && blank(*begin)) ++begin;
+  while (end > begin && blank(end[-1])) --end;
+}
+
+int digit(char c, unsigned base) {
+  unsigned d;
+  if (c >= '0' && c <= '9') {
+    d = c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    d = c - 'a' + 10;
+  } else if (c >= 'A' && c <= 'F') {
+    d = c - 'A' + 10;
+  } else {
+    return -1;
+  }
+  return d < base ? static_cast<int>(d) : -1;
+}
+
+// a whole field as an integer of type T: an optional sign (if T is
+// signed), then decimal, 0x hex or 0 octal, as std::stol with base 0
+template <typename T>
+bool parse_number(const char* p, const char* end, T& value) {
+  trim(p, end);
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p++ == '-';
+    if (negative && !std::numeric_limits<T>::is_signed) return false;
+  }
+  unsigned base = 10;
+  if (end - p > 1 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+    base = 16;
+    p += 2;
+  } else if (end - p > 1 && p[0] == '0') {
+    base = 8;
+    ++p;
+  }
+  if (p == end) return false;
+
+  const uint64_t limit =
+      negative ? static_cast<uint64_t>(std::numeric_limits<T>::max()) + 1
+               : static_cast<uint64_t>(std::numeric_limits<T>::max());
+  uint64_t v = 0;
+  for (; p < end; ++p) {
+    int d = digit(*p, base);
+    if (d < 0) return false;
+    v = v * base + d;
+    if (v > limit) return false;
+  }
+  value = negative ? static_cast<T>(-static_cast<int64_t>(v))
+                   : static_cast<T>(v);
+  return true;
+}
+
+bool parse_type(const char* begin, const char* end, eq_register_type& type) {
+  trim(begin, end);
+  if (begin < end && *begin >= '0' && *begin <= '9') {
+    uint8_t number = 0;
+    if (!parse_number(begin, end, number)) return false;
+    type = static_cast<eq_register_type>(number);
+    return true;
+  }
+  // the names are short enough for the small string buffer
+  auto it = str_register_type_map.find(std::string(begin, end));
+  if (it == str_register_type_map.end()) return false;
+  type = it->second;
+  return true;
+}
+
+}  // end of anonymous namespace
+
+eq_csv_reader::eq_csv_reader(void* map, size_t size)
+    : map_(map),
+      size_(size),
+      pos_(static_cast<const char*>(map)),
+      end_(static_cast<const char*>(map) + size),
+      line_(0),
+      skipped_(0) {}
+
+eq_csv_reader::~eq_csv_reader() {
+  if (map_) ::munmap(map_, size_);
+}
+
+eq_csv_reader::ptr_t eq_csv_reader::open(const std::string& path,
+                                         std::string& error) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    error = "cannot open";
+    return ptr_t();
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    error = "cannot stat";
+    return ptr_t();
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  void* map = nullptr;
+  if (size) {
+    map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      ::close(fd);
+      error = "cannot map";
+      return ptr_t();
+    }
+    // read ahead: the file is parsed front to back, once
+    ::madvise(map, size, MADV_SEQUENTIAL);
+  }
+  ::close(fd);
+  return ptr_t(new eq_csv_reader(map, size));
+}
+
+bool eq_csv_reader::next(eq_register& reg) {
+  while (pos_ < end_) {
+    const char* begin = pos_;
+    const char* nl =
+        static_cast<const char*>(std::memchr(begin, '\n', end_ - begin));
+    const char* end = nl ? nl : end_;
+    pos_ = nl ? nl + 1 : end_;
+    ++line_;
+
+    const char* first = begin;
+    const char* last = end;
+    trim(first, last);
+    if (first == last || *first == '#') {
+      continue;
+    }
+    if (parse_line(begin, end, reg)) {
+      return true;
+    }
+    ++skipped_;
+  }
+  return false;
+}
+
+bool eq_csv_reader::parse_line(const char* begin, const char* end,
+                               eq_register& reg) {
+  // the bounds of the first five fields; any after those are ignored
+  const char* first[5];
+  const char* last[5];
+  size_t fields = 0;
+  const char* p = begin;
+  while (fields < 5) {
+    const char* comma =
+        static_cast<const char*>(std::memchr(p, ',', end - p));
+    first[fields] = p;
+    last[fields] = comma ? comma : end;
+    ++fields;
+    if (!comma) break;
+    p = comma + 1;
+  }
+  if (fields < 4) {
+    return false;
+  }
+
+  eq_register r;
+  if (!parse_type(first[0], last[0], r.type) ||
+      !parse_number(first[1], last[1], r.channel_lane) ||
+      !parse_number(first[2], last[2], r.device) ||
+      !parse_number(first[3], last[3], r.address) ||
+      (fields > 4 && !parse_number(first[4], last[4], r.value))) {
+    return false;
+  }
+  reg = r;
+  return true;
+}
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
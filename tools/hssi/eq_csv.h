@@ -0,0 +1,90 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "eq_register.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+/// @brief The register type of each CSV type name, and back
+extern const std::map<std::string, eq_register_type> str_register_type_map;
+extern const std::map<eq_register_type, std::string> register_type_str_map;
+
+/// @brief Reads the registers of a CSV equalization profile straight out
+///        of the mapped file.
+///
+/// Lines are type,lane/channel,device,address[,value], as load reads
+/// them: the type by name (FPGA_TX, RTMR_RX, MODE, ...) or number, the
+/// numbers decimal, 0x hex or 0 octal. Fields are parsed where they lie,
+/// with no string per line or field. Blank lines and lines starting
+/// with # are skipped, and so are lines that do not parse (a heading).
+class eq_csv_reader {
+ public:
+  typedef std::shared_ptr<eq_csv_reader> ptr_t;
+
+  ~eq_csv_reader();
+
+  static ptr_t open(const std::string& path, std::string& error);
+
+  /// @brief Parse the next register
+  ///
+  /// @return false at the end of the file
+  bool next(eq_register& reg);
+
+  /// @brief Line number (from 1) of the last register returned
+  size_t line() const { return line_; }
+  /// @brief Lines skipped because they did not parse
+  size_t skipped() const { return skipped_; }
+
+  /// @brief Parse one line, without its end of line
+  static bool parse_line(const char* begin, const char* end,
+                         eq_register& reg);
+
+ private:
+  eq_csv_reader(void* map, size_t size);
+  eq_csv_reader(const eq_csv_reader&) = delete;
+  eq_csv_reader& operator=(const eq_csv_reader&) = delete;
+
+  void* map_;
+  size_t size_;
+  const char* pos_;
+  const char* end_;
+  size_t line_;
+  size_t skipped_;
+};
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
@@ -0,0 +1,222 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "eq_profile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <new>
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+// the records are used in place, so their layout is the file format
+static_assert(sizeof(eq_register) == 20, "eq_register layout changed");
+static_assert(sizeof(eq_profile_header) % alignof(eq_register) == 0,
+              "records after the header are misaligned");
+
+namespace {
+
+// reflected CRC-32 (IEEE 802.3), as zlib computes it
+struct crc_table {
+  uint32_t entry[256];
+  crc_table() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k) {
+        c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+      }
+      entry[i] = c;
+    }
+  }
+};
+
+// mode changes and PR zone writes may change any other register
+bool barrier(const eq_register& reg) {
+  return reg.type != eq_register_type::fpga_tx &&
+         reg.type != eq_register_type::fpga_rx &&
+         reg.type != eq_register_type::retimer_tx &&
+         reg.type != eq_register_type::retimer_rx &&
+         reg.type != eq_register_type::mdio;
+}
+
+int target(eq_register_type type) {
+  switch (type) {
+    case eq_register_type::fpga_tx:
+    case eq_register_type::fpga_rx:
+      return 0;
+    case eq_register_type::retimer_tx:
+    case eq_register_type::retimer_rx:
+      return 1;
+    default:
+      return 2;
+  }
+}
+
+// transceivers by lane, retimers by device then channel, MDIO by port
+// then device; the registers of one lane (channel, port) compare equal,
+// so the stable sort keeps them in CSV order
+bool locality_less(const eq_register& a, const eq_register& b) {
+  int ta = target(a.type), tb = target(b.type);
+  if (ta != tb) return ta < tb;
+  if (a.device != b.device) return a.device < b.device;
+  return a.channel_lane < b.channel_lane;
+}
+
+}  // end of anonymous namespace
+
+eq_profile::eq_profile(void* map, size_t map_size)
+    : map_(map),
+      map_size_(map_size),
+      records_(reinterpret_cast<const eq_register*>(
+          static_cast<const uint8_t*>(map) + sizeof(eq_profile_header))),
+      count_(static_cast<const eq_profile_header*>(map)->count) {}
+
+eq_profile::~eq_profile() { ::munmap(map_, map_size_); }
+
+eq_profile::ptr_t eq_profile::open(const std::string& path,
+                                   std::string& error) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    error = "cannot open";
+    return ptr_t();
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(eq_profile_header)) {
+    ::close(fd);
+    error = "not a compiled equalization profile";
+    return ptr_t();
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) {
+    error = "cannot map";
+    return ptr_t();
+  }
+
+  const eq_profile_header* header = static_cast<const eq_profile_header*>(map);
+  if (std::memcmp(header->magic, eq_profile_magic, sizeof(header->magic))) {
+    error = "not a compiled equalization profile";
+  } else if (header->version != eq_profile_version ||
+             header->record_size != sizeof(eq_register)) {
+    error = "unsupported profile version";
+  } else if (header->count != (size - sizeof(*header)) / sizeof(eq_register) ||
+             (size - sizeof(*header)) % sizeof(eq_register)) {
+    error = "truncated profile";
+  } else if (crc32(header + 1, size - sizeof(*header)) != header->crc32) {
+    error = "profile checksum mismatch";
+  } else {
+    return ptr_t(new eq_profile(map, size));
+  }
+  ::munmap(map, size);
+  return ptr_t();
+}
+
+bool eq_profile::is_profile(const std::string& path) {
+  char magic[sizeof(eq_profile_magic)] = {};
+  std::ifstream in(path, std::ios::binary);
+  return in.read(magic, sizeof(magic)) &&
+         std::memcmp(magic, eq_profile_magic, sizeof(magic)) == 0;
+}
+
+void eq_profile::arrange(std::vector<eq_register>& registers) {
+  auto begin = registers.begin();
+  while (begin != registers.end()) {
+    auto end = std::find_if(begin, registers.end(), barrier);
+    std::stable_sort(begin, end, locality_less);
+    begin = end == registers.end() ? end : end + 1;
+  }
+}
+
+bool eq_profile::write(const std::string& path,
+                       std::vector<eq_register> registers,
+                       std::string& error) {
+  arrange(registers);
+
+  // construct the records in zeroed storage, so the padding after type
+  // is zero and the checksum the same from one compile to the next
+  std::vector<char> records(registers.size() * sizeof(eq_register), 0);
+  for (size_t i = 0; i < registers.size(); ++i) {
+    const eq_register& r = registers[i];
+    new (&records[i * sizeof(eq_register)])
+        eq_register(r.type, r.channel_lane, r.device, r.address, r.value);
+  }
+
+  eq_profile_header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, eq_profile_magic, sizeof(header.magic));
+  header.version = eq_profile_version;
+  header.record_size = sizeof(eq_register);
+  header.count = registers.size();
+  header.crc32 = crc32(records.data(), records.size());
+
+  // write a temporary and rename it so a loader never sees a partial file
+  std::string tmp = path + "." + std::to_string(::getpid()) + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      error = "cannot create " + tmp;
+      return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(records.data(), records.size());
+    if (!out) {
+      ::unlink(tmp.c_str());
+      error = "cannot write " + tmp;
+      return false;
+    }
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    ::unlink(tmp.c_str());
+    error = "cannot rename " + tmp;
+    return false;
+  }
+  return true;
+}
+
+uint32_t eq_profile::crc32(const void* data, size_t size) {
+  static const crc_table table;
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < size; ++i) {
+    crc = table.entry[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFF;
+}
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
@@ -0,0 +1,103 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eq_register.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+/// @brief Header of a compiled equalization profile, followed by count
+///        eq_register records in host byte order
+struct eq_profile_header {
+  char magic[8];          ///< "HSSIEQP"
+  uint32_t version;
+  uint32_t record_size;
+  uint64_t count;
+  uint32_t crc32;         ///< of the records
+  uint32_t reserved[3];
+};
+
+static const char eq_profile_magic[8] = "HSSIEQP";
+static const uint32_t eq_profile_version = 1;
+
+/// @brief A compiled equalization profile, mapped read-only.
+///
+/// hssi_config compile validates a CSV profile once and writes its
+/// registers as they are held in memory, so loading one is an mmap and
+/// a checksum instead of parsing text. The registers are grouped by
+/// target and sorted for locality: transceiver registers by lane (one
+/// batched transaction), retimer registers by device and channel (fewer
+/// channel selects), MDIO registers by device and port. Mode changes and
+/// PR zone writes may affect everything else, so registers are only
+/// moved between two of them, never across; the registers of one lane,
+/// channel or port keep their CSV order.
+class eq_profile {
+ public:
+  typedef std::shared_ptr<eq_profile> ptr_t;
+
+  ~eq_profile();
+
+  /// @brief Map a compiled profile, checking its header and checksum
+  static ptr_t open(const std::string& path, std::string& error);
+
+  /// @brief true if path starts with the profile magic
+  static bool is_profile(const std::string& path);
+
+  /// @brief Arrange registers and write them as a profile to path
+  static bool write(const std::string& path,
+                    std::vector<eq_register> registers, std::string& error);
+
+  /// @brief Group and sort registers in place, as write does
+  static void arrange(std::vector<eq_register>& registers);
+
+  static uint32_t crc32(const void* data, size_t size);
+
+  const eq_register* data() const { return records_; }
+  size_t size() const { return count_; }
+
+ private:
+  eq_profile(void* map, size_t map_size);
+  eq_profile(const eq_profile&) = delete;
+  eq_profile& operator=(const eq_profile&) = delete;
+
+  void* map_;
+  size_t map_size_;
+  const eq_register* records_;
+  size_t count_;
+};
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
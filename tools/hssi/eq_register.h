@@ -0,0 +1,76 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstdint>
+
+namespace intel
+{
+namespace fpga
+{
+namespace hssi
+{
+
+enum class eq_register_type : uint8_t
+{
+    unknown = 0,
+    fpga_tx,
+    fpga_rx,
+    retimer_tx,
+    retimer_rx,
+    hssi_mode,
+    mdio,
+    przone
+};
+
+struct eq_register
+{
+    eq_register_type type;
+    int32_t channel_lane;
+    int32_t device;
+    uint32_t address;
+    uint32_t value;
+    eq_register()
+    : type(eq_register_type::unknown)
+    , channel_lane(-1)
+    , device(-1)
+    , address(0)
+    , value(0)
+    {}
+
+    eq_register(eq_register_type in_type, int32_t cl, int32_t dev, uint32_t addr, uint32_t in_value=0 )
+    : type(in_type)
+    , channel_lane(cl)
+    , device(dev)
+    , address(addr)
+    , value(in_value)
+    {}
+};
+
+} // end of namespace hssi
+} // end of namespace fpga
+} // end of namespace intel
@@ -29,6 +29,10 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <fcntl.h>
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
 #include "fme.h"
 
 
@@ -40,11 +44,89 @@ namespace intel
 namespace fpga
 {
 
+namespace
+{
+
+const size_t block_size = 64;
+const size_t block_writes = block_size / sizeof(uint64_t);
+
+inline void store_fence()
+{
+#if defined(__x86_64__)
+    _mm_sfence();
+#else
+    __sync_synchronize();
+#endif
+}
+
+#if defined(__x86_64__)
+bool cpu_has_movdir64b()
+{
+    unsigned int eax, ebx, ecx, edx;
+    return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ecx & (1u << 28));
+}
+
+bool cpu_has_avx512()
+{
+    unsigned int eax, ebx, ecx, edx;
+    // the OS must save the opmask and ZMM state (XCR0 bits 1, 2, 5-7)
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & (1u << 27)))
+    {
+        return false;
+    }
+    unsigned int xcr0_lo, xcr0_hi;
+    __asm__ volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    if ((xcr0_lo & 0xE6) != 0xE6)
+    {
+        return false;
+    }
+    return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1u << 16));
+}
+
+// movdir64b (%rdx), %rax, spelled out for assemblers that predate it
+inline void store_movdir64b(volatile uint8_t * dst, const uint64_t * src)
+{
+    __asm__ volatile(".byte 0x66, 0x0f, 0x38, 0xf8, 0x02"
+                     : : "a"(dst), "d"(src) : "memory");
+}
+
+__attribute__((target("avx512f")))
+void store_avx512(volatile uint8_t * dst, const uint64_t * src)
+{
+    __m512i line = _mm512_load_si512(src);
+    _mm512_store_si512(const_cast<uint8_t*>(dst), line);
+}
+
+// eight writes filling one aligned block, none of them but the last
+// asking for a fence
+bool full_block(const csr_write * writes, size_t count)
+{
+    if (count < block_writes || writes[0].offset % block_size)
+    {
+        return false;
+    }
+    for (size_t i = 1; i < block_writes; ++i)
+    {
+        if (writes[i].offset != writes[0].offset + i * sizeof(uint64_t) ||
+            writes[i - 1].fence)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+} // end of anonymous namespace
+
 fme::fme(const string & resource, bool read_only)
     : mmio_(0),
       resource_(resource),
       fd_(-1),
-      mmap_size_(0)
+      mmap_size_(0),
+      wc_(0),
+      wc_fd_(-1),
+      bulk_store_(bulk_store::qword)
 {
     struct stat stbuffer;
     int flags = read_only ?  O_RDONLY : O_RDWR | O_SYNC;
@@ -69,6 +151,18 @@ fme::fme(const string & resource, bool read_only)
 
 fme::~fme()
 {
+    if (wc_)
+    {
+        munmap(wc_, mmap_size_);
+        wc_ = 0;
+    }
+
+    if (wc_fd_ >= 0)
+    {
+        close(wc_fd_);
+        wc_fd_ = -1;
+    }
+
     if (mmio_)
     {
         munmap(mmio_, mmap_size_);
@@ -107,5 +201,146 @@ fme::ptr_t fme::open(string resource, int8_t socket_id, bool read_only)
     return fme_ptr;
 }
 
+bool fme::map_write_combining()
+{
+    if (wc_)
+    {
+        return true;
+    }
+    if (!mmio_)
+    {
+        return false;
+    }
+
+    std::string wc_resource = resource_ + "_wc";
+    struct stat stbuffer;
+    wc_fd_ = ::open(wc_resource.c_str(), O_RDWR);
+    if (wc_fd_ < 0)
+    {
+        return false;
+    }
+    if (::fstat(wc_fd_, &stbuffer) != 0 ||
+        static_cast<uint64_t>(stbuffer.st_size) < mmap_size_)
+    {
+        close(wc_fd_);
+        wc_fd_ = -1;
+        return false;
+    }
+
+    wc_ = mmap(0, mmap_size_, PROT_READ | PROT_WRITE, MAP_SHARED, wc_fd_, 0);
+    if (wc_ == MAP_FAILED)
+    {
+        wc_ = 0;
+        close(wc_fd_);
+        wc_fd_ = -1;
+        return false;
+    }
+    bulk_store_ = best_bulk_store();
+    return true;
+}
+
+fme::bulk_store fme::best_bulk_store() const
+{
+    if (supports(bulk_store::movdir64b))
+    {
+        return bulk_store::movdir64b;
+    }
+    if (supports(bulk_store::avx512))
+    {
+        return bulk_store::avx512;
+    }
+    return bulk_store::qword;
+}
+
+bool fme::supports(bulk_store store) const
+{
+#if defined(__x86_64__)
+    static const bool movdir64b = cpu_has_movdir64b();
+    static const bool avx512 = cpu_has_avx512();
+#else
+    static const bool movdir64b = false;
+    static const bool avx512 = false;
+#endif
+    switch (store)
+    {
+        case bulk_store::qword:
+            return true;
+        case bulk_store::avx512:
+            // a 64-byte store only stays whole through a write-combining mapping
+            return avx512 && wc_;
+        case bulk_store::movdir64b:
+            return movdir64b;
+    }
+    return false;
+}
+
+bool fme::set_bulk_store(bulk_store store)
+{
+    if (!supports(store))
+    {
+        return false;
+    }
+    bulk_store_ = store;
+    return true;
+}
+
+size_t fme::write_bulk(const csr_write * writes, size_t count)
+{
+    volatile uint8_t * base = wc_ ? reinterpret_cast<volatile uint8_t*>(wc_) : base_ptr();
+    if (!base)
+    {
+        return 0;
+    }
+
+    size_t done = 0;
+    while (done < count)
+    {
+        const csr_write & w = writes[done];
+        if (static_cast<uint64_t>(w.offset) + sizeof(uint64_t) > mmap_size_)
+        {
+            break;
+        }
+
+#if defined(__x86_64__)
+        if (bulk_store_ != bulk_store::qword &&
+            full_block(writes + done, count - done) &&
+            static_cast<uint64_t>(w.offset) + block_size <= mmap_size_)
+        {
+            alignas(64) uint64_t block[block_writes];
+            for (size_t i = 0; i < block_writes; ++i)
+            {
+                block[i] = writes[done + i].value;
+            }
+            if (bulk_store_ == bulk_store::movdir64b)
+            {
+                store_movdir64b(base + w.offset, block);
+            }
+            else
+            {
+                store_avx512(base + w.offset, block);
+            }
+            done += block_writes;
+            if (writes[done - 1].fence)
+            {
+                store_fence();
+            }
+            continue;
+        }
+#endif
+
+        *reinterpret_cast<volatile uint64_t*>(base + w.offset) = w.value;
+        ++done;
+        if (w.fence)
+        {
+            store_fence();
+        }
+    }
+
+    // write-combined and direct stores are weakly ordered: drain them
+    // before any later access through the uncached mapping
+    store_fence();
+    return done;
+}
+
 }   // end of namespace fpga
 }   // end of namespace intel
@@ -30,6 +30,7 @@
 #include <string>
 #include <cstdint>
 #include <ostream>
+#include <vector>
 #include "mmio.h"
 
 namespace intel
@@ -37,11 +38,27 @@ namespace intel
 namespace fpga
 {
 
+/// @brief One write of a bulk CSR write
+struct csr_write
+{
+    uint32_t offset;
+    uint64_t value;
+    bool     fence;   ///< every write up to this one lands before the next
+};
+
 class fme : public mmio
 {
 public:
     typedef std::shared_ptr<fme> ptr_t;
 
+    /// @brief Store used for the 64-byte aligned blocks of a bulk write
+    enum class bulk_store
+    {
+        qword,      ///< eight 64-bit stores
+        avx512,     ///< one 64-byte AVX-512 store (write-combining mapping)
+        movdir64b   ///< one 64-byte direct store
+    };
+
     enum class csr : uint32_t
     {
         dfh             = 0x0000,
@@ -153,12 +170,53 @@ public:
 
     static ptr_t open(std::string resource, int8_t socket_id = -1, bool read_only = false);
 
+    /// @brief Also map <resource>_wc, the write-combining view of the
+    ///        same BAR, for bulk writes
+    /// @return false if the kernel does not offer one
+    bool map_write_combining();
+
+    bool write_combining() const
+    {
+        return wc_ != nullptr;
+    }
+
+    /// @brief Stream writes in order, through the write-combining mapping
+    ///        when there is one. Eight writes filling a 64-byte aligned
+    ///        block go out as a single 64-byte store when the bulk store
+    ///        allows it. An sfence follows every write marked fence and
+    ///        the last write.
+    /// @return the number of writes done; a write outside the BAR stops
+    size_t write_bulk(const csr_write * writes, size_t count);
+
+    size_t write_bulk(const std::vector<csr_write> & writes)
+    {
+        return write_bulk(writes.data(), writes.size());
+    }
+
+    /// @brief The widest store this CPU supports for the current mapping
+    bulk_store best_bulk_store() const;
+
+    /// @brief true if this CPU supports store for the current mapping
+    bool supports(bulk_store store) const;
+
+    bulk_store get_bulk_store() const
+    {
+        return bulk_store_;
+    }
+
+    /// @return false, keeping the current store, if store is not
+    ///         supported (it would fault in write_bulk)
+    bool set_bulk_store(bulk_store store);
+
 private:
     fme():
     mmio_(nullptr),
     resource_(""),
     fd_(-1),
-    mmap_size_(0)
+    mmap_size_(0),
+    wc_(nullptr),
+    wc_fd_(-1),
+    bulk_store_(bulk_store::qword)
     {}
 
     void * mmio_;
@@ -166,6 +224,9 @@ private:
     int fd_;
     fme(const std::string & resource, bool read_only);
     uint32_t mmap_size_;
+    void * wc_;
+    int wc_fd_;
+    bulk_store bulk_store_;
 };
 
 } // end of namespace fpga
@@ -0,0 +1,168 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "hssi_device.h"
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <exception>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+#include "dfh.h"
+#include "dfh_index.h"
+#include "fme.h"
+#include "hssi.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+namespace {
+
+const std::string fme_prefix = "intel-fpga-dev.";
+
+}  // end of anonymous namespace
+
+hssi_device::ptr_t hssi_device::open(const std::string& resource,
+                                     const std::string& name,
+                                     int8_t socket_id) {
+  fme::ptr_t f = fme::open(resource, socket_id);
+  if (!f) {
+    return ptr_t();
+  }
+
+  ptr_t dev = open(f, name);
+  dev->resource_ = resource;
+  dev->socket_id_ =
+      (f->ref()[fme::csr::fab_capability] &
+       static_cast<uint32_t>(fme::bitmask::socket_id)) ? 1 : 0;
+  return dev;
+}
+
+hssi_device::ptr_t hssi_device::open(mmio::ptr_t mmio,
+                                     const std::string& name) {
+  if (!mmio) {
+    return ptr_t();
+  }
+
+  ptr_t dev(new hssi_device());
+  dev->name_ = name;
+  dev->mmio_ = mmio;
+  dev->ctrl_ = static_cast<uint32_t>(fme_csr::hssi_ctrl);
+  dev->stat_ = static_cast<uint32_t>(fme_csr::hssi_stat);
+
+  dev->index_ = dfh_index::build(dev->mmio_);
+  const dfh_feature* hssi = dev->index_->find(hssi_dfh_id, dfh::priv);
+  if (hssi && hssi->rev == hssi_dfh_rev) {
+    dev->has_dfh_ = true;
+    dev->ctrl_ = hssi->offset + 0x08;
+    dev->stat_ = hssi->offset + 0x10;
+  }
+  return dev;
+}
+
+std::vector<hssi_device::ptr_t> hssi_device::enumerate(
+    const std::string& sysfs_class) {
+  std::vector<std::string> names;
+  DIR* dir = opendir(sysfs_class.c_str());
+  if (dir) {
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+      std::string name = entry->d_name;
+      if (name.compare(0, fme_prefix.size(), fme_prefix) == 0) {
+        names.push_back(name);
+      }
+    }
+    closedir(dir);
+  }
+
+  // intel-fpga-dev.2 before intel-fpga-dev.10
+  std::sort(names.begin(), names.end(),
+            [](const std::string& a, const std::string& b) {
+              return a.size() != b.size() ? a.size() < b.size() : a < b;
+            });
+
+  std::vector<ptr_t> devices;
+  for (const auto& name : names) {
+    ptr_t dev = open(sysfs_class + "/" + name + "/device/resource0", name);
+    if (dev) {
+      devices.push_back(dev);
+    }
+  }
+  return devices;
+}
+
+std::vector<device_result> run_on_devices(
+    const std::vector<hssi_device::ptr_t>& devices,
+    std::function<bool(const hssi_device::ptr_t& device, std::ostream& out,
+                       std::ostream& err)> job) {
+  std::vector<device_result> results(devices.size());
+  std::vector<std::thread> workers;
+  workers.reserve(devices.size());
+
+  size_t started = 0;
+  try {
+    for (; started < devices.size(); ++started) {
+      size_t i = started;
+      workers.emplace_back([&devices, &results, &job, i]() {
+        std::ostringstream out, err;
+        device_result& r = results[i];
+        r.device = devices[i];
+        try {
+          r.ok = job(devices[i], out, err);
+        } catch (const std::exception& e) {
+          err << "ERROR: " << e.what() << std::endl;
+          r.ok = false;
+        } catch (...) {
+          err << "ERROR: unknown exception" << std::endl;
+          r.ok = false;
+        }
+        r.output = out.str();
+        r.errors = err.str();
+      });
+    }
+  } catch (const std::system_error& e) {
+    // the workers started so far still use results: let them finish,
+    // and fail the devices left without one
+    for (size_t i = started; i < devices.size(); ++i) {
+      results[i].device = devices[i];
+      results[i].ok = false;
+      results[i].errors =
+          std::string("ERROR: could not start a worker: ") + e.what() + "\n";
+    }
+  }
+
+  for (auto& w : workers) {
+    w.join();
+  }
+  return results;
+}
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
@@ -0,0 +1,107 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "dfh_index.h"
+#include "hssi_przone.h"
+#include "mmio.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+/// @brief An FME with an HSSI controller, found through sysfs
+class hssi_device {
+ public:
+  typedef std::shared_ptr<hssi_device> ptr_t;
+
+  /// @brief Open every FME below sysfs_class (intel-fpga-dev.N) and
+  ///        locate its HSSI DFH. Devices that cannot be opened are skipped.
+  static std::vector<ptr_t> enumerate(
+      const std::string& sysfs_class = "/sys/class/fpga");
+
+  /// @brief Open one FME resource file, of socket_id unless it is -1
+  static ptr_t open(const std::string& resource, const std::string& name,
+                    int8_t socket_id = -1);
+
+  /// @brief Locate the HSSI DFH behind an MMIO space opened otherwise
+  ///        (a model, a trace replay or a traced FME)
+  static ptr_t open(mmio::ptr_t mmio, const std::string& name);
+
+  const std::string& name() const { return name_; }
+  const std::string& resource() const { return resource_; }
+  int socket_id() const { return socket_id_; }
+  /// @brief true if an HSSI DFH was found, otherwise ctrl/stat are the
+  ///        legacy FME offsets
+  bool has_hssi_dfh() const { return has_dfh_; }
+
+  mmio::ptr_t get_mmio() const { return mmio_; }
+  uint32_t get_ctrl() const { return ctrl_; }
+  uint32_t get_stat() const { return stat_; }
+  /// @brief The feature list of the FME, indexed when it was opened
+  dfh_index::ptr_t get_dfh_index() const { return index_; }
+
+ private:
+  hssi_device() : socket_id_(-1), has_dfh_(false), ctrl_(0), stat_(0) {}
+
+  std::string name_;
+  std::string resource_;
+  int socket_id_;
+  bool has_dfh_;
+  mmio::ptr_t mmio_;
+  dfh_index::ptr_t index_;
+  uint32_t ctrl_;
+  uint32_t stat_;
+};
+
+/// @brief Outcome of running a job on one device
+struct device_result {
+  hssi_device::ptr_t device;
+  bool ok;
+  std::string output;
+  std::string errors;
+};
+
+/// @brief Run job concurrently, one thread per device.
+///
+/// Each job writes to its own output and error streams, which are
+/// returned in device order so the caller can print them without
+/// interleaving. An exception thrown by a job fails that device only,
+/// and so does a worker thread that cannot be started.
+std::vector<device_result> run_on_devices(
+    const std::vector<hssi_device::ptr_t>& devices,
+    std::function<bool(const hssi_device::ptr_t& device, std::ostream& out,
+                       std::ostream& err)> job);
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
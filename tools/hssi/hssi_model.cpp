@@ -0,0 +1,615 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "hssi_model.h"
+
+#include "dfh.h"
+#include "hssi.h"
+#include "hssi_msg.h"
+#include "i2c.h"
+#include "mdio.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+namespace {
+
+const uint64_t ack_mask = 1UL << 32;
+const uint32_t page_size = 256;
+const uint32_t channel_select = 0xFF;
+const uint32_t retimer_devices[] = {0x30, 0x32, 0x34, 0x36};
+const uint32_t mac_offsets[] = {0xE0, 0xE8, 0xF0, 0xF8};
+
+// DFH fields, as decoded by dfh
+const uint64_t dfh_type_fiu = 0x4;
+
+uint64_t dfh_word(uint64_t type, uint64_t id, uint64_t next, bool end) {
+  return type << 60 | static_cast<uint64_t>(end) << 40 | next << 16 | id;
+}
+
+uint64_t mdio_key(uint32_t address) {
+  return address & (mdio_device_address_mask | mdio_port_address_mask |
+                    mdio_register_address_mask);
+}
+
+}  // namespace
+
+const uint32_t hssi_model::default_feature_offset;
+const uint32_t hssi_model::default_lanes;
+const uint32_t hssi_model::qsfp_device;
+const uint32_t hssi_model::eeprom_device;
+const uint32_t hssi_model::retimer_channels;
+const uint32_t hssi_model::firmware_version;
+
+hssi_model::hssi_model(const model_latency& latency, uint32_t lanes,
+                       uint32_t feature_offset)
+    : feature_offset_(feature_offset),
+      lanes_(lanes),
+      latency_(latency),
+      stats_(),
+      ctrl_word_(0),
+      ack_(false),
+      target_(false),
+      change_(),
+      stat_data_(0),
+      aux_(),
+      local_(),
+      args_(),
+      result_(0),
+      mode_(0),
+      enable_(1),
+      init_done_(true),
+      i2c_(),
+      i2c_instance_(0),
+      i2c_busy_until_(),
+      mdio_ctrl_(0),
+      mdio_address_(0),
+      mdio_rd_data_(0),
+      mdio_busy_until_() {
+  local_[controller::pll_locked_status] = 1;
+
+  for (auto& c : i2c_) {
+    c.device = nullptr;
+    c.state = i2c_controller::phase::idle;
+    c.addr_left = 0;
+    c.pointer = 0;
+    c.rddata = 0;
+    c.error = false;
+  }
+
+  // a QSFP+ module (SFF-8436 identifier 0x0D)
+  i2c_device qsfp = {std::vector<uint8_t>(page_size), 1, false};
+  qsfp.memory[0] = 0x0D;
+  i2c_[controller::i2c_instance_qsfp].devices[qsfp_device] = qsfp;
+
+  auto& bus = i2c_[controller::i2c_instance_retimer].devices;
+  for (uint32_t dev : retimer_devices) {
+    bus[dev] = {std::vector<uint8_t>(page_size * (retimer_channels + 1)), 1,
+                true};
+  }
+  bus[eeprom_device] = {std::vector<uint8_t>(page_size, 0xFF), 1, false};
+  for (uint32_t port = 0; port < 4; ++port) {
+    const uint8_t mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00,
+                            static_cast<uint8_t>(port)};
+    set_mac_address(port, mac);
+  }
+}
+
+model_latency hssi_model::no_latency() {
+  model_latency latency = {0, 0, 0, 0, 0};
+  return latency;
+}
+
+model_latency hssi_model::typical_latency() {
+  // a NIOS handshake of a few microseconds, 100 kHz I2C (nine bit times
+  // a byte) and a 2.5 MHz MDC clock (a 64 bit frame)
+  model_latency latency = {2000, 1000, 100000, 90000, 26000};
+  return latency;
+}
+
+bool hssi_model::parse_latency(const std::string& name,
+                               model_latency& latency) {
+  if (name == "none") {
+    latency = no_latency();
+  } else if (name == "typical") {
+    latency = typical_latency();
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool hssi_model::write_mmio32(uint32_t offset, uint32_t value) {
+  // the controller is driven through 64-bit accesses only
+  (void)offset;
+  (void)value;
+  return true;
+}
+
+bool hssi_model::write_mmio64(uint32_t offset, uint64_t value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (offset != ctrl_offset()) {
+    return true;
+  }
+
+  ctrl_word_ = value;
+  uint64_t extra_nsec = 0;
+  if (value) {
+    // a command before the last one was acknowledged and cleared
+    if (target_ || ack_) ++stats_.errors;
+    ++stats_.commands;
+    execute(value, extra_nsec);
+  }
+  target_ = value != 0;
+  change_ = after(latency_.ack_nsec + extra_nsec);
+  return true;
+}
+
+bool hssi_model::read_mmio32(uint32_t offset, uint32_t& value) {
+  uint64_t value64 = 0;
+  if (!read_mmio64(offset & ~0x7u, value64)) {
+    return false;
+  }
+  value = static_cast<uint32_t>(offset & 0x4 ? value64 >> 32 : value64);
+  return true;
+}
+
+bool hssi_model::read_mmio64(uint32_t offset, uint64_t& value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  value = 0;
+  if (offset == 0) {
+    value = dfh_word(dfh_type_fiu, 0, feature_offset_, false);
+  } else if (offset == feature_offset_) {
+    value = dfh_word(dfh::priv, hssi_dfh_id, 0, true);
+  } else if (offset == ctrl_offset()) {
+    value = ctrl_word_;
+  } else if (offset == stat_offset()) {
+    if (ack_ != target_ && !busy(change_)) ack_ = target_;
+    value = stat_data_ | (ack_ ? ack_mask : 0);
+  }
+  return true;
+}
+
+uint8_t* hssi_model::mmio_pointer(uint32_t offset) {
+  (void)offset;
+  return nullptr;
+}
+
+model_latency hssi_model::get_latency() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return latency_;
+}
+
+void hssi_model::set_latency(const model_latency& latency) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  latency_ = latency;
+}
+
+hssi_model::stats hssi_model::get_stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void hssi_model::reset_stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_ = stats();
+}
+
+uint32_t hssi_model::hssi_mode() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return mode_;
+}
+
+bool hssi_model::xcvr_register(uint32_t lane, uint32_t reg, uint32_t& value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = xcvr_.find(reg + controller::hssi_xcvr_lane_offset * lane);
+  if (it == xcvr_.end()) {
+    return false;
+  }
+  value = it->second;
+  return true;
+}
+
+uint32_t hssi_model::tx_eq(uint32_t lane, uint32_t setting) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = tx_eq_.find(lane << 16 | (setting & 0xFFFF));
+  return it == tx_eq_.end() ? 0 : it->second;
+}
+
+uint32_t hssi_model::przone_register(uint32_t address) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = przone_.find(address);
+  return it == przone_.end() ? 0 : it->second;
+}
+
+uint32_t hssi_model::mdio_register(uint32_t device_addr, uint32_t port_addr,
+                                   uint32_t reg_addr) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = mdio_.find(mdio_key(device_addr << mdio_device_address |
+                                port_addr << mdio_port_addres |
+                                reg_addr << mdio_register_address));
+  return it == mdio_.end() ? 0 : it->second;
+}
+
+bool hssi_model::i2c_peek(uint32_t instance, uint32_t device_addr,
+                          uint32_t byte_addr, uint8_t& value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  i2c_device* dev = find_device(instance, device_addr);
+  if (!dev || byte_addr >= dev->memory.size()) {
+    return false;
+  }
+  value = dev->memory[byte_addr];
+  return true;
+}
+
+bool hssi_model::i2c_poke(uint32_t instance, uint32_t device_addr,
+                          uint32_t byte_addr, uint8_t value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  i2c_device* dev = find_device(instance, device_addr);
+  if (!dev || byte_addr >= dev->memory.size()) {
+    return false;
+  }
+  dev->memory[byte_addr] = value;
+  return true;
+}
+
+void hssi_model::set_mac_address(uint32_t port, const uint8_t mac[6]) {
+  if (port >= sizeof(mac_offsets) / sizeof(mac_offsets[0])) {
+    return;
+  }
+  for (uint32_t i = 0; i < 6; ++i) {
+    i2c_poke(controller::i2c_instance_retimer, eeprom_device,
+             mac_offsets[port] + i, mac[i]);
+  }
+}
+
+void hssi_model::execute(uint64_t word, uint64_t& extra_nsec) {
+  uint32_t command = static_cast<uint32_t>(word >> 48);
+  uint32_t address = static_cast<uint32_t>(word >> 32) & 0xFFFF;
+  uint32_t data = static_cast<uint32_t>(word);
+
+  switch (command) {
+    case controller::hssi_cmd::aux_write:
+      ++stats_.aux_writes;
+      aux_write(address, data, extra_nsec);
+      break;
+    case controller::hssi_cmd::aux_read:
+      ++stats_.aux_reads;
+      if (address < aux_.size()) {
+        stat_data_ = aux_[address];
+      } else {
+        stat_data_ = 0;
+        ++stats_.errors;
+      }
+      break;
+    case controller::hssi_cmd::sw_write:
+      if (address == 1) {
+        extra_nsec += latency_.nios_nsec;
+        nios(data);
+      } else if (address >= 2 && address < 2 + args_.size()) {
+        args_[address - 2] = data;
+      } else {
+        ++stats_.errors;
+      }
+      break;
+    case controller::hssi_cmd::sw_read:
+      if (address == 6) {
+        stat_data_ = result_;
+      } else {
+        stat_data_ = 0;
+        ++stats_.errors;
+      }
+      break;
+    default:
+      ++stats_.errors;
+      break;
+  }
+}
+
+void hssi_model::aux_write(uint32_t address, uint32_t data,
+                           uint64_t& extra_nsec) {
+  if (address >= aux_.size()) {
+    ++stats_.errors;
+    return;
+  }
+  aux_[address] = data;
+
+  uint32_t bus_cmd = data >> 16;
+  uint32_t bus_addr = data & 0xFFFF;
+  switch (address) {
+    case controller::aux_bus::prmgmt_cmd:
+      if (bus_cmd == controller::bus_cmd::prmgmt_write) {
+        przone_write(bus_addr, aux_[controller::aux_bus::prmgmt_din]);
+      } else {
+        aux_[controller::aux_bus::prmgmt_dout] = przone_read(bus_addr);
+      }
+      break;
+    case controller::aux_bus::local_cmd:
+      if (bus_cmd == controller::bus_cmd::local_write) {
+        local_write(bus_addr, aux_[controller::aux_bus::local_din],
+                    extra_nsec);
+      } else {
+        aux_[controller::aux_bus::local_dout] = local_read(bus_addr);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void hssi_model::local_write(uint32_t address, uint32_t data,
+                             uint64_t& extra_nsec) {
+  if (address >= local_.size()) {
+    ++stats_.errors;
+    return;
+  }
+  local_[address] = data;
+  if (address != controller::local_bus::recfg_cmd_addr) {
+    return;
+  }
+
+  // a reconfiguration command: rcfg_write or rcfg_read << 16 | address
+  uint32_t reg = data & 0xFFFF;
+  extra_nsec += latency_.xcvr_nsec;
+  if (reg / controller::hssi_xcvr_lane_offset >= lanes_) {
+    ++stats_.errors;
+    local_[controller::local_bus::recfg_cmd_rddata] = 0;
+    return;
+  }
+
+  switch (data >> 16) {
+    case controller::bus_cmd::rcfg_write:
+      ++stats_.xcvr_writes;
+      xcvr_[reg] = local_[controller::local_bus::recfg_cmd_wrdata];
+      break;
+    case controller::bus_cmd::rcfg_read: {
+      ++stats_.xcvr_reads;
+      auto it = xcvr_.find(reg);
+      local_[controller::local_bus::recfg_cmd_rddata] =
+          it == xcvr_.end() ? 0 : it->second;
+      break;
+    }
+    default:
+      ++stats_.errors;
+      break;
+  }
+}
+
+uint32_t hssi_model::local_read(uint32_t address) {
+  if (address >= local_.size()) {
+    ++stats_.errors;
+    return 0;
+  }
+  return local_[address];
+}
+
+void hssi_model::nios(uint32_t func) {
+  ++stats_.nios_cmds;
+  result_ = 0;
+  switch (func) {
+    case controller::nios_cmd::change_hssi_mode:
+      mode_ = args_[0];
+      init_done_ = false;
+      break;
+    case controller::nios_cmd::hssi_init:
+      init_done_ = true;
+      break;
+    case controller::nios_cmd::hssi_init_done:
+      result_ = init_done_ ? 1 : 0;
+      break;
+    case controller::nios_cmd::fatal_err:
+      break;
+    case controller::nios_cmd::set_hssi_enable:
+      enable_ = args_[0];
+      break;
+    case controller::nios_cmd::get_hssi_enable:
+      result_ = enable_;
+      break;
+    case controller::nios_cmd::get_hssi_mode:
+      result_ = mode_;
+      break;
+    case controller::nios_cmd::tx_eq_write:
+      // lane, setting, value
+      tx_eq_[args_[0] << 16 | (args_[1] & 0xFFFF)] = args_[2];
+      break;
+    case controller::nios_cmd::tx_eq_read: {
+      auto it = tx_eq_.find(args_[0] << 16 | (args_[1] & 0xFFFF));
+      result_ = it == tx_eq_.end() ? 0 : it->second;
+      break;
+    }
+    case controller::nios_cmd::gbs_service_ena:
+      break;
+    case controller::nios_cmd::firmware_version:
+      result_ = firmware_version;
+      break;
+    default:
+      ++stats_.errors;
+      break;
+  }
+}
+
+void hssi_model::przone_write(uint32_t address, uint32_t data) {
+  ++stats_.przone_writes;
+  przone_[address] = data;
+  switch (address) {
+    case i2c_reg_ctrl_wrdata:
+      i2c_command(data);
+      break;
+    case mdio_ctrl_reg:
+      mdio_command(data);
+      break;
+    default:
+      break;
+  }
+}
+
+uint32_t hssi_model::przone_read(uint32_t address) {
+  ++stats_.przone_reads;
+  switch (address) {
+    case i2c_reg_stat_rddata: {
+      const i2c_controller& c = i2c_[i2c_instance_];
+      return (busy(i2c_busy_until_) ? i2c_stat_tx : 0) |
+             (c.error ? i2c_stat_error : 0) | (c.rddata & 0xFF);
+    }
+    case mdio_ctrl_reg:
+      return busy(mdio_busy_until_) ? mdio_ctrl_
+                                    : mdio_ctrl_ & ~(mdio_write | mdio_read);
+    case mdio_rd_data_reg:
+      return mdio_rd_data_;
+    default: {
+      auto it = przone_.find(address);
+      return it == przone_.end() ? 0 : it->second;
+    }
+  }
+}
+
+void hssi_model::i2c_command(uint32_t data) {
+  uint32_t instance = data >> i2c_ctrl_instance;
+  if (instance >= i2c_.size()) {
+    ++stats_.errors;
+    return;
+  }
+  if (!(data & i2c_ctrl_trigger)) {
+    return;
+  }
+
+  // one byte on the wire, whatever it turns out to be
+  ++stats_.i2c_bytes;
+  i2c_instance_ = instance;
+  i2c_busy_until_ = after(latency_.i2c_byte_nsec);
+
+  typedef i2c_controller::phase phase;
+  i2c_controller& c = i2c_[instance];
+  uint8_t byte = static_cast<uint8_t>(data);
+
+  if ((data & i2c_ctrl_transmit) && (data & i2c_ctrl_send_start)) {
+    // (repeated) START with the device address and direction
+    c.error = false;
+    c.device = find_device(instance, byte);
+    if (!c.device) {
+      c.error = true;
+      c.state = phase::idle;
+      ++stats_.errors;
+    } else if (byte & 1) {
+      c.state = phase::read;
+    } else {
+      c.state = phase::byte_address;
+      c.addr_left = c.device->addr_bytes;
+      c.pointer = 0;
+    }
+  } else if (data & i2c_ctrl_transmit) {
+    switch (c.state) {
+      case phase::byte_address:
+        c.pointer = c.pointer << 8 | byte;
+        if (--c.addr_left == 0) c.state = phase::write;
+        break;
+      case phase::write:
+        *i2c_byte(*c.device, c.pointer++) = byte;
+        break;
+      default:
+        c.error = true;
+        ++stats_.errors;
+        break;
+    }
+  } else if (c.state == phase::read) {
+    c.rddata = *i2c_byte(*c.device, c.pointer++);
+  } else {
+    c.error = true;
+    ++stats_.errors;
+  }
+
+  if (data & i2c_ctrl_send_stop) {
+    c.state = phase::idle;
+  }
+}
+
+void hssi_model::mdio_command(uint32_t ctrl) {
+  ++stats_.mdio_cmds;
+  mdio_ctrl_ = ctrl;
+  mdio_busy_until_ = after(latency_.mdio_nsec);
+
+  uint32_t wr_data = przone_[mdio_wr_data_reg];
+  uint32_t reg = ctrl & ~(mdio_write | mdio_read);
+  if (reg == mdio_address_reg) {
+    if (ctrl & mdio_write) mdio_address_ = wr_data;
+  } else if (reg == mdio_access_reg) {
+    if (ctrl & mdio_write) {
+      mdio_[mdio_key(mdio_address_)] = wr_data;
+    } else if (ctrl & mdio_read) {
+      auto it = mdio_.find(mdio_key(mdio_address_));
+      mdio_rd_data_ = it == mdio_.end() ? 0 : it->second;
+    }
+  } else {
+    ++stats_.errors;
+  }
+}
+
+uint8_t* hssi_model::retimer_byte(i2c_device& dev, uint32_t byte_addr) {
+  // the channel select register picks the page of the other registers
+  byte_addr %= page_size;
+  uint8_t* shared = &dev.memory[retimer_channels * page_size];
+  if (byte_addr == channel_select) {
+    return shared + channel_select;
+  }
+  uint32_t select = shared[channel_select];
+  uint32_t page = select >= 4 && select < 4 + retimer_channels
+                      ? select - 4
+                      : retimer_channels;
+  return &dev.memory[page * page_size + byte_addr];
+}
+
+uint8_t* hssi_model::i2c_byte(i2c_device& dev, uint32_t byte_addr) {
+  if (dev.retimer) {
+    return retimer_byte(dev, byte_addr);
+  }
+  return &dev.memory[byte_addr % dev.memory.size()];
+}
+
+hssi_model::i2c_device* hssi_model::find_device(uint32_t instance,
+                                                uint32_t device_addr) {
+  if (instance >= i2c_.size()) {
+    return nullptr;
+  }
+  auto it = i2c_[instance].devices.find(device_addr & 0xFE);
+  return it == i2c_[instance].devices.end() ? nullptr : &it->second;
+}
+
+bool hssi_model::busy(const clock::time_point& until) const {
+  // without latency no operation reads the clock
+  return until != clock::time_point() && clock::now() < until;
+}
+
+hssi_model::clock::time_point hssi_model::after(uint64_t nsec) const {
+  if (!nsec) {
+    return clock::time_point();
+  }
+  return clock::now() + std::chrono::nanoseconds(nsec);
+}
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
@@ -0,0 +1,225 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mmio.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+/// @brief Time the model takes for each kind of operation
+struct model_latency {
+  uint32_t ack_nsec;       ///< HSSI_CTRL write (or clear) to ack (or nack)
+  uint32_t xcvr_nsec;      ///< added to the ack of a reconfiguration access
+  uint32_t nios_nsec;      ///< added to the ack of a soft command
+  uint32_t i2c_byte_nsec;  ///< I2C controller busy per byte
+  uint32_t mdio_nsec;      ///< MDIO controller busy per command
+};
+
+/// @brief In-process model of the FME HSSI controller behind the mmio
+///        interface.
+///
+/// The model answers the HSSI_CTRL/HSSI_STAT handshake and executes the
+/// AUX bus commands behind it: the local bus with the transceiver
+/// reconfiguration registers of each lane and the PLL registers, the PR
+/// management bus with the I2C and MDIO controllers, and the NIOS soft
+/// commands. Instance 0 of the I2C controller holds a QSFP module at
+/// 0xA0, instance 1 the retimers at 0x30-0x36 and the EEPROM at 0xAE
+/// with the MAC addresses. A DFH list at offset 0 leads to the controller
+/// feature, so the feature walk finds HSSI_CTRL and HSSI_STAT as on an
+/// FPGA.
+///
+/// Acks, reconfiguration accesses, soft commands, I2C bytes and MDIO
+/// commands take the configured latency, so hssi-io and hssi_config can
+/// be benchmarked and stress-tested without a board. All accesses are
+/// serialized; mmio_pointer returns nullptr.
+class hssi_model : public mmio {
+ public:
+  typedef std::shared_ptr<hssi_model> ptr_t;
+
+  static const uint32_t default_feature_offset = 0x80;
+  static const uint32_t default_lanes = 16;
+  static const uint32_t qsfp_device = 0xA0;
+  static const uint32_t eeprom_device = 0xAE;
+  static const uint32_t retimer_channels = 4;
+  static const uint32_t firmware_version = 0x00010000;
+
+  struct stats {
+    uint64_t commands;      ///< words written to HSSI_CTRL
+    uint64_t aux_reads;
+    uint64_t aux_writes;
+    uint64_t xcvr_reads;
+    uint64_t xcvr_writes;
+    uint64_t przone_reads;
+    uint64_t przone_writes;
+    uint64_t nios_cmds;
+    uint64_t i2c_bytes;
+    uint64_t mdio_cmds;
+    uint64_t errors;        ///< unknown commands, lanes, devices and overruns
+  };
+
+  explicit hssi_model(const model_latency& latency = no_latency(),
+                      uint32_t lanes = default_lanes,
+                      uint32_t feature_offset = default_feature_offset);
+
+  /// @brief Every operation completes on the next poll
+  static model_latency no_latency();
+  /// @brief Timings in the range of a real board
+  static model_latency typical_latency();
+  /// @brief Parse none or typical
+  static bool parse_latency(const std::string& name, model_latency& latency);
+
+  bool write_mmio32(uint32_t offset, uint32_t value) override;
+  bool write_mmio64(uint32_t offset, uint64_t value) override;
+  bool read_mmio32(uint32_t offset, uint32_t& value) override;
+  bool read_mmio64(uint32_t offset, uint64_t& value) override;
+  uint8_t* mmio_pointer(uint32_t offset) override;
+
+  uint32_t ctrl_offset() const { return feature_offset_ + 0x08; }
+  uint32_t stat_offset() const { return feature_offset_ + 0x10; }
+
+  model_latency get_latency();
+  void set_latency(const model_latency& latency);
+
+  stats get_stats();
+  void reset_stats();
+
+  // Device state, for checking what a client did
+
+  uint32_t hssi_mode();
+  bool xcvr_register(uint32_t lane, uint32_t reg, uint32_t& value);
+  uint32_t tx_eq(uint32_t lane, uint32_t setting);
+  uint32_t przone_register(uint32_t address);
+  uint32_t mdio_register(uint32_t device_addr, uint32_t port_addr,
+                         uint32_t reg_addr);
+
+  /// @brief Access the memory of an I2C device. A retimer has a page of
+  ///        256 registers per channel, followed by the shared page that
+  ///        holds the channel select register (0xFF).
+  bool i2c_peek(uint32_t instance, uint32_t device_addr, uint32_t byte_addr,
+                uint8_t& value);
+  bool i2c_poke(uint32_t instance, uint32_t device_addr, uint32_t byte_addr,
+                uint8_t value);
+  bool retimer_register(uint32_t device_addr, uint32_t channel, uint32_t reg,
+                        uint8_t& value) {
+    return i2c_peek(1, device_addr, channel * 256 + reg, value);
+  }
+
+  /// @brief Program the MAC address of port (0-3) into the EEPROM
+  void set_mac_address(uint32_t port, const uint8_t mac[6]);
+
+ private:
+  typedef std::chrono::steady_clock clock;
+
+  struct i2c_device {
+    std::vector<uint8_t> memory;  ///< one page, or a page per channel
+    size_t addr_bytes;
+    bool retimer;
+  };
+
+  struct i2c_controller {
+    enum class phase { idle, byte_address, write, read };
+    std::map<uint32_t, i2c_device> devices;
+    i2c_device* device;
+    phase state;
+    size_t addr_left;
+    uint32_t pointer;
+    uint32_t rddata;
+    bool error;
+  };
+
+  void execute(uint64_t word, uint64_t& extra_nsec);
+  void aux_write(uint32_t address, uint32_t data, uint64_t& extra_nsec);
+  void local_write(uint32_t address, uint32_t data, uint64_t& extra_nsec);
+  uint32_t local_read(uint32_t address);
+  void nios(uint32_t func);
+  void przone_write(uint32_t address, uint32_t data);
+  uint32_t przone_read(uint32_t address);
+  void i2c_command(uint32_t data);
+  void mdio_command(uint32_t ctrl);
+
+  uint8_t* retimer_byte(i2c_device& dev, uint32_t byte_addr);
+  uint8_t* i2c_byte(i2c_device& dev, uint32_t byte_addr);
+  i2c_device* find_device(uint32_t instance, uint32_t device_addr);
+
+  bool busy(const clock::time_point& until) const;
+  clock::time_point after(uint64_t nsec) const;
+
+  uint32_t feature_offset_;
+  uint32_t lanes_;
+  model_latency latency_;
+  stats stats_;
+
+  // HSSI_CTRL/HSSI_STAT handshake
+  uint64_t ctrl_word_;
+  bool ack_;
+  bool target_;
+  clock::time_point change_;
+  uint32_t stat_data_;
+
+  std::array<uint32_t, 16> aux_;
+  std::array<uint32_t, 16> local_;
+  std::unordered_map<uint32_t, uint32_t> xcvr_;
+  std::unordered_map<uint32_t, uint32_t> przone_;
+
+  // NIOS
+  std::array<uint32_t, 4> args_;
+  uint32_t result_;
+  uint32_t mode_;
+  uint32_t enable_;
+  bool init_done_;
+  std::map<uint32_t, uint32_t> tx_eq_;
+
+  std::array<i2c_controller, 2> i2c_;
+  uint32_t i2c_instance_;  ///< instance of the last I2C command
+  clock::time_point i2c_busy_until_;
+
+  // MDIO
+  uint32_t mdio_ctrl_;
+  uint32_t mdio_address_;
+  uint32_t mdio_rd_data_;
+  clock::time_point mdio_busy_until_;
+  std::unordered_map<uint64_t, uint32_t> mdio_;
+
+  std::mutex mutex_;
+};
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
@@ -25,8 +25,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 #include "hssi_przone.h"
 #include "hssi_msg.h"
-#include <chrono>
-#include <thread>
+#include "latency.h"
 
 namespace intel
 {
@@ -38,132 +37,137 @@ namespace hssi
 using namespace intel::fpga;
 using namespace intel::fpga::hssi::controller;
 using namespace std;
-using namespace std::chrono;
 
 hssi_przone::hssi_przone(mmio::ptr_t mmio, uint32_t ctrl, uint32_t stat)
 : mmio_(mmio)
 , ctrl_(ctrl)
 , stat_(stat)
+, base_(nullptr)
+, priority_(arbiter::priority::normal)
+, breaker_limit_(default_breaker_limit)
+, timeouts_in_row_(0)
+, tripped_(false)
 {
+    // Use the mapping directly when the mmio has one; streams
+    // (e.g. C header generation) only see the virtual calls
+    if (mmio_)
+    {
+        base_ = mmio_->mmio_pointer(0);
+    }
 }
 
 bool hssi_przone::read(uint32_t address, uint32_t & value)
 {
-    hssi_ctrl msg;
+    trace_scope trace(trace_tag::przone_read);
+    latency_scope timer(latency_op::przone_read);
+    transaction tx;
+    tx.przone_read(address, &value);
+    return execute(tx);
+}
 
-    msg.clear();
-    msg.set_address(aux_bus::prmgmt_cmd);
-    msg.set_data(address);
-    msg.set_command(hssi_cmd::aux_write);
-    mmio_->write_mmio64(static_cast<uint32_t>(ctrl_), msg.data());
+bool hssi_przone::write(uint32_t address, uint32_t value)
+{
+    trace_scope trace(trace_tag::przone_write);
+    latency_scope timer(latency_op::przone_write);
+    transaction tx;
+    tx.przone_write(address, value);
+    return execute(tx);
+}
 
-    if (!hssi_ack())
+bool hssi_przone::execute(const transaction & tx, size_t * completed, uint32_t timeout_usec)
+{
+    trace_scope trace(trace_tag::transaction);
+    if (tripped_.load(std::memory_order_relaxed))
     {
+        if (completed)
+        {
+            *completed = 0;
+        }
         return false;
     }
-
-
-    msg.clear();
-    msg.set_address(aux_bus::prmgmt_dout);
-    msg.set_bus_command(bus_cmd::prmgmt_write, address);
-    msg.set_command(hssi_cmd::aux_read);
-    mmio_->write_mmio64(static_cast<uint32_t>(ctrl_), msg.data());
-
-    if (!hssi_ack())
+    if (timeout_usec == 0)
     {
-        return false;
+        timeout_usec = adaptive_timeout::get(latency_op::ack_wait, default_timeout_usec);
     }
 
+    arbiter::lease lease(arbiter_, priority_);
+    uint64_t timeouts = poll_.stats().timeouts;
+    bool ok = base_ ? mapped().execute(tx, completed, timeout_usec)
+                    : indirect().execute(tx, completed, timeout_usec);
+    count_timeout(poll_.stats().timeouts != timeouts, ok);
+    return ok;
+}
 
-    uint64_t hssi_value;
-    if (!mmio_->read_mmio64(static_cast<uint32_t>(stat_), hssi_value))
+void hssi_przone::count_timeout(bool timed_out, bool ok)
+{
+    if (ok)
     {
-        return false;
+        timeouts_in_row_.store(0, std::memory_order_relaxed);
+    }
+    else if (timed_out)
+    {
+        uint32_t limit = breaker_limit_.load(std::memory_order_relaxed);
+        if (timeouts_in_row_.fetch_add(1, std::memory_order_relaxed) + 1 >= limit && limit)
+        {
+            tripped_.store(true, std::memory_order_relaxed);
+        }
     }
-
-    value = static_cast<uint32_t>(hssi_value & 0x00000000FFFFFFFF);
-
-    return true;
 }
 
-bool hssi_przone::write(uint32_t address, uint32_t value)
+bool hssi_przone::wait_for_ack(ack_t response, uint32_t timeout_usec, uint32_t * duration)
 {
-    hssi_ctrl msg;
-
-    msg.clear();
-    msg.set_address(aux_bus::prmgmt_din);
-    msg.set_data(static_cast<uint32_t>(value));
-    msg.set_command(hssi_cmd::aux_write);
-    mmio_->write_mmio64(static_cast<uint32_t>(ctrl_), msg.data());
+    bool ack = response == ack_t::ack;
+    return base_ ? mapped().wait_for_ack(ack, timeout_usec, duration)
+                 : indirect().wait_for_ack(ack, timeout_usec, duration);
+}
 
-    if (!hssi_ack())
-    {
-        return false;
-    }
+bool hssi_przone::hssi_ack(uint32_t timeout_usec, uint32_t * duration)
+{
+    return base_ ? mapped().hssi_ack(timeout_usec, duration)
+                 : indirect().hssi_ack(timeout_usec, duration);
+}
 
+uint32_t hssi_przone::get_ctrl() const { return ctrl_; }
+uint32_t hssi_przone::get_stat() const { return stat_; }
 
-    msg.clear();
-    msg.set_address(aux_bus::prmgmt_cmd);
-    msg.set_bus_command(bus_cmd::prmgmt_write, address);
-    msg.set_command(hssi_cmd::aux_write);
-    mmio_->write_mmio64(static_cast<uint32_t>(ctrl_), msg.data());
+mmio::ptr_t hssi_przone::get_mmio() const { return mmio_; }
 
-    if (!hssi_ack())
-    {
-        return false;
-    }
+poller & hssi_przone::get_poller() { return poll_; }
 
-    return true;
+arbiter::lease hssi_przone::hold()
+{
+    return arbiter::lease(arbiter_, priority_);
 }
 
-bool hssi_przone::wait_for_ack(ack_t response, uint32_t timeout_usec, uint32_t * duration)
+void hssi_przone::set_arbiter(arbiter::ptr_t a, arbiter::priority p)
 {
-    uint64_t value = response == ack_t::ack ? 0 : 0xFFFF;
-    // write a little lambda to check the value based on response type we are
-    // waiting on
-    auto check_ack = [response](uint64_t v) -> bool
-    {
-        return response == ack_t::ack ?  (v & (1UL << ack_bit)) : (~v & (1UL << ack_bit));
-    };
-
-    auto begin  = high_resolution_clock::now();
-    auto delta = high_resolution_clock::now() - begin;
-    while (delta < microseconds(timeout_usec))
-    {
-        if (mmio_->read_mmio64(static_cast<uint32_t>(stat_), value) && check_ack(value))
-        {
-            if (duration)
-            {
-                *duration = duration_cast<microseconds>(delta).count();
-            }
+    arbiter_ = a;
+    priority_ = p;
+}
 
-            return true;
-        }
+arbiter::ptr_t hssi_przone::get_arbiter() const { return arbiter_; }
+arbiter::priority hssi_przone::get_priority() const { return priority_; }
 
-        std::this_thread::sleep_for(microseconds(10));
-        delta = high_resolution_clock::now() - begin;
-    }
-    return false;
+void hssi_przone::set_breaker_limit(uint32_t limit)
+{
+    breaker_limit_.store(limit, std::memory_order_relaxed);
 }
 
-bool hssi_przone::hssi_ack(uint32_t timeout_usec, uint32_t * duration)
+uint32_t hssi_przone::get_breaker_limit() const
 {
-    if (!wait_for_ack(ack_t::ack, timeout_usec, duration))
-    {
-        return false;
-    }
-    mmio_->write_mmio64(static_cast<uint32_t>(ctrl_), 0UL);
-    if (!wait_for_ack(ack_t::nack, timeout_usec, duration))
-    {
-        return false;
-    }
-    return true;
+    return breaker_limit_.load(std::memory_order_relaxed);
 }
 
-uint32_t hssi_przone::get_ctrl() const { return ctrl_; }
-uint32_t hssi_przone::get_stat() const { return stat_; }
+bool hssi_przone::tripped() const
+{
+    return tripped_.load(std::memory_order_relaxed);
+}
 
-mmio::ptr_t hssi_przone::get_mmio() const { return mmio_; }
+void hssi_przone::reset_breaker()
+{
+    timeouts_in_row_.store(0, std::memory_order_relaxed);
+    tripped_.store(false, std::memory_order_relaxed);
+}
 
 } // end of namespace hssi
 } // end of namespace fpga
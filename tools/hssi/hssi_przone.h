@@ -24,8 +24,13 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 #pragma once
+#include <atomic>
+
 #include "przone.h"
 #include "mmio.h"
+#include "mailbox.h"
+#include "poll.h"
+#include "transaction.h"
 
 namespace intel
 {
@@ -58,26 +63,79 @@ public:
 
     virtual bool read(uint32_t address, uint32_t & value);
     virtual bool write(uint32_t address, uint32_t value);
+    virtual arbiter::lease hold();
 
     /// @brief Perform the HSSI acknowledge routine
     ///        This will wait for an ack message, then write 0 to the HSSI_CTRL register.
     ///        Finally, this will wait for a nack message
     ///
     /// @return true if the routine completed successfully, false if any of the waits timed out
-    bool hssi_ack(uint32_t timeout_usec = 1000, uint32_t * duration = 0);
-    bool wait_for_ack(ack_t response, uint32_t timeout_usec = 1000, uint32_t * duration = 0);
+    bool hssi_ack(uint32_t timeout_usec = default_timeout_usec, uint32_t * duration = 0);
+    bool wait_for_ack(ack_t response, uint32_t timeout_usec = default_timeout_usec, uint32_t * duration = 0);
+
+    /// @brief Run the controller words of a transaction in order, doing
+    ///        the acknowledge routine after each one
+    ///
+    /// @param[in] tx The transaction
+    /// @param[out] completed Optional number of words acknowledged
+    /// @param[in] timeout_usec Timeout of each ack and nack wait; 0 learns
+    ///            it from the ack waits so far, at most default_timeout_usec
+    ///
+    /// @return true if every word was acknowledged and every read completed;
+    ///         false at once while the breaker is tripped
+    bool execute(const transaction & tx, size_t * completed = nullptr,
+                 uint32_t timeout_usec = 0);
 
     uint32_t get_ctrl() const;
     uint32_t get_stat() const;
     mmio::ptr_t get_mmio() const;
 
-private:
+    /// @brief The poller used to wait for ack/nack messages
+    poller & get_poller();
+
+    /// @brief Share the mailbox with other clients through a; every
+    ///        transaction and hold() then waits for its turn at priority p
+    void set_arbiter(arbiter::ptr_t a, arbiter::priority p = arbiter::priority::normal);
+    arbiter::ptr_t get_arbiter() const;
+    arbiter::priority get_priority() const;
+
+    /// @brief Trip the breaker after limit transactions in a row timed
+    ///        out (0 never trips it)
+    void set_breaker_limit(uint32_t limit);
+    uint32_t get_breaker_limit() const;
 
-    static const uint32_t ack_bit = 32;
+    /// @brief true once the mailbox stopped answering: the rest of a batch
+    ///        fails fast instead of waiting out every register
+    bool tripped() const;
+    void reset_breaker();
 
+    static const uint32_t default_timeout_usec = 1000;
+    static const uint32_t default_breaker_limit = 8;
+
+private:
     mmio::ptr_t mmio_;
     uint32_t ctrl_;
     uint32_t stat_;
+    uint8_t * base_;
+    poller poll_;
+    arbiter::ptr_t arbiter_;
+    arbiter::priority priority_;
+    std::atomic<uint32_t> breaker_limit_;
+    std::atomic<uint32_t> timeouts_in_row_;
+    std::atomic<bool> tripped_;
+
+    void count_timeout(bool timed_out, bool ok);
+
+    // the mailbox over the mapping (base_ set) or the virtual interface
+    mailbox<mapped_mmio> mapped()
+    {
+        return mailbox<mapped_mmio>(mapped_mmio(base_), ctrl_, stat_, poll_);
+    }
+
+    mailbox<virtual_mmio> indirect()
+    {
+        return mailbox<virtual_mmio>(virtual_mmio(mmio_.get()), ctrl_, stat_, poll_);
+    }
 
 };
 
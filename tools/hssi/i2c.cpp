@@ -24,9 +24,9 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 #include "i2c.h"
+#include "latency.h"
+#include "mmio_trace.h"
 #include <iostream>
-#include <chrono>
-#include <thread>
 
 namespace intel
 {
@@ -36,7 +36,6 @@ namespace hssi
 {
 
 using namespace std;
-using namespace std::chrono;
 
 i2c::i2c(przone_interface::ptr_t przone, size_t byte_addr_size)
 : przone_(przone)
@@ -54,26 +53,26 @@ bool i2c::send_byte_address(uint32_t instance, uint32_t byte_addr)
     // make sure we decrement the ptr before we start using it to dereference the byte
     while (ptr-- > base_ptr){
         ctrl = i2c_ctrl_trigger | i2c_ctrl_transmit;
-        przone_->write(i2c_reg_ctrl_wrdata, (instance << i2c_ctrl_instance) | ctrl | *ptr);
-        wait_for_i2c_tx();
+        transfer(instance, ctrl | *ptr);
     }
     return true;
 }
 
 bool i2c::read(uint32_t instance, uint32_t device_addr, uint32_t byte_addr, uint8_t bytes[], size_t read_bytes)
 {
+    trace_scope trace(trace_tag::i2c_read);
+    // the whole bus sequence, not word by word
+    arbiter::lease lease = przone_->hold();
     // 1. Set the device address and control bits (07) into I2C_CTRL_WDATA
     uint32_t ctrl = i2c_ctrl_trigger  | i2c_ctrl_transmit | i2c_ctrl_send_start;
-    przone_->write(i2c_reg_ctrl_wrdata, (instance << i2c_ctrl_instance) | ctrl | device_addr);
-    wait_for_i2c_tx();
+    transfer(instance, ctrl | device_addr);
 
     // 2. Set the byte address and control bits (03) into I2C_CTRL_WDATA
     send_byte_address(instance, byte_addr);
 
     // 3. Set the device address (as read) and control bits (07) into I2C_CTRL_WDATA
     ctrl = i2c_ctrl_trigger | i2c_ctrl_transmit | i2c_ctrl_send_start;
-    przone_->write(i2c_reg_ctrl_wrdata, (instance << i2c_ctrl_instance) | ctrl | device_addr | 1);
-    wait_for_i2c_tx();
+    transfer(instance, ctrl | device_addr | 1);
 
     // 4. Trigger the I2C byte read and ACK, writing control bits (09) into I2C_CTRL_WDATA
     ctrl = i2c_ctrl_trigger | i2c_ctrl_send_ack;
@@ -87,8 +86,7 @@ bool i2c::read(uint32_t instance, uint32_t device_addr, uint32_t byte_addr, uint
             ctrl = i2c_ctrl_trigger | i2c_ctrl_send_stop;
         }
 
-        przone_->write(i2c_reg_ctrl_wrdata, (instance << i2c_ctrl_instance) | ctrl);
-        wait_for_i2c_tx();
+        transfer(instance, ctrl);
 
         if(przone_->read(i2c_reg_stat_rddata, value))
         {
@@ -97,7 +95,7 @@ bool i2c::read(uint32_t instance, uint32_t device_addr, uint32_t byte_addr, uint
         else
         {
             std::cerr << "WARNING: Could not complete I2C read" << std::endl;
-            break;
+            return false;
         }
     }
     return true;
@@ -105,10 +103,11 @@ bool i2c::read(uint32_t instance, uint32_t device_addr, uint32_t byte_addr, uint
 
 bool i2c::write(uint32_t instance, uint32_t device_addr, uint32_t byte_addr, uint8_t bytes[], size_t write_bytes)
 {
+    trace_scope trace(trace_tag::i2c_write);
+    arbiter::lease lease = przone_->hold();
     uint32_t ctrl = i2c_ctrl_trigger  | i2c_ctrl_transmit | i2c_ctrl_send_start;
     // 1. Set the Device Address (30) and the control bits (07) into I2C_CTRL_WDATA
-    przone_->write(i2c_reg_ctrl_wrdata, (instance << i2c_ctrl_instance) | ctrl | device_addr);
-    wait_for_i2c_tx();
+    transfer(instance, ctrl | device_addr);
 
     // 2. Set the byte address and control bits (03) into I2C_CTRL_WDATA
     send_byte_address(instance, byte_addr);
@@ -123,40 +122,46 @@ bool i2c::write(uint32_t instance, uint32_t device_addr, uint32_t byte_addr, uin
             ctrl |= i2c_ctrl_send_stop;
         }
 
-        przone_->write(i2c_reg_ctrl_wrdata, (instance << i2c_ctrl_instance) | ctrl | bytes[i]);
-        wait_for_i2c_tx();
+        transfer(instance, ctrl | bytes[i]);
     }
     return true;
 }
 
+bool i2c::transfer(uint32_t instance, uint32_t ctrl)
+{
+    latency_scope timer(latency_op::i2c_byte);
+    przone_->write(i2c_reg_ctrl_wrdata, (instance << i2c_ctrl_instance) | ctrl);
+    return wait_for_i2c_tx();
+}
+
 bool i2c::wait_for_i2c_tx(uint32_t timeout_usec)
 {
-    auto begin  = high_resolution_clock::now();
+    if (timeout_usec == 0)
+    {
+        timeout_usec = adaptive_timeout::get(latency_op::i2c_byte, tx_timeout_usec);
+    }
     uint32_t stat;
-    while (true)
+    bool read_error = false;
+    bool done = poll_.wait([&]() -> poll_status
     {
-        auto delta = high_resolution_clock::now() - begin;
-        if (delta >= microseconds(timeout_usec))
-        {
-            log_.warn() << "Timed out waiting for I2C TX to stop" << std::endl;
-            return false;
-        }
-
         if (!przone_->read(i2c_reg_stat_rddata, stat))
         {
-            std::cerr << "ERROR: Waiting for i2c ready" << std::endl;
-            return false;
+            read_error = true;
+            return poll_status::error;
         }
 
-        if (~stat & i2c_stat_tx)
-        {
-            return true;
-        }
-        else
-        {
-            std::this_thread::sleep_for(microseconds(10));
-        }
+        return (~stat & i2c_stat_tx) ? poll_status::ready : poll_status::pending;
+    }, timeout_usec);
+
+    if (read_error)
+    {
+        std::cerr << "ERROR: Waiting for i2c ready" << std::endl;
+    }
+    else if (!done)
+    {
+        log_.warn() << "Timed out waiting for I2C TX to stop" << std::endl;
     }
+    return done;
 }
 
 } // end of namespace hssi
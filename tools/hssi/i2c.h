@@ -26,6 +26,7 @@
 #pragma once
 #include "przone.h"
 #include "log.h"
+#include "poll.h"
 
 namespace intel
 {
@@ -78,17 +79,24 @@ class i2c
 {
 public:
     typedef std::shared_ptr<i2c> ptr_t;
+    static const uint32_t tx_timeout_usec = 400;
     i2c(przone_interface::ptr_t przone, size_t byte_addr_size = 1);
     ~i2c(){}
     bool read(uint32_t instance, uint32_t device_addr, uint32_t byte_addr, uint8_t bytes[], std::size_t read_bytes);
     bool write(uint32_t instance, uint32_t device_addr, uint32_t byte_addr, uint8_t bytes[], std::size_t read_bytes);
-    bool wait_for_i2c_tx(uint32_t timeout_usec = 400);
+    /// @brief Wait for TX to stop; a timeout of 0 is learned from the
+    ///        bytes sent so far, at most tx_timeout_usec
+    bool wait_for_i2c_tx(uint32_t timeout_usec = 0);
+    poller & get_poller() { return poll_; }
 private:
     przone_interface::ptr_t przone_;
     intel::utils::logger log_;
     size_t byte_addr_size_;
+    poller poll_;
 
     bool send_byte_address(uint32_t instance, uint32_t byte_addr);
+    /// @brief Put one byte (or read one) on the bus and wait for TX to stop
+    bool transfer(uint32_t instance, uint32_t ctrl);
 };
 
 } // end of namespace hssi
@@ -0,0 +1,364 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "latency.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+namespace {
+
+const size_t op_count = static_cast<size_t>(latency_op::count);
+const unsigned sub_bits = 4;  // log2(sub_buckets)
+
+const char* const op_names[] = {"ack_wait",  "przone_read", "przone_write",
+                                "xcvr_read", "xcvr_write",  "i2c_byte",
+                                "mdio",      "nios"};
+
+// a counter only its thread writes: no read-modify-write needed
+inline void bump(std::atomic<uint64_t>& counter, uint64_t n) {
+  counter.store(counter.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+}
+
+// learned timeouts (usec, 0: the caller's ceiling) and the policy
+// that produced them
+std::atomic<uint32_t> learned[op_count];
+constexpr timeout_policy default_policy = {true, 99.9, 4.0, 200, 1000};
+std::mutex policy_mutex;
+timeout_policy policy = default_policy;
+
+}  // end of anonymous namespace
+
+const size_t latency_histogram::sub_buckets;
+const size_t latency_histogram::max_magnitude;
+const size_t latency_histogram::buckets;
+const uint32_t adaptive_timeout::refresh_calls;
+
+const char* latency_op_name(latency_op op) {
+  size_t i = static_cast<size_t>(op);
+  return i < op_count ? op_names[i] : "unknown";
+}
+
+latency_histogram::latency_histogram() { reset(); }
+
+void latency_histogram::record(uint64_t ticks) {
+  ++counts_[bucket(ticks)];
+  ++count_;
+  sum_ += ticks;
+  min_ = std::min(min_, ticks);
+  max_ = std::max(max_, ticks);
+}
+
+void latency_histogram::add(const latency_histogram& other) {
+  for (size_t b = 0; b < buckets; ++b) {
+    counts_[b] += other.counts_[b];
+  }
+  count_ += other.count_;
+  sum_ += other.sum_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+}
+
+void latency_histogram::reset() {
+  std::fill(counts_, counts_ + buckets, 0);
+  count_ = 0;
+  sum_ = 0;
+  min_ = std::numeric_limits<uint64_t>::max();
+  max_ = 0;
+}
+
+double latency_histogram::mean_usec() const {
+  return count_ ? to_usec(sum_) / count_ : 0.0;
+}
+
+double latency_histogram::min_usec() const {
+  return count_ ? to_usec(min_) : 0.0;
+}
+
+double latency_histogram::max_usec() const { return to_usec(max_); }
+
+double latency_histogram::percentile_usec(double p) const {
+  if (!count_) {
+    return 0.0;
+  }
+  uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * count_));
+  rank = std::max<uint64_t>(1, std::min(rank, count_));
+
+  uint64_t seen = 0;
+  for (size_t b = 0; b < buckets; ++b) {
+    seen += counts_[b];
+    if (seen >= rank) {
+      return to_usec(std::min(bucket_limit(b), max_));
+    }
+  }
+  return to_usec(max_);
+}
+
+size_t latency_histogram::bucket(uint64_t ticks) {
+  // exact below 2 * sub_buckets, then sub_buckets per power of two
+  if (ticks < 2 * sub_buckets) {
+    return static_cast<size_t>(ticks);
+  }
+  size_t magnitude = 63 - __builtin_clzll(ticks) - sub_bits;
+  if (magnitude > max_magnitude) {
+    return buckets - 1;
+  }
+  return magnitude * sub_buckets + static_cast<size_t>(ticks >> magnitude);
+}
+
+uint64_t latency_histogram::bucket_limit(size_t b) {
+  if (b < 2 * sub_buckets) {
+    return b;
+  }
+  size_t magnitude = b / sub_buckets - 1;
+  if (b == buckets - 1) {
+    return std::numeric_limits<uint64_t>::max();
+  }
+  uint64_t lower = static_cast<uint64_t>(b - magnitude * sub_buckets)
+                   << magnitude;
+  return lower + (1ULL << magnitude) - 1;
+}
+
+double latency_histogram::to_usec(uint64_t ticks) {
+  uint64_t hz = mmio_trace::tsc_hz();
+  return hz ? static_cast<double>(ticks) * 1e6 / hz : 0.0;
+}
+
+struct latency_recorder::per_thread {
+  std::atomic<uint64_t> counts[op_count][latency_histogram::buckets];
+  std::atomic<uint64_t> count[op_count];
+  std::atomic<uint64_t> sum[op_count];
+  std::atomic<uint64_t> min[op_count];
+  std::atomic<uint64_t> max[op_count];
+
+  per_thread() { clear(); }
+
+  void clear() {
+    for (size_t op = 0; op < op_count; ++op) {
+      for (auto& c : counts[op]) c.store(0, std::memory_order_relaxed);
+      count[op].store(0, std::memory_order_relaxed);
+      sum[op].store(0, std::memory_order_relaxed);
+      min[op].store(std::numeric_limits<uint64_t>::max(),
+                    std::memory_order_relaxed);
+      max[op].store(0, std::memory_order_relaxed);
+    }
+  }
+};
+
+struct latency_recorder::registry {
+  std::mutex mutex;
+  std::vector<per_thread*> live;
+  latency_histogram retired[op_count];
+};
+
+latency_recorder::registry& latency_recorder::shared() {
+  // never destroyed: threads may exit after static destructors ran
+  static registry* r = new registry();
+  return *r;
+}
+
+// registers the histograms of a thread, and folds them into the retired
+// ones when the thread exits
+struct latency_recorder::slot {
+  per_thread* histograms;
+
+  slot() : histograms(new per_thread()) {
+    registry& r = shared();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.live.push_back(histograms);
+  }
+
+  ~slot() {
+    registry& r = shared();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (size_t op = 0; op < op_count; ++op) {
+      merge(*histograms, op, r.retired[op]);
+    }
+    r.live.erase(std::remove(r.live.begin(), r.live.end(), histograms),
+                 r.live.end());
+    delete histograms;
+  }
+};
+
+latency_recorder::per_thread& latency_recorder::local() {
+  static thread_local slot s;
+  return *s.histograms;
+}
+
+void latency_recorder::record(latency_op op, uint64_t ticks) {
+  per_thread& t = local();
+  size_t i = static_cast<size_t>(op);
+  bump(t.counts[i][latency_histogram::bucket(ticks)], 1);
+  bump(t.count[i], 1);
+  bump(t.sum[i], ticks);
+  if (ticks < t.min[i].load(std::memory_order_relaxed)) {
+    t.min[i].store(ticks, std::memory_order_relaxed);
+  }
+  if (ticks > t.max[i].load(std::memory_order_relaxed)) {
+    t.max[i].store(ticks, std::memory_order_relaxed);
+  }
+}
+
+void latency_recorder::merge(const per_thread& t, size_t op,
+                             latency_histogram& h) {
+  for (size_t b = 0; b < latency_histogram::buckets; ++b) {
+    h.counts_[b] += t.counts[op][b].load(std::memory_order_relaxed);
+  }
+  h.count_ += t.count[op].load(std::memory_order_relaxed);
+  h.sum_ += t.sum[op].load(std::memory_order_relaxed);
+  h.min_ = std::min(h.min_, t.min[op].load(std::memory_order_relaxed));
+  h.max_ = std::max(h.max_, t.max[op].load(std::memory_order_relaxed));
+}
+
+latency_histogram latency_recorder::snapshot(latency_op op) {
+  size_t i = static_cast<size_t>(op);
+  registry& r = shared();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  latency_histogram h = r.retired[i];
+  for (const per_thread* t : r.live) {
+    merge(*t, i, h);
+  }
+  return h;
+}
+
+void latency_recorder::reset() {
+  registry& r = shared();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (per_thread* t : r.live) {
+    t->clear();
+  }
+  for (auto& h : r.retired) {
+    h.reset();
+  }
+}
+
+void latency_recorder::print(std::ostream& os) {
+  std::ios::fmtflags flags = os.flags();
+  os << std::left << std::setw(14) << "operation" << std::right
+     << std::setw(10) << "count" << std::setw(10) << "mean"
+     << std::setw(10) << "p50" << std::setw(10) << "p90"
+     << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+     << std::setw(10) << "max" << std::setw(10) << "timeout"
+     << "  (usec)" << std::endl;
+  os << std::fixed << std::setprecision(1);
+  for (size_t op = 0; op < op_count; ++op) {
+    latency_histogram h = snapshot(static_cast<latency_op>(op));
+    if (!h.count()) {
+      continue;
+    }
+    os << std::left << std::setw(14) << op_names[op] << std::right
+       << std::setw(10) << h.count() << std::setw(10) << h.mean_usec()
+       << std::setw(10) << h.percentile_usec(50.0)
+       << std::setw(10) << h.percentile_usec(90.0)
+       << std::setw(10) << h.percentile_usec(99.0)
+       << std::setw(10) << h.percentile_usec(99.9)
+       << std::setw(10) << h.max_usec() << std::setw(10);
+    uint32_t timeout = learned[op].load(std::memory_order_relaxed);
+    if (timeout) {
+      os << timeout << std::endl;
+    } else {
+      os << "-" << std::endl;
+    }
+  }
+  os.flags(flags);
+}
+
+uint32_t adaptive_timeout::get(latency_op op, uint32_t ceiling_usec) {
+  size_t i = static_cast<size_t>(op);
+  if (i >= op_count) {
+    return ceiling_usec;
+  }
+  // each thread refreshes on its own count: no shared counter to bounce
+  static thread_local uint32_t calls[op_count];
+  if (calls[i]++ % refresh_calls == 0) {
+    refresh(i);
+  }
+  uint32_t usec = learned[i].load(std::memory_order_relaxed);
+  return usec && usec < ceiling_usec ? usec : ceiling_usec;
+}
+
+uint32_t adaptive_timeout::learned_usec(latency_op op) {
+  size_t i = static_cast<size_t>(op);
+  return i < op_count ? learned[i].load(std::memory_order_relaxed) : 0;
+}
+
+void adaptive_timeout::refresh(size_t op) {
+  timeout_policy p = get_policy();
+  uint32_t usec = 0;
+  if (p.adaptive) {
+    latency_histogram h =
+        latency_recorder::snapshot(static_cast<latency_op>(op));
+    if (h.count() >= p.min_samples) {
+      double limit = std::ceil(p.factor * h.percentile_usec(p.percentile));
+      limit = std::max(limit, static_cast<double>(p.floor_usec));
+      usec = limit < std::numeric_limits<uint32_t>::max()
+                 ? static_cast<uint32_t>(limit)
+                 : std::numeric_limits<uint32_t>::max();
+    }
+  }
+  learned[op].store(usec, std::memory_order_relaxed);
+}
+
+timeout_policy adaptive_timeout::get_policy() {
+  std::lock_guard<std::mutex> lock(policy_mutex);
+  return policy;
+}
+
+void adaptive_timeout::set_policy(const timeout_policy& p) {
+  {
+    std::lock_guard<std::mutex> lock(policy_mutex);
+    policy = p;
+  }
+  for (auto& usec : learned) {
+    usec.store(0, std::memory_order_relaxed);
+  }
+}
+
+bool adaptive_timeout::parse(const std::string& name, timeout_policy& p) {
+  if (name == "adaptive") {
+    p = default_policy;
+  } else if (name == "static") {
+    p = default_policy;
+    p.adaptive = false;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
@@ -0,0 +1,177 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "mmio_trace.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+/// @brief The hssi-io operation classes that are timed
+enum class latency_op : uint8_t {
+  ack_wait,      ///< one ack or nack wait of the mailbox
+  przone_read,
+  przone_write,
+  xcvr_read,
+  xcvr_write,
+  i2c_byte,      ///< one byte on the I2C bus, until TX stops
+  mdio,          ///< one MDIO register read or write
+  nios,          ///< one NIOS soft command
+  count
+};
+
+const char* latency_op_name(latency_op op);
+
+/// @brief A log-linear (HDR-style) histogram of time stamp counter ticks.
+///
+/// Every power of two is split into 16 buckets, so a percentile is
+/// within 1/16 of the value it reports. Values from 2^41 ticks (over
+/// ten minutes) on share the last bucket.
+class latency_histogram {
+ public:
+  static const size_t sub_buckets = 16;
+  static const size_t max_magnitude = 36;
+  static const size_t buckets = (max_magnitude + 2) * sub_buckets;
+
+  latency_histogram();
+
+  void record(uint64_t ticks);
+  void add(const latency_histogram& other);
+  void reset();
+
+  uint64_t count() const { return count_; }
+  double mean_usec() const;
+  double min_usec() const;
+  double max_usec() const;
+  /// @brief The upper bound of the bucket holding the p-th percentile
+  ///        (0-100); 0 if nothing was recorded
+  double percentile_usec(double p) const;
+
+  static size_t bucket(uint64_t ticks);
+  /// @brief Largest value that falls into bucket b
+  static uint64_t bucket_limit(size_t b);
+  static double to_usec(uint64_t ticks);
+
+ private:
+  friend class latency_recorder;
+
+  uint64_t counts_[buckets];
+  uint64_t count_;
+  uint64_t sum_;
+  uint64_t min_;
+  uint64_t max_;
+};
+
+/// @brief Always-on latency statistics of the hssi-io operations.
+///
+/// Each thread records into histograms of its own, without locking;
+/// snapshot() merges them, including those of threads that exited.
+class latency_recorder {
+ public:
+  static void record(latency_op op, uint64_t ticks);
+
+  static latency_histogram snapshot(latency_op op);
+  /// @brief Clear every thread's histograms. Records made meanwhile by
+  ///        other threads may be lost.
+  static void reset();
+
+  /// @brief Print count, mean, percentiles, max and learned timeout of
+  ///        every operation class that was recorded
+  static void print(std::ostream& os);
+
+ private:
+  struct per_thread;
+  struct slot;
+  struct registry;
+
+  static per_thread& local();
+  static registry& shared();
+  static void merge(const per_thread& t, size_t op, latency_histogram& h);
+};
+
+/// @brief How the timeouts of the hssi-io waits are chosen
+struct timeout_policy {
+  bool adaptive;         ///< false: always wait the fixed (ceiling) timeout
+  double percentile;     ///< of the recorded latency (0-100)
+  double factor;         ///< safety factor applied to that percentile
+  uint32_t floor_usec;   ///< never wait less (scheduling noise)
+  uint64_t min_samples;  ///< wait the ceiling until this many were recorded
+};
+
+/// @brief Timeouts derived from the latency recorded so far.
+///
+/// A wait of an operation class lasts factor times the given percentile
+/// of that class, no less than the floor and no more than the fixed
+/// timeout the caller passes as ceiling. A healthy card answers well
+/// within that, while a wedged one costs a fraction of the fixed
+/// timeout per register. The learned value is refreshed every
+/// refresh_calls waits of a thread. Waits that timed out are recorded
+/// too, so a card that keeps timing out drifts back to the ceiling;
+/// the circuit breaker of hssi_przone is what cuts a wedged batch short.
+class adaptive_timeout {
+ public:
+  static const uint32_t refresh_calls = 256;
+
+  static uint32_t get(latency_op op, uint32_t ceiling_usec);
+  /// @brief The timeout learned for op; 0 while the ceiling applies
+  static uint32_t learned_usec(latency_op op);
+
+  static timeout_policy get_policy();
+  /// @brief Use policy from now on and forget what was learned
+  static void set_policy(const timeout_policy& policy);
+
+  /// @brief Parse static or adaptive into a policy using the default
+  ///        percentile, factor and floor
+  static bool parse(const std::string& name, timeout_policy& policy);
+
+ private:
+  static void refresh(size_t op);
+};
+
+/// @brief Time an operation until the end of the scope
+class latency_scope {
+ public:
+  explicit latency_scope(latency_op op) : op_(op), begin_(trace_tsc()) {}
+  ~latency_scope() { latency_recorder::record(op_, trace_tsc() - begin_); }
+
+ private:
+  latency_scope(const latency_scope&) = delete;
+  latency_scope& operator=(const latency_scope&) = delete;
+
+  latency_op op_;
+  uint64_t begin_;
+};
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
@@ -25,6 +25,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 #include "loopback.h"
 #include "accelerator_przone.h"
+#include <opae/cxx/core/properties.h>
 
 using namespace intel::utils;
 
@@ -48,6 +49,8 @@ loopback::loopback()
 , random_count_(false)
 , random_length_(false)
 , random_delay_(false)
+, przone_order_(accelerator_przone::ordering::spin)
+, przone_delay_nsec_(accelerator_przone::default_delay_nsec)
 , config_("hssi.json")
 , mode_("auto")
 {
@@ -65,6 +68,8 @@ loopback::loopback(const std::string & name)
 , random_count_(false)
 , random_length_(false)
 , random_delay_(false)
+, przone_order_(accelerator_przone::ordering::spin)
+, przone_delay_nsec_(accelerator_przone::default_delay_nsec)
 , config_("hssi.json")
 , mode_("auto")
 {
@@ -82,10 +87,31 @@ void loopback::assign(opae::fpga::types::handle::ptr_t accelerator)
     accelerator_ = accelerator;
     przone_.reset(new accelerator_przone(accelerator_));
     i2c_.reset(new i2c(przone_));
+    // image only the MAC address window, in a single burst
+    size_t mac_window = mac_offsets.back() + sizeof(uint8_t[6]) - mac_offsets.front();
+    eeprom_.reset(new eeprom_image(i2c_, 1, eeprom, mac_offsets.front(), mac_window, mac_window));
+}
+
+void loopback::eeprom_cache(const std::string & dir)
+{
+    auto props = opae::fpga::types::properties::get(accelerator_);
+    eeprom_->set_cache_file(eeprom_image::cache_file(dir,
+                                                     props->segment,
+                                                     props->bus,
+                                                     props->device,
+                                                     props->function,
+                                                     eeprom,
+                                                     mac_offsets.front()));
 }
 
 bool loopback::initialize()
 {
+    auto pz = std::dynamic_pointer_cast<accelerator_przone>(przone_);
+    if (pz)
+    {
+        pz->set_ordering(przone_order_, przone_delay_nsec_);
+    }
+
     uint64_t value = accelerator_->read_csr64(afu_init);
     if ((value & 0x2) == 0x2)
     {
@@ -159,16 +185,19 @@ std::vector<mac_address_t> loopback::get_mac_addresses()
 
 mac_address_t loopback::read_mac_address(uint32_t port)
 {
-    mac_address_t mac;
-    uint8_t *hi = reinterpret_cast<uint8_t*>(&mac.hi);
-    uint8_t *lo = reinterpret_cast<uint8_t*>(&mac.lo);
+    mac_address_t mac = { 0, 0 };
+    uint8_t bytes[6];
+
+    // the MAC window is read once (or taken from the cache file)
+    if (!eeprom_->read(mac_offsets[port], bytes, sizeof(bytes)))
+    {
+        std::cerr << "WARNING: Could not read MAC address from EEPROM" << std::endl;
+        return mac;
+    }
 
-    i2c_->read(1, eeprom, mac_offsets[port],   hi+1, 1);
-    i2c_->read(1, eeprom, mac_offsets[port]+1, hi,   1);
-    i2c_->read(1, eeprom, mac_offsets[port]+2, lo+3, 1);
-    i2c_->read(1, eeprom, mac_offsets[port]+3, lo+2, 1);
-    i2c_->read(1, eeprom, mac_offsets[port]+4, lo+1, 1);
-    i2c_->read(1, eeprom, mac_offsets[port]+5, lo,   1);
+    mac.hi = static_cast<uint32_t>(bytes[0]) << 8 | bytes[1];
+    mac.lo = static_cast<uint32_t>(bytes[2]) << 24 | static_cast<uint32_t>(bytes[3]) << 16
+           | static_cast<uint32_t>(bytes[4]) << 8  | bytes[5];
     return mac;
 }
 
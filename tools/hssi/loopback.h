@@ -31,7 +31,9 @@
 #include <chrono>
 #include <array>
 #include "przone.h"
+#include "accelerator_przone.h"
 #include "i2c.h"
+#include "eeprom_image.h"
 
 namespace intel
 {
@@ -131,6 +133,19 @@ public:
     virtual std::vector<mac_address_t> get_mac_addresses();
     mac_address_t read_mac_address(uint32_t port);
 
+    /// @brief Keep the EEPROM image in dir, keyed by PCI address, so
+    ///        later runs can skip reading it over I2C
+    void eeprom_cache(const std::string & dir);
+
+
+    /// @brief Choose how PR zone reads are ordered after the previous
+    ///        command; applied by initialize()
+    void przone_order(accelerator_przone::ordering order,
+                      uint32_t delay_nsec = accelerator_przone::default_delay_nsec)
+    {
+        przone_order_ = order;
+        przone_delay_nsec_ = delay_nsec;
+    }
 
     virtual bool initialize();
 
@@ -212,6 +227,7 @@ public:
 protected:
     przone_interface::ptr_t przone_;
     i2c::ptr_t i2c_;
+    eeprom_image::ptr_t eeprom_;
     std::string afu_id_;
     opae::fpga::types::handle::ptr_t accelerator_;
     bool continuous_;
@@ -221,6 +237,8 @@ protected:
     bool random_count_;
     bool random_length_;
     bool random_delay_;
+    accelerator_przone::ordering przone_order_;
+    uint32_t przone_delay_nsec_;
 
 private:
     std::string config_;
@@ -65,6 +65,9 @@ loopback_app::loopback_app()
     options_.add_option<uint32_t>("packet-delay",  'd', option::with_argument, "Delay between packets (in cycles)");
     options_.add_option<uint32_t>("packet-length", 'l', option::with_argument, "Length of packets (in bytes)");
     options_.add_option<bool>    ("random-length", 'r', option::no_argument, "Choose random packet length", false);
+    options_.add_option<std::string>("eeprom-cache"   , option::with_argument, "Directory to cache EEPROM images (MAC addresses) in");
+    options_.add_option<std::string>("przone-order"   , option::with_argument, "Ordering of PR zone reads - spin, fence, sleep", "spin");
+    options_.add_option<uint32_t>("przone-delay"      , option::with_argument, "Delay (nsec) before PR zone reads with spin or sleep ordering", accelerator_przone::default_delay_nsec);
     options_.add_option<bool>("help"                  , option::no_argument, "Show help message", false);
     options_.add_option<bool>("version",           'v', option::no_argument, "Show version", false);
 
@@ -106,12 +109,32 @@ void loopback_app::show_help()
 uint32_t loopback_app::run(loopback::ptr_t lpbk, const std::vector<std::string> & args)
 {
     lpbk_ = lpbk;
+
+    std::string order_name = "spin";
+    uint32_t delay_nsec = accelerator_przone::default_delay_nsec;
+    options_.get_value<std::string>("przone-order", order_name);
+    options_.get_value<uint32_t>("przone-delay", delay_nsec);
+    accelerator_przone::ordering order;
+    if (!accelerator_przone::parse(order_name, order))
+    {
+        std::cerr << "Invalid PR zone ordering: " << order_name << std::endl;
+        return EXIT_FAILURE;
+    }
+    lpbk_->przone_order(order, delay_nsec);
+
     if (!lpbk_->initialize())
     {
         std::cerr << "Error initializing accelerator" << std::endl;
         return EXIT_FAILURE;
     }
 
+    std::string eeprom_dir;
+    if (options_["eeprom-cache"] && options_["eeprom-cache"]->is_set() &&
+        options_.get_value<std::string>("eeprom-cache", eeprom_dir))
+    {
+        lpbk_->eeprom_cache(eeprom_dir);
+    }
+
     if (args.size() == 0)
     {
         std::cerr << "No commands specified" << std::endl;
@@ -0,0 +1,156 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "latency.h"
+#include "mmio.h"
+#include "mmio_trace.h"
+#include "poll.h"
+#include "transaction.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+// An MMIO policy is any copyable type with
+//   bool read64(uint32_t offset, uint64_t& value);
+//   bool write64(uint32_t offset, uint64_t value);
+// mailbox<Policy> runs the HSSI_CTRL/HSSI_STAT handshake over it with
+// no virtual call, so mapped_mmio inlines to plain volatile accesses.
+
+/// @brief Direct access to an mmapped register space
+class mapped_mmio {
+ public:
+  explicit mapped_mmio(uint8_t* base) : base_(base) {}
+
+  bool read64(uint32_t offset, uint64_t& value) const {
+    value = *reinterpret_cast<volatile uint64_t*>(base_ + offset);
+    return true;
+  }
+
+  bool write64(uint32_t offset, uint64_t value) const {
+    *reinterpret_cast<volatile uint64_t*>(base_ + offset) = value;
+    return true;
+  }
+
+ private:
+  uint8_t* base_;
+};
+
+/// @brief Adapter to the virtual mmio interface, for mmio_stream and
+///        test doubles that have no mapping
+class virtual_mmio {
+ public:
+  explicit virtual_mmio(mmio* io) : io_(io) {}
+
+  bool read64(uint32_t offset, uint64_t& value) const {
+    return io_->read_mmio64(offset, value);
+  }
+
+  bool write64(uint32_t offset, uint64_t value) const {
+    return io_->write_mmio64(offset, value);
+  }
+
+ private:
+  mmio* io_;
+};
+
+/// @brief The HSSI controller mailbox over an MMIO policy
+template <typename Policy>
+class mailbox {
+ public:
+  static const uint32_t ack_bit = 32;
+
+  mailbox(Policy io, uint32_t ctrl, uint32_t stat, poller& poll)
+      : io_(io), ctrl_(ctrl), stat_(stat), poll_(poll) {}
+
+  /// @brief Wait for the ack bit to be asserted (ack) or de-asserted
+  ///        A failed status read counts as not there yet.
+  bool wait_for_ack(bool ack, uint32_t timeout_usec,
+                    uint32_t* duration = nullptr) {
+    const uint64_t mask = 1UL << ack_bit;
+    trace_ack_scope trace;
+    latency_scope timer(latency_op::ack_wait);
+    return poll_.wait([&]() -> poll_status {
+      uint64_t value;
+      if (io_.read64(stat_, value) && ((value & mask) != 0) == ack) {
+        return poll_status::ready;
+      }
+      return poll_status::pending;
+    }, timeout_usec, duration);
+  }
+
+  /// @brief Wait for an ack, clear HSSI_CTRL and wait for the nack
+  bool hssi_ack(uint32_t timeout_usec, uint32_t* duration = nullptr) {
+    return wait_for_ack(true, timeout_usec, duration) &&
+           io_.write64(ctrl_, 0UL) &&
+           wait_for_ack(false, timeout_usec, duration);
+  }
+
+  /// @brief Write each controller word of tx and acknowledge it, reading
+  ///        HSSI_STAT[31:0] into the step's result after the nack
+  bool execute(const transaction& tx, size_t* completed,
+               uint32_t timeout_usec) {
+    size_t done = 0;
+    bool ok = true;
+
+    for (const transaction::step& s : tx) {
+      if (!io_.write64(ctrl_, s.ctrl) || !hssi_ack(timeout_usec)) {
+        ok = false;
+        break;
+      }
+
+      if (s.result) {
+        uint64_t value;
+        if (!io_.read64(stat_, value)) {
+          ok = false;
+          break;
+        }
+        *s.result = static_cast<uint32_t>(value & 0x00000000FFFFFFFF);
+      }
+      ++done;
+    }
+
+    if (completed) {
+      *completed = done;
+    }
+    return ok;
+  }
+
+ private:
+  Policy io_;
+  uint32_t ctrl_;
+  uint32_t stat_;
+  poller& poll_;
+};
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
@@ -24,6 +24,8 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 #include "mdio.h"
+#include "latency.h"
+#include "mmio_trace.h"
 #include <iostream>
 #include <chrono>
 #include <thread>
@@ -38,44 +40,131 @@ namespace hssi
 using namespace std;
 using namespace std::chrono;
 
-const uint64_t mdio_delay_usec = 1000;
-
-mdio::mdio(przone_interface::ptr_t przone)
+mdio::mdio(przone_interface::ptr_t przone, shadow_cache::ptr_t cache)
 : przone_(przone)
+, cache_(cache)
 {
+    settle_usec_.fill(0);
+}
+
+void mdio::set_settle_usec(uint8_t device_addr, uint32_t usec)
+{
+    settle_usec_[device_addr % max_devices] = usec;
+}
+
+uint32_t mdio::get_settle_usec(uint8_t device_addr) const
+{
+    return settle_usec_[device_addr % max_devices];
 }
 
 bool mdio::write(uint8_t device_addr, uint8_t port_addr, uint16_t reg_addr, uint32_t value)
 {
+    trace_scope trace(trace_tag::mdio_write);
+    // never skipped: a PHY register may have changed since it was last
+    // written, and control bits such as resets clear themselves
+    bool ok = write_hw(device_addr, port_addr, reg_addr, value);
+    if (cache_)
+    {
+        uint64_t key = shadow_cache::mdio_key(device_addr, port_addr, reg_addr);
+        if (ok)
+        {
+            cache_->update(shadow_cache::target::mdio, key, value);
+        }
+        else
+        {
+            cache_->erase(shadow_cache::target::mdio, key);
+        }
+    }
+    return ok;
+}
+
+bool mdio::read(uint8_t device_addr, uint8_t port_addr, uint16_t reg_addr, uint32_t &value)
+{
+    trace_scope trace(trace_tag::mdio_read);
+    // PHY status and counter registers change on their own, so reads
+    // always go to the device
+    if (!read_hw(device_addr, port_addr, reg_addr, value))
+    {
+        return false;
+    }
+    if (cache_)
+    {
+        cache_->update(shadow_cache::target::mdio,
+                       shadow_cache::mdio_key(device_addr, port_addr, reg_addr), value);
+    }
+    return true;
+}
+
+size_t mdio::read(std::vector<mdio_register> & registers)
+{
+    size_t count = 0;
+    for (auto & reg : registers)
+    {
+        if (!read(reg.device_addr, reg.port_addr, reg.reg_addr, reg.value))
+        {
+            break;
+        }
+        ++count;
+    }
+    return count;
+}
+
+size_t mdio::write(const std::vector<mdio_register> & registers)
+{
+    size_t count = 0;
+    for (const auto & reg : registers)
+    {
+        if (!write(reg.device_addr, reg.port_addr, reg.reg_addr, reg.value))
+        {
+            break;
+        }
+        ++count;
+    }
+    return count;
+}
+
+bool mdio::command(uint8_t device_addr, uint32_t ctrl)
+{
+    przone_->write(mdio_ctrl_reg, ctrl);
+    uint32_t settle = get_settle_usec(device_addr);
+    if (settle)
+    {
+        std::this_thread::sleep_for(microseconds(settle));
+    }
+    return wait_for_mdio_tx();
+}
+
+bool mdio::write_hw(uint8_t device_addr, uint8_t port_addr, uint16_t reg_addr, uint32_t value)
+{
+    latency_scope timer(latency_op::mdio);
+    arbiter::lease lease = przone_->hold();
     uint32_t addr = (mdio_device_address_mask & (device_addr << mdio_device_address))
                   | (mdio_port_address_mask & (port_addr << mdio_port_addres))
                   | (mdio_register_address_mask & (reg_addr << mdio_register_address));
 
     przone_->write(mdio_wr_data_reg,  addr); //Write contents of MDIO addr reg
-    przone_->write(mdio_ctrl_reg, mdio_write | mdio_address_reg); //Write request to MDIO addr reg
-    std::this_thread::sleep_for(microseconds(mdio_delay_usec));
-    wait_for_mdio_tx();
+    if (!command(device_addr, mdio_write | mdio_address_reg)) //Write request to MDIO addr reg
+    {
+        return false;
+    }
     przone_->write(mdio_wr_data_reg, value); //Write contents of MDIO data reg
-    przone_->write(mdio_ctrl_reg, mdio_write | mdio_access_reg); //Write request for data reg
-    std::this_thread::sleep_for(microseconds(mdio_delay_usec));
-    wait_for_mdio_tx();
-
-    return true;
+    return command(device_addr, mdio_write | mdio_access_reg); //Write request for data reg
 }
 
-bool mdio::read(uint8_t device_addr, uint8_t port_addr, uint16_t reg_addr, uint32_t &value)
+bool mdio::read_hw(uint8_t device_addr, uint8_t port_addr, uint16_t reg_addr, uint32_t &value)
 {
+    latency_scope timer(latency_op::mdio);
+    arbiter::lease lease = przone_->hold();
     uint32_t addr = (mdio_device_address_mask & (device_addr << mdio_device_address))
                   | (mdio_port_address_mask & (port_addr << mdio_port_addres))
                   | (mdio_register_address_mask & (reg_addr << mdio_register_address));
 
     przone_->write(mdio_wr_data_reg,  addr); //Write contents of MDIO addr reg
-    przone_->write(mdio_ctrl_reg, mdio_write | mdio_address_reg); //Write request to MDIO addr reg
-    std::this_thread::sleep_for(microseconds(mdio_delay_usec));
-    wait_for_mdio_tx();
-    przone_->write(mdio_ctrl_reg, mdio_read | mdio_access_reg); //Write read request for data
-    std::this_thread::sleep_for(microseconds(mdio_delay_usec));
-    wait_for_mdio_tx();
+    if (!command(device_addr, mdio_write | mdio_address_reg) || //Write request to MDIO addr reg
+        !command(device_addr, mdio_read | mdio_access_reg))     //Write read request for data
+    {
+        return false;
+    }
 
     uint32_t temp;
     if(przone_->read(mdio_rd_data_reg, temp))
@@ -85,6 +174,7 @@ bool mdio::read(uint8_t device_addr, uint8_t port_addr, uint16_t reg_addr, uint3
     else
     {
         std::cerr << "WARNING: Could not complete MDIO read" << std::endl;
+        return false;
     }
 
     return true;
@@ -92,32 +182,33 @@ bool mdio::read(uint8_t device_addr, uint8_t port_addr, uint16_t reg_addr, uint3
 
 bool mdio::wait_for_mdio_tx(uint32_t timeout_usec)
 {
-    auto begin  = high_resolution_clock::now();
+    if (timeout_usec == 0)
+    {
+        timeout_usec = adaptive_timeout::get(latency_op::mdio, tx_timeout_usec);
+    }
     uint32_t stat;
-    while (true)
+    bool read_error = false;
+    bool done = poll_.wait([&]() -> poll_status
     {
-        auto delta = high_resolution_clock::now() - begin;
-        if (delta >= microseconds(timeout_usec))
-        {
-            log_.warn() << "Timed out waiting for MDIO TX to stop" << std::endl;
-            return false;
-        }
-
         if (!przone_->read(mdio_ctrl_reg, stat))
         {
-            std::cerr << "ERROR: Waiting for MDIO ready" << std::endl;
-            return false;
+            read_error = true;
+            return poll_status::error;
         }
 
-        if ((~stat & mdio_write) && (~stat & mdio_read))
-        {
-            return true;
-        }
-        else
-        {
-            std::this_thread::sleep_for(microseconds(10));
-        }
+        return ((~stat & mdio_write) && (~stat & mdio_read)) ?
+               poll_status::ready : poll_status::pending;
+    }, timeout_usec);
+
+    if (read_error)
+    {
+        std::cerr << "ERROR: Waiting for MDIO ready" << std::endl;
+    }
+    else if (!done)
+    {
+        log_.warn() << "Timed out waiting for MDIO TX to stop" << std::endl;
     }
+    return done;
 }
 
 } // end of namespace hssi
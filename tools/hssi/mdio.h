@@ -24,8 +24,12 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 #pragma once
+#include <array>
+#include <vector>
 #include "przone.h"
 #include "log.h"
+#include "poll.h"
+#include "shadow_cache.h"
 
 namespace intel
 {
@@ -55,18 +59,57 @@ enum mdio_ctrl
     mdio_register_address_mask  = 0xFFFF0000
 };
 
+/// @brief One clause-45 register of a bulk MDIO access
+struct mdio_register
+{
+    uint8_t  device_addr;
+    uint8_t  port_addr;
+    uint16_t reg_addr;
+    uint32_t value;
+};
+
 class mdio
 {
 public:
     typedef std::shared_ptr<mdio> ptr_t;
-    mdio(przone_interface::ptr_t przone);
+    static const size_t max_devices = 32;
+    static const uint32_t tx_timeout_usec = 500;
+
+    mdio(przone_interface::ptr_t przone, shadow_cache::ptr_t cache = shadow_cache::ptr_t());
     ~mdio(){}
     bool read(uint8_t device_addr, uint8_t port_addr, uint16_t reg_addr, uint32_t &value);
     bool write(uint8_t device_addr, uint8_t port_addr, uint16_t reg_addr, uint32_t value);
-    bool wait_for_mdio_tx(uint32_t timeout_usec = 500);
+
+    /// @brief Read each register of registers into its value, in order
+    ///
+    /// @return The number of registers read before the first failure
+    size_t read(std::vector<mdio_register> & registers);
+
+    /// @brief Write the value of each register of registers, in order
+    ///
+    /// @return The number of registers written before the first failure
+    size_t write(const std::vector<mdio_register> & registers);
+
+    /// @brief Wait for the command to complete; a timeout of 0 is learned
+    ///        from the MDIO accesses so far, at most tx_timeout_usec
+    bool wait_for_mdio_tx(uint32_t timeout_usec = 0);
+    poller & get_poller() { return poll_; }
+
+    /// @brief Minimum time to wait after each MDIO command to a device
+    ///        before polling for its completion (0, the default, polls at once)
+    void set_settle_usec(uint8_t device_addr, uint32_t usec);
+    uint32_t get_settle_usec(uint8_t device_addr) const;
 private:
     przone_interface::ptr_t przone_;
     intel::utils::logger log_;
+    poller poll_;
+    shadow_cache::ptr_t cache_;
+    std::array<uint32_t, max_devices> settle_usec_;
+
+    bool command(uint8_t device_addr, uint32_t ctrl);
+
+    bool write_hw(uint8_t device_addr, uint8_t port_addr, uint16_t reg_addr, uint32_t value);
+    bool read_hw(uint8_t device_addr, uint8_t port_addr, uint16_t reg_addr, uint32_t &value);
 };
 
 } // end of namespace hssi
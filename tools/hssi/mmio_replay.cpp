@@ -0,0 +1,210 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "mmio_replay.h"
+
+#include <sstream>
+#include <thread>
+
+#include "poll.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+namespace {
+
+const char* const access_names[] = {"read32", "read64", "write32", "write64"};
+
+std::string describe(trace_access access, uint32_t offset, uint64_t value) {
+  std::ostringstream s;
+  s << access_names[static_cast<size_t>(access)] << " 0x" << std::hex
+    << offset << " = 0x" << value;
+  return s.str();
+}
+
+std::string describe(const trace_record& rec) {
+  return describe(static_cast<trace_access>(rec.access & 0x3), rec.offset,
+                  rec.value);
+}
+
+bool is_read(const trace_record& rec) {
+  return rec.access == static_cast<uint8_t>(trace_access::read32) ||
+         rec.access == static_cast<uint8_t>(trace_access::read64);
+}
+
+uint64_t read_key(trace_access access, uint32_t offset) {
+  return static_cast<uint64_t>(offset) << 8 | static_cast<uint8_t>(access);
+}
+
+}  // end of anonymous namespace
+
+mmio_replay::mmio_replay(const std::vector<trace_record>& records,
+                         uint64_t tsc_hz, timing pace)
+    : records_(records),
+      tsc_hz_(tsc_hz),
+      timing_(tsc_hz ? pace : timing::none),
+      pos_(0),
+      started_(false),
+      stats_() {}
+
+mmio_replay::ptr_t mmio_replay::open(const std::string& path, timing pace,
+                                     std::string& error) {
+  trace_file trace;
+  if (!trace.load(path, error)) {
+    return ptr_t();
+  }
+  return ptr_t(new mmio_replay(trace.records, trace.header.tsc_hz, pace));
+}
+
+bool mmio_replay::write_mmio32(uint32_t offset, uint32_t value) {
+  return write(trace_access::write32, offset, value);
+}
+
+bool mmio_replay::write_mmio64(uint32_t offset, uint64_t value) {
+  return write(trace_access::write64, offset, value);
+}
+
+bool mmio_replay::read_mmio32(uint32_t offset, uint32_t& value) {
+  uint64_t v = 0;
+  bool ok = read(trace_access::read32, offset, v);
+  value = static_cast<uint32_t>(v);
+  return ok;
+}
+
+bool mmio_replay::read_mmio64(uint32_t offset, uint64_t& value) {
+  return read(trace_access::read64, offset, value);
+}
+
+uint8_t* mmio_replay::mmio_pointer(uint32_t offset) {
+  (void)offset;
+  return nullptr;
+}
+
+bool mmio_replay::finished() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  skip_polls();
+  return pos_ == records_.size();
+}
+
+void mmio_replay::skip_polls() {
+  while (pos_ < records_.size() && is_read(records_[pos_]) &&
+         (records_[pos_].flags & trace_ack_poll)) {
+    const trace_record& rec = records_[pos_++];
+    last_poll_[read_key(static_cast<trace_access>(rec.access), rec.offset)] =
+        rec.value;
+    ++stats_.skipped_polls;
+  }
+}
+
+void mmio_replay::pace(const trace_record& rec) {
+  if (timing_ != timing::recorded) {
+    return;
+  }
+  if (!started_) {
+    started_ = true;
+    start_ = clock::now();
+  }
+  uint64_t ticks = rec.tsc - records_.front().tsc;
+  clock::time_point due =
+      start_ + std::chrono::nanoseconds(ticks * 1000000000ULL / tsc_hz_);
+  while (clock::now() < due) {
+    poller::pause();
+  }
+}
+
+void mmio_replay::mismatch(const std::string& message) {
+  ++stats_.mismatches;
+  if (messages_.size() < max_messages) {
+    std::ostringstream s;
+    s << "record " << pos_ << ": " << message;
+    messages_.push_back(s.str());
+  }
+}
+
+bool mmio_replay::write(trace_access access, uint32_t offset, uint64_t value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.writes;
+  skip_polls();
+  if (pos_ == records_.size()) {
+    mismatch(describe(access, offset, value) + " past the end of the trace");
+    return false;
+  }
+
+  const trace_record& rec = records_[pos_];
+  if (rec.access != static_cast<uint8_t>(access) || rec.offset != offset) {
+    mismatch(describe(access, offset, value) + ", recorded " + describe(rec));
+    return false;
+  }
+
+  // the bus sees the write either way; keep following the trace
+  pace(rec);
+  ++pos_;
+  if (rec.value != value) {
+    mismatch(describe(access, offset, value) + ", recorded value differs: " +
+             describe(rec));
+  }
+  return !(rec.flags & trace_failed);
+}
+
+bool mmio_replay::read(trace_access access, uint32_t offset, uint64_t& value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.reads;
+  uint64_t key = read_key(access, offset);
+
+  if (pos_ < records_.size()) {
+    const trace_record& rec = records_[pos_];
+    if (rec.access == static_cast<uint8_t>(access) && rec.offset == offset) {
+      pace(rec);
+      ++pos_;
+      value = rec.value;
+      if (rec.flags & trace_ack_poll) {
+        last_poll_[key] = value;
+      } else {
+        last_poll_.erase(key);
+      }
+      return !(rec.flags & trace_failed);
+    }
+  }
+
+  // polling longer than recorded: the register still reads the same; any
+  // other read the trace does not have is a divergence
+  auto it = last_poll_.find(key);
+  if (it != last_poll_.end()) {
+    ++stats_.repeated_polls;
+    value = it->second;
+    return true;
+  }
+
+  value = 0;
+  mismatch(describe(access, offset, 0) + (pos_ < records_.size()
+               ? ", recorded " + describe(records_[pos_])
+               : std::string(" past the end of the trace")));
+  return false;
+}
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
@@ -0,0 +1,116 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "mmio.h"
+#include "mmio_trace.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+/// @brief mmio backend replaying a trace recorded by mmio_trace
+///
+/// Reads return the recorded values and writes are checked against the
+/// recorded offsets and values, in order. Ack polling may take a different
+/// number of reads than recorded: a repeated read of a register last read
+/// as an ack poll returns its last recorded value again, and recorded ack
+/// polls not made before the next write are skipped. Any other read the
+/// trace does not have is a mismatch.
+class mmio_replay : public mmio {
+ public:
+  typedef std::shared_ptr<mmio_replay> ptr_t;
+
+  enum class timing {
+    none,     ///< replay as fast as possible
+    recorded  ///< hold each access until its recorded time from the start
+  };
+
+  struct stats {
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t repeated_polls;  ///< ack polls answered again with the last value
+    uint64_t skipped_polls;   ///< recorded ack polls not replayed
+    uint64_t mismatches;
+  };
+
+  mmio_replay(const std::vector<trace_record>& records, uint64_t tsc_hz,
+              timing pace = timing::none);
+
+  /// @brief Replay a trace file
+  static ptr_t open(const std::string& path, timing pace, std::string& error);
+
+  bool write_mmio32(uint32_t offset, uint32_t value) override;
+  bool write_mmio64(uint32_t offset, uint64_t value) override;
+  bool read_mmio32(uint32_t offset, uint32_t& value) override;
+  bool read_mmio64(uint32_t offset, uint64_t& value) override;
+  uint8_t* mmio_pointer(uint32_t offset) override;
+
+  /// @brief Every record was replayed (trailing ack polls aside)
+  bool finished();
+  size_t position() const { return pos_; }
+  size_t size() const { return records_.size(); }
+
+  stats get_stats() const { return stats_; }
+
+  /// @brief The first max_messages mismatches, as readable messages
+  const std::vector<std::string>& mismatches() const { return messages_; }
+  static const size_t max_messages = 100;
+
+ private:
+  typedef std::chrono::steady_clock clock;
+
+  bool write(trace_access access, uint32_t offset, uint64_t value);
+  bool read(trace_access access, uint32_t offset, uint64_t& value);
+  void skip_polls();
+  void pace(const trace_record& rec);
+  void mismatch(const std::string& message);
+
+  std::vector<trace_record> records_;
+  uint64_t tsc_hz_;
+  timing timing_;
+  size_t pos_;
+  bool started_;
+  clock::time_point start_;
+  std::map<uint64_t, uint64_t> last_poll_;
+  stats stats_;
+  std::vector<std::string> messages_;
+  std::mutex mutex_;
+};
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
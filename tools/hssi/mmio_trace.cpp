@@ -0,0 +1,319 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "mmio_trace.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+namespace {
+
+// state of the calling thread: its current op and its ring of the
+// mmio_trace that was used last
+struct thread_state {
+  trace_tag tag;
+  uint8_t flags;
+  uint32_t op;
+  uint64_t owner;
+  void* ring;
+};
+
+thread_local thread_state state = {trace_tag::none, 0, 0, 0, nullptr};
+
+std::atomic<uint64_t> next_id(1);
+
+const char* const tag_names[] = {
+    "none",         "transaction", "przone_read", "przone_write",
+    "xcvr_read",    "xcvr_write",  "pll_read",    "nios_cmd",
+    "i2c_read",     "i2c_write",   "mdio_read",   "mdio_write",
+    "retimer_read", "retimer_write"};
+
+static_assert(sizeof(tag_names) / sizeof(tag_names[0]) ==
+                  static_cast<size_t>(trace_tag::count),
+              "a trace_tag has no name");
+static_assert(sizeof(trace_record) == 32, "trace_record must stay packed");
+static_assert(sizeof(trace_header) == 64, "trace_header must stay packed");
+
+}  // end of anonymous namespace
+
+const char* trace_tag_name(trace_tag tag) {
+  size_t i = static_cast<size_t>(tag);
+  return i < static_cast<size_t>(trace_tag::count) ? tag_names[i] : "unknown";
+}
+
+uint64_t trace_tsc() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+trace_scope::trace_scope(trace_tag tag) : outer_(state.tag == trace_tag::none) {
+  if (outer_) {
+    state.tag = tag;
+    ++state.op;
+  }
+}
+
+trace_scope::~trace_scope() {
+  if (outer_) {
+    state.tag = trace_tag::none;
+  }
+}
+
+trace_ack_scope::trace_ack_scope() : flags_(state.flags) {
+  state.flags |= trace_ack_poll;
+}
+
+trace_ack_scope::~trace_ack_scope() { state.flags = flags_; }
+
+struct mmio_trace::ring {
+  int fd;
+  size_t size;
+  trace_header* header;
+  trace_record* records;
+  std::string path;
+
+  ring() : fd(-1), size(0), header(nullptr), records(nullptr) {}
+
+  ~ring() {
+    if (header) {
+      ::msync(header, size, MS_ASYNC);
+      ::munmap(header, size);
+    }
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+
+  bool open(const std::string& file, size_t capacity) {
+    path = file;
+    size = sizeof(trace_header) + capacity * sizeof(trace_record);
+    fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ::ftruncate(fd, size) != 0) {
+      return false;
+    }
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    // fault the ring in now, not one page at a time while tracing
+    flags |= MAP_POPULATE;
+#endif
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, fd, 0);
+    if (p == MAP_FAILED) {
+      return false;
+    }
+    header = static_cast<trace_header*>(p);
+    records = reinterpret_cast<trace_record*>(header + 1);
+
+    std::memcpy(header->magic, trace_magic, sizeof(header->magic));
+    header->version = trace_version;
+    header->record_size = sizeof(trace_record);
+    header->capacity = capacity;
+    header->head = 0;
+    header->tsc_hz = mmio_trace::tsc_hz();
+    header->thread = static_cast<uint32_t>(::syscall(SYS_gettid));
+    return true;
+  }
+
+  void push(const trace_record& r) {
+    records[header->head % header->capacity] = r;
+    ++header->head;
+  }
+};
+
+mmio_trace::mmio_trace(mmio::ptr_t target, const std::string& prefix,
+                       size_t capacity)
+    : target_(target),
+      prefix_(prefix),
+      capacity_(capacity ? capacity : default_capacity),
+      id_(next_id++) {
+  // calibrate and open the creating thread's ring now rather than in
+  // the middle of the first traced op
+  tsc_hz();
+  thread_ring();
+}
+
+mmio_trace::~mmio_trace() {}
+
+uint64_t mmio_trace::tsc_hz() {
+  static std::once_flag once;
+  static uint64_t hz = 0;
+  std::call_once(once, []() {
+#if defined(__x86_64__) || defined(__i386__)
+    auto begin = std::chrono::steady_clock::now();
+    uint64_t tsc_begin = trace_tsc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    uint64_t tsc_end = trace_tsc();
+    auto nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - begin).count();
+    hz = nsec > 0 ? (tsc_end - tsc_begin) * 1000000000ULL / nsec : 0;
+#else
+    hz = 1000000000ULL;
+#endif
+  });
+  return hz;
+}
+
+mmio_trace::ring* mmio_trace::thread_ring() {
+  if (state.owner == id_) {
+    return static_cast<ring*>(state.ring);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<ring> r(new ring());
+  std::string file = prefix_ + "." + std::to_string(rings_.size()) + ".trace";
+  state.owner = id_;
+  if (!r->open(file, capacity_)) {
+    std::cerr << "WARNING: Could not create MMIO trace " << file << ": "
+              << std::strerror(errno) << std::endl;
+    state.ring = nullptr;
+    return nullptr;
+  }
+  state.ring = r.get();
+  rings_.push_back(std::move(r));
+  return static_cast<ring*>(state.ring);
+}
+
+std::vector<std::string> mmio_trace::files() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::string> paths;
+  for (const auto& r : rings_) {
+    paths.push_back(r->path);
+  }
+  return paths;
+}
+
+void mmio_trace::record(uint64_t tsc, trace_access access, uint32_t offset,
+                        uint64_t value, bool ok) {
+  uint64_t end = trace_tsc();
+  ring* r = thread_ring();
+  if (!r) {
+    return;
+  }
+  trace_record rec;
+  rec.tsc = tsc;
+  rec.value = value;
+  rec.offset = offset;
+  rec.ticks = static_cast<uint32_t>(end - tsc);
+  rec.op = state.op;
+  rec.access = static_cast<uint8_t>(access);
+  rec.tag = static_cast<uint8_t>(state.tag);
+  rec.flags = state.flags | (ok ? 0 : trace_failed);
+  rec.reserved = 0;
+  r->push(rec);
+}
+
+bool mmio_trace::write_mmio32(uint32_t offset, uint32_t value) {
+  uint64_t tsc = trace_tsc();
+  bool ok = target_->write_mmio32(offset, value);
+  record(tsc, trace_access::write32, offset, value, ok);
+  return ok;
+}
+
+bool mmio_trace::write_mmio64(uint32_t offset, uint64_t value) {
+  uint64_t tsc = trace_tsc();
+  bool ok = target_->write_mmio64(offset, value);
+  record(tsc, trace_access::write64, offset, value, ok);
+  return ok;
+}
+
+bool mmio_trace::read_mmio32(uint32_t offset, uint32_t& value) {
+  uint64_t tsc = trace_tsc();
+  bool ok = target_->read_mmio32(offset, value);
+  record(tsc, trace_access::read32, offset, value, ok);
+  return ok;
+}
+
+bool mmio_trace::read_mmio64(uint32_t offset, uint64_t& value) {
+  uint64_t tsc = trace_tsc();
+  bool ok = target_->read_mmio64(offset, value);
+  record(tsc, trace_access::read64, offset, value, ok);
+  return ok;
+}
+
+uint8_t* mmio_trace::mmio_pointer(uint32_t offset) {
+  (void)offset;
+  return nullptr;
+}
+
+bool trace_file::load(const std::string& file, std::string& error) {
+  path = file;
+  records.clear();
+  std::ifstream in(file, std::ios::binary);
+  if (!in) {
+    error = "cannot open";
+    return false;
+  }
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, trace_magic, sizeof(header.magic)) != 0) {
+    error = "not an HSSI MMIO trace";
+    return false;
+  }
+  if (header.version != trace_version ||
+      header.record_size != sizeof(trace_record) || header.capacity == 0) {
+    error = "unsupported trace version";
+    return false;
+  }
+
+  std::vector<trace_record> ring(header.capacity);
+  if (!in.read(reinterpret_cast<char*>(ring.data()),
+               ring.size() * sizeof(trace_record))) {
+    error = "truncated trace";
+    return false;
+  }
+
+  // once the ring wrapped, the oldest record is the one at head
+  uint64_t count = std::min(header.head, header.capacity);
+  uint64_t first = header.head > header.capacity ? header.head % header.capacity : 0;
+  records.reserve(count);
+  for (uint64_t i = 0; i < count; ++i) {
+    records.push_back(ring[(first + i) % header.capacity]);
+  }
+  return true;
+}
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
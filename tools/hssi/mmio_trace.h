@@ -0,0 +1,182 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "mmio.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+/// @brief Operation an MMIO access was made for
+enum class trace_tag : uint8_t {
+  none = 0,
+  transaction,
+  przone_read,
+  przone_write,
+  xcvr_read,
+  xcvr_write,
+  pll_read,
+  nios_cmd,
+  i2c_read,
+  i2c_write,
+  mdio_read,
+  mdio_write,
+  retimer_read,
+  retimer_write,
+  count
+};
+
+const char* trace_tag_name(trace_tag tag);
+
+enum class trace_access : uint8_t { read32, read64, write32, write64 };
+
+enum trace_flags : uint8_t {
+  trace_ack_poll = 0x1,  ///< made while polling for an ack or nack
+  trace_failed = 0x2     ///< the access returned false
+};
+
+/// @brief One MMIO access
+struct trace_record {
+  uint64_t tsc;     ///< time stamp counter at the start of the access
+  uint64_t value;   ///< value written or read
+  uint32_t offset;
+  uint32_t ticks;   ///< time stamp counter ticks the access took
+  uint32_t op;      ///< per-thread sequence number of the outermost op
+  uint8_t access;   ///< trace_access
+  uint8_t tag;      ///< trace_tag of the outermost op
+  uint8_t flags;    ///< trace_flags
+  uint8_t reserved;
+};
+
+/// @brief Header of a trace file; the records follow it
+struct trace_header {
+  char magic[8];          ///< "HSSITRC"
+  uint32_t version;
+  uint32_t record_size;
+  uint64_t capacity;      ///< records in the ring
+  uint64_t head;          ///< records written, the newest at (head-1) % capacity
+  uint64_t tsc_hz;        ///< time stamp counter frequency
+  uint32_t thread;        ///< kernel thread id of the writer
+  uint32_t reserved[5];
+};
+
+static const char trace_magic[8] = "HSSITRC";
+static const uint32_t trace_version = 1;
+
+/// @brief Read the time stamp counter (steady clock nanoseconds where
+///        there is none)
+uint64_t trace_tsc();
+
+/// @brief Tag the MMIO accesses made by the current thread until the end
+///        of the scope; an enclosing op keeps its tag
+class trace_scope {
+ public:
+  explicit trace_scope(trace_tag tag);
+  ~trace_scope();
+
+ private:
+  bool outer_;
+};
+
+/// @brief Flag the MMIO accesses made by the current thread until the
+///        end of the scope as ack polling
+class trace_ack_scope {
+ public:
+  trace_ack_scope();
+  ~trace_ack_scope();
+
+ private:
+  uint8_t flags_;
+};
+
+/// @brief mmio decorator recording every access into a binary ring file
+///        per thread, <prefix>.<n>.trace, mmapped so a crash keeps it
+///
+/// mmio_pointer returns nullptr, so users fall back to the virtual
+/// calls and every access is seen.
+class mmio_trace : public mmio {
+ public:
+  typedef std::shared_ptr<mmio_trace> ptr_t;
+
+  static const size_t default_capacity = 1 << 20;
+
+  mmio_trace(mmio::ptr_t target, const std::string& prefix,
+             size_t capacity = default_capacity);
+  virtual ~mmio_trace();
+
+  bool write_mmio32(uint32_t offset, uint32_t value) override;
+  bool write_mmio64(uint32_t offset, uint64_t value) override;
+  bool read_mmio32(uint32_t offset, uint32_t& value) override;
+  bool read_mmio64(uint32_t offset, uint64_t& value) override;
+  uint8_t* mmio_pointer(uint32_t offset) override;
+
+  mmio::ptr_t target() const { return target_; }
+  const std::string& prefix() const { return prefix_; }
+
+  /// @brief Files written so far, one per thread
+  std::vector<std::string> files();
+
+  /// @brief Time stamp counter ticks per second, measured once per process
+  static uint64_t tsc_hz();
+
+ private:
+  struct ring;
+
+  ring* thread_ring();
+  void record(uint64_t tsc, trace_access access, uint32_t offset,
+              uint64_t value, bool ok);
+
+  mmio::ptr_t target_;
+  std::string prefix_;
+  size_t capacity_;
+  uint64_t id_;
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<ring>> rings_;
+};
+
+/// @brief The records of one trace file, oldest first
+struct trace_file {
+  std::string path;
+  trace_header header;
+  std::vector<trace_record> records;
+
+  /// @brief Load a trace file written by mmio_trace
+  bool load(const std::string& path, std::string& error);
+};
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
@@ -25,73 +25,73 @@
 // POSSIBILITY OF SUCH DAMAGE.
 #include "nios.h"
 #include "hssi_msg.h"
+#include "latency.h"
+#include "mmio_trace.h"
 
 namespace intel {
 namespace fpga {
 namespace hssi {
 
-nios::nios(hssi_przone::ptr_t przone)
-    : przone_{przone}, mmio_{przone->get_mmio()} {}
+const size_t nios_args::capacity;
 
-bool nios::write(uint32_t nios_func, std::vector<uint32_t> args) {
-  uint32_t junk;
-  return write(nios_func, args, junk);
+nios::nios(hssi_przone::ptr_t przone, shadow_cache::ptr_t cache)
+    : przone_{przone}, cache_{cache} {}
+
+bool nios::write(uint32_t nios_func, const nios_args& args) {
+  return execute(nios_func, args, nullptr);
 }
 
-bool nios::write(uint32_t nios_func, std::vector<uint32_t> args,
+bool nios::write(uint32_t nios_func, const nios_args& args,
                  uint32_t& value_out) {
-  if (args.size() > 4) {
+  return execute(nios_func, args, &value_out);
+}
+
+bool nios::execute(uint32_t nios_func, const nios_args& args,
+                   uint32_t* value_out) {
+  trace_scope trace(trace_tag::nios_cmd);
+  latency_scope timer(latency_op::nios);
+  if (!args.valid()) {
     return false;
   }
 
-  controller::hssi_ctrl msg;
-  for (size_t i = 0; i < args.size(); ++i) {
-    msg.clear();
-    msg.set_command(controller::hssi_cmd::sw_write);
-    msg.set_address(i + 2);
-    msg.set_data(args[i]);
-    mmio_->write_mmio64(przone_->get_ctrl(), msg.data());
-    if (!przone_->hssi_ack(100000)) {
-      return false;
-    }
-  }
+  // arguments, the function and, if it returns a value, its read back
+  // go to the controller as one transaction, built in storage each
+  // thread reuses so a command allocates nothing
+  static thread_local transaction tx;
+  tx.clear();
+  tx.soft_cmd(nios_func, args.data(), args.size(), value_out);
 
-  msg.set_command(controller::hssi_cmd::sw_write);
-  msg.set_address(1);
-  msg.set_data(nios_func);
-  mmio_->write_mmio64(przone_->get_ctrl(), msg.data());
-  if (!przone_->hssi_ack(100000)) {
-    return false;
-  }
+  // the NIOS may rewrite any register once it has the command
+  invalidate_shadow(nios_func);
+  return przone_->execute(tx, nullptr, timeout_usec(nios_func));
+}
 
+uint32_t nios::timeout_usec(uint32_t nios_func) {
   switch (nios_func) {
-    case controller::nios_cmd::tx_eq_read:
+    // these take as long as the reconfiguration, whatever the others took
+    case controller::nios_cmd::change_hssi_mode:
     case controller::nios_cmd::hssi_init:
-    case controller::nios_cmd::hssi_init_done:
-    case controller::nios_cmd::fatal_err:
-    case controller::nios_cmd::get_hssi_enable:
-    case controller::nios_cmd::get_hssi_mode: {
-      msg.set_command(controller::hssi_cmd::sw_read);
-      msg.set_address(6);
-      msg.set_data(nios_func);
-      mmio_->write_mmio64(przone_->get_ctrl(), msg.data());
-      if (!przone_->hssi_ack(100000)) {
-        return false;
-      }
-
-      uint64_t value64;
-      if (!mmio_->read_mmio64(przone_->get_stat(), value64))
-      {
-        return false;
-      }
+    case controller::nios_cmd::set_hssi_enable:
+      return soft_cmd_timeout_usec;
+    default:
+      return adaptive_timeout::get(latency_op::nios, soft_cmd_timeout_usec);
+  }
+}
 
-      value_out = static_cast<uint32_t>(value64);
-    } break;
+void nios::invalidate_shadow(uint32_t nios_func) {
+  if (!cache_) return;
+  switch (nios_func) {
+    case controller::nios_cmd::change_hssi_mode:
+    case controller::nios_cmd::hssi_init:
+    case controller::nios_cmd::set_hssi_enable:
+      cache_->invalidate();
+      break;
+    case controller::nios_cmd::tx_eq_write:
+      cache_->invalidate(shadow_cache::target::xcvr);
+      break;
     default:
       break;
   }
-
-  return true;
 }
 }
 }
@@ -2,26 +2,60 @@
 
 #include "fme.h"
 #include "hssi_przone.h"
-#include "mmio.h"
+#include "shadow_cache.h"
+#include "transaction.h"
 
-#include <vector>
+#include <algorithm>
+#include <initializer_list>
 
 namespace intel {
 namespace fpga {
 namespace hssi {
 
+/// @brief The arguments of a soft command, held in place: write(f, {a, b})
+///        allocates nothing
+class nios_args {
+ public:
+  nios_args() : size_(0) {}
+  nios_args(std::initializer_list<uint32_t> args)
+      : nios_args(args.begin(), args.size()) {}
+  nios_args(const uint32_t* args, size_t count) : size_(count) {
+    std::copy(args, args + std::min(count, capacity), args_);
+  }
+
+  const uint32_t* data() const { return args_; }
+  size_t size() const { return size_; }
+  /// @brief false if more arguments were given than a command takes
+  bool valid() const { return size_ <= capacity; }
+
+  static const size_t capacity = transaction::max_soft_cmd_args;
+
+ private:
+  uint32_t args_[capacity];
+  size_t size_;
+};
+
 class nios {
  public:
   typedef std::shared_ptr<nios> ptr_t;
 
-  nios(hssi_przone::ptr_t przone);
-  bool write(uint32_t nios_func, std::vector<uint32_t> args);
-  bool write(uint32_t nios_func, std::vector<uint32_t> args,
-             uint32_t& value_out);
+  nios(hssi_przone::ptr_t przone,
+       shadow_cache::ptr_t cache = shadow_cache::ptr_t());
+  bool write(uint32_t nios_func, const nios_args& args = nios_args());
+  bool write(uint32_t nios_func, const nios_args& args, uint32_t& value_out);
+
+  /// Timeout of each ack and nack wait of a soft command; commands that
+  /// do not reconfigure the transceivers wait as long as learned from
+  /// the soft commands so far, at most this
+  static const uint32_t soft_cmd_timeout_usec = 100000;
 
  private:
   hssi_przone::ptr_t przone_;
-  mmio::ptr_t mmio_;
+  shadow_cache::ptr_t cache_;
+
+  bool execute(uint32_t nios_func, const nios_args& args, uint32_t* value_out);
+  void invalidate_shadow(uint32_t nios_func);
+  static uint32_t timeout_usec(uint32_t nios_func);
 };
 
 }  // end of namespace hssi
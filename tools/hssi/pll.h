@@ -41,7 +41,6 @@ class pll {
 
  private:
   hssi_przone::ptr_t przone_;
-  mmio::ptr_t mmio_;
 };
 }
 }
@@ -0,0 +1,120 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "poll.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+namespace {
+
+// Mailbox handshakes complete within a few microseconds, so spin
+// through those; I2C bytes take ~100 usec and end up sleeping.
+const poll_config spin_sleep_config = {poll_policy::spin_sleep, 20, 5, 50};
+
+struct defaults_holder {
+  std::atomic<poll_policy> policy;
+  std::atomic<uint32_t> spin_usec;
+  std::atomic<uint32_t> sleep_usec;
+  std::atomic<uint32_t> max_sleep_usec;
+};
+
+defaults_holder defaults = {{spin_sleep_config.policy},
+                            {spin_sleep_config.spin_usec},
+                            {spin_sleep_config.sleep_usec},
+                            {spin_sleep_config.max_sleep_usec}};
+
+}  // end of anonymous namespace
+
+poller::poller() : config_(get_defaults()), stats_() {}
+
+poller::poller(const poll_config& config) : config_(config), stats_() {}
+
+void poller::reset_stats() { stats_ = poll_stats(); }
+
+poll_config poller::get_defaults() {
+  poll_config config;
+  config.policy = defaults.policy.load();
+  config.spin_usec = defaults.spin_usec.load();
+  config.sleep_usec = defaults.sleep_usec.load();
+  config.max_sleep_usec = defaults.max_sleep_usec.load();
+  return config;
+}
+
+void poller::set_defaults(const poll_config& config) {
+  defaults.policy = config.policy;
+  defaults.spin_usec = config.spin_usec;
+  defaults.sleep_usec = config.sleep_usec;
+  defaults.max_sleep_usec = config.max_sleep_usec;
+}
+
+bool poller::parse(const std::string& name, poll_config& config) {
+  config = spin_sleep_config;
+  if (name == "spin") {
+    config.policy = poll_policy::spin;
+  } else if (name == "yield") {
+    config.policy = poll_policy::spin_yield;
+  } else if (name == "sleep") {
+    config.policy = poll_policy::spin_sleep;
+  } else if (name == "legacy") {
+    config.policy = poll_policy::sleep;
+    config.spin_usec = 0;
+    config.sleep_usec = 10;
+    config.max_sleep_usec = 10;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void poller::backoff(clock::duration remaining, uint32_t& sleep_usec) {
+  switch (config_.policy) {
+    case poll_policy::spin_yield:
+      std::this_thread::yield();
+      break;
+    case poll_policy::spin_sleep:
+      std::this_thread::sleep_for(
+          std::min<clock::duration>(std::chrono::microseconds(sleep_usec),
+                                    remaining));
+      sleep_usec = std::min(sleep_usec * 2, config_.max_sleep_usec);
+      break;
+    case poll_policy::sleep:
+      std::this_thread::sleep_for(std::chrono::microseconds(sleep_usec));
+      break;
+    default:
+      pause();
+      break;
+  }
+}
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
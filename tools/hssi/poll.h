@@ -0,0 +1,174 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+/// @brief Result of one poll of a completion condition
+enum class poll_status { ready, pending, error };
+
+/// @brief How a poller waits between two polls
+enum class poll_policy : uint8_t {
+  spin,        ///< busy-spin with a pause hint
+  spin_yield,  ///< spin for spin_usec, then yield the CPU between polls
+  spin_sleep,  ///< spin for spin_usec, then sleep with exponential backoff
+  sleep        ///< sleep sleep_usec between polls (the historical behavior)
+};
+
+struct poll_config {
+  poll_policy policy;
+  uint32_t spin_usec;       ///< spin phase of spin_yield and spin_sleep
+  uint32_t sleep_usec;      ///< first sleep of spin_sleep, every sleep of sleep
+  uint32_t max_sleep_usec;  ///< backoff limit of spin_sleep
+};
+
+struct poll_stats {
+  uint64_t waits;
+  uint64_t timeouts;
+  uint64_t errors;
+  uint64_t polls;       ///< polls over all waits
+  uint64_t max_polls;   ///< most polls taken by a single wait
+  uint64_t last_polls;  ///< polls taken by the last wait
+};
+
+/// @brief Deadline-based polling engine shared by the HSSI mailbox,
+///        I2C and MDIO wait loops.
+class poller {
+ public:
+  poller();
+  explicit poller(const poll_config& config);
+
+  /// @brief Poll ready() until it stops returning pending or the
+  ///        timeout expires.
+  ///
+  /// @param[in] ready Callable returning a poll_status
+  /// @param[in] timeout_usec Deadline, relative to the call
+  /// @param[out] duration Optional time (usec) until ready
+  ///
+  /// @return true if ready() returned ready before the deadline
+  template <typename Ready>
+  bool wait(Ready ready, uint32_t timeout_usec, uint32_t* duration = nullptr) {
+    // a condition that already holds needs no clock
+    if (!duration) {
+      poll_status status = ready();
+      if (status != poll_status::pending) {
+        record(1);
+        if (status == poll_status::error) ++stats_.errors;
+        return status == poll_status::ready;
+      }
+    }
+
+    const clock::time_point begin = clock::now();
+    const clock::time_point deadline =
+        begin + std::chrono::microseconds(timeout_usec);
+    const clock::time_point spin_end =
+        begin + std::chrono::microseconds(config_.spin_usec);
+    uint32_t sleep_usec = config_.sleep_usec;
+    uint64_t polls = 0;
+
+    while (true) {
+      ++polls;
+      poll_status status = ready();
+      clock::time_point now = clock::now();
+
+      if (status == poll_status::ready) {
+        if (duration) {
+          *duration = std::chrono::duration_cast<std::chrono::microseconds>(
+                          now - begin).count();
+        }
+        record(polls);
+        return true;
+      }
+
+      if (status == poll_status::error) {
+        record(polls);
+        ++stats_.errors;
+        return false;
+      }
+
+      if (now >= deadline) {
+        record(polls);
+        ++stats_.timeouts;
+        return false;
+      }
+
+      if (config_.policy == poll_policy::spin || now < spin_end) {
+        pause();
+      } else {
+        backoff(deadline - now, sleep_usec);
+      }
+    }
+  }
+
+  const poll_config& config() const { return config_; }
+  void set_config(const poll_config& config) { config_ = config; }
+
+  const poll_stats& stats() const { return stats_; }
+  void reset_stats();
+
+  /// @brief Configuration given to pollers created from now on
+  static poll_config get_defaults();
+  static void set_defaults(const poll_config& config);
+
+  /// @brief Parse spin, yield, sleep or legacy into a configuration
+  ///        using the default timings
+  static bool parse(const std::string& name, poll_config& config);
+
+  static void pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+  }
+
+ private:
+  typedef std::chrono::steady_clock clock;
+
+  void record(uint64_t polls) {
+    ++stats_.waits;
+    stats_.polls += polls;
+    stats_.last_polls = polls;
+    if (polls > stats_.max_polls) stats_.max_polls = polls;
+  }
+
+  void backoff(clock::duration remaining, uint32_t& sleep_usec);
+
+  poll_config config_;
+  poll_stats stats_;
+};
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
@@ -26,6 +26,7 @@
 #pragma once
 #include <cstdint>
 #include <memory>
+#include "arbiter.h"
 
 namespace intel
 {
@@ -42,6 +43,10 @@ public:
     virtual bool read(uint32_t address, uint32_t & value) = 0;
     virtual bool write(uint32_t address, uint32_t value) = 0;
 
+    /// @brief Keep other clients of the mailbox out of a sequence of
+    ///        reads and writes until the lease is released
+    virtual arbiter::lease hold() { return arbiter::lease(); }
+
 };
 
 } // end of namespace hssi
@@ -0,0 +1,481 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "reactor.h"
+
+#include <utility>
+
+#include "i2c.h"
+#include "mdio.h"
+#include "nios.h"
+#include "poll.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+namespace {
+
+const uint64_t ack_mask = 1UL << mailbox<virtual_mmio>::ack_bit;
+
+// the fixed timeouts of i2c::wait_for_i2c_tx and mdio::wait_for_mdio_tx
+const uint32_t i2c_timeout_usec = i2c::tx_timeout_usec;
+const uint32_t mdio_timeout_usec = mdio::tx_timeout_usec;
+
+// MDIO commands (the async_hssi members hide the mdio_ctrl names)
+const uint32_t mdio_set_address = mdio_write | mdio_address_reg;
+const uint32_t mdio_read_data = mdio_read | mdio_access_reg;
+const uint32_t mdio_write_data = mdio_write | mdio_access_reg;
+
+// mailbox words done per visit before the next mailbox gets its turn
+const int visit_budget = 16;
+
+typedef std::shared_ptr<uint32_t> shared_word;
+
+// write an I2C command, then poll the status until the byte is through
+void i2c_command(async_op& op, const shared_word& stat, uint32_t instance,
+                 uint32_t ctrl, uint8_t* byte_out = nullptr) {
+  transaction write;
+  write.przone_write(i2c_reg_ctrl_wrdata,
+                     (instance << i2c_ctrl_instance) | ctrl);
+  op.then(write);
+
+  transaction poll;
+  poll.przone_read(i2c_reg_stat_rddata, stat.get());
+  op.until(poll, [stat, byte_out]() {
+    if (*stat & i2c_stat_tx) return false;
+    if (byte_out) *byte_out = static_cast<uint8_t>(*stat);
+    return true;
+  }, i2c_timeout_usec);
+}
+
+// START with the device address, then the byte address, upper byte first
+void i2c_address(async_op& op, const shared_word& stat, uint32_t instance,
+                 uint32_t device_addr, uint32_t byte_addr, size_t size) {
+  i2c_command(op, stat, instance,
+              i2c_ctrl_trigger | i2c_ctrl_transmit | i2c_ctrl_send_start |
+                  device_addr);
+  for (size_t i = size; i-- > 0;) {
+    i2c_command(op, stat, instance,
+                i2c_ctrl_trigger | i2c_ctrl_transmit |
+                    ((byte_addr >> (8 * i)) & 0xFF));
+  }
+}
+
+void mdio_command(async_op& op, const shared_word& stat, uint32_t ctrl) {
+  transaction write;
+  write.przone_write(mdio_ctrl_reg, ctrl);
+  op.then(write);
+
+  transaction poll;
+  poll.przone_read(mdio_ctrl_reg, stat.get());
+  op.until(poll, [stat]() {
+    return !(*stat & (mdio_write | mdio_read));
+  }, mdio_timeout_usec);
+}
+
+uint32_t mdio_address(uint8_t device_addr, uint8_t port_addr,
+                      uint16_t reg_addr) {
+  return (mdio_device_address_mask & (device_addr << mdio_device_address)) |
+         (mdio_port_address_mask & (port_addr << mdio_port_addres)) |
+         (mdio_register_address_mask &
+          (static_cast<uint32_t>(reg_addr) << mdio_register_address));
+}
+
+}  // end of anonymous namespace
+
+async_op& async_op::then(const transaction& tx, uint32_t ack_timeout_usec) {
+  stage s = {tx, condition(), ack_timeout_usec, 0};
+  stages_.push_back(s);
+  return *this;
+}
+
+async_op& async_op::hold(std::shared_ptr<void> state) {
+  held_.push_back(state);
+  return *this;
+}
+
+async_op& async_op::until(const transaction& tx, condition done,
+                          uint32_t timeout_usec, uint32_t ack_timeout_usec) {
+  stage s = {tx, done, ack_timeout_usec, timeout_usec};
+  stages_.push_back(s);
+  return *this;
+}
+
+reactor::reactor() : in_flight_(0), leased_(0), stats_(), running_(false) {}
+
+reactor::~reactor() { stop(); }
+
+std::future<bool> reactor::submit(hssi_przone::ptr_t mailbox, async_op op,
+                                  callback done) {
+  std::unique_ptr<job> j(new job());
+  j->op = std::move(op);
+  j->done = done;
+  j->stage = 0;
+  j->step = 0;
+  j->state = phase::write;
+  j->stage_started = false;
+  j->leased = false;
+  std::future<bool> result = j->promise.get_future();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    incoming_.emplace_back(mailbox, std::move(j));
+    ++stats_.submitted;
+  }
+  wake_.notify_one();
+  return result;
+}
+
+void reactor::start() {
+  if (running_.exchange(true)) {
+    return;
+  }
+  thread_ = std::thread(&reactor::loop, this);
+}
+
+void reactor::stop() {
+  if (!running_.exchange(false)) {
+    return;
+  }
+  wake_.notify_one();
+  thread_.join();
+}
+
+reactor::stats reactor::get_stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+size_t reactor::run_once() {
+  std::lock_guard<std::mutex> run(run_mutex_);
+
+  std::vector<std::pair<hssi_przone::ptr_t, std::unique_ptr<job>>> incoming;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    incoming.swap(incoming_);
+    ++stats_.rounds;
+  }
+
+  for (auto& in : incoming) {
+    channel* c = nullptr;
+    for (auto& ch : channels_) {
+      if (ch->przone == in.first) {
+        c = ch.get();
+        break;
+      }
+    }
+    if (!c) {
+      std::unique_ptr<channel> ch(new channel());
+      ch->przone = in.first;
+      ch->io = in.first->get_mmio().get();
+      ch->base = ch->io->mmio_pointer(0);
+      ch->ctrl = in.first->get_ctrl();
+      ch->stat = in.first->get_stat();
+      c = ch.get();
+      channels_.push_back(std::move(ch));
+    }
+    c->jobs.push_back(std::move(in.second));
+    ++in_flight_;
+  }
+
+  bool advanced = false;
+  for (auto& c : channels_) {
+    if (!c->jobs.empty()) advanced |= advance(*c);
+  }
+  if (!advanced && in_flight_) {
+    poller::pause();
+  }
+  return in_flight_;
+}
+
+void reactor::loop() {
+  // an operation holding an arbiter runs to completion before stopping
+  while (running_ || leased_) {
+    if (run_once()) continue;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_.wait(lock, [this]() { return !running_ || !incoming_.empty(); });
+  }
+}
+
+bool reactor::advance(channel& c) {
+  bool advanced = false;
+  for (int budget = visit_budget; budget > 0 && !c.jobs.empty(); --budget) {
+    job& front = *c.jobs.front();
+    if (!front.leased) {
+      if (!acquire(c)) {
+        return advanced;
+      }
+      front.leased = true;
+      ++leased_;
+    }
+    progress p = step(c, front);
+    if (p == progress::waiting) {
+      return advanced;
+    }
+    advanced = true;
+    if (p != progress::advanced) {
+      std::unique_ptr<job> j = std::move(c.jobs.front());
+      c.jobs.pop_front();
+      release(c);
+      --leased_;
+      finish(std::move(j), p == progress::finished);
+    }
+  }
+  return advanced;
+}
+
+bool reactor::acquire(channel& c) {
+  arbiter::ptr_t a = c.przone->get_arbiter();
+  if (!a) {
+    return true;
+  }
+  // held by this thread for another mailbox of the same controller
+  if (a->owned()) {
+    return false;
+  }
+  return a->try_lock(c.przone->get_priority());
+}
+
+void reactor::release(channel& c) {
+  arbiter::ptr_t a = c.przone->get_arbiter();
+  if (a) {
+    a->unlock();
+  }
+}
+
+reactor::progress reactor::step(channel& c, job& j) {
+  const auto& stages = j.op.stages();
+  if (j.stage == stages.size()) {
+    return progress::finished;
+  }
+  const async_op::stage& s = stages[j.stage];
+  clock::time_point now = clock::now();
+  if (!j.stage_started) {
+    j.stage_started = true;
+    j.stage_deadline = now + std::chrono::microseconds(s.timeout_usec);
+  }
+
+  if (s.tx.empty()) {
+    if (s.done && !s.done()) {
+      return now >= j.stage_deadline ? progress::failed : progress::waiting;
+    }
+    ++j.stage;
+    j.stage_started = false;
+    return progress::advanced;
+  }
+
+  const transaction::step& w = s.tx.begin()[j.step];
+  uint64_t value = 0;
+  switch (j.state) {
+    case phase::write:
+      if (!write64(c, c.ctrl, w.ctrl)) {
+        return progress::failed;
+      }
+      j.state = phase::ack;
+      j.ack_deadline = now + std::chrono::microseconds(s.ack_timeout_usec);
+      return progress::advanced;
+
+    case phase::ack:
+      if (read64(c, c.stat, value) && (value & ack_mask)) {
+        write64(c, c.ctrl, 0UL);
+        j.state = phase::nack;
+        return progress::advanced;
+      }
+      return now >= j.ack_deadline ? progress::failed : progress::waiting;
+
+    case phase::nack:
+      if (!read64(c, c.stat, value) || (value & ack_mask)) {
+        return now >= j.ack_deadline ? progress::failed : progress::waiting;
+      }
+      break;
+  }
+
+  // the word is acknowledged
+  if (w.result) {
+    *w.result = static_cast<uint32_t>(value & 0x00000000FFFFFFFF);
+  }
+  j.state = phase::write;
+  if (++j.step < s.tx.size()) {
+    return progress::advanced;
+  }
+
+  j.step = 0;
+  if (s.done && !s.done()) {
+    // run the stage again on the next visit, after the other mailboxes
+    return now >= j.stage_deadline ? progress::failed : progress::waiting;
+  }
+  ++j.stage;
+  j.stage_started = false;
+  return j.stage == stages.size() ? progress::finished : progress::advanced;
+}
+
+bool reactor::read64(const channel& c, uint32_t offset, uint64_t& value) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.polls;
+  }
+  if (c.base) {
+    return mapped_mmio(c.base).read64(offset, value);
+  }
+  return virtual_mmio(c.io).read64(offset, value);
+}
+
+bool reactor::write64(const channel& c, uint32_t offset, uint64_t value) {
+  if (c.base) {
+    return mapped_mmio(c.base).write64(offset, value);
+  }
+  return virtual_mmio(c.io).write64(offset, value);
+}
+
+void reactor::finish(std::unique_ptr<job> j, bool ok) {
+  --in_flight_;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++(ok ? stats_.completed : stats_.failed);
+  }
+  j->promise.set_value(ok);
+  if (j->done) {
+    j->done(ok);
+  }
+}
+
+async_hssi::async_hssi(reactor::ptr_t r, hssi_przone::ptr_t przone,
+                       size_t byte_addr_size)
+    : reactor_(r), przone_(przone), byte_addr_size_(byte_addr_size) {}
+
+std::future<bool> async_hssi::xcvr_write(uint32_t lane, uint32_t reg_addr,
+                                         uint32_t value, callback done) {
+  transaction tx;
+  tx.xcvr_write(lane, reg_addr, value);
+  return reactor_->submit(przone_, async_op().then(tx), done);
+}
+
+std::future<bool> async_hssi::xcvr_read(uint32_t lane, uint32_t reg_addr,
+                                        uint32_t& value, callback done) {
+  transaction tx;
+  tx.xcvr_read(lane, reg_addr, &value);
+  return reactor_->submit(przone_, async_op().then(tx), done);
+}
+
+std::future<bool> async_hssi::pll_read(uint32_t info_sel, uint32_t& value,
+                                       callback done) {
+  transaction tx;
+  tx.pll_read(info_sel, &value);
+  return reactor_->submit(przone_, async_op().then(tx), done);
+}
+
+std::future<bool> async_hssi::nios(uint32_t nios_func, const nios_args& args,
+                                   uint32_t* value_out, callback done) {
+  if (!args.valid()) {
+    std::promise<bool> failed;
+    failed.set_value(false);
+    if (done) done(false);
+    return failed.get_future();
+  }
+  // a soft command with a result always reads it back
+  shared_word junk(new uint32_t(0));
+  transaction tx;
+  tx.soft_cmd(nios_func, args.data(), args.size(),
+              value_out ? value_out : junk.get());
+  return reactor_->submit(
+      przone_,
+      async_op().then(tx, hssi::nios::soft_cmd_timeout_usec).hold(junk),
+      done);
+}
+
+std::future<bool> async_hssi::i2c_read(uint32_t instance, uint32_t device_addr,
+                                       uint32_t byte_addr, uint8_t bytes[],
+                                       size_t count, callback done) {
+  shared_word stat(new uint32_t(0));
+  async_op op;
+  i2c_address(op, stat, instance, device_addr, byte_addr, byte_addr_size_);
+  i2c_command(op, stat, instance,
+              i2c_ctrl_trigger | i2c_ctrl_transmit | i2c_ctrl_send_start |
+                  device_addr | 1);
+  for (size_t i = 0; i < count; ++i) {
+    // the last byte is NACKed with a STOP
+    uint32_t ctrl = i + 1 == count ? i2c_ctrl_trigger | i2c_ctrl_send_stop
+                                   : i2c_ctrl_trigger | i2c_ctrl_send_ack;
+    i2c_command(op, stat, instance, ctrl, &bytes[i]);
+  }
+  return reactor_->submit(przone_, op, done);
+}
+
+std::future<bool> async_hssi::i2c_write(uint32_t instance,
+                                        uint32_t device_addr,
+                                        uint32_t byte_addr,
+                                        const uint8_t bytes[], size_t count,
+                                        callback done) {
+  shared_word stat(new uint32_t(0));
+  async_op op;
+  i2c_address(op, stat, instance, device_addr, byte_addr, byte_addr_size_);
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t ctrl = i2c_ctrl_trigger | i2c_ctrl_transmit;
+    if (i + 1 == count) ctrl |= i2c_ctrl_send_stop;
+    i2c_command(op, stat, instance, ctrl | bytes[i]);
+  }
+  return reactor_->submit(przone_, op, done);
+}
+
+std::future<bool> async_hssi::mdio_read(uint8_t device_addr,
+                                        uint8_t port_addr, uint16_t reg_addr,
+                                        uint32_t& value, callback done) {
+  shared_word stat(new uint32_t(0));
+  async_op op;
+  transaction addr;
+  addr.przone_write(mdio_wr_data_reg,
+                    mdio_address(device_addr, port_addr, reg_addr));
+  op.then(addr);
+  mdio_command(op, stat, mdio_set_address);
+  mdio_command(op, stat, mdio_read_data);
+  transaction data;
+  data.przone_read(mdio_rd_data_reg, &value);
+  op.then(data);
+  return reactor_->submit(przone_, op, done);
+}
+
+std::future<bool> async_hssi::mdio_write(uint8_t device_addr,
+                                         uint8_t port_addr, uint16_t reg_addr,
+                                         uint32_t value, callback done) {
+  shared_word stat(new uint32_t(0));
+  async_op op;
+  transaction addr;
+  addr.przone_write(mdio_wr_data_reg,
+                    mdio_address(device_addr, port_addr, reg_addr));
+  op.then(addr);
+  mdio_command(op, stat, mdio_set_address);
+  transaction data;
+  data.przone_write(mdio_wr_data_reg, value);
+  op.then(data);
+  mdio_command(op, stat, mdio_write_data);
+  return reactor_->submit(przone_, op, done);
+}
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
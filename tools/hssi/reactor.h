@@ -0,0 +1,220 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hssi_przone.h"
+#include "nios.h"
+#include "transaction.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+/// @brief An HSSI operation for a reactor: stages of controller
+///        transactions, run in order
+class async_op {
+ public:
+  typedef std::function<bool()> condition;
+
+  struct stage {
+    transaction tx;
+    condition done;             ///< if set, tx runs again until it holds
+    uint32_t ack_timeout_usec;  ///< of each ack and nack
+    uint32_t timeout_usec;      ///< for done to hold, from the first run
+  };
+
+  /// @brief Run tx once
+  async_op& then(const transaction& tx,
+                 uint32_t ack_timeout_usec = hssi_przone::default_timeout_usec);
+
+  /// @brief Run tx, then again until done() returns true; done sees the
+  ///        results of the run that just completed
+  async_op& until(const transaction& tx, condition done,
+                  uint32_t timeout_usec,
+                  uint32_t ack_timeout_usec = hssi_przone::default_timeout_usec);
+
+  /// @brief Keep state (e.g. a result buffer) until the operation is done
+  async_op& hold(std::shared_ptr<void> state);
+
+  const std::vector<stage>& stages() const { return stages_; }
+
+ private:
+  std::vector<stage> stages_;
+  std::vector<std::shared_ptr<void>> held_;
+};
+
+/// @brief Drives the HSSI_CTRL/HSSI_STAT handshakes of many mailboxes
+///        from one thread.
+///
+/// Operations submitted for a mailbox run in order. Each round visits
+/// every mailbox with work and advances its current operation as far as
+/// it can without waiting: a write, or one poll of HSSI_STAT. A mailbox
+/// used by a reactor must not be used synchronously at the same time,
+/// unless its hssi_przone has an arbiter: the reactor then holds it for
+/// each operation, taking it without blocking the round.
+/// Completion callbacks run on the reactor thread and must not block.
+class reactor {
+ public:
+  typedef std::shared_ptr<reactor> ptr_t;
+  typedef std::function<void(bool ok)> callback;
+
+  struct stats {
+    uint64_t submitted;
+    uint64_t completed;
+    uint64_t failed;
+    uint64_t rounds;
+    uint64_t polls;  ///< HSSI_STAT reads
+  };
+
+  reactor();
+  ~reactor();
+
+  /// @brief Queue op for mailbox; the future (and done, if set) receive
+  ///        whether every stage completed
+  std::future<bool> submit(hssi_przone::ptr_t mailbox, async_op op,
+                           callback done = callback());
+
+  /// @brief Run the rounds on a thread of the reactor's own
+  void start();
+  /// @brief Stop the thread once no operation holds an arbiter; queued
+  ///        operations stay queued
+  void stop();
+
+  /// @brief One round over the mailboxes, for callers that run their own
+  ///        loop instead of start(), always from the same thread
+  /// @return the operations not completed yet
+  size_t run_once();
+
+  stats get_stats();
+
+ private:
+  typedef std::chrono::steady_clock clock;
+  enum class phase { write, ack, nack };
+  enum class progress { advanced, waiting, finished, failed };
+
+  struct job {
+    async_op op;
+    std::promise<bool> promise;
+    callback done;
+    size_t stage;
+    size_t step;
+    phase state;
+    clock::time_point ack_deadline;
+    clock::time_point stage_deadline;
+    bool stage_started;
+    bool leased;  ///< holds the arbiter of the mailbox
+  };
+
+  struct channel {
+    hssi_przone::ptr_t przone;
+    mmio* io;
+    uint8_t* base;  ///< mapped register space, or nullptr
+    uint32_t ctrl;
+    uint32_t stat;
+    std::deque<std::unique_ptr<job>> jobs;
+  };
+
+  bool advance(channel& c);
+  bool acquire(channel& c);
+  void release(channel& c);
+  progress step(channel& c, job& j);
+  bool read64(const channel& c, uint32_t offset, uint64_t& value);
+  bool write64(const channel& c, uint32_t offset, uint64_t value);
+  void finish(std::unique_ptr<job> j, bool ok);
+  void loop();
+
+  std::vector<std::unique_ptr<channel>> channels_;  ///< round thread only
+  size_t in_flight_;
+  size_t leased_;
+
+  std::mutex mutex_;  ///< guards incoming_ and stats_
+  std::condition_variable wake_;
+  std::vector<std::pair<hssi_przone::ptr_t, std::unique_ptr<job>>> incoming_;
+  stats stats_;
+
+  std::mutex run_mutex_;  ///< one round at a time
+  std::atomic<bool> running_;
+  std::thread thread_;
+};
+
+/// @brief Asynchronous counterparts of the hssi-io operations on one
+///        mailbox. They bypass the shadow register cache. Buffers and
+///        result references must stay valid until the operation completes.
+class async_hssi {
+ public:
+  typedef std::shared_ptr<async_hssi> ptr_t;
+  typedef reactor::callback callback;
+
+  async_hssi(reactor::ptr_t r, hssi_przone::ptr_t przone,
+             size_t byte_addr_size = 1);
+
+  std::future<bool> xcvr_write(uint32_t lane, uint32_t reg_addr,
+                               uint32_t value, callback done = callback());
+  std::future<bool> xcvr_read(uint32_t lane, uint32_t reg_addr,
+                              uint32_t& value, callback done = callback());
+  std::future<bool> pll_read(uint32_t info_sel, uint32_t& value,
+                             callback done = callback());
+  std::future<bool> nios(uint32_t nios_func, const nios_args& args,
+                         uint32_t* value_out = nullptr,
+                         callback done = callback());
+  std::future<bool> i2c_read(uint32_t instance, uint32_t device_addr,
+                             uint32_t byte_addr, uint8_t bytes[], size_t count,
+                             callback done = callback());
+  std::future<bool> i2c_write(uint32_t instance, uint32_t device_addr,
+                              uint32_t byte_addr, const uint8_t bytes[],
+                              size_t count, callback done = callback());
+  std::future<bool> mdio_read(uint8_t device_addr, uint8_t port_addr,
+                              uint16_t reg_addr, uint32_t& value,
+                              callback done = callback());
+  std::future<bool> mdio_write(uint8_t device_addr, uint8_t port_addr,
+                               uint16_t reg_addr, uint32_t value,
+                               callback done = callback());
+
+  hssi_przone::ptr_t get_przone() const { return przone_; }
+
+ private:
+  reactor::ptr_t reactor_;
+  hssi_przone::ptr_t przone_;
+  size_t byte_addr_size_;
+};
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
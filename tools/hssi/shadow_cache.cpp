@@ -0,0 +1,93 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "shadow_cache.h"
+
+#include "hssi_msg.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+shadow_cache::shadow_cache() : enabled_(true), epoch_(), stats_() {}
+
+bool shadow_cache::lookup(target t, uint64_t key, uint32_t& value) const {
+  if (!enabled_) return false;
+  const auto& entries = entries_[index(t)];
+  auto it = entries.find(key);
+  if (it == entries.end() || it->second.epoch != epoch_[index(t)]) {
+    return false;
+  }
+  value = it->second.value;
+  return true;
+}
+
+void shadow_cache::update(target t, uint64_t key, uint32_t value) {
+  if (!enabled_) return;
+  entry& e = entries_[index(t)][key];
+  e.value = value;
+  e.epoch = epoch_[index(t)];
+}
+
+void shadow_cache::erase(target t, uint64_t key) {
+  entries_[index(t)].erase(key);
+}
+
+void shadow_cache::invalidate(target t) {
+  // stale entries are overwritten in place by later updates, so the
+  // maps stay bounded by the number of distinct registers touched
+  ++epoch_[index(t)];
+}
+
+void shadow_cache::invalidate() {
+  for (size_t i = 0; i < num_targets; ++i) {
+    ++epoch_[i];
+  }
+}
+
+void shadow_cache::set_enabled(bool enabled) {
+  if (enabled_ != enabled) invalidate();
+  enabled_ = enabled;
+}
+
+uint64_t shadow_cache::xcvr_key(uint32_t lane, uint32_t reg_addr) {
+  return reg_addr + controller::hssi_xcvr_lane_offset * lane;
+}
+
+uint64_t shadow_cache::retimer_key(uint32_t device_addr, uint32_t channel,
+                                   uint32_t reg_addr) {
+  return static_cast<uint64_t>(device_addr) << 40 |
+         static_cast<uint64_t>(channel) << 32 | reg_addr;
+}
+
+uint64_t shadow_cache::mdio_key(uint32_t device_addr, uint32_t port_addr,
+                                uint32_t reg_addr) {
+  return static_cast<uint64_t>(device_addr) << 40 |
+         static_cast<uint64_t>(port_addr) << 32 | reg_addr;
+}
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
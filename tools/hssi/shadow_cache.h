@@ -0,0 +1,143 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+/// @brief Last known values of transceiver, retimer and MDIO registers.
+///
+/// Accessors are write-through: a write whose value matches the shadow is
+/// skipped, any other write goes to the hardware and then updates the
+/// shadow, and a read is served from the shadow when the entry is valid.
+/// Each target has an epoch; invalidating a target bumps its epoch, which
+/// retires every entry recorded before it. Register state changed behind
+/// the cache's back (NIOS mode changes, hssi_init, raw I2C writes) must
+/// invalidate the affected targets.
+///
+/// The shadow lives in memory for one run of the tool: it only saves
+/// the repeated accesses within that run, and every run starts cold.
+/// MDIO accesses always reach the PHY (see mdio::read and mdio::write),
+/// whose registers change on their own; the shadow only records them.
+class shadow_cache {
+ public:
+  typedef std::shared_ptr<shadow_cache> ptr_t;
+
+  enum class target : uint8_t { xcvr = 0, retimer, mdio };
+
+  struct stats {
+    uint64_t read_hits;
+    uint64_t read_misses;
+    uint64_t writes_skipped;
+    uint64_t writes;
+  };
+
+  shadow_cache();
+
+  /// @brief Get the shadow value of a register, if known
+  bool lookup(target t, uint64_t key, uint32_t& value) const;
+
+  /// @brief Record the value a register holds now
+  void update(target t, uint64_t key, uint32_t value);
+
+  /// @brief Forget one register
+  void erase(target t, uint64_t key);
+
+  /// @brief Forget every register of a target
+  void invalidate(target t);
+
+  /// @brief Forget every register
+  void invalidate();
+
+  /// @brief Read through the cache.
+  ///        read_hw(uint32_t&) -> bool is only called on a miss.
+  template <typename ReadHw>
+  bool read(target t, uint64_t key, uint32_t& value, ReadHw read_hw) {
+    if (lookup(t, key, value)) {
+      ++stats_.read_hits;
+      return true;
+    }
+    ++stats_.read_misses;
+    if (!read_hw(value)) return false;
+    update(t, key, value);
+    return true;
+  }
+
+  /// @brief Write through the cache.
+  ///        write_hw() -> bool is skipped if the register holds value.
+  template <typename WriteHw>
+  bool write(target t, uint64_t key, uint32_t value, WriteHw write_hw) {
+    uint32_t current;
+    if (lookup(t, key, current) && current == value) {
+      ++stats_.writes_skipped;
+      return true;
+    }
+    ++stats_.writes;
+    if (!write_hw()) {
+      erase(t, key);
+      return false;
+    }
+    update(t, key, value);
+    return true;
+  }
+
+  bool enabled() const { return enabled_; }
+  void set_enabled(bool enabled);
+
+  const stats& get_stats() const { return stats_; }
+  void reset_stats() { stats_ = stats(); }
+
+  uint32_t epoch(target t) const { return epoch_[index(t)]; }
+
+  static uint64_t xcvr_key(uint32_t lane, uint32_t reg_addr);
+  static uint64_t retimer_key(uint32_t device_addr, uint32_t channel,
+                              uint32_t reg_addr);
+  static uint64_t mdio_key(uint32_t device_addr, uint32_t port_addr,
+                           uint32_t reg_addr);
+
+ private:
+  static const size_t num_targets = 3;
+  static size_t index(target t) { return static_cast<size_t>(t); }
+
+  struct entry {
+    uint32_t value;
+    uint32_t epoch;
+  };
+
+  bool enabled_;
+  uint32_t epoch_[num_targets];
+  std::unordered_map<uint64_t, entry> entries_[num_targets];
+  stats stats_;
+};
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
@@ -0,0 +1,206 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "mmio_trace.h"
+
+using namespace intel::fpga::hssi;
+
+namespace
+{
+
+struct tag_summary
+{
+    uint64_t ops;
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t failed;
+    double   total_usec;
+    double   max_usec;
+};
+
+struct access_summary
+{
+    uint64_t count;
+    double   total_nsec;
+    double   max_nsec;
+};
+
+const char * access_names[] = { "read32", "read64", "write32", "write64" };
+
+void show_help()
+{
+    std::cout << "Usage: hssi_trace <trace file> [<trace file>...]" << std::endl
+              << std::endl
+              << "Summarize MMIO traces written by hssi_config --trace:" << std::endl
+              << "ops and accesses per operation, access latencies and" << std::endl
+              << "the time spent polling for acks." << std::endl;
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || !strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))
+    {
+        show_help();
+        return argc < 2 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    std::array<tag_summary, static_cast<size_t>(trace_tag::count)> tags = {};
+    std::array<access_summary, 4> accesses = {};
+    uint64_t ack_waits = 0, ack_polls = 0;
+    double ack_usec = 0.0, traced_usec = 0.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        trace_file trace;
+        std::string error;
+        if (!trace.load(argv[i], error))
+        {
+            std::cerr << argv[i] << ": " << error << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        const double usec_per_tick = trace.header.tsc_hz ? 1e6 / trace.header.tsc_hz : 0.0;
+        const auto & recs = trace.records;
+        uint64_t dropped = trace.header.head - recs.size();
+        double span_usec = recs.empty() ? 0.0 :
+            (recs.back().tsc + recs.back().ticks - recs.front().tsc) * usec_per_tick;
+        traced_usec += span_usec;
+
+        std::printf("%s: thread %u, %zu records, %llu overwritten, %.1f usec\n",
+                    argv[i], trace.header.thread, recs.size(),
+                    static_cast<unsigned long long>(dropped), span_usec);
+
+        // an op is the run of records sharing its sequence number
+        size_t op_begin = 0;
+        size_t ack_begin = 0;
+        bool in_ack = false;
+        for (size_t r = 0; r < recs.size(); ++r)
+        {
+            const trace_record & rec = recs[r];
+            size_t tag = rec.tag < tags.size() ? rec.tag : 0;
+            tag_summary & ts = tags[tag];
+            bool write = rec.access == static_cast<uint8_t>(trace_access::write32) ||
+                         rec.access == static_cast<uint8_t>(trace_access::write64);
+            ++(write ? ts.writes : ts.reads);
+            if (rec.flags & trace_failed)
+            {
+                ++ts.failed;
+            }
+
+            if (rec.access < accesses.size())
+            {
+                access_summary & as = accesses[rec.access];
+                double nsec = rec.ticks * usec_per_tick * 1000.0;
+                ++as.count;
+                as.total_nsec += nsec;
+                as.max_nsec = std::max(as.max_nsec, nsec);
+            }
+
+            bool last = r + 1 == recs.size();
+            const trace_record * next = last ? nullptr : &recs[r + 1];
+            if (tag != 0 && (last || next->op != rec.op || next->tag != rec.tag))
+            {
+                double usec = (rec.tsc + rec.ticks - recs[op_begin].tsc) * usec_per_tick;
+                ++ts.ops;
+                ts.total_usec += usec;
+                ts.max_usec = std::max(ts.max_usec, usec);
+            }
+            if (last || next->op != rec.op || next->tag != rec.tag)
+            {
+                op_begin = r + 1;
+            }
+
+            // a wait is a run of ack polling reads
+            if (rec.flags & trace_ack_poll)
+            {
+                if (!in_ack)
+                {
+                    ack_begin = r;
+                    in_ack = true;
+                }
+                ++ack_polls;
+            }
+            if (in_ack && (last || !(next->flags & trace_ack_poll)))
+            {
+                ++ack_waits;
+                ack_usec += (rec.tsc + rec.ticks - recs[ack_begin].tsc) * usec_per_tick;
+                in_ack = false;
+            }
+        }
+    }
+
+    std::printf("\n%-14s %10s %10s %10s %8s %12s %10s %10s\n",
+                "op", "ops", "reads", "writes", "failed", "total(us)", "mean(us)", "max(us)");
+    for (size_t t = 0; t < tags.size(); ++t)
+    {
+        const tag_summary & ts = tags[t];
+        if (!ts.reads && !ts.writes)
+        {
+            continue;
+        }
+        std::printf("%-14s %10llu %10llu %10llu %8llu %12.1f %10.2f %10.2f\n",
+                    trace_tag_name(static_cast<trace_tag>(t)),
+                    static_cast<unsigned long long>(ts.ops),
+                    static_cast<unsigned long long>(ts.reads),
+                    static_cast<unsigned long long>(ts.writes),
+                    static_cast<unsigned long long>(ts.failed),
+                    ts.total_usec, ts.ops ? ts.total_usec / ts.ops : 0.0, ts.max_usec);
+    }
+
+    std::printf("\n%-14s %10s %10s %10s\n", "access", "count", "mean(ns)", "max(ns)");
+    for (size_t a = 0; a < accesses.size(); ++a)
+    {
+        const access_summary & as = accesses[a];
+        if (!as.count)
+        {
+            continue;
+        }
+        std::printf("%-14s %10llu %10.1f %10.1f\n", access_names[a],
+                    static_cast<unsigned long long>(as.count),
+                    as.total_nsec / as.count, as.max_nsec);
+    }
+
+    std::printf("\nack polling: %llu waits, %llu polls (%.1f per wait), %.1f usec (%.1f%% of traced time)\n",
+                static_cast<unsigned long long>(ack_waits),
+                static_cast<unsigned long long>(ack_polls),
+                ack_waits ? static_cast<double>(ack_polls) / ack_waits : 0.0,
+                ack_usec, traced_usec > 0.0 ? 100.0 * ack_usec / traced_usec : 0.0);
+    return EXIT_SUCCESS;
+}
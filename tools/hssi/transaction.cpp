@@ -0,0 +1,148 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "transaction.h"
+
+#include "hssi_msg.h"
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+using namespace controller;
+
+namespace {
+
+uint64_t aux_word(aux_bus address, hssi_cmd command, uint32_t data) {
+  hssi_ctrl msg;
+  msg.set_address(address);
+  msg.set_data(data);
+  msg.set_command(command);
+  return msg.data();
+}
+
+inline uint32_t bus_word(bus_cmd cmd, uint32_t addr) {
+  return static_cast<uint32_t>(cmd) << 16 | addr;
+}
+
+}  // end of anonymous namespace
+
+transaction& transaction::add(uint64_t ctrl, uint32_t* result) {
+  step s = {ctrl, result};
+  steps_.push_back(s);
+  return *this;
+}
+
+transaction& transaction::xcvr_write(uint32_t lane, uint32_t reg_addr,
+                                     uint32_t value) {
+  uint32_t reconfig_addr = reg_addr + hssi_xcvr_lane_offset * lane;
+  // 1. value -> local_din
+  add(aux_word(aux_bus::local_din, hssi_cmd::aux_write, value));
+  // 2. local_din -> local_dout
+  add(aux_word(aux_bus::local_cmd, hssi_cmd::aux_write,
+               bus_word(bus_cmd::local_write, aux_bus::local_dout)));
+  // 3. channel + reconfig_addr -> local_din
+  add(aux_word(aux_bus::local_din, hssi_cmd::aux_write,
+               bus_word(bus_cmd::local_write, reconfig_addr)));
+  // 4. write local_dout to the register identified in step 3
+  return add(aux_word(aux_bus::local_cmd, hssi_cmd::aux_write,
+                      bus_word(bus_cmd::local_write, aux_bus::local_din)));
+}
+
+transaction& transaction::xcvr_read(uint32_t lane, uint32_t reg_addr,
+                                    uint32_t* value) {
+  uint32_t reconfig_addr = reg_addr + hssi_xcvr_lane_offset * lane;
+  // 1. read_cmd, channel, reconfig_addr -> local_din
+  add(aux_word(aux_bus::local_din, hssi_cmd::aux_write,
+               bus_word(bus_cmd::rcfg_read, reconfig_addr)));
+  // 2. local_din -> recfg_cmd_addr
+  add(aux_word(aux_bus::local_cmd, hssi_cmd::aux_write,
+               bus_word(bus_cmd::local_write, local_bus::recfg_cmd_addr)));
+  // 3. recfg_cmd_rddata -> local_dout
+  add(aux_word(aux_bus::local_cmd, hssi_cmd::aux_write,
+               bus_word(bus_cmd::local_read, local_bus::recfg_cmd_rddata)));
+  // 4. local_dout -> HSSI_STAT
+  return add(aux_word(aux_bus::local_dout, hssi_cmd::aux_read, 0), value);
+}
+
+transaction& transaction::pll_read(uint32_t info_sel, uint32_t* value) {
+  uint32_t reg = info_sel == 0 ? local_bus::pll_rst_control
+                               : local_bus::pll_locked_status;
+  add(aux_word(aux_bus::local_cmd, hssi_cmd::aux_write,
+               bus_word(bus_cmd::local_read, reg)));
+  return add(aux_word(aux_bus::local_dout, hssi_cmd::aux_read, 0), value);
+}
+
+transaction& transaction::przone_write(uint32_t address, uint32_t value) {
+  add(aux_word(aux_bus::prmgmt_din, hssi_cmd::aux_write, value));
+  return add(aux_word(aux_bus::prmgmt_cmd, hssi_cmd::aux_write,
+                      bus_word(bus_cmd::prmgmt_write, address)));
+}
+
+transaction& transaction::przone_read(uint32_t address, uint32_t* value) {
+  add(aux_word(aux_bus::prmgmt_cmd, hssi_cmd::aux_write, address));
+  return add(aux_word(aux_bus::prmgmt_dout, hssi_cmd::aux_read,
+                      bus_word(bus_cmd::prmgmt_write, address)),
+             value);
+}
+
+transaction& transaction::soft_cmd(uint32_t nios_func, const uint32_t* args,
+                                   size_t count, uint32_t* value) {
+  hssi_ctrl msg;
+  for (size_t i = 0; i < count; ++i) {
+    msg.clear();
+    msg.set_command(hssi_cmd::sw_write);
+    msg.set_address(i + 2);
+    msg.set_data(args[i]);
+    add(msg.data());
+  }
+
+  msg.clear();
+  msg.set_command(hssi_cmd::sw_write);
+  msg.set_address(1);
+  msg.set_data(nios_func);
+  add(msg.data());
+
+  switch (nios_func) {
+    case nios_cmd::tx_eq_read:
+    case nios_cmd::hssi_init:
+    case nios_cmd::hssi_init_done:
+    case nios_cmd::fatal_err:
+    case nios_cmd::get_hssi_enable:
+    case nios_cmd::get_hssi_mode:
+      msg.set_command(hssi_cmd::sw_read);
+      msg.set_address(6);
+      msg.set_data(nios_func);
+      add(msg.data(), value);
+      break;
+    default:
+      break;
+  }
+  return *this;
+}
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
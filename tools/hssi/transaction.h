@@ -0,0 +1,85 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace intel {
+namespace fpga {
+namespace hssi {
+
+/// @brief A sequence of HSSI_CTRL words, each of which is followed by
+///        the ack/nack handshake.
+///
+/// Operations on the transceiver, PLL and PR zone registers are flattened
+/// into controller words once, when they are added, so a batch (e.g. all
+/// equalization registers of a profile) can be run back-to-back by
+/// hssi_przone::execute.
+class transaction {
+ public:
+  struct step {
+    uint64_t ctrl;     ///< word written to HSSI_CTRL
+    uint32_t* result;  ///< if set, receives HSSI_STAT[31:0] after the ack
+  };
+
+  transaction& xcvr_write(uint32_t lane, uint32_t reg_addr, uint32_t value);
+  transaction& xcvr_read(uint32_t lane, uint32_t reg_addr, uint32_t* value);
+  transaction& pll_read(uint32_t info_sel, uint32_t* value);
+  transaction& przone_write(uint32_t address, uint32_t value);
+  transaction& przone_read(uint32_t address, uint32_t* value);
+  /// @brief A NIOS soft command: up to four arguments, the function and,
+  ///        for functions that return one, the read of its result
+  transaction& soft_cmd(uint32_t nios_func, const uint32_t* args,
+                        size_t count, uint32_t* value);
+
+  /// @brief Append a single controller word
+  transaction& add(uint64_t ctrl, uint32_t* result = nullptr);
+
+  void reserve(size_t steps) { steps_.reserve(steps); }
+  void clear() { steps_.clear(); }
+  bool empty() const { return steps_.empty(); }
+  size_t size() const { return steps_.size(); }
+
+  const step* begin() const { return steps_.data(); }
+  const step* end() const { return steps_.data() + steps_.size(); }
+
+  /// Controller words per operation
+  static const size_t xcvr_write_steps = 4;
+  static const size_t xcvr_read_steps = 4;
+  static const size_t pll_read_steps = 2;
+  static const size_t przone_write_steps = 2;
+  static const size_t przone_read_steps = 2;
+  static const size_t max_soft_cmd_args = 4;
+
+ private:
+  std::vector<step> steps_;
+};
+
+}  // end of namespace hssi
+}  // end of namespace fpga
+}  // end of namespace intel
@@ -27,6 +27,7 @@
 
 #include "hssi_przone.h"
 #include "mmio.h"
+#include "shadow_cache.h"
 
 namespace intel {
 namespace fpga {
@@ -36,14 +37,15 @@ class xcvr {
  public:
   typedef std::shared_ptr<xcvr> ptr_t;
 
-  xcvr(hssi_przone::ptr_t przone);
+  xcvr(hssi_przone::ptr_t przone,
+       shadow_cache::ptr_t cache = shadow_cache::ptr_t());
 
   bool write(uint32_t lane, uint32_t reg_addr, uint32_t value);
   bool read(uint32_t lane, uint32_t reg_addr, uint32_t& value);
 
  private:
   hssi_przone::ptr_t przone_;
-  mmio::ptr_t mmio_;
+  shadow_cache::ptr_t cache_;
 };
 }
 }